@@ -0,0 +1,143 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2026 Vincent Bernat <bernat@luffy.cx>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "arena.h"
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ARENA_ALIGN (2 * sizeof(void *))
+#define ARENA_ROUND(size) (((size) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+#define ARENA_MIN_SIZE 256
+
+struct arena_chunk {
+	struct arena_chunk *ac_next; /* Previous chunk */
+	size_t ac_size;		     /* Usable size */
+	size_t ac_used;		     /* Allocated size */
+};
+
+struct arena {
+	struct arena_chunk *a_chunks; /* Current chunk first */
+	unsigned a_refcount;
+};
+
+/* The first chunk is allocated with the arena itself */
+#define ARENA_FIRST(arena) \
+  ((struct arena_chunk *)((char *)(arena) + ARENA_ROUND(sizeof(struct arena))))
+#define ARENA_DATA(chunk) ((char *)(chunk) + ARENA_ROUND(sizeof(struct arena_chunk)))
+
+/**
+ * Create a new arena.
+ *
+ * @param size Expected size of all the objects to be allocated.
+ * @return The arena, with a single reference, or NULL on error.
+ */
+struct arena *
+arena_new(size_t size)
+{
+	struct arena *arena;
+
+	if (size < ARENA_MIN_SIZE) size = ARENA_MIN_SIZE;
+	if (size > SIZE_MAX / 4) return NULL;
+	size = ARENA_ROUND(size);
+	if ((arena = calloc(1,
+		 ARENA_ROUND(sizeof(struct arena)) +
+		     ARENA_ROUND(sizeof(struct arena_chunk)) + size)) == NULL)
+		return NULL;
+	arena->a_chunks = ARENA_FIRST(arena);
+	arena->a_chunks->ac_size = size;
+	arena->a_refcount = 1;
+	return arena;
+}
+
+/* Get an additional reference to an arena. */
+struct arena *
+arena_ref(struct arena *arena)
+{
+	if (arena) arena->a_refcount++;
+	return arena;
+}
+
+/* Drop a reference to an arena. All its objects are freed with the last one. */
+void
+arena_release(struct arena *arena)
+{
+	struct arena_chunk *chunk, *chunk_next;
+
+	if (arena == NULL || --arena->a_refcount > 0) return;
+	for (chunk = arena->a_chunks; chunk != ARENA_FIRST(arena); chunk = chunk_next) {
+		chunk_next = chunk->ac_next;
+		free(chunk);
+	}
+	free(arena);
+}
+
+/**
+ * Allocate zeroed memory from an arena.
+ *
+ * @param arena Arena to allocate from or NULL to use `calloc()`.
+ * @param size  Size to allocate.
+ * @return The allocated memory or NULL on error.
+ *
+ * When the current chunk is full, a new one at least twice as large is
+ * allocated. The memory cannot be freed individually.
+ */
+void *
+arena_alloc(struct arena *arena, size_t size)
+{
+	struct arena_chunk *chunk;
+	size_t len;
+	void *result;
+
+	if (arena == NULL) return calloc(1, size);
+	if (size > SIZE_MAX / 4) return NULL;
+	size = ARENA_ROUND(size);
+	chunk = arena->a_chunks;
+	if (chunk->ac_size - chunk->ac_used < size) {
+		len = chunk->ac_size * 2;
+		if (len < size) len = size;
+		if ((chunk = calloc(1,
+			 ARENA_ROUND(sizeof(struct arena_chunk)) + len)) == NULL)
+			return NULL;
+		chunk->ac_next = arena->a_chunks;
+		chunk->ac_size = len;
+		arena->a_chunks = chunk;
+	}
+	result = ARENA_DATA(chunk) + chunk->ac_used;
+	chunk->ac_used += size;
+	return result;
+}
+
+/* Like asprintf() but allocate the result from an arena (or with `calloc()`
+ * when the arena is NULL). */
+int
+arena_asprintf(struct arena *arena, char **result, const char *format, ...)
+{
+	va_list ap;
+	int len;
+
+	va_start(ap, format);
+	len = vsnprintf(NULL, 0, format, ap);
+	va_end(ap);
+	if (len < 0 || (*result = arena_alloc(arena, len + 1)) == NULL) return -1;
+	va_start(ap, format);
+	vsnprintf(*result, len + 1, format, ap);
+	va_end(ap);
+	return len;
+}
@@ -0,0 +1,41 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2026 Vincent Bernat <bernat@luffy.cx>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <stddef.h>
+
+/* Region allocator. Objects are allocated from large chunks and are only
+ * released all at once, when the last reference to the arena is dropped.
+ * Memory returned by `arena_alloc()` is zeroed.
+ *
+ * This is used to hold everything decoded from a frame received from a
+ * neighbor: the remote port and the remote chassis both keep a reference to
+ * the arena their content was allocated from. When no arena is provided,
+ * `arena_alloc()` falls back to `calloc()` and objects are freed one by one
+ * as usual. */
+struct arena;
+
+struct arena *arena_new(size_t);
+struct arena *arena_ref(struct arena *);
+void arena_release(struct arena *);
+void *arena_alloc(struct arena *, size_t);
+int arena_asprintf(struct arena *, char **, const char *, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#endif
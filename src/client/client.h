@@ -115,7 +115,7 @@ char *totag(const char *);
 #define DISPLAY_NORMAL 2
 #define DISPLAY_DETAILS 3
 void display_interfaces(lldpctl_conn_t *, struct writer *, struct cmd_env *, int, int);
-void display_interface(lldpctl_conn_t *, struct writer *, int, lldpctl_atom_t *,
+void display_interface(lldpctl_conn_t *, struct writer *, int, const char *,
     lldpctl_atom_t *, int, int);
 void display_local_chassis(lldpctl_conn_t *, struct writer *, struct cmd_env *, int);
 void display_configuration(lldpctl_conn_t *, struct writer *);
@@ -76,6 +76,74 @@ cmd_perm_iface_pattern(struct lldpctl_conn_t *conn, struct writer *w,
 	return 1;
 }
 
+static int
+cmd_iface_rx_ring(struct lldpctl_conn_t *conn, struct writer *w, struct cmd_env *env,
+    void *arg)
+{
+	lldpctl_atom_t *config = lldpctl_get_configuration(conn);
+	if (config == NULL) {
+		log_warnx("lldpctl", "unable to get configuration from lldpd. %s",
+		    lldpctl_last_strerror(conn));
+		return 0;
+	}
+	if (lldpctl_atom_set_int(config, lldpctl_k_config_iface_rx_ring, arg ? 1 : 0) ==
+	    NULL) {
+		log_warnx("lldpctl", "unable to %s memory-mapped ring: %s",
+		    arg ? "enable" : "disable", lldpctl_last_strerror(conn));
+		lldpctl_atom_dec_ref(config);
+		return 0;
+	}
+	log_info("lldpctl", "interface memory-mapped ring %s",
+	    arg ? "enabled" : "disabled");
+	lldpctl_atom_dec_ref(config);
+	return 1;
+}
+
+static int
+cmd_iface_shared_socket(struct lldpctl_conn_t *conn, struct writer *w,
+    struct cmd_env *env, void *arg)
+{
+	lldpctl_atom_t *config = lldpctl_get_configuration(conn);
+	if (config == NULL) {
+		log_warnx("lldpctl", "unable to get configuration from lldpd. %s",
+		    lldpctl_last_strerror(conn));
+		return 0;
+	}
+	if (lldpctl_atom_set_int(config, lldpctl_k_config_iface_shared_socket,
+		arg ? 1 : 0) == NULL) {
+		log_warnx("lldpctl", "unable to %s shared socket: %s",
+		    arg ? "enable" : "disable", lldpctl_last_strerror(conn));
+		lldpctl_atom_dec_ref(config);
+		return 0;
+	}
+	log_info("lldpctl", "interface shared socket %s",
+	    arg ? "enabled" : "disabled");
+	lldpctl_atom_dec_ref(config);
+	return 1;
+}
+
+static int
+cmd_snapshot(struct lldpctl_conn_t *conn, struct writer *w, struct cmd_env *env,
+    void *arg)
+{
+	lldpctl_atom_t *config = lldpctl_get_configuration(conn);
+	if (config == NULL) {
+		log_warnx("lldpctl", "unable to get configuration from lldpd. %s",
+		    lldpctl_last_strerror(conn));
+		return 0;
+	}
+	if (lldpctl_atom_set_int(config, lldpctl_k_config_snapshot, arg ? 1 : 0) ==
+	    NULL) {
+		log_warnx("lldpctl", "unable to %s snapshot of neighbors: %s",
+		    arg ? "enable" : "disable", lldpctl_last_strerror(conn));
+		lldpctl_atom_dec_ref(config);
+		return 0;
+	}
+	log_info("lldpctl", "snapshot of neighbors %s", arg ? "enabled" : "disabled");
+	lldpctl_atom_dec_ref(config);
+	return 1;
+}
+
 static int
 cmd_iface_promisc(struct lldpctl_conn_t *conn, struct writer *w, struct cmd_env *env,
     void *arg)
@@ -534,6 +602,16 @@ register_commands_configure_system(struct cmd_node *configure,
 	    NEWLINE, "Set maximum number of neighbors per port", NULL, cmd_maxneighs,
 	    NULL);
 
+	commands_new(commands_new(configure_system, "snapshot",
+			 "Publish neighbors in a memory-mapped file", NULL, NULL, NULL),
+	    NEWLINE, "Publish neighbors in a memory-mapped file", NULL, cmd_snapshot,
+	    "enable");
+	commands_new(commands_new(unconfigure_system, "snapshot",
+			 "Don't publish neighbors in a memory-mapped file", NULL, NULL,
+			 NULL),
+	    NEWLINE, "Don't publish neighbors in a memory-mapped file", NULL,
+	    cmd_snapshot, NULL);
+
 	commands_new(
 	    commands_new(commands_new(commands_new(commands_new(configure_system, "ip",
 						       "IP related options", NULL, NULL,
@@ -595,6 +673,25 @@ register_commands_configure_system(struct cmd_node *configure,
 	    NEWLINE, "Don't enable promiscuous mode on managed interfaces", NULL,
 	    cmd_iface_promisc, NULL);
 
+	commands_new(commands_new(configure_interface, "rx-ring",
+			 "Receive frames through a memory-mapped ring", NULL, NULL,
+			 NULL),
+	    NEWLINE, "Receive frames through a memory-mapped ring", NULL,
+	    cmd_iface_rx_ring, "enable");
+	commands_new(commands_new(unconfigure_interface, "rx-ring",
+			 "Receive frames with regular system calls", NULL, NULL, NULL),
+	    NEWLINE, "Receive frames with regular system calls", NULL,
+	    cmd_iface_rx_ring, NULL);
+
+	commands_new(commands_new(configure_interface, "shared-socket",
+			 "Use a single socket for all interfaces", NULL, NULL, NULL),
+	    NEWLINE, "Use a single socket for all interfaces", NULL,
+	    cmd_iface_shared_socket, "enable");
+	commands_new(commands_new(unconfigure_interface, "shared-socket",
+			 "Use a socket for each interface", NULL, NULL, NULL),
+	    NEWLINE, "Use a socket for each interface", NULL,
+	    cmd_iface_shared_socket, NULL);
+
 	register_commands_capabilities(configure_system, unconfigure_system);
 	register_commands_srcmac_type(configure_system);
 }
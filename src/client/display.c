@@ -711,7 +711,7 @@ display_local_chassis(lldpctl_conn_t *conn, struct writer *w, struct cmd_env *en
 
 void
 display_interface(lldpctl_conn_t *conn, struct writer *w, int hidden,
-    lldpctl_atom_t *iface, lldpctl_atom_t *port, int details, int protocol)
+    const char *ifname, lldpctl_atom_t *port, int details, int protocol)
 {
 	int local = 0;
 
@@ -728,7 +728,7 @@ display_interface(lldpctl_conn_t *conn, struct writer *w, int hidden,
 	lldpctl_atom_t *chassis = lldpctl_atom_get(port, lldpctl_k_port_chassis);
 
 	tag_start(w, "interface", "Interface");
-	tag_attr(w, "name", "", lldpctl_atom_get_str(iface, lldpctl_k_interface_name));
+	tag_attr(w, "name", "", ifname);
 	if (!local) {
 		tag_attr(w, "via", "via",
 		    lldpctl_atom_get_str(port, lldpctl_k_port_protocol));
@@ -774,8 +774,8 @@ void
 display_interfaces(lldpctl_conn_t *conn, struct writer *w, struct cmd_env *env,
     int hidden, int details)
 {
-	lldpctl_atom_t *iface;
-	int protocol = LLDPD_MODE_MAX;
+	lldpctl_atom_t *ports, *port;
+	int protocol = 0;
 	const char *proto_str;
 
 	/* user might have specified protocol to filter display results */
@@ -784,7 +784,7 @@ display_interfaces(lldpctl_conn_t *conn, struct writer *w, struct cmd_env *env,
 	if (proto_str) {
 		log_debug("display", "filter protocol: %s ", proto_str);
 
-		protocol = 0;
+		protocol = -1; /* No neighbor for an unknown protocol */
 		for (lldpctl_map_t *protocol_map =
 			 lldpctl_key_get_map(lldpctl_k_port_protocol);
 		     protocol_map->string; protocol_map++) {
@@ -795,21 +795,29 @@ display_interfaces(lldpctl_conn_t *conn, struct writer *w, struct cmd_env *env,
 		}
 	}
 
+	/* Neighbors are filtered by lldpd */
+	ports = lldpctl_get_neighbors(conn, cmdenv_get(env, "ports"), protocol);
+	if (ports == NULL) {
+		log_warnx("lldpctl", "not able to get the list of neighbors. %s",
+		    lldpctl_last_strerror(conn));
+		return;
+	}
+
 	tag_start(w, "lldp", "LLDP neighbors");
-	while ((iface = cmd_iterate_on_interfaces(conn, env))) {
-		lldpctl_atom_t *port;
+	lldpctl_atom_foreach(ports, port)
+	{
 		lldpctl_atom_t *neighbors;
 		lldpctl_atom_t *neighbor;
-		port = lldpctl_get_port(iface);
+		const char *ifname = lldpctl_atom_get_str(port, lldpctl_k_port_name);
 		neighbors = lldpctl_atom_get(port, lldpctl_k_port_neighbors);
 		lldpctl_atom_foreach(neighbors, neighbor)
 		{
-			display_interface(conn, w, hidden, iface, neighbor, details,
-			    protocol);
+			display_interface(conn, w, hidden, ifname, neighbor, details,
+			    LLDPD_MODE_MAX);
 		}
 		lldpctl_atom_dec_ref(neighbors);
-		lldpctl_atom_dec_ref(port);
 	}
+	lldpctl_atom_dec_ref(ports);
 	tag_end(w);
 }
 
@@ -826,16 +834,25 @@ void
 display_local_interfaces(lldpctl_conn_t *conn, struct writer *w, struct cmd_env *env,
     int hidden, int details)
 {
-	lldpctl_atom_t *iface;
+	lldpctl_atom_t *ports, *port;
 	int protocol = LLDPD_MODE_MAX;
 
+	/* Neighbors are not needed */
+	ports = lldpctl_get_neighbors(conn, cmdenv_get(env, "ports"), -1);
+	if (ports == NULL) {
+		log_warnx("lldpctl", "not able to get the list of interfaces. %s",
+		    lldpctl_last_strerror(conn));
+		return;
+	}
+
 	tag_start(w, "lldp", "LLDP interfaces");
-	while ((iface = cmd_iterate_on_interfaces(conn, env))) {
-		lldpctl_atom_t *port;
-		port = lldpctl_get_port(iface);
-		display_interface(conn, w, hidden, iface, port, details, protocol);
-		lldpctl_atom_dec_ref(port);
+	lldpctl_atom_foreach(ports, port)
+	{
+		display_interface(conn, w, hidden,
+		    lldpctl_atom_get_str(port, lldpctl_k_port_name), port, details,
+		    protocol);
 	}
+	lldpctl_atom_dec_ref(ports);
 	tag_end(w);
 }
 
@@ -889,7 +906,7 @@ display_interface_stats(lldpctl_conn_t *conn, struct writer *w, lldpctl_atom_t *
 void
 display_interfaces_stats(lldpctl_conn_t *conn, struct writer *w, struct cmd_env *env)
 {
-	lldpctl_atom_t *iface;
+	lldpctl_atom_t *ports, *port;
 	int summary = 0;
 	u_int64_t h_tx_cnt = 0;
 	u_int64_t h_rx_cnt = 0;
@@ -901,10 +918,17 @@ display_interfaces_stats(lldpctl_conn_t *conn, struct writer *w, struct cmd_env
 
 	if (cmdenv_get(env, "summary")) summary = 1;
 
+	/* Neighbors are not needed */
+	ports = lldpctl_get_neighbors(conn, cmdenv_get(env, "ports"), -1);
+	if (ports == NULL) {
+		log_warnx("lldpctl", "not able to get the list of interfaces. %s",
+		    lldpctl_last_strerror(conn));
+		return;
+	}
+
 	tag_start(w, "lldp", (summary ? "LLDP Global statistics" : "LLDP statistics"));
-	while ((iface = cmd_iterate_on_interfaces(conn, env))) {
-		lldpctl_atom_t *port;
-		port = lldpctl_get_port(iface);
+	lldpctl_atom_foreach(ports, port)
+	{
 		if (!summary)
 			display_interface_stats(conn, w, port);
 		else {
@@ -921,8 +945,8 @@ display_interfaces_stats(lldpctl_conn_t *conn, struct writer *w, struct cmd_env
 			h_delete_cnt +=
 			    lldpctl_atom_get_int(port, lldpctl_k_delete_cnt);
 		}
-		lldpctl_atom_dec_ref(port);
 	}
+	lldpctl_atom_dec_ref(ports);
 
 	if (summary) {
 		tag_start(w, "summary", "Summary of stats");
@@ -1009,6 +1033,18 @@ display_configuration(lldpctl_conn_t *conn, struct writer *w)
 	    lldpctl_atom_get_int(configuration, lldpctl_k_config_iface_promisc) ?
 		"yes" :
 		"no");
+	tag_datatag(w, "iface-rx-ring", "Memory-mapped ring for reception",
+	    lldpctl_atom_get_int(configuration, lldpctl_k_config_iface_rx_ring) ?
+		"yes" :
+		"no");
+	tag_datatag(w, "iface-shared-socket", "Single socket for all interfaces",
+	    lldpctl_atom_get_int(configuration, lldpctl_k_config_iface_shared_socket) ?
+		"yes" :
+		"no");
+	tag_datatag(w, "snapshot", "Publish a snapshot of neighbors",
+	    lldpctl_atom_get_int(configuration, lldpctl_k_config_snapshot) ?
+		"yes" :
+		"no");
 	tag_datatag(w, "lldpmed-no-inventory", "Disable LLDP-MED inventory",
 	    (lldpctl_atom_get_int(configuration,
 		 lldpctl_k_config_lldpmed_noinventory) == 0) ?
@@ -47,6 +47,9 @@ struct json_writer_private {
 	int variant;
 	struct element *root;
 	struct element *current; /* should always be an object */
+	struct element *stream;	 /* Array of the top-level object being written */
+	int streamed;		 /* Number of elements of this array written */
+	int indent;		 /* Indentation of this array */
 };
 
 /* Create a new element. If a parent is provided, it will also be attached to
@@ -180,6 +183,21 @@ json_element_dump(FILE *fh, struct element *current, int indent)
 	}
 }
 
+/* Write the opening of an array or an object. */
+static void
+json_open(FILE *fh, const char *key, char c, int indent)
+{
+	if (key) fprintf(fh, "\"%s\": ", key);
+	fprintf(fh, "%c\n%*s", c, indent + 2, "");
+}
+
+/* Write the closing of an array or an object. */
+static void
+json_close(FILE *fh, char c, int indent)
+{
+	fprintf(fh, "\n%*c", indent + 1, c);
+}
+
 static void
 json_dump(struct json_writer_private *p)
 {
@@ -315,6 +333,84 @@ json_cleanup(struct json_writer_private *p)
 	if (p->variant != 0) json_element_cleanup(p->root);
 }
 
+/* The root object only contains one top-level object, like "lldp" for a list
+ * of neighbors. When this object only contains several elements of the same
+ * kind, like interfaces, they are written as soon as they are complete instead
+ * of keeping the whole output in memory. The result is the same as long as the
+ * top-level object does not get a "name" attribute afterwards.
+ *
+ * This function is called each time we are back in the top-level object. */
+static void
+json_stream(struct json_writer_private *p)
+{
+	struct element *top = p->current, *array, *el;
+	int count = 0;
+
+	if (p->stream == NULL) {
+		array = TAILQ_FIRST(&top->children);
+		if (array == NULL || TAILQ_NEXT(array, next) != NULL ||
+		    array->tag != ARRAY || !strcmp(array->key, "value"))
+			return;
+		TAILQ_FOREACH (el, &array->children, next)
+			count++;
+		/* Without the json0 variant, an array with one element
+		 * disappears. */
+		if (p->variant != 0 && count < 2) return;
+
+		/* Write the beginning, as json_element_dump() would do */
+		json_open(p->fh, NULL, '{', 0);
+		if (p->variant == 0) {
+			json_open(p->fh, top->parent->key, '[', 2);
+			json_open(p->fh, NULL, '{', 4);
+			p->indent = 6;
+		} else {
+			json_open(p->fh, top->parent->key, '{', 2);
+			p->indent = 4;
+		}
+		json_open(p->fh, array->key, '[', p->indent);
+		p->stream = array;
+		p->streamed = 0;
+	}
+
+	/* Write complete elements and forget about them */
+	while ((el = TAILQ_FIRST(&p->stream->children)) != NULL) {
+		if (p->variant != 0) {
+			json_element_cleanup(el);
+			el = TAILQ_FIRST(&p->stream->children);
+		}
+		if (p->streamed++ > 0) fprintf(p->fh, ",\n%*s", p->indent + 2, "");
+		json_element_dump(p->fh, el, p->indent + 2);
+		TAILQ_REMOVE(&p->stream->children, el, next);
+		json_element_free(el);
+		free(el->key);
+		free(el);
+	}
+	fflush(p->fh);
+}
+
+/* Write the end of a streamed top-level object with its remaining content. */
+static void
+json_stream_end(struct json_writer_private *p)
+{
+	struct element *child, *child_next;
+
+	json_close(p->fh, ']', p->indent);
+	for (child = TAILQ_NEXT(p->stream, next); child; child = child_next) {
+		child_next = TAILQ_NEXT(child, next);
+		if (p->variant != 0) json_element_cleanup(child);
+	}
+	TAILQ_FOREACH (child, &p->stream->parent->children, next) {
+		if (child == p->stream) continue;
+		fprintf(p->fh, ",\n%*s\"%s\": ", p->indent, "", child->key);
+		json_element_dump(p->fh, child, p->indent);
+	}
+	json_close(p->fh, '}', p->indent - 2);
+	if (p->variant == 0) json_close(p->fh, ']', 2);
+	json_close(p->fh, '}', 0);
+	fprintf(p->fh, "\n");
+	p->stream = NULL;
+}
+
 static void
 json_end(struct writer *w)
 {
@@ -328,13 +424,18 @@ json_end(struct writer *w)
 
 	/* Display current object if last one */
 	if (p->current == p->root) {
-		json_cleanup(p);
-		json_dump(p);
+		if (p->stream) {
+			json_stream_end(p);
+		} else {
+			json_cleanup(p);
+			json_dump(p);
+		}
 		json_free(p);
 		fprintf(p->fh, "\n");
 		fflush(p->fh);
 		p->root = p->current = json_element_new(NULL, NULL, OBJECT);
-	}
+	} else if (p->current->parent->parent == p->root)
+		json_stream(p);
 }
 
 static void
@@ -358,7 +459,12 @@ json_init(FILE *fh, int variant)
 
 	priv->fh = fh;
 	priv->root = priv->current = json_element_new(NULL, NULL, OBJECT);
+#ifdef ENABLE_JSON0
+	/* Elements are never cleaned up */
+	variant = 0;
+#endif
 	priv->variant = variant;
+	priv->stream = NULL;
 
 	result = malloc(sizeof(*result));
 	if (result == NULL) fatal(NULL, NULL);
@@ -78,8 +78,11 @@ kv_end(struct writer *w)
 	if ((dot = strrchr(p->prefix, '\1')) == NULL) {
 		p->prefix[0] = '\0';
 		fflush(p->fh);
-	} else
+	} else {
 		*dot = '\0';
+		/* Write each element of the top-level one when complete */
+		if (strchr(p->prefix, '\1') == NULL) fflush(p->fh);
+	}
 }
 
 void
@@ -166,6 +166,12 @@ watchcb(lldpctl_change_t type, lldpctl_atom_t *interface, lldpctl_atom_t *neighb
 	const char *proto_str;
 	int protocol = LLDPD_MODE_MAX;
 
+	if (type == lldpctl_c_overflow) {
+		tag_start(w, "lldp-overflow", "Some LLDP neighbor changes were lost");
+		tag_end(w);
+		return;
+	}
+
 	if (interfaces &&
 	    !contains(interfaces,
 		lldpctl_atom_get_str(interface, lldpctl_k_interface_name)))
@@ -201,7 +207,8 @@ watchcb(lldpctl_change_t type, lldpctl_atom_t *interface, lldpctl_atom_t *neighb
 	default:
 		return;
 	}
-	display_interface(NULL, w, 1, interface, neighbor,
+	display_interface(NULL, w, 1,
+	    lldpctl_atom_get_str(interface, lldpctl_k_interface_name), neighbor,
 	    cmdenv_get(env, "summary")	    ? DISPLAY_BRIEF :
 		cmdenv_get(env, "detailed") ? DISPLAY_DETAILS :
 					      DISPLAY_NORMAL,
@@ -219,6 +226,7 @@ cmd_watch_neighbors(struct lldpctl_conn_t *conn, struct writer *w, struct cmd_en
 {
 	struct watcharg wa = { .env = env, .w = w, .nb = 0 };
 	const char *limit_str = cmdenv_get(env, "limit");
+	const char *coalesce_str = cmdenv_get(env, "coalesce");
 	size_t limit = 0;
 
 	if (limit_str) {
@@ -229,6 +237,19 @@ cmd_watch_neighbors(struct lldpctl_conn_t *conn, struct writer *w, struct cmd_en
 			    limit_str, errstr);
 		}
 	}
+	if (coalesce_str) {
+		const char *errstr;
+		int window = strtonum(coalesce_str, 1, 60000, &errstr);
+		if (errstr != NULL) {
+			log_warnx("lldpctl",
+			    "specified coalescing window (%s) is %s and ignored",
+			    coalesce_str, errstr);
+		} else if (lldpctl_watch_coalesce(conn, window, 0) < 0) {
+			log_warnx("lldpctl", "unable to coalesce changes. %s",
+			    lldpctl_last_strerror(conn));
+			return 0;
+		}
+	}
 
 	log_debug("lldpctl", "watch for neighbor changes");
 	if (lldpctl_watch_callback2(conn, watchcb, &wa) < 0) {
@@ -360,5 +381,11 @@ register_commands_watch(struct cmd_node *root)
 	    NULL, "Stop after getting X events", NULL, cmd_store_env_value_and_pop2,
 	    "limit");
 
+	commands_new(commands_new(watch, "coalesce",
+			 "Coalesce changes during X milliseconds", cmd_check_no_env,
+			 NULL, "coalesce"),
+	    NULL, "Coalescing window in milliseconds", NULL,
+	    cmd_store_env_value_and_pop2, "coalesce");
+
 	register_common_commands(watch, 1);
 }
@@ -36,13 +36,15 @@ struct xml_writer_private {
 	FILE *fh;
 	ssize_t depth;
 	xmlTextWriterPtr xw;
-	xmlDocPtr doc;
 };
 
 void
 xml_new_writer(struct xml_writer_private *priv)
 {
-	priv->xw = xmlNewTextWriterDoc(&(priv->doc), 0);
+	xmlOutputBufferPtr out = xmlOutputBufferCreateFile(priv->fh, NULL);
+	if (!out) fatalx("lldpctl", "cannot create xml output buffer");
+	/* Write directly to the file, without building the document first */
+	priv->xw = xmlNewTextWriter(out);
 	if (!priv->xw) fatalx("lldpctl", "cannot create xml writer");
 
 	xmlTextWriterSetIndent(priv->xw, 4);
@@ -82,11 +84,53 @@ xml_attr(struct writer *w, const char *tag, const char *descr, const char *value
 		    value ? value : "(none)");
 }
 
+/* Escape data like libxml2 does when dumping a document. Unlike
+ * xmlTextWriterWriteString(), quotes are kept as is. */
+static char *
+xml_escape(const char *data)
+{
+	const char *s, *entity;
+	char *escaped, *d;
+
+	if ((escaped = malloc(strlen(data) * 5 + 1)) == NULL) fatal(NULL, NULL);
+	for (s = data, d = escaped; *s != '\0'; s++) {
+		switch (*s) {
+		case '&':
+			entity = "&amp;";
+			break;
+		case '<':
+			entity = "&lt;";
+			break;
+		case '>':
+			entity = "&gt;";
+			break;
+		case '\r':
+			entity = "&#13;";
+			break;
+		default:
+			*d++ = *s;
+			continue;
+		}
+		memcpy(d, entity, strlen(entity));
+		d += strlen(entity);
+	}
+	*d = '\0';
+	return escaped;
+}
+
 void
 xml_data(struct writer *w, const char *data)
 {
 	struct xml_writer_private *p = w->priv;
-	if (xmlTextWriterWriteString(p->xw, BAD_CAST(data ? data : "")) < 0)
+	char *escaped;
+	int rc;
+
+	/* Writing nothing would still close the start tag of an empty element */
+	if (data == NULL || *data == '\0') return;
+	escaped = xml_escape(data);
+	rc = xmlTextWriterWriteRaw(p->xw, BAD_CAST escaped);
+	free(escaped);
+	if (rc < 0)
 		log_warnx("lldpctl", "cannot add '%s' as data to element",
 		    data ? data : "(none)");
 }
@@ -100,19 +144,14 @@ xml_end(struct writer *w)
 		log_warnx("lldpctl", "cannot end element");
 
 	if (--p->depth == 0) {
-		int failed = 0;
-
-		if (xmlTextWriterEndDocument(p->xw) < 0) {
+		if (xmlTextWriterEndDocument(p->xw) < 0)
 			log_warnx("lldpctl", "cannot finish document");
-			failed = 1;
-		}
-
 		xmlFreeTextWriter(p->xw);
-		if (!failed) {
-			xmlDocDump(p->fh, p->doc);
-			fflush(p->fh);
-		}
-		xmlFreeDoc(p->doc);
+		fflush(p->fh);
+	} else if (p->depth == 1) {
+		/* Write each element of the top-level one when complete */
+		xmlTextWriterFlush(p->xw);
+		fflush(p->fh);
 	}
 }
 
@@ -130,19 +130,23 @@ int
 ctl_msg_send_unserialized(uint8_t **output_buffer, size_t *output_len,
     enum hmsg_type type, void *t, struct marshal_info *mi)
 {
-	ssize_t len = 0, newlen;
+	ssize_t len = 0, newlen, chunk, offset = 0;
+	size_t chunks;
+	uint8_t *out;
 	void *buffer = NULL;
 
 	log_debug("control", "send a message through control socket");
 	if (t) {
-		len = marshal_serialize_(mi, t, &buffer, 0, NULL, 0);
+		len = marshal_serialize_(mi, t, &buffer);
 		if (len <= 0) {
 			log_warnx("control", "unable to serialize data");
 			return -1;
 		}
 	}
 
-	newlen = len + sizeof(struct hmsg_header);
+	/* Large messages are split in chunks, each of them with a header. */
+	chunks = len ? (len + HMSG_MAX_SIZE - 1) / HMSG_MAX_SIZE : 1;
+	newlen = len + chunks * sizeof(struct hmsg_header);
 
 	if (*output_buffer == NULL) {
 		*output_len = 0;
@@ -161,19 +165,132 @@ ctl_msg_send_unserialized(uint8_t **output_buffer, size_t *output_len,
 		*output_buffer = new;
 	}
 
-	struct hmsg_header hdr;
-	memset(&hdr, 0, sizeof(struct hmsg_header));
-	hdr.type = type;
-	hdr.len = len;
-	memcpy(*output_buffer + *output_len, &hdr, sizeof(struct hmsg_header));
-	if (t)
-		memcpy(*output_buffer + *output_len + sizeof(struct hmsg_header),
-		    buffer, len);
+	out = *output_buffer + *output_len;
+	do {
+		struct hmsg_header hdr;
+		chunk = (len - offset > HMSG_MAX_SIZE) ? HMSG_MAX_SIZE : len - offset;
+		memset(&hdr, 0, sizeof(struct hmsg_header));
+		hdr.type = type;
+		hdr.len = chunk;
+		if (offset + chunk < len) hdr.flags |= HMSG_MORE;
+		memcpy(out, &hdr, sizeof(struct hmsg_header));
+		out += sizeof(struct hmsg_header);
+		if (chunk > 0) memcpy(out, (uint8_t *)buffer + offset, chunk);
+		out += chunk;
+		offset += chunk;
+	} while (offset < len);
 	*output_len += newlen;
 	free(buffer);
 	return 0;
 }
 
+/**
+ * Unserialize a structure from a buffer containing incoming messages.
+ *
+ * Unlike @c ctl_msg_recv_unserialized(), the buffer is not modified. The caller
+ * is expected to discard the consumed bytes itself.
+ *
+ * @param input_buffer  The buffer with the incoming message. Can be @c NULL.
+ *                      It must be aligned as returned by @c malloc().
+ * @param input_len     The length of the provided buffer.
+ * @param expected_type The expected message type.
+ * @param[out] t        Will contain a pointer to the unserialized structure.
+ *                      Can be @c NULL if we don't want to store the answer.
+ * @param mi            The appropriate marshal structure for unserialization.
+ * @param[out] consumed Number of bytes to discard from the buffer.
+ *
+ * @return Same as @c ctl_msg_recv_unserialized().
+ */
+size_t
+ctl_msg_parse_unserialized(const uint8_t *input_buffer, size_t input_len,
+    enum hmsg_type expected_type, void **t, struct marshal_info *mi,
+    size_t *consumed)
+{
+	struct hmsg_header hdr;
+	enum hmsg_type type = NONE;
+	size_t offset = 0, total = 0, chunks = 0;
+	uint8_t *payload = NULL;
+	int rc = -1;
+
+	*consumed = 0;
+
+	/* Walk the chunks until we find the last one of the message. */
+	do {
+		if (input_buffer == NULL ||
+		    input_len < offset + sizeof(struct hmsg_header)) {
+			/* Not enough data. */
+			return offset + sizeof(struct hmsg_header) - input_len;
+		}
+		memcpy(&hdr, input_buffer + offset, sizeof(struct hmsg_header));
+		if (chunks == 0) {
+			type = hdr.type;
+			log_debug("control", "receive a message through control socket");
+		}
+		if (hdr.len > HMSG_MAX_SIZE || hdr.type != type) {
+			if (hdr.type != type)
+				log_warnx("control",
+				    "chunk received for another message");
+			else
+				log_warnx("control", "message received is too large");
+			/* We discard the whole buffer */
+			*consumed = input_len;
+			return -1;
+		}
+		if (input_len < offset + sizeof(struct hmsg_header) + hdr.len) {
+			/* Not enough data. */
+			return offset + sizeof(struct hmsg_header) + hdr.len - input_len;
+		}
+		offset += sizeof(struct hmsg_header) + hdr.len;
+		total += hdr.len;
+		chunks++;
+	} while (hdr.flags & HMSG_MORE);
+
+	if (type != expected_type) {
+		if (expected_type == NOTIFICATION || expected_type == NOTIFICATIONS)
+			return -1;
+		log_warnx("control",
+		    "incorrect received message type (expected: %d, received: %d)",
+		    expected_type, type);
+		goto end;
+	}
+
+	if (t && !total) {
+		log_warnx("control", "no payload available in answer");
+		goto end;
+	}
+	if (t) {
+		/* We have data to unserialize. A message in a single chunk is
+		 * unserialized in place, otherwise, chunks are joined first. */
+		if (chunks == 1)
+			payload = (uint8_t *)input_buffer + sizeof(struct hmsg_header);
+		else {
+			size_t pos = 0, len;
+			if ((payload = malloc(total)) == NULL) {
+				log_warn("control", "no memory available");
+				goto end;
+			}
+			for (offset = 0; pos < total; offset += len) {
+				memcpy(&hdr, input_buffer + offset,
+				    sizeof(struct hmsg_header));
+				offset += sizeof(struct hmsg_header);
+				len = hdr.len;
+				memcpy(payload + pos, input_buffer + offset, len);
+				pos += len;
+			}
+		}
+		if (marshal_unserialize_(mi, payload, total, t, NULL, 0, 0) <= 0) {
+			log_warnx("control", "unable to deserialize received data");
+			goto end;
+		}
+	}
+
+	rc = 0;
+end:
+	if (chunks > 1) free(payload);
+	*consumed = chunks * sizeof(struct hmsg_header) + total;
+	return rc;
+}
+
 /**
  * "Receive" and unserialize a structure through the control protocol.
  *
@@ -197,65 +314,28 @@ ctl_msg_send_unserialized(uint8_t **output_buffer, size_t *output_len,
  * @return -1 in case of error, 0 in case of success and the number of bytes we
  *         request to complete unserialization.
  *
- * When requesting a notification, the input buffer is left untouched if we
- * don't get one and we fail silently.
+ * When requesting a notification (or a batch of notifications), the input
+ * buffer is left untouched if we don't get one and we fail silently.
+ *
+ * A message split in several chunks is only unserialized once all its chunks
+ * have been received.
  */
 size_t
 ctl_msg_recv_unserialized(uint8_t **input_buffer, size_t *input_len,
     enum hmsg_type expected_type, void **t, struct marshal_info *mi)
 {
-	struct hmsg_header hdr;
-	int rc = -1;
-
-	if (*input_buffer == NULL || *input_len < sizeof(struct hmsg_header)) {
-		/* Not enough data. */
-		return sizeof(struct hmsg_header) - *input_len;
-	}
-
-	log_debug("control", "receive a message through control socket");
-	memcpy(&hdr, *input_buffer, sizeof(struct hmsg_header));
-	if (hdr.len > HMSG_MAX_SIZE) {
-		log_warnx("control", "message received is too large");
-		/* We discard the whole buffer */
-		free(*input_buffer);
-		*input_buffer = NULL;
-		*input_len = 0;
-		return -1;
-	}
-	if (*input_len < sizeof(struct hmsg_header) + hdr.len) {
-		/* Not enough data. */
-		return sizeof(struct hmsg_header) + hdr.len - *input_len;
-	}
-	if (hdr.type != expected_type) {
-		if (expected_type == NOTIFICATION) return -1;
-		log_warnx("control",
-		    "incorrect received message type (expected: %d, received: %d)",
-		    expected_type, hdr.type);
-		goto end;
-	}
+	size_t consumed, rc;
 
-	if (t && !hdr.len) {
-		log_warnx("control", "no payload available in answer");
-		goto end;
-	}
-	if (t) {
-		/* We have data to unserialize. */
-		if (marshal_unserialize_(mi, *input_buffer + sizeof(struct hmsg_header),
-			hdr.len, t, NULL, 0, 0) <= 0) {
-			log_warnx("control", "unable to deserialize received data");
-			goto end;
-		}
-	}
+	rc = ctl_msg_parse_unserialized(*input_buffer, *input_len, expected_type, t,
+	    mi, &consumed);
+	if (consumed == 0) return rc;
 
-	rc = 0;
-end:
 	/* Discard input buffer */
-	*input_len -= sizeof(struct hmsg_header) + hdr.len;
+	*input_len -= consumed;
 	if (*input_len == 0) {
 		free(*input_buffer);
 		*input_buffer = NULL;
 	} else
-		memmove(*input_buffer,
-		    *input_buffer + sizeof(struct hmsg_header) + hdr.len, *input_len);
+		memmove(*input_buffer, *input_buffer + consumed, *input_len);
 	return rc;
 }
@@ -37,6 +37,10 @@ enum hmsg_type {
 	SET_PORT,	  /* Set port-related information (location, power, policy) */
 	SUBSCRIBE,	  /* Subscribe to neighbor changes */
 	NOTIFICATION,	  /* Notification message (sent by lldpd!) */
+	GET_NEIGHBORS,	  /* Get all interfaces with their neighbors */
+	NOTIFICATIONS,	  /* Coalesced notifications (sent by lldpd!) */
+	/* Get all information related to an interface, unless it did not change */
+	GET_INTERFACE_IF_MODIFIED,
 };
 
 /** Header for the control protocol.
@@ -44,12 +48,18 @@ enum hmsg_type {
  * The protocol is pretty simple. We send a single message containing the
  * provided message type with the message length, followed by the message
  * content.
+ *
+ * A message larger than @c HMSG_MAX_SIZE is split into several chunks, each
+ * with its own header. All chunks but the last one have the @c HMSG_MORE flag
+ * set. The receiver concatenates them before unserializing the message.
  */
 struct hmsg_header {
 	enum hmsg_type type;
-	size_t len;
+	int flags;
+	size_t len; /* Length of this chunk */
 };
-#define HMSG_MAX_SIZE (1 << 19)
+#define HMSG_MORE 0x1		/* Message continues in the next chunk */
+#define HMSG_MAX_SIZE (1 << 19) /* Maximum size of a chunk */
 
 /* ctl.c */
 int ctl_create(const char *);
@@ -60,5 +70,7 @@ int ctl_msg_send_unserialized(uint8_t **, size_t *, enum hmsg_type, void *,
     struct marshal_info *);
 size_t ctl_msg_recv_unserialized(uint8_t **, size_t *, enum hmsg_type, void **,
     struct marshal_info *);
+size_t ctl_msg_parse_unserialized(const uint8_t *, size_t, enum hmsg_type, void **,
+    struct marshal_info *, size_t *);
 
 #endif
@@ -59,21 +59,68 @@ lastchange(struct lldpd_port *port)
 /* -------------
   Helper functions to build header_*indexed_table() functions.
   Those functions keep an internal state. They are not reentrant!
+
+  Walking a table with GETNEXT requests would be quadratic if each request had
+  to enumerate all the entries to find the successor of the requested OID.
+  Therefore, each table gets a sorted index, built on first use and dropped
+  on any change to local ports or to neighbors (see
+  `agent_index_invalidate()`). Requests are then solved with a binary search.
 */
+#define HEADER_INDEX_MAX_LEN (5 + 16) /* Largest index is for remote addresses */
+struct header_entry {
+	oid index[HEADER_INDEX_MAX_LEN];
+	size_t len;
+	size_t order;		 /* Enumeration order, to break ties */
+	void *entity;		 /* Entity to return */
+	struct lldpd_port *port; /* Remote port the entity belongs to */
+};
+struct header_table {
+	unsigned int generation; /* Index is valid if equal to header_generation */
+	struct header_entry *entries;
+	size_t count;
+	size_t size;
+};
+enum {
+	HEADER_TABLE_PORT,
+	HEADER_TABLE_PMED_POLICY,
+	HEADER_TABLE_PMED_LOCATION,
+	HEADER_TABLE_TPR,
+	HEADER_TABLE_TPR_MED,
+	HEADER_TABLE_IP,
+	HEADER_TABLE_TPRIP,
+	HEADER_TABLE_TPRCUSTOM,
+	HEADER_TABLE_TPRMED_POLICY,
+	HEADER_TABLE_TPRMED_LOCATION,
+	HEADER_TABLE_PV,
+	HEADER_TABLE_TPRV,
+	HEADER_TABLE_PPPVID,
+	HEADER_TABLE_TPRPPVID,
+	HEADER_TABLE_PPI,
+	HEADER_TABLE_TPRPI,
+	HEADER_TABLE_LAST
+};
+static struct header_table header_tables[HEADER_TABLE_LAST];
+static unsigned int header_generation = 1;
+
 struct header_index {
 	struct variable *vp;
 	oid *name;	/* Requested/returned OID */
 	size_t *length; /* Length of above OID */
 	int exact;
-	oid best[MAX_OID_LEN]; /* Best OID */
-	size_t best_len;       /* Best OID length */
-	void *entity;	       /* Best entity */
+	struct header_table *table; /* Index of the table */
 };
 static struct header_index header_idx;
 
+/* Drop all indexes. To be called on any change to local ports or neighbors. */
+void
+agent_index_invalidate()
+{
+	header_generation++;
+}
+
 static int
 header_index_init(struct variable *vp, oid *name, size_t *length, int exact,
-    size_t *var_len, WriteMethod **write_method)
+    size_t *var_len, WriteMethod **write_method, int table)
 {
 	/* If the requested OID name is less than OID prefix we
 	   handle, adjust it to our prefix. */
@@ -96,41 +143,100 @@ header_index_init(struct variable *vp, oid *name, size_t *length, int exact,
 	header_idx.name = name;
 	header_idx.length = length;
 	header_idx.exact = exact;
-	header_idx.best_len = 0;
-	header_idx.entity = NULL;
+	header_idx.table = &header_tables[table];
 	return 1;
 }
 
+/* Return 1 if the index of the current table has to be built. In this case,
+ * all entries should be added with `header_index_add()`. */
 static int
-header_index_add(oid *index, size_t len, void *entity)
+header_index_build()
 {
-	int result;
-	oid *target;
-	size_t target_len;
+	if (header_idx.table->generation == header_generation) return 0;
+	header_idx.table->count = 0;
+	return 1;
+}
 
-	target = header_idx.name + header_idx.vp->namelen;
-	target_len = *header_idx.length - header_idx.vp->namelen;
-	if ((result = snmp_oid_compare(index, len, target, target_len)) < 0)
-		return 0; /* Too small. */
-	if (result == 0) return header_idx.exact;
-	if (header_idx.best_len == 0 ||
-	    (snmp_oid_compare(index, len, header_idx.best, header_idx.best_len) < 0)) {
-		memcpy(header_idx.best, index, sizeof(oid) * len);
-		header_idx.best_len = len;
-		header_idx.entity = entity;
+/* Add an entry to the index being built. `port` is the remote port the entity
+ * belongs to: the entry is skipped while the port is hidden. */
+static void
+header_index_add(oid *index, size_t len, void *entity, struct lldpd_port *port)
+{
+	struct header_table *table = header_idx.table;
+	struct header_entry *entries, *entry;
+	size_t size;
+
+	if (len > HEADER_INDEX_MAX_LEN) return;
+	if (table->count == table->size) {
+		size = table->size ? table->size * 2 : 16;
+		if ((entries = realloc(table->entries, size * sizeof(*entries))) ==
+		    NULL) {
+			log_warnx("snmp", "unable to grow index to %zu entries", size);
+			return;
+		}
+		table->entries = entries;
+		table->size = size;
 	}
-	return 0; /* No best match yet. */
+	entry = &table->entries[table->count];
+	memcpy(entry->index, index, sizeof(oid) * len);
+	entry->len = len;
+	entry->order = table->count++;
+	entry->entity = entity;
+	entry->port = port;
+}
+
+static int
+header_index_compare(const void *a, const void *b)
+{
+	const struct header_entry *ea = a, *eb = b;
+	int result = snmp_oid_compare(ea->index, ea->len, eb->index, eb->len);
+	if (result != 0) return result;
+	return (ea->order < eb->order) ? -1 : (ea->order > eb->order);
 }
 
 void *
 header_index_best()
 {
-	if (header_idx.entity == NULL) return NULL;
-	if (header_idx.exact) return NULL;
-	memcpy(header_idx.name + header_idx.vp->namelen, header_idx.best,
-	    sizeof(oid) * header_idx.best_len);
-	*header_idx.length = header_idx.vp->namelen + header_idx.best_len;
-	return header_idx.entity;
+	struct header_table *table = header_idx.table;
+	struct header_entry *entry;
+	oid *target;
+	size_t target_len, low, high, mid;
+
+	if (table->generation != header_generation) {
+		qsort(table->entries, table->count, sizeof(struct header_entry),
+		    header_index_compare);
+		table->generation = header_generation;
+	}
+
+	/* Search the first entry greater or equal to the requested index */
+	target = header_idx.name + header_idx.vp->namelen;
+	target_len = *header_idx.length - header_idx.vp->namelen;
+	low = 0;
+	high = table->count;
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		entry = &table->entries[mid];
+		if (snmp_oid_compare(entry->index, entry->len, target, target_len) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	for (; low < table->count; low++) {
+		entry = &table->entries[low];
+		if (entry->port && SMART_HIDDEN(entry->port)) continue;
+		if (snmp_oid_compare(entry->index, entry->len, target, target_len) ==
+		    0) {
+			if (header_idx.exact) return entry->entity;
+			continue;
+		}
+		if (header_idx.exact) return NULL;
+		memcpy(header_idx.name + header_idx.vp->namelen, entry->index,
+		    sizeof(oid) * entry->len);
+		*header_idx.length = header_idx.vp->namelen + entry->len;
+		return entry->entity;
+	}
+	return NULL;
 }
 /* ----------------------------- */
 
@@ -140,11 +246,13 @@ header_portindexed_table(struct variable *vp, oid *name, size_t *length, int exa
 {
 	struct lldpd_hardware *hardware;
 
-	if (!header_index_init(vp, name, length, exact, var_len, write_method))
+	if (!header_index_init(vp, name, length, exact, var_len, write_method,
+		HEADER_TABLE_PORT))
 		return NULL;
+	if (!header_index_build()) return header_index_best();
 	TAILQ_FOREACH (hardware, &scfg->g_hardware, h_entries) {
 		oid index[1] = { hardware->h_ifindex };
-		if (header_index_add(index, 1, hardware)) return hardware;
+		header_index_add(index, 1, hardware, NULL);
 	}
 	return header_index_best();
 }
@@ -158,16 +266,17 @@ header_pmedindexed_policy_table(struct variable *vp, oid *name, size_t *length,
 	int i;
 	oid index[2];
 
-	if (!header_index_init(vp, name, length, exact, var_len, write_method))
+	if (!header_index_init(vp, name, length, exact, var_len, write_method,
+		HEADER_TABLE_PMED_POLICY))
 		return NULL;
+	if (!header_index_build()) return header_index_best();
 	TAILQ_FOREACH (hardware, &scfg->g_hardware, h_entries) {
 		for (i = 0; i < LLDP_MED_APPTYPE_LAST; i++) {
 			if (hardware->h_lport.p_med_policy[i].type != i + 1) continue;
 			index[0] = hardware->h_ifindex;
 			index[1] = i + 1;
-			if (header_index_add(index, 2,
-				&hardware->h_lport.p_med_policy[i]))
-				return &hardware->h_lport.p_med_policy[i];
+			header_index_add(index, 2,
+			    &hardware->h_lport.p_med_policy[i], NULL);
 		}
 	}
 	return header_index_best();
@@ -181,17 +290,18 @@ header_pmedindexed_location_table(struct variable *vp, oid *name, size_t *length
 	int i;
 	oid index[2];
 
-	if (!header_index_init(vp, name, length, exact, var_len, write_method))
+	if (!header_index_init(vp, name, length, exact, var_len, write_method,
+		HEADER_TABLE_PMED_LOCATION))
 		return NULL;
+	if (!header_index_build()) return header_index_best();
 	TAILQ_FOREACH (hardware, &scfg->g_hardware, h_entries) {
 		for (i = 0; i < LLDP_MED_LOCFORMAT_LAST; i++) {
 			if (hardware->h_lport.p_med_location[i].format != i + 1)
 				continue;
 			index[0] = hardware->h_ifindex;
 			index[1] = i + 2;
-			if (header_index_add(index, 2,
-				&hardware->h_lport.p_med_location[i]))
-				return &hardware->h_lport.p_med_location[i];
+			header_index_add(index, 2,
+			    &hardware->h_lport.p_med_location[i], NULL);
 		}
 	}
 	return header_index_best();
@@ -206,18 +316,19 @@ header_tprindexed_table(struct variable *vp, oid *name, size_t *length, int exac
 	struct lldpd_port *port;
 	oid index[3];
 
-	if (!header_index_init(vp, name, length, exact, var_len, write_method))
+	if (!header_index_init(vp, name, length, exact, var_len, write_method,
+		withmed ? HEADER_TABLE_TPR_MED : HEADER_TABLE_TPR))
 		return NULL;
+	if (!header_index_build()) return header_index_best();
 	TAILQ_FOREACH (hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH (port, &hardware->h_rports, p_entries) {
-			if (SMART_HIDDEN(port)) continue;
 #ifdef ENABLE_LLDPMED
 			if (withmed && !port->p_chassis->c_med_cap_available) continue;
 #endif
 			index[0] = lastchange(port);
 			index[1] = hardware->h_ifindex;
 			index[2] = port->p_chassis->c_index;
-			if (header_index_add(index, 3, port)) return port;
+			header_index_add(index, 3, port, port);
 		}
 	}
 	return header_index_best();
@@ -231,8 +342,10 @@ header_ipindexed_table(struct variable *vp, oid *name, size_t *length, int exact
 	struct lldpd_mgmt *mgmt;
 	oid index[2 + 16];
 
-	if (!header_index_init(vp, name, length, exact, var_len, write_method))
+	if (!header_index_init(vp, name, length, exact, var_len, write_method,
+		HEADER_TABLE_IP))
 		return NULL;
+	if (!header_index_build()) return header_index_best();
 	TAILQ_FOREACH (mgmt, &chassis->c_mgmt, m_entries) {
 		int i;
 		switch (mgmt->m_family) {
@@ -249,7 +362,7 @@ header_ipindexed_table(struct variable *vp, oid *name, size_t *length, int exact
 		if (index[1] > sizeof(index) - 2) continue; /* Odd... */
 		for (i = 0; i < index[1]; i++)
 			index[i + 2] = mgmt->m_addr.octets[i];
-		if (header_index_add(index, 2 + index[1], mgmt)) return mgmt;
+		header_index_add(index, 2 + index[1], mgmt, NULL);
 	}
 
 	return header_index_best();
@@ -264,11 +377,12 @@ header_tpripindexed_table(struct variable *vp, oid *name, size_t *length, int ex
 	struct lldpd_mgmt *mgmt;
 	oid index[5 + 16];
 
-	if (!header_index_init(vp, name, length, exact, var_len, write_method))
+	if (!header_index_init(vp, name, length, exact, var_len, write_method,
+		HEADER_TABLE_TPRIP))
 		return NULL;
+	if (!header_index_build()) return header_index_best();
 	TAILQ_FOREACH (hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH (port, &hardware->h_rports, p_entries) {
-			if (SMART_HIDDEN(port)) continue;
 			TAILQ_FOREACH (mgmt, &port->p_chassis->c_mgmt, m_entries) {
 				int i;
 				index[0] = lastchange(port);
@@ -288,8 +402,7 @@ header_tpripindexed_table(struct variable *vp, oid *name, size_t *length, int ex
 				if (index[4] > sizeof(index) - 5) continue; /* Odd... */
 				for (i = 0; i < index[4]; i++)
 					index[i + 5] = mgmt->m_addr.octets[i];
-				if (header_index_add(index, 5 + index[4], mgmt))
-					return mgmt;
+				header_index_add(index, 5 + index[4], mgmt, port);
 			}
 		}
 	}
@@ -307,11 +420,12 @@ header_tprcustomindexed_table(struct variable *vp, oid *name, size_t *length, in
 	oid index[8];
 	oid idx;
 
-	if (!header_index_init(vp, name, length, exact, var_len, write_method))
+	if (!header_index_init(vp, name, length, exact, var_len, write_method,
+		HEADER_TABLE_TPRCUSTOM))
 		return NULL;
+	if (!header_index_build()) return header_index_best();
 	TAILQ_FOREACH (hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH (port, &hardware->h_rports, p_entries) {
-			if (SMART_HIDDEN(port)) continue;
 			idx = 1;
 			TAILQ_FOREACH (custom, &port->p_custom_list, next) {
 				index[0] = lastchange(port);
@@ -322,7 +436,7 @@ header_tprcustomindexed_table(struct variable *vp, oid *name, size_t *length, in
 				index[5] = custom->oui[2];
 				index[6] = custom->subtype;
 				index[7] = idx++;
-				if (header_index_add(index, 8, custom)) return custom;
+				header_index_add(index, 8, custom, port);
 			}
 		}
 	}
@@ -342,11 +456,13 @@ header_tprmedindexed_table(struct variable *vp, oid *name, size_t *length, int e
 	int j;
 	oid index[4];
 
-	if (!header_index_init(vp, name, length, exact, var_len, write_method))
+	if (!header_index_init(vp, name, length, exact, var_len, write_method,
+		variant == TPR_VARIANT_MED_POLICY ? HEADER_TABLE_TPRMED_POLICY :
+						    HEADER_TABLE_TPRMED_LOCATION))
 		return NULL;
+	if (!header_index_build()) return header_index_best();
 	TAILQ_FOREACH (hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH (port, &hardware->h_rports, p_entries) {
-			if (SMART_HIDDEN(port)) continue;
 			if (!port->p_chassis->c_med_cap_available) continue;
 			switch (variant) {
 			case TPR_VARIANT_MED_POLICY:
@@ -357,9 +473,8 @@ header_tprmedindexed_table(struct variable *vp, oid *name, size_t *length, int e
 					index[1] = hardware->h_ifindex;
 					index[2] = port->p_chassis->c_index;
 					index[3] = j + 1;
-					if (header_index_add(index, 4,
-						&port->p_med_policy[j]))
-						return &port->p_med_policy[j];
+					header_index_add(index, 4,
+					    &port->p_med_policy[j], port);
 				}
 				break;
 			case TPR_VARIANT_MED_LOCATION:
@@ -370,9 +485,8 @@ header_tprmedindexed_table(struct variable *vp, oid *name, size_t *length, int e
 					index[1] = hardware->h_ifindex;
 					index[2] = port->p_chassis->c_index;
 					index[3] = j + 2;
-					if (header_index_add(index, 4,
-						&port->p_med_location[j]))
-						return &port->p_med_location[j];
+					header_index_add(index, 4,
+					    &port->p_med_location[j], port);
 				}
 				break;
 			}
@@ -390,12 +504,14 @@ header_pvindexed_table(struct variable *vp, oid *name, size_t *length, int exact
 	struct lldpd_hardware *hardware;
 	struct lldpd_vlan *vlan;
 
-	if (!header_index_init(vp, name, length, exact, var_len, write_method))
+	if (!header_index_init(vp, name, length, exact, var_len, write_method,
+		HEADER_TABLE_PV))
 		return NULL;
+	if (!header_index_build()) return header_index_best();
 	TAILQ_FOREACH (hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH (vlan, &hardware->h_lport.p_vlans, v_entries) {
 			oid index[2] = { hardware->h_ifindex, vlan->v_vid };
-			if (header_index_add(index, 2, vlan)) return vlan;
+			header_index_add(index, 2, vlan, NULL);
 		}
 	}
 	return header_index_best();
@@ -409,15 +525,16 @@ header_tprvindexed_table(struct variable *vp, oid *name, size_t *length, int exa
 	struct lldpd_port *port;
 	struct lldpd_vlan *vlan;
 
-	if (!header_index_init(vp, name, length, exact, var_len, write_method))
+	if (!header_index_init(vp, name, length, exact, var_len, write_method,
+		HEADER_TABLE_TPRV))
 		return NULL;
+	if (!header_index_build()) return header_index_best();
 	TAILQ_FOREACH (hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH (port, &hardware->h_rports, p_entries) {
-			if (SMART_HIDDEN(port)) continue;
 			TAILQ_FOREACH (vlan, &port->p_vlans, v_entries) {
 				oid index[4] = { lastchange(port), hardware->h_ifindex,
 					port->p_chassis->c_index, vlan->v_vid };
-				if (header_index_add(index, 4, vlan)) return vlan;
+				header_index_add(index, 4, vlan, port);
 			}
 		}
 	}
@@ -431,12 +548,14 @@ header_pppvidindexed_table(struct variable *vp, oid *name, size_t *length, int e
 	struct lldpd_hardware *hardware;
 	struct lldpd_ppvid *ppvid;
 
-	if (!header_index_init(vp, name, length, exact, var_len, write_method))
+	if (!header_index_init(vp, name, length, exact, var_len, write_method,
+		HEADER_TABLE_PPPVID))
 		return NULL;
+	if (!header_index_build()) return header_index_best();
 	TAILQ_FOREACH (hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH (ppvid, &hardware->h_lport.p_ppvids, p_entries) {
 			oid index[2] = { hardware->h_ifindex, ppvid->p_ppvid };
-			if (header_index_add(index, 2, ppvid)) return ppvid;
+			header_index_add(index, 2, ppvid, NULL);
 		}
 	}
 	return header_index_best();
@@ -450,15 +569,16 @@ header_tprppvidindexed_table(struct variable *vp, oid *name, size_t *length, int
 	struct lldpd_port *port;
 	struct lldpd_ppvid *ppvid;
 
-	if (!header_index_init(vp, name, length, exact, var_len, write_method))
+	if (!header_index_init(vp, name, length, exact, var_len, write_method,
+		HEADER_TABLE_TPRPPVID))
 		return NULL;
+	if (!header_index_build()) return header_index_best();
 	TAILQ_FOREACH (hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH (port, &hardware->h_rports, p_entries) {
-			if (SMART_HIDDEN(port)) continue;
 			TAILQ_FOREACH (ppvid, &port->p_ppvids, p_entries) {
 				oid index[4] = { lastchange(port), hardware->h_ifindex,
 					port->p_chassis->c_index, ppvid->p_ppvid };
-				if (header_index_add(index, 4, ppvid)) return ppvid;
+				header_index_add(index, 4, ppvid, port);
 			}
 		}
 	}
@@ -472,14 +592,16 @@ header_ppiindexed_table(struct variable *vp, oid *name, size_t *length, int exac
 	struct lldpd_hardware *hardware;
 	struct lldpd_pi *pi;
 
-	if (!header_index_init(vp, name, length, exact, var_len, write_method))
+	if (!header_index_init(vp, name, length, exact, var_len, write_method,
+		HEADER_TABLE_PPI))
 		return NULL;
+	if (!header_index_build()) return header_index_best();
 	TAILQ_FOREACH (hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH (pi, &hardware->h_lport.p_pids, p_entries) {
 			oid index[2] = { hardware->h_ifindex,
 				frame_checksum((const u_char *)pi->p_pi, pi->p_pi_len,
 				    0) };
-			if (header_index_add(index, 2, pi)) return pi;
+			header_index_add(index, 2, pi, NULL);
 		}
 	}
 	return header_index_best();
@@ -493,17 +615,18 @@ header_tprpiindexed_table(struct variable *vp, oid *name, size_t *length, int ex
 	struct lldpd_port *port;
 	struct lldpd_pi *pi;
 
-	if (!header_index_init(vp, name, length, exact, var_len, write_method))
+	if (!header_index_init(vp, name, length, exact, var_len, write_method,
+		HEADER_TABLE_TPRPI))
 		return NULL;
+	if (!header_index_build()) return header_index_best();
 	TAILQ_FOREACH (hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH (port, &hardware->h_rports, p_entries) {
-			if (SMART_HIDDEN(port)) continue;
 			TAILQ_FOREACH (pi, &port->p_pids, p_entries) {
 				oid index[4] = { lastchange(port), hardware->h_ifindex,
 					port->p_chassis->c_index,
 					frame_checksum((const u_char *)pi->p_pi,
 					    pi->p_pi_len, 0) };
-				if (header_index_add(index, 4, pi)) return pi;
+				header_index_add(index, 4, pi, port);
 			}
 		}
 	}
@@ -1786,6 +1909,7 @@ agent_notify(struct lldpd_hardware *hardware, int type, struct lldpd_port *rport
 
 	netsnmp_variable_list *notification_vars = NULL;
 
+	agent_index_invalidate();
 	if (!hardware->h_cfg->g_snmp) return;
 
 	switch (type) {
@@ -1933,7 +2057,12 @@ agent_init(struct lldpd *cfg, const char *agentx)
 void
 agent_shutdown()
 {
+	int i;
 	log_debug("snmp", "agent shutdown");
 	unregister_sysORTable(lldp_oid, OID_LENGTH(lldp_oid));
 	snmp_shutdown("lldpAgent");
+	for (i = 0; i < HEADER_TABLE_LAST; i++) {
+		free(header_tables[i].entries);
+		memset(&header_tables[i], 0, sizeof(header_tables[i]));
+	}
 }
@@ -22,7 +22,7 @@
 
 static ssize_t
 client_handle_none(struct lldpd *cfg, enum hmsg_type *type, void *input, int input_len,
-    void **output, int *subscribed)
+    void **output, struct lldpd_subscription *subscription)
 {
 	log_info("rpc", "received noop request from client");
 	*type = NONE;
@@ -32,7 +32,7 @@ client_handle_none(struct lldpd *cfg, enum hmsg_type *type, void *input, int inp
 /* Return the global configuration */
 static ssize_t
 client_handle_get_configuration(struct lldpd *cfg, enum hmsg_type *type, void *input,
-    int input_len, void **output, int *subscribed)
+    int input_len, void **output, struct lldpd_subscription *subscription)
 {
 	ssize_t output_len;
 	log_debug("rpc", "client requested configuration");
@@ -54,7 +54,7 @@ xstrdup(const char *str)
 /* Change the global configuration */
 static ssize_t
 client_handle_set_configuration(struct lldpd *cfg, enum hmsg_type *type, void *input,
-    int input_len, void **output, int *subscribed)
+    int input_len, void **output, struct lldpd_subscription *subscription)
 {
 	struct lldpd_config *config;
 
@@ -138,6 +138,7 @@ client_handle_set_configuration(struct lldpd *cfg, enum hmsg_type *type, void *i
 		    config->c_iface_pattern ? config->c_iface_pattern : "(NULL)");
 		free(cfg->g_config.c_iface_pattern);
 		cfg->g_config.c_iface_pattern = xstrdup(config->c_iface_pattern);
+		lldpd_update_patterns(cfg);
 		levent_update_now(cfg);
 	}
 	if (CHANGED_STR(c_perm_ifaces)) {
@@ -145,6 +146,7 @@ client_handle_set_configuration(struct lldpd *cfg, enum hmsg_type *type, void *i
 		    config->c_perm_ifaces ? config->c_perm_ifaces : "(NULL)");
 		free(cfg->g_config.c_perm_ifaces);
 		cfg->g_config.c_perm_ifaces = xstrdup(config->c_perm_ifaces);
+		lldpd_update_patterns(cfg);
 		levent_update_now(cfg);
 	}
 	if (CHANGED_STR(c_mgmt_pattern)) {
@@ -152,6 +154,7 @@ client_handle_set_configuration(struct lldpd *cfg, enum hmsg_type *type, void *i
 		    config->c_mgmt_pattern ? config->c_mgmt_pattern : "(NULL)");
 		free(cfg->g_config.c_mgmt_pattern);
 		cfg->g_config.c_mgmt_pattern = xstrdup(config->c_mgmt_pattern);
+		lldpd_update_patterns(cfg);
 		levent_update_now(cfg);
 	}
 	if (CHANGED_STR(c_cid_string)) {
@@ -201,6 +204,24 @@ client_handle_set_configuration(struct lldpd *cfg, enum hmsg_type *type, void *i
 		cfg->g_config.c_promisc = config->c_promisc;
 		levent_update_now(cfg);
 	}
+	if (CHANGED(c_rx_ring)) {
+		log_debug("rpc", "%s memory-mapped ring for reception",
+		    config->c_rx_ring ? "enable" : "disable");
+		cfg->g_config.c_rx_ring = config->c_rx_ring;
+		levent_update_now(cfg);
+	}
+	if (CHANGED(c_shared_socket)) {
+		log_debug("rpc", "%s socket shared by all ports",
+		    config->c_shared_socket ? "enable" : "disable");
+		cfg->g_config.c_shared_socket = config->c_shared_socket;
+		levent_update_now(cfg);
+	}
+	if (CHANGED(c_snapshot)) {
+		log_debug("rpc", "%s snapshot of neighbors",
+		    config->c_snapshot ? "enable" : "disable");
+		cfg->g_config.c_snapshot = config->c_snapshot;
+		client_publish_snapshot(cfg);
+	}
 	if (CHANGED(c_cap_advertise)) {
 		log_debug("rpc", "%s chassis capabilities advertisement",
 		    config->c_cap_advertise ? "enable" : "disable");
@@ -234,6 +255,7 @@ client_handle_set_configuration(struct lldpd *cfg, enum hmsg_type *type, void *i
 		}
 	}
 
+	cfg->g_config_generation++;
 	lldpd_config_cleanup(config);
 	free(config);
 
@@ -246,7 +268,7 @@ client_handle_set_configuration(struct lldpd *cfg, enum hmsg_type *type, void *i
 */
 static ssize_t
 client_handle_get_interfaces(struct lldpd *cfg, enum hmsg_type *type, void *input,
-    int input_len, void **output, int *subscribed)
+    int input_len, void **output, struct lldpd_subscription *subscription)
 {
 	struct lldpd_interface *iff, *iff_next;
 	struct lldpd_hardware *hardware;
@@ -288,7 +310,7 @@ client_handle_get_interfaces(struct lldpd *cfg, enum hmsg_type *type, void *inpu
  */
 static ssize_t
 client_handle_set_local_chassis(struct lldpd *cfg, enum hmsg_type *type, void *input,
-    int input_len, void **output, int *subscribed)
+    int input_len, void **output, struct lldpd_subscription *subscription)
 {
 	struct lldpd_chassis *chassis = NULL;
 	struct lldpd_chassis *local_chassis = NULL;
@@ -364,6 +386,7 @@ client_handle_set_local_chassis(struct lldpd *cfg, enum hmsg_type *type, void *i
 #endif
 
 	lldpd_chassis_cleanup(chassis, 1);
+	local_chassis->c_generation++;
 
 	ssize_t output_len = lldpd_chassis_serialize(local_chassis, output);
 	if (output_len <= 0) {
@@ -380,7 +403,7 @@ client_handle_set_local_chassis(struct lldpd *cfg, enum hmsg_type *type, void *i
 */
 static ssize_t
 client_handle_get_local_chassis(struct lldpd *cfg, enum hmsg_type *type, void *input,
-    int input_len, void **output, int *subscribed)
+    int input_len, void **output, struct lldpd_subscription *subscription)
 {
 	struct lldpd_chassis *chassis = LOCAL_CHASSIS(cfg);
 	ssize_t output_len;
@@ -401,7 +424,7 @@ client_handle_get_local_chassis(struct lldpd *cfg, enum hmsg_type *type, void *i
 */
 static ssize_t
 client_handle_get_interface(struct lldpd *cfg, enum hmsg_type *type, void *input,
-    int input_len, void **output, int *subscribed)
+    int input_len, void **output, struct lldpd_subscription *subscription)
 {
 	char *name;
 	struct lldpd_hardware *hardware;
@@ -433,13 +456,177 @@ client_handle_get_interface(struct lldpd *cfg, enum hmsg_type *type, void *input
 	return 0;
 }
 
+/* Return all available information related to an interface, unless it did
+   not change since the generation known by the client
+   Input:  name of the interface and known generation (lldpd_interface_request)
+   Output: Generation and, if modified, the interface (lldpd_interface_answer)
+*/
+static ssize_t
+client_handle_get_interface_if_modified(struct lldpd *cfg, enum hmsg_type *type,
+    void *input, int input_len, void **output,
+    struct lldpd_subscription *subscription)
+{
+	struct lldpd_interface_request *request;
+	struct lldpd_interface_answer answer = { .hardware = NULL };
+	struct lldpd_hardware *hardware;
+	ssize_t output_len = 0;
+
+	if (lldpd_interface_request_unserialize(input, input_len, &request) <= 0) {
+		*type = NONE;
+		return 0;
+	}
+
+	log_debug("rpc", "client request interface %s if modified since %u",
+	    request->ifname, request->generation);
+	TAILQ_FOREACH (hardware, &cfg->g_hardware, h_entries)
+		if (!strcmp(hardware->h_ifname, request->ifname)) break;
+	if (hardware == NULL) {
+		log_warnx("rpc", "no interface %s found", request->ifname);
+		goto end;
+	}
+
+	answer.generation = lldpd_hardware_generation(hardware);
+	if (request->generation == 0 || request->generation != answer.generation)
+		answer.hardware = hardware;
+	else
+		log_debug("rpc", "interface %s not modified", hardware->h_ifname);
+	output_len = lldpd_interface_answer_serialize(&answer, output);
+
+end:
+	free(request->ifname);
+	free(request);
+	if (output_len <= 0) {
+		output_len = 0;
+		*type = NONE;
+	}
+	return output_len;
+}
+
+/* Skip neighbors not using the protocol pointed by `arg`. */
+static void *
+client_filter_neighbors(struct marshal_info *mi, void *object, void *arg)
+{
+	struct lldpd_port *port = object;
+	int protocol = *(int *)arg;
+	if (mi != &MARSHAL_INFO(lldpd_port)) return object;
+	while (port != NULL && port->p_protocol != protocol)
+		port = TAILQ_NEXT(port, p_entries);
+	return port;
+}
+
+/* Serialize an interface with only the neighbors using the given protocol. */
+static ssize_t
+client_serialize_neighbors(struct lldpd_hardware *hardware, int protocol,
+    void **output)
+{
+	struct lldpd_neighbors_record record = { .hardware = hardware };
+	if (protocol == 0) return lldpd_neighbors_record_serialize(&record, output);
+	return marshal_serialize_filtered(lldpd_neighbors_record, &record, output,
+	    client_filter_neighbors, &protocol);
+}
+
+/* Stream all interfaces with their neighbors.
+   Input:  filter on interfaces and neighbors (lldpd_neighbors_filter)
+   Output: one message per interface (lldpd_neighbors_record), then a record
+           without hardware
+*/
+static ssize_t
+client_handle_get_neighbors(struct lldpd *cfg, void *input, int input_len,
+    ssize_t (*send)(void *, int, void *, size_t), void *out)
+{
+	struct lldpd_neighbors_filter *filter = NULL;
+	struct lldpd_neighbors_record end = { .hardware = NULL };
+	struct lldpd_hardware *hardware;
+	struct pattern_set *ifnames = NULL;
+	void *output;
+	ssize_t output_len, sent = 0;
+
+	if (lldpd_neighbors_filter_unserialize(input, input_len, &filter) <= 0)
+		return send(out, NONE, NULL, 0);
+
+	log_debug("rpc", "client request all neighbors (interfaces: %s, protocol: %d)",
+	    filter->ifnames ? filter->ifnames : "all", filter->protocol);
+	ifnames = pattern_compile(filter->ifnames);
+	TAILQ_FOREACH (hardware, &cfg->g_hardware, h_entries) {
+		if (filter->ifnames &&
+		    pattern_set_match(ifnames, hardware->h_ifname, 0) ==
+			PATTERN_MATCH_DENIED)
+			continue;
+		output = NULL;
+		output_len =
+		    client_serialize_neighbors(hardware, filter->protocol, &output);
+		if (output_len <= 0) {
+			log_warnx("rpc", "unable to serialize interface %s",
+			    hardware->h_ifname);
+			free(output);
+			continue;
+		}
+		sent = send(out, GET_NEIGHBORS, output, output_len);
+		free(output);
+		if (sent == -1) goto end;
+	}
+
+	output = NULL;
+	output_len = lldpd_neighbors_record_serialize(&end, &output);
+	if (output_len <= 0)
+		sent = send(out, NONE, NULL, 0);
+	else
+		sent = send(out, GET_NEIGHBORS, output, output_len);
+	free(output);
+
+end:
+	pattern_set_free(ifnames);
+	free(filter->ifnames);
+	free(filter);
+	return sent;
+}
+
+/* Publish all interfaces with their neighbors in the snapshot file. The
+   content is the same as the answer to GET_NEIGHBORS without filter. When
+   snapshots are disabled, any previous snapshot is withdrawn. */
+void
+client_publish_snapshot(struct lldpd *cfg)
+{
+	struct lldpd_neighbors_record record = { .hardware = NULL };
+	struct lldpd_hardware *hardware;
+	uint8_t *output = NULL;
+	size_t output_len = 0;
+
+	if (cfg->g_snapshot.s_fd == -1) return;
+	if (!cfg->g_config.c_snapshot) {
+		if (cfg->g_snapshot.s_map != NULL)
+			snapshot_update(&cfg->g_snapshot, NULL, 0);
+		return;
+	}
+
+	log_debug("rpc", "publish snapshot of neighbors");
+	TAILQ_FOREACH (hardware, &cfg->g_hardware, h_entries) {
+		record.hardware = hardware;
+		if (ctl_msg_send_unserialized(&output, &output_len, GET_NEIGHBORS,
+			&record, &MARSHAL_INFO(lldpd_neighbors_record)) == -1) {
+			log_warnx("rpc", "unable to serialize interface %s",
+			    hardware->h_ifname);
+			goto end;
+		}
+	}
+	record.hardware = NULL;
+	if (ctl_msg_send_unserialized(&output, &output_len, GET_NEIGHBORS, &record,
+		&MARSHAL_INFO(lldpd_neighbors_record)) == -1) {
+		log_warnx("rpc", "unable to serialize snapshot of neighbors");
+		goto end;
+	}
+	snapshot_update(&cfg->g_snapshot, output, output_len);
+end:
+	free(output);
+}
+
 /* Return all available information related to an interface
    Input:  name of the interface (serialized)
    Output: Information about the interface (lldpd_hardware)
 */
 static ssize_t
 client_handle_get_default_port(struct lldpd *cfg, enum hmsg_type *type, void *input,
-    int input_len, void **output, int *subscribed)
+    int input_len, void **output, struct lldpd_subscription *subscription)
 {
 	log_debug("rpc", "client request the default local port");
 	ssize_t output_len = lldpd_port_serialize(cfg->g_default_local_port, output);
@@ -575,6 +762,7 @@ _client_handle_set_port(struct lldpd *cfg, struct lldpd_port *port,
 		}
 	}
 #endif
+	port->p_generation++;
 	return 0;
 }
 
@@ -584,7 +772,7 @@ _client_handle_set_port(struct lldpd *cfg, struct lldpd_port *port,
 */
 static ssize_t
 client_handle_set_port(struct lldpd *cfg, enum hmsg_type *type, void *input,
-    int input_len, void **output, int *subscribed)
+    int input_len, void **output, struct lldpd_subscription *subscription)
 {
 	int ret = 0;
 	struct lldpd_port_set *set = NULL;
@@ -647,21 +835,45 @@ set_port_finished:
 	return 0;
 }
 
-/* Register subscribtion to neighbor changes */
+/* Register subscribtion to neighbor changes. The client may ask for changes to
+ * be coalesced or for unchanged sections to be omitted. */
 static ssize_t
 client_handle_subscribe(struct lldpd *cfg, enum hmsg_type *type, void *input,
-    int input_len, void **output, int *subscribed)
+    int input_len, void **output, struct lldpd_subscription *subscription)
 {
-	log_debug("rpc", "client subscribe to changes");
-	*subscribed = 1;
+	struct lldpd_subscription *request = NULL;
+
+	if (input_len > 0) {
+		if (lldpd_subscription_unserialize(input, input_len, &request) <= 0) {
+			*type = NONE;
+			return 0;
+		}
+		subscription->window = request->window;
+		subscription->queue = request->queue;
+		subscription->delta = !!request->delta;
+		free(request);
+		if (subscription->window < 0) subscription->window = 0;
+		if (subscription->window > CLIENT_SUBSCRIPTION_MAX_WINDOW)
+			subscription->window = CLIENT_SUBSCRIPTION_MAX_WINDOW;
+		if (subscription->queue <= 0 ||
+		    subscription->queue > CLIENT_SUBSCRIPTION_MAX_QUEUE)
+			subscription->queue = CLIENT_SUBSCRIPTION_MAX_QUEUE;
+	}
+	log_debug("rpc",
+	    "client subscribe to changes (coalescing window: %d ms, delta: %s)",
+	    subscription->window, subscription->delta ? "yes" : "no");
+	subscription->subscribed = 1;
 	return 0;
 }
 
 struct client_handle {
 	enum hmsg_type type;
 	const char *name;
-	ssize_t (
-	    *handle)(struct lldpd *, enum hmsg_type *, void *, int, void **, int *);
+	ssize_t (*handle)(struct lldpd *, enum hmsg_type *, void *, int, void **,
+	    struct lldpd_subscription *);
+	/* Handlers answering with several messages send them themselves */
+	ssize_t (*stream)(struct lldpd *, void *, int,
+	    ssize_t (*)(void *, int, void *, size_t), void *);
 };
 
 static struct client_handle client_handles[] = { { NONE, "None", client_handle_none },
@@ -673,22 +885,28 @@ static struct client_handle client_handles[] = { { NONE, "None", client_handle_n
 	{ SET_CHASSIS, "Set local chassis", client_handle_set_local_chassis },
 	{ GET_CHASSIS, "Get local chassis", client_handle_get_local_chassis },
 	{ SET_PORT, "Set port", client_handle_set_port },
-	{ SUBSCRIBE, "Subscribe", client_handle_subscribe }, { 0, NULL } };
+	{ SUBSCRIBE, "Subscribe", client_handle_subscribe },
+	{ GET_NEIGHBORS, "Get neighbors", NULL, client_handle_get_neighbors },
+	{ GET_INTERFACE_IF_MODIFIED, "Get interface if modified",
+	    client_handle_get_interface_if_modified },
+	{ 0, NULL } };
 
 int
 client_handle_client(struct lldpd *cfg, ssize_t (*send)(void *, int, void *, size_t),
-    void *out, enum hmsg_type type, void *buffer, size_t n, int *subscribed)
+    void *out, enum hmsg_type type, void *buffer, size_t n,
+    struct lldpd_subscription *subscription)
 {
 	struct client_handle *ch;
 	void *answer;
 	ssize_t len, sent;
 
 	log_debug("rpc", "handle client request");
-	for (ch = client_handles; ch->handle != NULL; ch++) {
+	for (ch = client_handles; ch->name != NULL; ch++) {
 		if (ch->type == type) {
 			TRACE(LLDPD_CLIENT_REQUEST(ch->name));
+			if (ch->stream) return ch->stream(cfg, buffer, n, send, out);
 			answer = NULL;
-			len = ch->handle(cfg, &type, buffer, n, &answer, subscribed);
+			len = ch->handle(cfg, &type, buffer, n, &answer, subscription);
 			sent = send(out, type, answer, len);
 			free(answer);
 			return sent;
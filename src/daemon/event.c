@@ -229,20 +229,66 @@ levent_snmp_update(struct lldpd *cfg)
 }
 #endif /* USE_SNMP */
 
+/* Coalesced changes are not sent while more than this is waiting to be written
+ * to the client. */
+#define LEVENT_CTL_BACKLOG (4 * HMSG_MAX_SIZE)
+/* Requests from clients are small. Chunked ones cannot be larger than this. */
+#define LEVENT_CTL_MAX_REQUEST (4 * HMSG_MAX_SIZE)
+
 struct lldpd_one_client {
 	TAILQ_ENTRY(lldpd_one_client) next;
 	struct lldpd *cfg;
 	struct bufferevent *bev;
-	int subscribed; /* Is this client subscribed to changes? */
+	struct lldpd_subscription subscription; /* Subscription to changes */
+	int chunked;		     /* A chunked message is being received */
+	enum hmsg_type pending_type; /* Type of this message */
+	void *pending;		     /* Chunks of the message being received */
+	size_t pending_len;	     /* Length of the chunks received so far */
+	int receiving;		     /* A request is being handled */
+	int dead;		     /* Unable to send to the client anymore */
+
+	/* Changes coalesced for this client */
+	struct lldpd_neighbor_changes batch;
+	struct hash_table batch_index; /* Changes by interface and MSAP */
+	int batch_count;
+	struct event *batch_timer;
 };
 TAILQ_HEAD(, lldpd_one_client) lldpd_clients;
 
+static void
+levent_ctl_free_change(struct lldpd_neighbor_change *change)
+{
+	lldpd_chassis_cleanup(change->neighbor->p_chassis, 1);
+	lldpd_port_cleanup(change->neighbor, 1);
+	free(change->neighbor);
+	free(change->ifname);
+	free(change);
+}
+
+static void
+levent_ctl_clear_batch(struct lldpd_one_client *client)
+{
+	struct lldpd_neighbor_change *change, *change_next;
+	for (change = TAILQ_FIRST(&client->batch.changes); change;
+	     change = change_next) {
+		change_next = TAILQ_NEXT(change, c_entries);
+		levent_ctl_free_change(change);
+	}
+	TAILQ_INIT(&client->batch.changes);
+	client->batch.overflow = 0;
+	client->batch_count = 0;
+	hash_free(&client->batch_index);
+}
+
 static void
 levent_ctl_free_client(struct lldpd_one_client *client)
 {
 	if (client && client->bev) bufferevent_free(client->bev);
 	if (client) {
 		TAILQ_REMOVE(&lldpd_clients, client, next);
+		if (client->batch_timer) event_free(client->batch_timer);
+		levent_ctl_clear_batch(client);
+		free(client->pending);
 		free(client);
 	}
 }
@@ -257,60 +303,256 @@ levent_ctl_close_clients()
 	}
 }
 
+/* Free a client marked as dead by levent_ctl_send(). When one of its requests
+ * is being handled, levent_ctl_recv() frees it once done. */
+static void
+levent_ctl_reap_client(struct lldpd_one_client *client)
+{
+	if (client->dead && !client->receiving) levent_ctl_free_client(client);
+}
+
+/* Send a message to a client. On error, the client is marked as dead and has
+ * to be released with levent_ctl_reap_client() by the caller. */
 static ssize_t
 levent_ctl_send(struct lldpd_one_client *client, int type, void *data, size_t len)
 {
 	struct bufferevent *bev = client->bev;
-	struct hmsg_header hdr = { .len = len, .type = type };
+	struct hmsg_header hdr = { .type = type };
+	size_t offset = 0;
+	if (client->dead) return -1;
 	bufferevent_disable(bev, EV_WRITE);
-	if (bufferevent_write(bev, &hdr, sizeof(struct hmsg_header)) == -1 ||
-	    (len > 0 && bufferevent_write(bev, data, len) == -1)) {
-		log_warnx("event", "unable to create answer to client");
-		levent_ctl_free_client(client);
-		return -1;
-	}
+	do {
+		hdr.len = (len - offset > HMSG_MAX_SIZE) ? HMSG_MAX_SIZE : len - offset;
+		hdr.flags = (offset + hdr.len < len) ? HMSG_MORE : 0;
+		if (bufferevent_write(bev, &hdr, sizeof(struct hmsg_header)) == -1 ||
+		    (hdr.len > 0 &&
+			bufferevent_write(bev, (char *)data + offset, hdr.len) == -1)) {
+			log_warnx("event", "unable to create answer to client");
+			client->dead = 1;
+			return -1;
+		}
+		offset += hdr.len;
+	} while (offset < len);
 	bufferevent_enable(bev, EV_WRITE);
 	return len;
 }
 
+/* Hash of a change: interface name and MSAP of the neighbor. */
+static u_int32_t
+levent_ctl_change_hash(struct lldpd_neighbor_change *change)
+{
+	struct lldpd_port *port = change->neighbor;
+	struct lldpd_chassis *chassis = port->p_chassis;
+	u_int8_t key[] = { port->p_protocol, chassis->c_id_subtype,
+		port->p_id_subtype };
+	u_int32_t hash = hash_bytes(HASH_INIT, change->ifname, strlen(change->ifname));
+	hash = hash_bytes(hash, key, sizeof(key));
+	hash = hash_bytes(hash, chassis->c_id, chassis->c_id_len);
+	return hash_bytes(hash, port->p_id, port->p_id_len);
+}
+
+static struct lldpd_neighbor_change *
+levent_ctl_change_find(struct lldpd_one_client *client,
+    struct lldpd_neighbor_change *change, u_int32_t hash)
+{
+	struct hash_entry *entry;
+	struct lldpd_port *port = change->neighbor, *oport;
+	HASH_FOREACH (entry, &client->batch_index, hash) {
+		struct lldpd_neighbor_change *ochange =
+		    HASH_ENTRY(entry, struct lldpd_neighbor_change, c_hentry);
+		oport = ochange->neighbor;
+		if (!strcmp(ochange->ifname, change->ifname) &&
+		    oport->p_protocol == port->p_protocol &&
+		    oport->p_id_subtype == port->p_id_subtype &&
+		    oport->p_id_len == port->p_id_len &&
+		    !memcmp(oport->p_id, port->p_id, port->p_id_len) &&
+		    oport->p_chassis->c_id_subtype == port->p_chassis->c_id_subtype &&
+		    oport->p_chassis->c_id_len == port->p_chassis->c_id_len &&
+		    !memcmp(oport->p_chassis->c_id, port->p_chassis->c_id,
+			port->p_chassis->c_id_len))
+			return ochange;
+	}
+	return NULL;
+}
+
+static void
+levent_ctl_flush(evutil_socket_t fd, short what, void *arg)
+{
+	struct lldpd_one_client *client = arg;
+	struct timeval tv = { client->subscription.window / 1000,
+		(client->subscription.window % 1000) * 1000 };
+	void *output = NULL;
+	ssize_t output_len;
+
+	(void)fd;
+	(void)what;
+	if (client->batch_count == 0 && !client->batch.overflow) return;
+	if (evbuffer_get_length(bufferevent_get_output(client->bev)) >
+	    LEVENT_CTL_BACKLOG) {
+		/* The client does not keep up. Keep coalescing changes. */
+		log_debug("control", "client is slow, delay changes");
+		evtimer_add(client->batch_timer, &tv);
+		return;
+	}
+
+	log_debug("control", "send %d coalesced changes to client%s",
+	    client->batch_count,
+	    client->batch.overflow ? " (some changes were dropped)" : "");
+	output_len = lldpd_neighbor_changes_serialize(&client->batch, &output);
+	if (output_len <= 0) {
+		log_warnx("event", "unable to serialize coalesced changes");
+		return;
+	}
+	if (levent_ctl_send(client, NOTIFICATIONS, output, output_len) != -1)
+		levent_ctl_clear_batch(client);
+	free(output);
+	levent_ctl_reap_client(client);
+}
+
+/* Coalesce a change with the pending ones of a subscribed client. The change is
+ * provided serialized. */
+static void
+levent_ctl_coalesce(struct lldpd_one_client *client, void *output,
+    ssize_t output_len)
+{
+	struct lldpd_neighbor_change *change, *ochange;
+	struct lldpd_port *port;
+	u_int32_t hash;
+	struct timeval tv = { client->subscription.window / 1000,
+		(client->subscription.window % 1000) * 1000 };
+
+	if (client->batch_timer == NULL &&
+	    (client->batch_timer = evtimer_new(client->cfg->g_base,
+		 levent_ctl_flush, client)) == NULL) {
+		log_warnx("event", "unable to create timer to coalesce changes");
+		levent_ctl_send(client, NOTIFICATION, output, output_len);
+		return;
+	}
+	if (lldpd_neighbor_change_unserialize(output, output_len, &change) <= 0) {
+		log_warnx("event", "unable to copy changed neighbor");
+		return;
+	}
+
+	hash = levent_ctl_change_hash(change);
+	if ((ochange = levent_ctl_change_find(client, change, hash)) != NULL) {
+		if (ochange->state == NEIGHBOR_CHANGE_ADDED &&
+		    change->state == NEIGHBOR_CHANGE_DELETED) {
+			/* The client never heard of this neighbor. */
+			TAILQ_REMOVE(&client->batch.changes, ochange, c_entries);
+			hash_remove(&client->batch_index, &ochange->c_hentry);
+			client->batch_count--;
+			levent_ctl_free_change(ochange);
+			levent_ctl_free_change(change);
+			return;
+		}
+		if (ochange->state == NEIGHBOR_CHANGE_DELETED &&
+		    change->state == NEIGHBOR_CHANGE_ADDED)
+			ochange->state = NEIGHBOR_CHANGE_UPDATED;
+		else if (ochange->state != NEIGHBOR_CHANGE_ADDED)
+			ochange->state = change->state;
+		/* Keep the position of the change but use the last neighbor. */
+		port = ochange->neighbor;
+		ochange->neighbor = change->neighbor;
+		change->neighbor = port;
+		levent_ctl_free_change(change);
+	} else if (client->batch_count >= client->subscription.queue) {
+		client->batch.overflow = 1;
+		levent_ctl_free_change(change);
+	} else {
+		TAILQ_INSERT_TAIL(&client->batch.changes, change, c_entries);
+		hash_insert(&client->batch_index, &change->c_hentry, hash);
+		client->batch_count++;
+	}
+
+	if (!evtimer_pending(client->batch_timer, NULL))
+		evtimer_add(client->batch_timer, &tv);
+}
+
+/* Serialize a neighbor change. When `unchanged' is not 0, the corresponding
+ * sections are omitted: the chassis is reduced to its identity and lists are
+ * emptied. */
+static ssize_t
+levent_ctl_serialize_change(struct lldpd_neighbor_change *change, int unchanged,
+    void **output)
+{
+	struct lldpd_port *neighbor = change->neighbor, port;
+	struct lldpd_chassis chassis;
+	struct lldpd_neighbor_change delta;
+	ssize_t output_len;
+
+	/* We don't want to transmit a list of ports. Work on a shallow copy of
+	 * the port to avoid this. */
+	memcpy(&port, neighbor, sizeof(port));
+	memset(&port.p_entries, 0, sizeof(port.p_entries));
+	port.p_unchanged = unchanged;
+	if (unchanged & NEIGHBOR_UNCHANGED_CHASSIS) {
+		memset(&chassis, 0, sizeof(chassis));
+		chassis.c_index = neighbor->p_chassis->c_index;
+		chassis.c_protocol = neighbor->p_chassis->c_protocol;
+		chassis.c_id_subtype = neighbor->p_chassis->c_id_subtype;
+		chassis.c_id = neighbor->p_chassis->c_id;
+		chassis.c_id_len = neighbor->p_chassis->c_id_len;
+		TAILQ_INIT(&chassis.c_mgmt);
+		port.p_chassis = &chassis;
+	}
+#ifdef ENABLE_DOT1
+	if (unchanged & NEIGHBOR_UNCHANGED_VLANS) {
+		TAILQ_INIT(&port.p_vlans);
+		TAILQ_INIT(&port.p_ppvids);
+		TAILQ_INIT(&port.p_pids);
+	}
+#endif
+#ifdef ENABLE_CUSTOM
+	if (unchanged & NEIGHBOR_UNCHANGED_CUSTOM) TAILQ_INIT(&port.p_custom_list);
+#endif
+
+	delta = *change;
+	delta.neighbor = &port;
+	output_len = lldpd_neighbor_change_serialize(&delta, output);
+	if (output_len <= 0) log_warnx("event", "unable to serialize changed neighbor");
+	return output_len;
+}
+
 void
-levent_ctl_notify(char *ifname, int state, struct lldpd_port *neighbor)
+levent_ctl_notify(char *ifname, int state, struct lldpd_port *neighbor, int unchanged)
 {
 	struct lldpd_one_client *client, *client_next;
 	struct lldpd_neighbor_change neigh = { .ifname = ifname,
 		.state = state,
 		.neighbor = neighbor };
-	void *output = NULL;
-	ssize_t output_len = 0;
+	void *output = NULL, *delta = NULL;
+	ssize_t output_len = 0, delta_len = 0;
 
 	/* Don't use TAILQ_FOREACH, the client may be deleted in case of errors. */
 	log_debug("control", "notify clients of neighbor changes");
 	for (client = TAILQ_FIRST(&lldpd_clients); client; client = client_next) {
 		client_next = TAILQ_NEXT(client, next);
-		if (!client->subscribed) continue;
-
-		if (output == NULL) {
-			/* Ugly hack: we don't want to transmit a list of
-			 * ports. We patch the port to avoid this. */
-			TAILQ_ENTRY(lldpd_port) backup_p_entries;
-			memcpy(&backup_p_entries, &neighbor->p_entries,
-			    sizeof(backup_p_entries));
-			memset(&neighbor->p_entries, 0, sizeof(backup_p_entries));
-			output_len = lldpd_neighbor_change_serialize(&neigh, &output);
-			memcpy(&neighbor->p_entries, &backup_p_entries,
-			    sizeof(backup_p_entries));
-
-			if (output_len <= 0) {
-				log_warnx("event",
-				    "unable to serialize changed neighbor");
-				return;
-			}
+		if (!client->subscription.subscribed) continue;
+
+		if (client->subscription.window == 0 && client->subscription.delta &&
+		    unchanged) {
+			/* Subscriber keeping its own copy of neighbors */
+			if (delta == NULL &&
+			    (delta_len = levent_ctl_serialize_change(&neigh, unchanged,
+				 &delta)) <= 0)
+				break;
+			levent_ctl_send(client, NOTIFICATION, delta, delta_len);
+			levent_ctl_reap_client(client);
+			continue;
 		}
 
-		levent_ctl_send(client, NOTIFICATION, output, output_len);
+		if (output == NULL &&
+		    (output_len = levent_ctl_serialize_change(&neigh, 0, &output)) <= 0)
+			break;
+		if (client->subscription.window > 0)
+			levent_ctl_coalesce(client, output, output_len);
+		else
+			levent_ctl_send(client, NOTIFICATION, output, output_len);
+		levent_ctl_reap_client(client);
 	}
 
 	free(output);
+	free(delta);
 }
 
 static ssize_t
@@ -325,38 +567,83 @@ levent_ctl_recv(struct bufferevent *bev, void *ptr)
 {
 	struct lldpd_one_client *client = ptr;
 	struct evbuffer *buffer = bufferevent_get_input(bev);
-	size_t buffer_len = evbuffer_get_length(buffer);
+	size_t buffer_len;
 	struct hmsg_header hdr;
 	void *data = NULL;
 
 	log_debug("control", "receive data on Unix socket");
-	if (buffer_len < sizeof(struct hmsg_header)) return; /* Not enough data yet */
-	if (evbuffer_copyout(buffer, &hdr, sizeof(struct hmsg_header)) !=
+	/* The client is not freed while handling its requests, even when
+	 * sending to it fails. It is freed once here instead. */
+	client->receiving = 1;
+	while ((buffer_len = evbuffer_get_length(buffer)) >=
 	    sizeof(struct hmsg_header)) {
-		log_warnx("event", "not able to read header");
-		return;
-	}
-	if (hdr.len > HMSG_MAX_SIZE) {
-		log_warnx("event", "message received is too large");
-		goto recv_error;
-	}
+		if (evbuffer_copyout(buffer, &hdr, sizeof(struct hmsg_header)) !=
+		    sizeof(struct hmsg_header)) {
+			log_warnx("event", "not able to read header");
+			break;
+		}
+		if (hdr.len > HMSG_MAX_SIZE) {
+			log_warnx("event", "message received is too large");
+			goto recv_error;
+		}
+		if (buffer_len < hdr.len + sizeof(struct hmsg_header))
+			break; /* Not enough data yet */
+
+		if (client->chunked || (hdr.flags & HMSG_MORE)) {
+			/* Chunked message: append this chunk to the previous
+			 * ones. */
+			void *new = NULL;
+			if (!client->chunked) {
+				client->chunked = 1;
+				client->pending_type = hdr.type;
+			} else if (hdr.type != client->pending_type) {
+				log_warnx("event",
+				    "message type changed in the middle of a message");
+				goto recv_error;
+			}
+			if (hdr.len > LEVENT_CTL_MAX_REQUEST - client->pending_len) {
+				log_warnx("event", "message received is too large");
+				goto recv_error;
+			}
+			evbuffer_drain(buffer, sizeof(struct hmsg_header));
+			if (hdr.len > 0) {
+				if ((new = realloc(client->pending,
+					 client->pending_len + hdr.len)) == NULL) {
+					log_warnx("event", "not enough memory");
+					goto recv_error;
+				}
+				client->pending = new;
+				evbuffer_remove(buffer,
+				    (char *)client->pending + client->pending_len,
+				    hdr.len);
+				client->pending_len += hdr.len;
+			}
+			if (hdr.flags & HMSG_MORE) continue;
+			data = client->pending;
+			hdr.len = client->pending_len;
+			client->chunked = 0;
+			client->pending = NULL;
+			client->pending_len = 0;
+		} else {
+			if (hdr.len > 0 && (data = malloc(hdr.len)) == NULL) {
+				log_warnx("event", "not enough memory");
+				goto recv_error;
+			}
+			evbuffer_drain(buffer, sizeof(struct hmsg_header));
+			if (hdr.len > 0) evbuffer_remove(buffer, data, hdr.len);
+		}
 
-	if (buffer_len < hdr.len + sizeof(struct hmsg_header))
-		return; /* Not enough data yet */
-	if (hdr.len > 0 && (data = malloc(hdr.len)) == NULL) {
-		log_warnx("event", "not enough memory");
-		goto recv_error;
+		/* Currently, we should not receive notification acknowledgment.
+		 * But if we receive one, we can discard it. */
+		if ((hdr.len > 0 || hdr.type != NOTIFICATION) &&
+		    client_handle_client(client->cfg, levent_ctl_send_cb, client,
+			hdr.type, data, hdr.len, &client->subscription) == -1)
+			goto recv_error;
+		free(data);
+		data = NULL;
+		if (client->dead) goto recv_error;
 	}
-	evbuffer_drain(buffer, sizeof(struct hmsg_header));
-	if (hdr.len > 0) evbuffer_remove(buffer, data, hdr.len);
-
-	/* Currently, we should not receive notification acknowledgment. But if
-	 * we receive one, we can discard it. */
-	if (hdr.len == 0 && hdr.type == NOTIFICATION) return;
-	if (client_handle_client(client->cfg, levent_ctl_send_cb, client, hdr.type,
-		data, hdr.len, &client->subscribed) == -1)
-		goto recv_error;
-	free(data);
+	client->receiving = 0;
 	return;
 
 recv_error:
@@ -398,6 +685,7 @@ levent_ctl_accept(evutil_socket_t fd, short what, void *arg)
 		goto accept_failed;
 	}
 	client->cfg = cfg;
+	TAILQ_INIT(&client->batch.changes);
 	levent_make_socket_nonblocking(s);
 	TAILQ_INSERT_TAIL(&lldpd_clients, client, next);
 	if ((client->bev = bufferevent_socket_new(cfg->g_base, s,
@@ -598,7 +886,9 @@ void
 levent_shutdown(struct lldpd *cfg)
 {
 	if (cfg->g_iface_event) event_free(cfg->g_iface_event);
+	if (cfg->g_packet_event) event_free(cfg->g_packet_event);
 	if (cfg->g_cleanup_timer) event_free(cfg->g_cleanup_timer);
+	if (cfg->g_snapshot_timer) event_free(cfg->g_snapshot_timer);
 	event_base_free(cfg->g_base);
 }
 
@@ -681,8 +971,8 @@ static void
 levent_iface_trigger(evutil_socket_t fd, short what, void *arg)
 {
 	struct lldpd *cfg = arg;
-	log_debug("event", "triggering update of all interfaces");
-	lldpd_update_localports(cfg);
+	log_debug("event", "triggering update of changed interfaces");
+	lldpd_update_localports(cfg, 0);
 }
 
 static void
@@ -753,56 +1043,111 @@ levent_iface_subscribe(struct lldpd *cfg, int socket)
 	return 0;
 }
 
+static void
+levent_packet_recv(evutil_socket_t fd, short what, void *arg)
+{
+	struct lldpd *cfg = arg;
+	(void)what;
+	log_debug("event", "received something on shared socket");
+	cfg->g_packet_cb(cfg, fd);
+	levent_schedule_cleanup(cfg);
+}
+
+/* Receive frames for several ports from a single socket. The callback is
+ * responsible for dispatching them to the right port. */
+int
+levent_packet_subscribe(struct lldpd *cfg, int socket, void (*cb)(struct lldpd *, int))
+{
+	log_debug("event", "subscribe to frames from shared socket %d", socket);
+	levent_make_socket_nonblocking(socket);
+	cfg->g_packet_cb = cb;
+	cfg->g_packet_event = event_new(cfg->g_base, socket, EV_READ | EV_PERSIST,
+	    levent_packet_recv, cfg);
+	if (cfg->g_packet_event == NULL) {
+		log_warnx("event", "unable to allocate a new event for shared socket");
+		return -1;
+	}
+	if (event_add(cfg->g_packet_event, NULL) == -1) {
+		log_warnx("event", "unable to schedule new event for shared socket");
+		event_free(cfg->g_packet_event);
+		cfg->g_packet_event = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+void
+levent_packet_unsubscribe(struct lldpd *cfg)
+{
+	if (cfg->g_packet_event == NULL) return;
+	log_debug("event", "unsubscribe from shared socket");
+	event_free(cfg->g_packet_event);
+	cfg->g_packet_event = NULL;
+}
+
 static void
 levent_trigger_cleanup(evutil_socket_t fd, short what, void *arg)
 {
 	struct lldpd *cfg = arg;
-	lldpd_cleanup(cfg);
+	lldpd_expire(cfg);
 }
 
 void
 levent_schedule_cleanup(struct lldpd *cfg)
 {
 	log_debug("event", "schedule next cleanup");
-	if (cfg->g_cleanup_timer != NULL) {
-		event_free(cfg->g_cleanup_timer);
-	}
-	cfg->g_cleanup_timer = evtimer_new(cfg->g_base, levent_trigger_cleanup, cfg);
-	if (cfg->g_cleanup_timer == NULL) {
+	if (cfg->g_cleanup_timer == NULL &&
+	    (cfg->g_cleanup_timer = evtimer_new(cfg->g_base, levent_trigger_cleanup,
+		 cfg)) == NULL) {
 		log_warnx("event", "unable to allocate a new event for cleanup tasks");
 		return;
 	}
 
-	/* Compute the next TTL event */
+	/* The next TTL event is the first one in the expiry heap */
 	struct timeval tv = { cfg->g_config.c_ttl, 0 };
 	time_t now = time(NULL);
-	time_t next;
-	struct lldpd_hardware *hardware;
-	struct lldpd_port *port;
-	TAILQ_FOREACH (hardware, &cfg->g_hardware, h_entries) {
-		TAILQ_FOREACH (port, &hardware->h_rports, p_entries) {
-			if (now >= port->p_lastupdate + port->p_ttl) {
-				tv.tv_sec = 0;
-				log_debug("event",
-				    "immediate cleanup on port %s (%lld, %d, %lld)",
-				    hardware->h_ifname, (long long)now, port->p_ttl,
-				    (long long)port->p_lastupdate);
-				break;
-			}
-			next = port->p_ttl - (now - port->p_lastupdate);
-			if (next < tv.tv_sec) tv.tv_sec = next;
-		}
+	time_t next = expiry_next(&cfg->g_expiry);
+	if (next != -1) {
+		if (next <= now) {
+			tv.tv_sec = 0;
+			log_debug("event", "immediate cleanup");
+		} else if (next - now < tv.tv_sec)
+			tv.tv_sec = next - now;
 	}
 
 	log_debug("event", "next cleanup in %ld seconds", (long)tv.tv_sec);
 	if (event_add(cfg->g_cleanup_timer, &tv) == -1) {
 		log_warnx("event", "unable to schedule cleanup task");
-		event_free(cfg->g_cleanup_timer);
-		cfg->g_cleanup_timer = NULL;
 		return;
 	}
 }
 
+static void
+levent_trigger_snapshot(evutil_socket_t fd, short what, void *arg)
+{
+	struct lldpd *cfg = arg;
+	client_publish_snapshot(cfg);
+}
+
+/* Publish neighbors a bit later, to handle a burst of changes at once. */
+#define LEVENT_SNAPSHOT_DELAY 100 /* ms */
+void
+levent_schedule_snapshot(struct lldpd *cfg)
+{
+	struct timeval tv = { 0, LEVENT_SNAPSHOT_DELAY * 1000 };
+
+	if (!cfg->g_config.c_snapshot && cfg->g_snapshot.s_map == NULL) return;
+	if (cfg->g_snapshot_timer == NULL &&
+	    (cfg->g_snapshot_timer = evtimer_new(cfg->g_base, levent_trigger_snapshot,
+		 cfg)) == NULL) {
+		log_warnx("event", "unable to allocate a new event for snapshots");
+		return;
+	}
+	if (evtimer_pending(cfg->g_snapshot_timer, NULL)) return;
+	if (event_add(cfg->g_snapshot_timer, &tv) == -1)
+		log_warnx("event", "unable to schedule snapshot");
+}
+
 static void
 levent_send_pdu(evutil_socket_t fd, short what, void *arg)
 {
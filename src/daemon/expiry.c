@@ -0,0 +1,151 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2026 Vincent Bernat <bernat@luffy.cx>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Min-heap of remote ports, ordered by expiration time. Each port remembers
+ * its position in the heap (`p_expiry`, 1-based, 0 when not in the heap) to
+ * be updated or removed in O(log n). */
+
+#include "lldpd.h"
+
+#include <stdlib.h>
+
+#define EXPIRY_MIN_SIZE 64
+
+static void
+expiry_set(struct expiry_heap *heap, u_int32_t i, struct expiry_entry *entry)
+{
+	heap->eh_entries[i] = *entry;
+	entry->e_port->p_expiry = i + 1;
+}
+
+static void
+expiry_up(struct expiry_heap *heap, u_int32_t i)
+{
+	struct expiry_entry entry = heap->eh_entries[i];
+	while (i > 0) {
+		u_int32_t parent = (i - 1) / 2;
+		if (heap->eh_entries[parent].e_when <= entry.e_when) break;
+		expiry_set(heap, i, &heap->eh_entries[parent]);
+		i = parent;
+	}
+	expiry_set(heap, i, &entry);
+}
+
+static void
+expiry_down(struct expiry_heap *heap, u_int32_t i)
+{
+	struct expiry_entry entry = heap->eh_entries[i];
+	for (;;) {
+		u_int32_t child = 2 * i + 1;
+		if (child >= heap->eh_count) break;
+		if (child + 1 < heap->eh_count &&
+		    heap->eh_entries[child + 1].e_when < heap->eh_entries[child].e_when)
+			child++;
+		if (entry.e_when <= heap->eh_entries[child].e_when) break;
+		expiry_set(heap, i, &heap->eh_entries[child]);
+		i = child;
+	}
+	expiry_set(heap, i, &entry);
+}
+
+/* Ensure there is room for one more entry. */
+int
+expiry_reserve(struct expiry_heap *heap)
+{
+	struct expiry_entry *entries;
+	u_int32_t size;
+
+	if (heap->eh_count < heap->eh_size) return 0;
+	size = heap->eh_size ? heap->eh_size * 2 : EXPIRY_MIN_SIZE;
+	if (size < heap->eh_size ||
+	    (entries = realloc(heap->eh_entries, size * sizeof(*entries))) == NULL) {
+		log_warnx("expiry", "unable to grow expiry heap to %u entries", size);
+		return -1;
+	}
+	heap->eh_entries = entries;
+	heap->eh_size = size;
+	return 0;
+}
+
+/* Insert a remote port or move it to its new position after its TTL or its
+ * last update time changed. */
+int
+expiry_update(struct expiry_heap *heap, struct lldpd_hardware *hardware,
+    struct lldpd_port *port)
+{
+	u_int32_t i;
+	time_t when = port->p_lastupdate + port->p_ttl;
+
+	if (port->p_expiry == 0) {
+		if (expiry_reserve(heap) == -1) return -1;
+		i = heap->eh_count++;
+		heap->eh_entries[i].e_port = port;
+		heap->eh_entries[i].e_hardware = hardware;
+	} else
+		i = port->p_expiry - 1;
+	heap->eh_entries[i].e_when = when;
+	if (i > 0 && heap->eh_entries[(i - 1) / 2].e_when > when)
+		expiry_up(heap, i);
+	else
+		expiry_down(heap, i);
+	return 0;
+}
+
+/* Remove a remote port. Nothing happens if the port is not in the heap. */
+void
+expiry_remove(struct expiry_heap *heap, struct lldpd_port *port)
+{
+	u_int32_t i = port->p_expiry;
+	if (i == 0) return;
+	i--;
+	port->p_expiry = 0;
+	if (i == --heap->eh_count) return;
+	expiry_set(heap, i, &heap->eh_entries[heap->eh_count]);
+	if (i > 0 &&
+	    heap->eh_entries[(i - 1) / 2].e_when > heap->eh_entries[i].e_when)
+		expiry_up(heap, i);
+	else
+		expiry_down(heap, i);
+}
+
+/* Return the next expiration time or -1 if the heap is empty. */
+time_t
+expiry_next(struct expiry_heap *heap)
+{
+	if (heap->eh_count == 0) return -1;
+	return heap->eh_entries[0].e_when;
+}
+
+/* Get the first port expiring at `now` or before. Return 0 if none. The port
+ * is not removed from the heap. */
+int
+expiry_due(struct expiry_heap *heap, time_t now, struct lldpd_hardware **hardware,
+    struct lldpd_port **port)
+{
+	if (heap->eh_count == 0 || heap->eh_entries[0].e_when > now) return 0;
+	*hardware = heap->eh_entries[0].e_hardware;
+	*port = heap->eh_entries[0].e_port;
+	return 1;
+}
+
+/* Release memory used by the heap. Ports are not touched. */
+void
+expiry_free(struct expiry_heap *heap)
+{
+	free(heap->eh_entries);
+	memset(heap, 0, sizeof(*heap));
+}
@@ -561,7 +561,7 @@ ifbsd_macphy(struct lldpd *cfg, struct lldpd_hardware *hardware)
 
 extern struct lldpd_ops bpf_ops;
 void
-interfaces_update(struct lldpd *cfg)
+interfaces_update(struct lldpd *cfg, int full)
 {
 	struct lldpd_hardware *hardware;
 	struct interfaces_device *iface;
@@ -605,7 +605,7 @@ interfaces_update(struct lldpd *cfg)
 	/* Mac/PHY */
 	TAILQ_FOREACH (hardware, &cfg->g_hardware, h_entries) {
 		if (!hardware->h_flags) continue;
-		ifbsd_macphy(cfg, hardware);
+		interfaces_helper_macphy(cfg, hardware, ifbsd_macphy);
 		interfaces_helper_promisc(cfg, hardware);
 	}
 
@@ -22,6 +22,7 @@
 #include <inttypes.h>
 #include <errno.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #if defined(__clang__)
 #  pragma clang diagnostic push
 #  pragma clang diagnostic ignored "-Wdocumentation"
@@ -48,11 +49,16 @@ iflinux_eth_init(struct lldpd *cfg, struct lldpd_hardware *hardware)
 	int fd;
 
 	log_debug("interfaces", "initialize ethernet device %s", hardware->h_ifname);
-	if ((fd = priv_iface_init(hardware->h_ifindex, hardware->h_ifname)) == -1)
-		return -1;
-	hardware->h_sendfd = fd; /* Send */
-
-	interfaces_setup_multicast(cfg, hardware->h_ifname, 0);
+	if (interfaces_helper_prepared(cfg, hardware, &fd)) {
+		if (fd == -1) return -1;
+		hardware->h_sendfd = fd; /* Send */
+	} else {
+		if ((fd = priv_iface_init(hardware->h_ifindex, hardware->h_ifname)) ==
+		    -1)
+			return -1;
+		hardware->h_sendfd = fd; /* Send */
+		interfaces_setup_multicast(cfg, hardware->h_ifname, 0);
+	}
 
 	levent_hardware_add_fd(hardware, fd); /* Receive */
 	log_debug("interfaces", "interface %s initialized (fd=%d)", hardware->h_ifname,
@@ -119,6 +125,121 @@ iflinux_eth_recv(struct lldpd *cfg, struct lldpd_hardware *hardware, int fd,
 	return n;
 }
 
+/* Discard a frame that did not fit in the reception buffer. Decoding it would
+ * lose its trailing TLVs. Always return -1. */
+static int
+iflinux_discard_truncated(struct lldpd_hardware *hardware, size_t size)
+{
+	log_debug("interfaces", "discard frame truncated to %zu bytes on %s", size,
+	    hardware->h_ifname);
+	hardware->h_rx_discarded_cnt++;
+	return -1;
+}
+
+/* Frames are received in batches with recvmmsg() into buffers reused across
+ * calls. Each wakeup drains up to BATCH_ROUNDS batches. */
+#define BATCH_SIZE 16
+#define BATCH_ROUNDS 8
+#define BATCH_FRAME_SIZE 9216
+
+struct lldpd_recv_batch {
+	struct mmsghdr msgs[BATCH_SIZE];
+	struct iovec iovs[BATCH_SIZE];
+	struct sockaddr_ll from[BATCH_SIZE];
+	char frames[BATCH_SIZE][BATCH_FRAME_SIZE];
+};
+
+/* Receive a batch of frames from `fd`. `hardware` is NULL for the shared
+ * socket. Return the number of frames received or -1 if none. */
+static int
+iflinux_batch_recv(struct lldpd *cfg, struct lldpd_hardware *hardware, int fd,
+    int first)
+{
+	struct lldpd_recv_batch *batch = cfg->g_recv_batch;
+	const char *name = hardware ? hardware->h_ifname : "shared socket";
+	int i, n, retry = 0;
+
+	if (batch == NULL) {
+		if ((batch = calloc(1, sizeof(struct lldpd_recv_batch))) == NULL) {
+			log_warn("interfaces", "unable to allocate reception buffers");
+			return -1;
+		}
+		for (i = 0; i < BATCH_SIZE; i++) {
+			batch->iovs[i].iov_base = batch->frames[i];
+			batch->iovs[i].iov_len = BATCH_FRAME_SIZE;
+			batch->msgs[i].msg_hdr.msg_iov = &batch->iovs[i];
+			batch->msgs[i].msg_hdr.msg_iovlen = 1;
+			batch->msgs[i].msg_hdr.msg_name = &batch->from[i];
+		}
+		cfg->g_recv_batch = batch;
+	}
+
+retry:
+	for (i = 0; i < BATCH_SIZE; i++) {
+		batch->msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_ll);
+		batch->from[i].sll_pkttype = PACKET_HOST;
+	}
+#ifdef HAVE_RECVMMSG
+	n = recvmmsg(fd, batch->msgs, BATCH_SIZE, MSG_DONTWAIT, NULL);
+#else
+	if ((n = recvmsg(fd, &batch->msgs[0].msg_hdr, MSG_DONTWAIT)) != -1) {
+		batch->msgs[0].msg_len = n;
+		n = 1;
+	}
+#endif
+	if (n == -1) {
+		if (errno == EAGAIN && first && retry == 0) {
+			/* There may be an error queued in the socket. Clear it and
+			 * retry. */
+			levent_recv_error(fd, name);
+			retry++;
+			goto retry;
+		}
+		/* The queue may already be empty after a full batch or a wakeup for
+		 * another port of the shared socket */
+		if (errno == EAGAIN && (hardware == NULL || !first)) return -1;
+		if (errno == ENETDOWN) {
+			log_debug("interfaces",
+			    "error while receiving frame on %s (network down)", name);
+		} else {
+			log_warn("interfaces",
+			    "error while receiving frame on %s (retry: %d)", name, retry);
+			if (hardware) hardware->h_rx_discarded_cnt++;
+		}
+		return -1;
+	}
+	return n;
+}
+
+static int
+iflinux_eth_recv_batch(struct lldpd *cfg, struct lldpd_hardware *hardware, int fd,
+    int (*handle)(struct lldpd *, struct lldpd_hardware *, char *, size_t))
+{
+	struct lldpd_recv_batch *batch;
+	int i, n, round, count = 0;
+
+	log_debug("interfaces", "receive PDUs from ethernet device %s",
+	    hardware->h_ifname);
+	for (round = 0; round < BATCH_ROUNDS; round++) {
+		if ((n = iflinux_batch_recv(cfg, hardware, fd, round == 0)) == -1)
+			break;
+		batch = cfg->g_recv_batch;
+		for (i = 0; i < n; i++) {
+			if (batch->from[i].sll_pkttype == PACKET_OUTGOING) continue;
+			if (batch->msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+				iflinux_discard_truncated(hardware,
+				    batch->msgs[i].msg_len);
+				continue;
+			}
+			if (handle(cfg, hardware, batch->frames[i],
+				batch->msgs[i].msg_len) == 0)
+				count++;
+		}
+		if (n < BATCH_SIZE) break;
+	}
+	return count;
+}
+
 static int
 iflinux_eth_close(struct lldpd *cfg, struct lldpd_hardware *hardware)
 {
@@ -130,9 +251,394 @@ iflinux_eth_close(struct lldpd *cfg, struct lldpd_hardware *hardware)
 static struct lldpd_ops eth_ops = {
 	.send = iflinux_eth_send,
 	.recv = iflinux_eth_recv,
+	.recv_batch = iflinux_eth_recv_batch,
 	.cleanup = iflinux_eth_close,
 };
 
+#ifdef TPACKET3_HDRLEN
+/* Reception through a TPACKET_V3 memory-mapped ring. The kernel fills blocks
+ * of frames and hands a block over when it is full or after a timeout. Frames
+ * are decoded directly from the ring and the block is given back to the kernel
+ * once all its frames have been handled. */
+#  define RING_BLOCK_SIZE (1 << 15)
+#  define RING_BLOCK_NR 4
+#  define RING_FRAME_SIZE (1 << 11)
+#  define RING_TIMEOUT 10 /* ms */
+
+struct ring {
+	u_int8_t *map;	/* Memory-mapped blocks */
+	unsigned block; /* Next block to look at */
+};
+
+static int
+iflinux_ring_setup(struct ring *ring, int fd, const char *name)
+{
+	int version = TPACKET_V3;
+	struct tpacket_req3 req = { .tp_block_size = RING_BLOCK_SIZE,
+		.tp_block_nr = RING_BLOCK_NR,
+		.tp_frame_size = RING_FRAME_SIZE,
+		.tp_frame_nr = RING_BLOCK_SIZE * RING_BLOCK_NR / RING_FRAME_SIZE,
+		.tp_retire_blk_tov = RING_TIMEOUT };
+
+	if (setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) ==
+		-1 ||
+	    setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) == -1) {
+		log_warn("interfaces", "unable to setup RX ring for %s", name);
+		return -1;
+	}
+	if ((ring->map = mmap(NULL, RING_BLOCK_SIZE * RING_BLOCK_NR,
+		 PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+		log_warn("interfaces", "unable to map RX ring for %s", name);
+		ring->map = NULL;
+		memset(&req, 0, sizeof(req));
+		setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req));
+		return -1;
+	}
+	ring->block = 0;
+	return 0;
+}
+
+static void
+iflinux_ring_release(struct ring *ring, int fd)
+{
+	struct tpacket_req3 req = {};
+	if (ring->map == NULL) return;
+	munmap(ring->map, RING_BLOCK_SIZE * RING_BLOCK_NR);
+	ring->map = NULL;
+	/* Frames will be received again through the socket */
+	setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req));
+}
+
+/* Call `handle` for each frame available in the ring with the captured size
+ * and the original length of the frame. Return the number of accepted
+ * frames. */
+static int
+iflinux_ring_walk(struct ring *ring,
+    int (*handle)(void *, struct sockaddr_ll *, char *, size_t, size_t), void *arg)
+{
+	struct tpacket_block_desc *block;
+	struct tpacket3_hdr *hdr;
+	struct sockaddr_ll *from;
+	unsigned i;
+	int accepted = 0;
+
+	for (;;) {
+		block = (struct tpacket_block_desc *)(ring->map +
+		    ring->block * RING_BLOCK_SIZE);
+		if (!(block->hdr.bh1.block_status & TP_STATUS_USER)) break;
+		log_debug("interfaces", "receive %u PDU from RX ring",
+		    block->hdr.bh1.num_pkts);
+		hdr = (struct tpacket3_hdr *)((u_int8_t *)block +
+		    block->hdr.bh1.offset_to_first_pkt);
+		for (i = 0; i < block->hdr.bh1.num_pkts; i++) {
+			from = (struct sockaddr_ll *)((u_int8_t *)hdr +
+			    TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+			if (from->sll_pkttype != PACKET_OUTGOING &&
+			    handle(arg, from, (char *)hdr + hdr->tp_mac,
+				hdr->tp_snaplen, hdr->tp_len) == 0)
+				accepted++;
+			hdr = (struct tpacket3_hdr *)((u_int8_t *)hdr +
+			    hdr->tp_next_offset);
+		}
+		/* Give the block back to the kernel */
+		__sync_synchronize();
+		block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+		ring->block = (ring->block + 1) % RING_BLOCK_NR;
+	}
+	return accepted;
+}
+
+static int
+iflinux_ring_init(struct lldpd *cfg, struct lldpd_hardware *hardware)
+{
+	struct ring *ring;
+	int fd, prepared;
+
+	log_debug("interfaces", "initialize ethernet device %s with a RX ring",
+	    hardware->h_ifname);
+	if ((ring = calloc(1, sizeof(struct ring))) == NULL) {
+		log_warn("interfaces", "unable to allocate RX ring for %s",
+		    hardware->h_ifname);
+		return -1;
+	}
+	if ((prepared = interfaces_helper_prepared(cfg, hardware, &fd)) == 0)
+		fd = priv_iface_init(hardware->h_ifindex, hardware->h_ifname);
+	if (fd == -1) {
+		free(ring);
+		return -1;
+	}
+	if (iflinux_ring_setup(ring, fd, hardware->h_ifname) == -1) {
+		if (prepared) interfaces_setup_multicast(cfg, hardware->h_ifname, 1);
+		close(fd);
+		free(ring);
+		return -1;
+	}
+	hardware->h_sendfd = fd;
+	hardware->h_data = ring;
+
+	if (!prepared) interfaces_setup_multicast(cfg, hardware->h_ifname, 0);
+
+	levent_hardware_add_fd(hardware, fd);
+	log_debug("interfaces", "interface %s initialized (fd=%d, ring)",
+	    hardware->h_ifname, fd);
+	return 0;
+}
+
+struct ring_port {
+	struct lldpd *cfg;
+	struct lldpd_hardware *hardware;
+	int (*handle)(struct lldpd *, struct lldpd_hardware *, char *, size_t);
+};
+
+static int
+iflinux_ring_port_frame(void *arg, struct sockaddr_ll *from, char *frame,
+    size_t size, size_t len)
+{
+	struct ring_port *port = arg;
+	if (len > size) return iflinux_discard_truncated(port->hardware, size);
+	return port->handle(port->cfg, port->hardware, frame, size);
+}
+
+static int
+iflinux_ring_recv(struct lldpd *cfg, struct lldpd_hardware *hardware, int fd,
+    int (*handle)(struct lldpd *, struct lldpd_hardware *, char *, size_t))
+{
+	struct ring_port port = { cfg, hardware, handle };
+	log_debug("interfaces", "receive PDU from RX ring of %s", hardware->h_ifname);
+	return iflinux_ring_walk(hardware->h_data, iflinux_ring_port_frame, &port);
+}
+
+static int
+iflinux_ring_close(struct lldpd *cfg, struct lldpd_hardware *hardware)
+{
+	log_debug("interfaces", "close ethernet device %s", hardware->h_ifname);
+	interfaces_setup_multicast(cfg, hardware->h_ifname, 1);
+	iflinux_ring_release(hardware->h_data, hardware->h_sendfd);
+	free(hardware->h_data);
+	hardware->h_data = NULL;
+	return 0;
+}
+
+static struct lldpd_ops ring_ops = {
+	.send = iflinux_eth_send,
+	.recv = iflinux_eth_recv,
+	.recv_batch = iflinux_ring_recv,
+	.cleanup = iflinux_ring_close,
+};
+#endif
+
+/* A single unbound socket receiving and sending frames for all ports. Frames
+ * are dispatched to ports using the interface index. The socket is opened with
+ * the first port and closed with the last one. */
+struct lldpd_shared {
+	int fd;
+#ifdef TPACKET3_HDRLEN
+	struct ring ring;
+#endif
+	struct hash_table ports; /* Ports, by interface index */
+};
+
+struct shared_port {
+	struct hash_entry entry;
+	struct lldpd_hardware *hardware;
+};
+
+static u_int32_t
+iflinux_shared_hash(int ifindex)
+{
+	return hash_bytes(HASH_INIT, &ifindex, sizeof(ifindex));
+}
+
+static struct lldpd_hardware *
+iflinux_shared_lookup(struct lldpd_shared *shared, int ifindex)
+{
+	struct hash_entry *entry;
+	struct shared_port *port;
+	HASH_FOREACH (entry, &shared->ports, iflinux_shared_hash(ifindex)) {
+		port = HASH_ENTRY(entry, struct shared_port, entry);
+		if (port->hardware->h_ifindex == ifindex) return port->hardware;
+	}
+	return NULL;
+}
+
+static int
+iflinux_shared_frame(void *arg, struct sockaddr_ll *from, char *frame, size_t size,
+    size_t len)
+{
+	struct lldpd *cfg = arg;
+	struct lldpd_hardware *hardware;
+	if ((hardware = iflinux_shared_lookup(cfg->g_shared, from->sll_ifindex)) ==
+	    NULL) {
+		log_debug("interfaces", "ignore PDU received on unmanaged interface %d",
+		    from->sll_ifindex);
+		return -1;
+	}
+	if (len > size) return iflinux_discard_truncated(hardware, size);
+	return lldpd_recv_frame(cfg, hardware, frame, size);
+}
+
+static void
+iflinux_shared_recv(struct lldpd *cfg, int fd)
+{
+	struct lldpd_recv_batch *batch;
+	struct lldpd_hardware *hardware, *last = NULL;
+	int i, n, round, count = 0;
+
+#ifdef TPACKET3_HDRLEN
+	if (cfg->g_shared->ring.map) {
+		if (iflinux_ring_walk(&cfg->g_shared->ring, iflinux_shared_frame, cfg) >
+		    0)
+			lldpd_recv_done(cfg, NULL);
+		return;
+	}
+#endif
+
+	for (round = 0; round < BATCH_ROUNDS; round++) {
+		if ((n = iflinux_batch_recv(cfg, NULL, fd, round == 0)) == -1) break;
+		batch = cfg->g_recv_batch;
+		for (i = 0; i < n; i++) {
+			if (batch->from[i].sll_pkttype == PACKET_OUTGOING) continue;
+			if ((hardware = iflinux_shared_lookup(cfg->g_shared,
+				 batch->from[i].sll_ifindex)) == NULL) {
+				log_debug("interfaces",
+				    "ignore PDU received on unmanaged interface %d",
+				    batch->from[i].sll_ifindex);
+				continue;
+			}
+			if (batch->msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+				iflinux_discard_truncated(hardware,
+				    batch->msgs[i].msg_len);
+				continue;
+			}
+			if (lldpd_recv_frame(cfg, hardware, batch->frames[i],
+				batch->msgs[i].msg_len) == -1)
+				continue;
+			/* Post-process only this port if it is the only one */
+			last = (count++ == 0 || last == hardware) ? hardware : NULL;
+		}
+		if (n < BATCH_SIZE) break;
+	}
+	if (count > 0) lldpd_recv_done(cfg, last);
+}
+
+static void
+iflinux_shared_close(struct lldpd *cfg)
+{
+	struct lldpd_shared *shared = cfg->g_shared;
+	log_debug("interfaces", "close shared socket");
+	levent_packet_unsubscribe(cfg);
+#ifdef TPACKET3_HDRLEN
+	iflinux_ring_release(&shared->ring, shared->fd);
+#endif
+	close(shared->fd);
+	hash_free(&shared->ports);
+	free(shared);
+	cfg->g_shared = NULL;
+}
+
+/* Open the shared socket or update it to match the configuration */
+static int
+iflinux_shared_open(struct lldpd *cfg)
+{
+	struct lldpd_shared *shared = cfg->g_shared;
+
+	if (shared == NULL) {
+		log_debug("interfaces", "open shared socket");
+		if ((shared = calloc(1, sizeof(struct lldpd_shared))) == NULL) {
+			log_warn("interfaces", "unable to allocate shared socket");
+			return -1;
+		}
+		if ((shared->fd = priv_iface_init(0, "any")) == -1) {
+			free(shared);
+			return -1;
+		}
+		cfg->g_shared = shared;
+		if (levent_packet_subscribe(cfg, shared->fd, iflinux_shared_recv) ==
+		    -1) {
+			iflinux_shared_close(cfg);
+			return -1;
+		}
+	}
+#ifdef TPACKET3_HDRLEN
+	if (cfg->g_config.c_rx_ring && shared->ring.map == NULL)
+		iflinux_ring_setup(&shared->ring, shared->fd, "shared socket");
+	else if (!cfg->g_config.c_rx_ring && shared->ring.map != NULL)
+		iflinux_ring_release(&shared->ring, shared->fd);
+#endif
+	return 0;
+}
+
+static int
+iflinux_shared_init(struct lldpd *cfg, struct lldpd_hardware *hardware)
+{
+	struct shared_port *port;
+	int fd;
+
+	log_debug("interfaces", "initialize ethernet device %s on shared socket",
+	    hardware->h_ifname);
+	if ((port = calloc(1, sizeof(struct shared_port))) == NULL) {
+		log_warn("interfaces", "unable to allocate memory for %s",
+		    hardware->h_ifname);
+		return -1;
+	}
+	if (iflinux_shared_open(cfg) == -1) {
+		free(port);
+		return -1;
+	}
+	port->hardware = hardware;
+	hash_insert(&cfg->g_shared->ports, &port->entry,
+	    iflinux_shared_hash(hardware->h_ifindex));
+	hardware->h_sendfd = -1;
+	hardware->h_data = port;
+
+	if (!interfaces_helper_prepared(cfg, hardware, &fd))
+		interfaces_setup_multicast(cfg, hardware->h_ifname, 0);
+	return 0;
+}
+
+static int
+iflinux_shared_send(struct lldpd *cfg, struct lldpd_hardware *hardware, char *buffer,
+    size_t size)
+{
+	struct sockaddr_ll sa = { .sll_family = AF_PACKET,
+		.sll_protocol = htons(ETH_P_ALL),
+		.sll_ifindex = hardware->h_ifindex,
+		.sll_halen = ETHER_ADDR_LEN };
+	log_debug("interfaces", "send PDU to ethernet device %s (shared socket)",
+	    hardware->h_ifname);
+	if (size >= ETHER_ADDR_LEN) memcpy(sa.sll_addr, buffer, ETHER_ADDR_LEN);
+	return sendto(cfg->g_shared->fd, buffer, size, 0, (struct sockaddr *)&sa,
+	    sizeof(sa));
+}
+
+static int
+iflinux_shared_recv_port(struct lldpd *cfg, struct lldpd_hardware *hardware, int fd,
+    char *buffer, size_t size)
+{
+	/* Frames are received by iflinux_shared_recv() */
+	return -1;
+}
+
+static int
+iflinux_shared_cleanup(struct lldpd *cfg, struct lldpd_hardware *hardware)
+{
+	struct shared_port *port = hardware->h_data;
+	log_debug("interfaces", "close ethernet device %s (shared socket)",
+	    hardware->h_ifname);
+	interfaces_setup_multicast(cfg, hardware->h_ifname, 1);
+	hash_remove(&cfg->g_shared->ports, &port->entry);
+	free(port);
+	hardware->h_data = NULL;
+	if (cfg->g_shared->ports.ht_count == 0) iflinux_shared_close(cfg);
+	return 0;
+}
+
+static struct lldpd_ops shared_ops = {
+	.send = iflinux_shared_send,
+	.recv = iflinux_shared_recv_port,
+	.cleanup = iflinux_shared_cleanup,
+};
+
 static int
 iflinux_is_bridge(struct lldpd *cfg, struct interfaces_device_list *interfaces,
     struct interfaces_device *iface)
@@ -807,6 +1313,7 @@ iflinux_handle_bond(struct lldpd *cfg, struct interfaces_device_list *interfaces
 				    hardware->h_ifname);
 				if (hardware->h_ops && hardware->h_ops->cleanup)
 					hardware->h_ops->cleanup(cfg, hardware);
+				hardware->h_ops = NULL;
 				levent_hardware_release(hardware);
 				levent_hardware_init(hardware);
 			}
@@ -814,6 +1321,9 @@ iflinux_handle_bond(struct lldpd *cfg, struct interfaces_device_list *interfaces
 			    calloc(1, sizeof(struct bond_master));
 			if (!bmaster) {
 				log_warn("interfaces", "not enough memory");
+				if (!created)
+					TAILQ_REMOVE(&cfg->g_hardware, hardware,
+					    h_entries);
 				lldpd_hardware_cleanup(cfg, hardware);
 				continue;
 			}
@@ -825,6 +1335,9 @@ iflinux_handle_bond(struct lldpd *cfg, struct interfaces_device_list *interfaces
 			if (iface_bond_init(cfg, hardware) != 0) {
 				log_warn("interfaces", "unable to initialize %s",
 				    hardware->h_ifname);
+				if (!created)
+					TAILQ_REMOVE(&cfg->g_hardware, hardware,
+					    h_entries);
 				lldpd_hardware_cleanup(cfg, hardware);
 				continue;
 			}
@@ -834,22 +1347,16 @@ iflinux_handle_bond(struct lldpd *cfg, struct interfaces_device_list *interfaces
 		if (created)
 			interfaces_helper_add_hardware(cfg, hardware);
 		else
-			lldpd_port_cleanup(&hardware->h_lport, 0);
+			lldpd_lport_refresh(hardware);
 
 		hardware->h_flags = iface->flags;
 		iface->ignore = 1;
 
-		/* Get local address */
-		memcpy(&hardware->h_lladdr, iface->address, ETHER_ADDR_LEN);
+		/* Get local address and additional info */
+		interfaces_helper_port_physical(hardware, iface, master->index);
 
 		/* Fill information about port */
 		interfaces_helper_port_name_desc(cfg, hardware, iface);
-
-		/* Fill additional info */
-#  ifdef ENABLE_DOT3
-		hardware->h_lport.p_aggregid = master->index;
-#  endif
-		hardware->h_mtu = iface->mtu ? iface->mtu : 1500;
 	}
 }
 #endif
@@ -862,7 +1369,7 @@ iflinux_add_driver(struct lldpd *cfg, struct interfaces_device_list *interfaces)
 	TAILQ_FOREACH (iface, interfaces, next) {
 		struct ethtool_drvinfo ethc = { .cmd = ETHTOOL_GDRVINFO };
 		struct ifreq ifr = { .ifr_data = (caddr_t)&ethc };
-		if (iface->driver) continue;
+		if (iface->driver || iface->unchanged) continue;
 
 		strlcpy(ifr.ifr_name, iface->name, IFNAMSIZ);
 		if (ioctl(cfg->g_sock, SIOCETHTOOL, &ifr) == 0) {
@@ -880,6 +1387,7 @@ iflinux_add_wireless(struct lldpd *cfg, struct interfaces_device_list *interface
 	struct interfaces_device *iface;
 	TAILQ_FOREACH (iface, interfaces, next) {
 		struct iwreq iwr = {};
+		if (iface->unchanged) continue;
 		strlcpy(iwr.ifr_name, iface->name, IFNAMSIZ);
 		if (ioctl(cfg->g_sock, SIOCGIWNAME, &iwr) >= 0) {
 			log_debug("interfaces", "%s is wireless", iface->name);
@@ -930,6 +1438,7 @@ iflinux_add_vlan(struct lldpd *cfg, struct interfaces_device_list *interfaces)
 	struct interfaces_device *iface;
 
 	TAILQ_FOREACH (iface, interfaces, next) {
+		if (iface->unchanged) continue;
 		if (iface->type &
 		    (IFACE_PHYSICAL_T | IFACE_VLAN_T | IFACE_BOND_T | IFACE_BRIDGE_T))
 			continue;
@@ -949,6 +1458,7 @@ iflinux_add_physical(struct lldpd *cfg, struct interfaces_device_list *interface
 	const char *const denied_drivers[] = { "cdc_mbim", "vxlan", NULL };
 
 	TAILQ_FOREACH (iface, interfaces, next) {
+		if (iface->unchanged) continue;
 		if (iface->type & (IFACE_VLAN_T | IFACE_BOND_T | IFACE_BRIDGE_T))
 			continue;
 
@@ -998,9 +1508,10 @@ iflinux_add_physical(struct lldpd *cfg, struct interfaces_device_list *interface
 }
 
 void
-interfaces_update(struct lldpd *cfg)
+interfaces_update(struct lldpd *cfg, int full)
 {
 	struct lldpd_hardware *hardware;
+	struct interfaces_device *iface;
 	struct interfaces_device_list *interfaces;
 	struct interfaces_address_list *addresses;
 	interfaces = netlink_get_interfaces(cfg);
@@ -1009,6 +1520,10 @@ interfaces_update(struct lldpd *cfg)
 		log_warnx("interfaces", "cannot update the list of local interfaces");
 		return;
 	}
+	if (full) {
+		TAILQ_FOREACH (iface, interfaces, next)
+			iface->unchanged = 0;
+	}
 
 	/* Add missing bits to list of interfaces */
 	iflinux_add_driver(cfg, interfaces);
@@ -1024,7 +1539,21 @@ interfaces_update(struct lldpd *cfg)
 #ifdef ENABLE_OLDIES
 	iflinux_handle_bond(cfg, interfaces);
 #endif
-	interfaces_helper_physical(cfg, interfaces, &eth_ops, iflinux_eth_init);
+	interfaces_helper_prepare(cfg, interfaces, !cfg->g_config.c_shared_socket);
+	if (cfg->g_config.c_shared_socket) {
+		if (cfg->g_shared) iflinux_shared_open(cfg);
+		interfaces_helper_physical(cfg, interfaces, &shared_ops,
+		    iflinux_shared_init);
+	}
+#ifdef TPACKET3_HDRLEN
+	else if (cfg->g_config.c_rx_ring)
+		interfaces_helper_physical(cfg, interfaces, &ring_ops,
+		    iflinux_ring_init);
+#endif
+	else
+		interfaces_helper_physical(cfg, interfaces, &eth_ops,
+		    iflinux_eth_init);
+	interfaces_helper_prepared_release(cfg);
 #ifdef ENABLE_DOT1
 	interfaces_helper_vlan(cfg, interfaces);
 #endif
@@ -1033,14 +1562,20 @@ interfaces_update(struct lldpd *cfg)
 
 	/* Mac/PHY */
 	TAILQ_FOREACH (hardware, &cfg->g_hardware, h_entries) {
-		if (!hardware->h_flags) continue;
-		iflinux_macphy(cfg, hardware);
+		if (!hardware->h_flags || hardware->h_unchanged) continue;
+		interfaces_helper_macphy(cfg, hardware, iflinux_macphy);
 		interfaces_helper_promisc(cfg, hardware);
 	}
+
+	/* Netlink will tell us about the next changes */
+	TAILQ_FOREACH (iface, interfaces, next)
+		iface->unchanged = 1;
 }
 
 void
 interfaces_cleanup(struct lldpd *cfg)
 {
 	netlink_cleanup(cfg);
+	free(cfg->g_recv_batch);
+	cfg->g_recv_batch = NULL;
 }
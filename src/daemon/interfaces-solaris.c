@@ -106,7 +106,7 @@ ifsolaris_extract(struct lldpd *cfg, struct interfaces_device_list *interfaces,
 
 extern struct lldpd_ops bpf_ops;
 void
-interfaces_update(struct lldpd *cfg)
+interfaces_update(struct lldpd *cfg, int full)
 {
 	struct lldpd_hardware *hardware;
 	caddr_t buffer = NULL;
@@ -71,6 +71,196 @@ interfaces_setup_multicast(struct lldpd *cfg, const char *name, int remove)
 	}
 }
 
+/**
+ * Send interfaces to the monitor by batches to add or remove multicast
+ * addresses.
+ *
+ * @param cfg     Configuration.
+ * @param ifaces  Interfaces. On return, @c fd and @c rc are set.
+ * @param n       Number of interfaces.
+ * @param sockets Whether a socket should be opened for each interface.
+ * @param add     1 to add multicast addresses, 0 to remove them.
+ * @return 0 on success, -1 if interfaces cannot be handled by batches.
+ */
+static int
+interfaces_helper_batch(struct lldpd *cfg, struct priv_iface *ifaces, size_t n,
+    int sockets, int add)
+{
+	struct priv_iface *batch;
+	u_int8_t macs[PRIV_MULTICAST_MAX][ETHER_ADDR_LEN];
+	int protocols[PRIV_MULTICAST_MAX];
+	int *mrc = NULL;
+	size_t i, j, k, count, nmacs = 0;
+	const u_int8_t zero[ETHER_ADDR_LEN] = {};
+
+	for (i = 0; cfg->g_protocols[i].mode != 0; i++) {
+		if (!cfg->g_protocols[i].enabled) continue;
+		for (j = 0; j < sizeof(cfg->g_protocols[0].mac) /
+			 sizeof(cfg->g_protocols[0].mac[0]);
+		     j++) {
+			if (memcmp(cfg->g_protocols[i].mac[j], zero, ETHER_ADDR_LEN) ==
+			    0)
+				break;
+			if (nmacs == PRIV_MULTICAST_MAX) {
+				log_warnx("interfaces",
+				    "too many multicast addresses to handle interfaces by batches");
+				return -1;
+			}
+			memcpy(macs[nmacs], cfg->g_protocols[i].mac[j], ETHER_ADDR_LEN);
+			protocols[nmacs++] = i;
+		}
+	}
+	if (nmacs > 0 &&
+	    (mrc = calloc(PRIV_IFACE_BATCH * nmacs, sizeof(int))) == NULL) {
+		log_warn("interfaces", "unable to handle interfaces by batches");
+		return -1;
+	}
+
+	for (i = 0; i < n; i += PRIV_IFACE_BATCH) {
+		batch = &ifaces[i];
+		count = (n - i > PRIV_IFACE_BATCH) ? PRIV_IFACE_BATCH : n - i;
+		priv_iface_init_batch(batch, count, sockets,
+		    (const u_int8_t(*)[ETHER_ADDR_LEN])macs, nmacs, add, mrc);
+		for (j = 0; j < count; j++) {
+			if (batch[j].rc != 0) continue;
+			for (k = 0; k < nmacs; k++) {
+				if (mrc[j * nmacs + k] == 0 ||
+				    mrc[j * nmacs + k] == ENOENT)
+					continue;
+				log_debug("interfaces",
+				    "unable to %s %s address to multicast filter for %s (%s)",
+				    add ? "add" : "delete",
+				    cfg->g_protocols[protocols[k]].name, batch[j].name,
+				    strerror(mrc[j * nmacs + k]));
+			}
+		}
+	}
+	free(mrc);
+	return 0;
+}
+
+/**
+ * Initialize new interfaces by batches.
+ *
+ * @param cfg        Configuration.
+ * @param interfaces List of interfaces.
+ * @param sockets    Whether a socket should be opened for each interface.
+ *
+ * Physical interfaces without an hardware port yet are initialized with as few
+ * requests to the monitor as possible: the monitor opens the sockets and adds
+ * the multicast addresses. Initialization functions get the result with @c
+ * interfaces_helper_prepared(). The remaining sockets are closed by @c
+ * interfaces_helper_prepared_release().
+ */
+void
+interfaces_helper_prepare(struct lldpd *cfg, struct interfaces_device_list *interfaces,
+    int sockets)
+{
+	struct interfaces_device *iface;
+	struct priv_iface *ifaces;
+	size_t n = 0, count = 0;
+
+	interfaces_helper_prepared_release(cfg);
+	TAILQ_FOREACH (iface, interfaces, next) {
+		if (!(iface->type & IFACE_PHYSICAL_T)) continue;
+		if (iface->ignore) continue;
+		if (lldpd_get_hardware(cfg, iface->name, iface->index) != NULL)
+			continue;
+		count++;
+	}
+	if (count == 0) return;
+
+	if ((ifaces = calloc(count, sizeof(struct priv_iface))) == NULL) {
+		log_warn("interfaces", "unable to initialize interfaces by batches");
+		return;
+	}
+	TAILQ_FOREACH (iface, interfaces, next) {
+		if (!(iface->type & IFACE_PHYSICAL_T)) continue;
+		if (iface->ignore) continue;
+		if (lldpd_get_hardware(cfg, iface->name, iface->index) != NULL)
+			continue;
+		ifaces[n].index = iface->index;
+		strlcpy(ifaces[n].name, iface->name, IFNAMSIZ);
+		n++;
+	}
+
+	log_debug("interfaces", "initialize %zu new interfaces by batches", n);
+	if (interfaces_helper_batch(cfg, ifaces, n, sockets, 1) == -1) {
+		free(ifaces);
+		return;
+	}
+	cfg->g_prepared = ifaces;
+	cfg->g_prepared_count = n;
+	cfg->g_prepared_next = 0;
+}
+
+/**
+ * Get the result of the initialization of an interface by @c
+ * interfaces_helper_prepare().
+ *
+ * @param cfg      Configuration.
+ * @param hardware Interface to initialize.
+ * @param[out] fd  Socket for the interface, now owned by the caller, or -1.
+ * @return 1 if the interface was initialized, 0 otherwise. When initialized,
+ *         multicast addresses were added to the interface if the socket could
+ *         be opened.
+ */
+int
+interfaces_helper_prepared(struct lldpd *cfg, struct lldpd_hardware *hardware,
+    int *fd)
+{
+	struct priv_iface *prepared;
+	size_t i;
+
+	/* Interfaces are usually initialized in the same order */
+	for (i = 0; i < cfg->g_prepared_count; i++) {
+		prepared = &cfg->g_prepared[(cfg->g_prepared_next + i) %
+		    cfg->g_prepared_count];
+		if (prepared->index != hardware->h_ifindex ||
+		    strcmp(prepared->name, hardware->h_ifname) != 0)
+			continue;
+		cfg->g_prepared_next = (prepared - cfg->g_prepared + 1) %
+		    cfg->g_prepared_count;
+		*fd = prepared->fd;
+		if (prepared->rc != 0) errno = prepared->rc;
+		prepared->fd = -1;
+		prepared->index = -1; /* Only once */
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * Close the sockets of the interfaces initialized by @c
+ * interfaces_helper_prepare() that were not used and remove the multicast
+ * addresses added to them, by batches.
+ */
+void
+interfaces_helper_prepared_release(struct lldpd *cfg)
+{
+	size_t i, n = 0;
+
+	/* Unused interfaces are moved to the beginning of the array */
+	for (i = 0; i < cfg->g_prepared_count; i++) {
+		if (cfg->g_prepared[i].index == -1) continue; /* Used */
+		if (cfg->g_prepared[i].fd != -1) close(cfg->g_prepared[i].fd);
+		if (cfg->g_prepared[i].rc == 0)
+			cfg->g_prepared[n++] = cfg->g_prepared[i];
+	}
+	if (n > 0) {
+		log_debug("interfaces", "release %zu unused interfaces by batches",
+		    n);
+		if (interfaces_helper_batch(cfg, cfg->g_prepared, n, 0, 0) == -1)
+			for (i = 0; i < n; i++)
+				interfaces_setup_multicast(cfg,
+				    cfg->g_prepared[i].name, 1);
+	}
+	free(cfg->g_prepared);
+	cfg->g_prepared = NULL;
+	cfg->g_prepared_count = 0;
+	cfg->g_prepared_next = 0;
+}
+
 /**
  * Free an interface.
  *
@@ -178,7 +368,7 @@ interfaces_helper_allowlist(struct lldpd *cfg,
 	if (!cfg->g_config.c_iface_pattern) return;
 
 	TAILQ_FOREACH (iface, interfaces, next) {
-		int m = pattern_match(iface->name, cfg->g_config.c_iface_pattern, 0);
+		int m = pattern_set_match(cfg->g_iface_patterns, iface->name, 0);
 		switch (m) {
 		case PATTERN_MATCH_DENIED:
 			log_debug("interfaces", "deny %s", iface->name);
@@ -355,7 +545,7 @@ interfaces_helper_chassis(struct lldpd *cfg, struct interfaces_device_list *inte
 	TAILQ_FOREACH (iface, interfaces, next) {
 		if (!(iface->type & IFACE_PHYSICAL_T)) continue;
 		if (cfg->g_config.c_cid_pattern &&
-		    !pattern_match(iface->name, cfg->g_config.c_cid_pattern, 0))
+		    !pattern_set_match(cfg->g_cid_patterns, iface->name, 0))
 			continue;
 
 		if ((hardware = lldpd_get_hardware(cfg, iface->name, iface->index)) ==
@@ -448,14 +638,14 @@ interfaces_helper_mgmt_for_af(struct lldpd *cfg, int af,
 		}
 		if (cfg->g_config.c_mgmt_pattern == NULL ||
 		    /* Match on IP address */
-		    pattern_match(addrstrbuf, cfg->g_config.c_mgmt_pattern,
+		    pattern_set_match(cfg->g_mgmt_patterns, addrstrbuf,
 			allnegative) ||
 		    /* Match on interface name */
 		    ((device = interfaces_indextointerface(interfaces, addr->index)) &&
-			pattern_match(device->name, cfg->g_config.c_mgmt_pattern,
+			pattern_set_match(cfg->g_mgmt_patterns, device->name,
 			    allnegative))) {
-			mgmt =
-			    lldpd_alloc_mgmt(af, &in_addr, in_addr_size, addr->index);
+			mgmt = lldpd_alloc_mgmt(NULL, af, &in_addr, in_addr_size,
+			    addr->index);
 			if (mgmt == NULL) {
 				assert(errno == ENOMEM); /* anything else is a bug */
 				log_warn("interfaces", "out of memory error");
@@ -531,7 +721,7 @@ interfaces_helper_mgmt(struct lldpd *cfg, struct interfaces_address_list *addrs,
 				}
 			}
 
-			mgmt = lldpd_alloc_mgmt(af, addr, addr_size,
+			mgmt = lldpd_alloc_mgmt(NULL, af, addr, addr_size,
 			    ifaddr ? ifaddr->index : 0);
 			if (mgmt == NULL) {
 				log_warn("interfaces", "out of memory error");
@@ -566,6 +756,35 @@ interfaces_helper_mgmt(struct lldpd *cfg, struct interfaces_address_list *addrs,
 	}
 }
 
+/* Set the ID of the local port, bumping its generation if it changes */
+static void
+interfaces_helper_port_id(struct lldpd_hardware *hardware, u_int8_t subtype,
+    const void *id, size_t len)
+{
+	struct lldpd_port *port = &hardware->h_lport;
+	if (port->p_id_subtype == subtype && port->p_id_len == len &&
+	    port->p_id != NULL && memcmp(port->p_id, id, len) == 0)
+		return;
+	port->p_id_subtype = subtype;
+	port->p_id_len = len;
+	free(port->p_id);
+	if ((port->p_id = calloc(1, len)) == NULL) fatal("interfaces", NULL);
+	memcpy(port->p_id, id, len);
+	port->p_generation++;
+}
+
+/* Set the description of the local port, bumping its generation if it
+ * changes */
+static void
+interfaces_helper_port_descr(struct lldpd_hardware *hardware, const char *descr)
+{
+	struct lldpd_port *port = &hardware->h_lport;
+	if (port->p_descr != NULL && strcmp(port->p_descr, descr) == 0) return;
+	free(port->p_descr);
+	port->p_descr = strdup(descr);
+	port->p_generation++;
+}
+
 /* Fill up port name and description */
 void
 interfaces_helper_port_name_desc(struct lldpd *cfg, struct lldpd_hardware *hardware,
@@ -585,49 +804,82 @@ interfaces_helper_port_name_desc(struct lldpd *cfg, struct lldpd_hardware *hardw
 		if (port->p_id_subtype != LLDP_PORTID_SUBTYPE_LOCAL) {
 			log_debug("interfaces", "use ifname for %s",
 			    hardware->h_ifname);
-			port->p_id_subtype = LLDP_PORTID_SUBTYPE_IFNAME;
-			port->p_id_len = strlen(hardware->h_ifname);
-			free(port->p_id);
-			if ((port->p_id = calloc(1, port->p_id_len)) == NULL)
-				fatal("interfaces", NULL);
-			memcpy(port->p_id, hardware->h_ifname, port->p_id_len);
+			interfaces_helper_port_id(hardware,
+			    LLDP_PORTID_SUBTYPE_IFNAME, hardware->h_ifname,
+			    strlen(hardware->h_ifname));
 		}
 
 		if (port->p_descr_force == 0) {
 			/* use the actual alias in the port description */
 			log_debug("interfaces", "using alias in description for %s",
 			    hardware->h_ifname);
-			free(port->p_descr);
 			if (has_alias) {
-				port->p_descr = strdup(iface->alias);
+				interfaces_helper_port_descr(hardware, iface->alias);
 			} else {
 				/* We don't have anything else to put here and for CDP
 				 * with need something non-NULL */
-				port->p_descr = strdup(hardware->h_ifname);
+				interfaces_helper_port_descr(hardware,
+				    hardware->h_ifname);
 			}
 		}
 	} else {
 		if (port->p_id_subtype != LLDP_PORTID_SUBTYPE_LOCAL) {
 			log_debug("interfaces", "use MAC address for %s",
 			    hardware->h_ifname);
-			port->p_id_subtype = LLDP_PORTID_SUBTYPE_LLADDR;
-			free(port->p_id);
-			if ((port->p_id = calloc(1, ETHER_ADDR_LEN)) == NULL)
-				fatal("interfaces", NULL);
-			memcpy(port->p_id, hardware->h_lladdr, ETHER_ADDR_LEN);
-			port->p_id_len = ETHER_ADDR_LEN;
+			interfaces_helper_port_id(hardware,
+			    LLDP_PORTID_SUBTYPE_LLADDR, hardware->h_lladdr,
+			    ETHER_ADDR_LEN);
 		}
 
 		if (port->p_descr_force == 0) {
 			/* use the ifname in the port description until alias is set */
 			log_debug("interfaces", "using ifname in description for %s",
 			    hardware->h_ifname);
-			free(port->p_descr);
-			port->p_descr = strdup(hardware->h_ifname);
+			interfaces_helper_port_descr(hardware, hardware->h_ifname);
 		}
 	}
 }
 
+/* Fill up the physical properties of the local port, bumping its generation
+ * if one of them changes */
+void
+interfaces_helper_port_physical(struct lldpd_hardware *hardware,
+    struct interfaces_device *iface, int aggregid)
+{
+	int mtu = iface->mtu ? iface->mtu : 1500;
+
+	if (memcmp(hardware->h_lladdr, iface->address, ETHER_ADDR_LEN) != 0) {
+		memcpy(&hardware->h_lladdr, iface->address, ETHER_ADDR_LEN);
+		hardware->h_lport.p_generation++;
+	}
+	if (hardware->h_mtu != mtu) {
+		hardware->h_mtu = mtu;
+		hardware->h_lport.p_generation++;
+	}
+#ifdef ENABLE_DOT3
+	if (hardware->h_lport.p_aggregid != aggregid) {
+		hardware->h_lport.p_aggregid = aggregid;
+		hardware->h_lport.p_generation++;
+	}
+#endif
+}
+
+/* Fill up MAC/PHY of the local port with `macphy`, bumping its generation if
+ * it changes */
+void
+interfaces_helper_macphy(struct lldpd *cfg, struct lldpd_hardware *hardware,
+    void (*macphy)(struct lldpd *, struct lldpd_hardware *))
+{
+#ifdef ENABLE_DOT3
+	struct lldpd_dot3_macphy previous = hardware->h_lport.p_macphy;
+	macphy(cfg, hardware);
+	if (memcmp(&previous, &hardware->h_lport.p_macphy, sizeof(previous)) != 0)
+		hardware->h_lport.p_generation++;
+#else
+	macphy(cfg, hardware);
+#endif
+}
+
 void
 interfaces_helper_add_hardware(struct lldpd *cfg, struct lldpd_hardware *hardware)
 {
@@ -661,6 +913,14 @@ interfaces_helper_physical(struct lldpd *cfg, struct interfaces_device_list *int
 			created = 1;
 		}
 		if (hardware->h_flags) continue;
+		if (iface->unchanged && !created && hardware->h_ops == ops &&
+		    !hardware->h_ifindex_changed) {
+			/* Keep the local port as is */
+			hardware->h_flags = iface->flags;
+			hardware->h_unchanged = 1;
+			iface->ignore = 1;
+			continue;
+		}
 		if (hardware->h_ops != ops || hardware->h_ifindex_changed) {
 			if (!created) {
 				log_debug("interfaces",
@@ -670,11 +930,19 @@ interfaces_helper_physical(struct lldpd *cfg, struct interfaces_device_list *int
 					hardware->h_ops->cleanup(cfg, hardware);
 					levent_hardware_release(hardware);
 					levent_hardware_init(hardware);
+					/* The transmit timer is gone, ensure
+					 * lldpd_reset_timer() will schedule
+					 * a new one. */
+					hardware->h_lport.p_generation++;
 				}
+				hardware->h_ops = NULL;
 			}
 			if (init(cfg, hardware) != 0) {
 				log_warnx("interfaces", "unable to initialize %s",
 				    hardware->h_ifname);
+				if (!created)
+					TAILQ_REMOVE(&cfg->g_hardware, hardware,
+					    h_entries);
 				lldpd_hardware_cleanup(cfg, hardware);
 				continue;
 			}
@@ -685,7 +953,7 @@ interfaces_helper_physical(struct lldpd *cfg, struct interfaces_device_list *int
 		if (created)
 			interfaces_helper_add_hardware(cfg, hardware);
 		else
-			lldpd_port_cleanup(&hardware->h_lport, 0);
+			lldpd_lport_refresh(hardware);
 
 		hardware->h_flags = iface->flags; /* Should be non-zero */
 		iface->ignore = 1;		  /* Future handlers
@@ -693,21 +961,14 @@ interfaces_helper_physical(struct lldpd *cfg, struct interfaces_device_list *int
 						     care about this
 						     interface. */
 
-		/* Get local address */
-		memcpy(&hardware->h_lladdr, iface->address, ETHER_ADDR_LEN);
+		/* Get local address and additional info */
+		interfaces_helper_port_physical(hardware, iface,
+		    (iface->upper && iface->upper->type & IFACE_BOND_T) ?
+			iface->upper->index :
+			0);
 
 		/* Fill information about port */
 		interfaces_helper_port_name_desc(cfg, hardware, iface);
-
-		/* Fill additional info */
-		hardware->h_mtu = iface->mtu ? iface->mtu : 1500;
-
-#ifdef ENABLE_DOT3
-		if (iface->upper && iface->upper->type & IFACE_BOND_T)
-			hardware->h_lport.p_aggregid = iface->upper->index;
-		else
-			hardware->h_lport.p_aggregid = 0;
-#endif
 	}
 }
 
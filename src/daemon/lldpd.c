@@ -246,6 +246,9 @@ lldpd_alloc_hardware(struct lldpd *cfg, char *name, int index)
 	hardware->h_lport.p_chassis = LOCAL_CHASSIS(cfg);
 	hardware->h_lport.p_chassis->c_refcount++;
 	TAILQ_INIT(&hardware->h_rports);
+#ifdef ENABLE_DOT1
+	TAILQ_INIT(&hardware->h_lport_previous_vlans);
+#endif
 
 #ifdef ENABLE_LLDPMED
 	if (LOCAL_CHASSIS(cfg)->c_med_cap_available) {
@@ -259,8 +262,10 @@ lldpd_alloc_hardware(struct lldpd *cfg, char *name, int index)
 	return hardware;
 }
 
+/* Allocate a management address, from the given arena if not NULL */
 struct lldpd_mgmt *
-lldpd_alloc_mgmt(int family, void *addrptr, size_t addrsize, u_int32_t iface)
+lldpd_alloc_mgmt(struct arena *arena, int family, void *addrptr, size_t addrsize,
+    u_int32_t iface)
 {
 	struct lldpd_mgmt *mgmt;
 
@@ -274,7 +279,7 @@ lldpd_alloc_mgmt(int family, void *addrptr, size_t addrsize, u_int32_t iface)
 		errno = EOVERFLOW;
 		return NULL;
 	}
-	mgmt = calloc(1, sizeof(struct lldpd_mgmt));
+	mgmt = arena_alloc(arena, sizeof(struct lldpd_mgmt));
 	if (mgmt == NULL) {
 		errno = ENOMEM;
 		return NULL;
@@ -286,14 +291,113 @@ lldpd_alloc_mgmt(int family, void *addrptr, size_t addrsize, u_int32_t iface)
 	return mgmt;
 }
 
+#ifdef ENABLE_DOT1
+static void
+lldpd_lport_previous_vlans_cleanup(struct lldpd_hardware *hardware)
+{
+	struct lldpd_vlan *vlan;
+	while ((vlan = TAILQ_FIRST(&hardware->h_lport_previous_vlans)) != NULL) {
+		TAILQ_REMOVE(&hardware->h_lport_previous_vlans, vlan, v_entries);
+		free(vlan->v_name);
+		free(vlan);
+	}
+}
+
+/* Tell if the VLANs of the local port changed since lldpd_lport_refresh() and
+ * release the previous ones. */
+static int
+lldpd_lport_vlans_changed(struct lldpd_hardware *hardware)
+{
+	struct lldpd_port *port = &hardware->h_lport;
+	struct lldpd_vlan *vlan, *previous;
+	int changed = (port->p_pvid != hardware->h_lport_previous_pvid);
+
+	previous = TAILQ_FIRST(&hardware->h_lport_previous_vlans);
+	TAILQ_FOREACH (vlan, &port->p_vlans, v_entries) {
+		if (changed) break;
+		if (previous == NULL || previous->v_vid != vlan->v_vid ||
+		    strcmp(previous->v_name, vlan->v_name) != 0)
+			changed = 1;
+		else
+			previous = TAILQ_NEXT(previous, v_entries);
+	}
+	if (previous != NULL) changed = 1;
+	lldpd_lport_previous_vlans_cleanup(hardware);
+	return changed;
+}
+#endif
+
+/**
+ * Prepare the local port of `hardware` to be filled again by the interface
+ * helpers. Properties are only replaced, and the generation of the port bumped,
+ * when their value changes. VLANs are rebuilt from scratch: the previous ones
+ * are kept to be compared with the new ones by lldpd_reset_timer().
+ */
+void
+lldpd_lport_refresh(struct lldpd_hardware *hardware)
+{
+	struct lldpd_port *port = &hardware->h_lport;
+#ifdef ENABLE_DOT1
+	struct lldpd_vlan *vlan;
+
+	lldpd_lport_previous_vlans_cleanup(hardware);
+	hardware->h_lport_previous_pvid = port->p_pvid;
+	while ((vlan = TAILQ_FIRST(&port->p_vlans)) != NULL) {
+		TAILQ_REMOVE(&port->p_vlans, vlan, v_entries);
+		TAILQ_INSERT_TAIL(&hardware->h_lport_previous_vlans, vlan, v_entries);
+	}
+#endif
+	lldpd_port_cleanup(port, 0);
+}
+
+/**
+ * Get the generation of an interface.
+ *
+ * Changes of neighbors bump the generation directly. Other changes are only
+ * detected here, from the counters and the generations of the local port and
+ * chassis, to avoid tracking each of them.
+ */
+u_int32_t
+lldpd_hardware_generation(struct lldpd_hardware *hardware)
+{
+	struct lldpd_port *port = &hardware->h_lport;
+	/* Counters are contiguous, from h_tx_cnt to h_drop_cnt */
+	const void *counters = &hardware->h_tx_cnt;
+
+	if (port->p_generation != hardware->h_state.lport_generation ||
+	    port->p_chassis->c_generation !=
+		hardware->h_state.lchassis_generation ||
+	    memcmp(counters, hardware->h_state.counters,
+		sizeof(hardware->h_state.counters)) != 0) {
+		hardware->h_state.lport_generation = port->p_generation;
+		hardware->h_state.lchassis_generation =
+		    port->p_chassis->c_generation;
+		memcpy(hardware->h_state.counters, counters,
+		    sizeof(hardware->h_state.counters));
+		hardware->h_generation++;
+	}
+	return hardware->h_generation;
+}
+
 void
 lldpd_hardware_cleanup(struct lldpd *cfg, struct lldpd_hardware *hardware)
 {
+	struct lldpd_port *port;
+
 	log_debug("alloc", "cleanup hardware port %s", hardware->h_ifname);
 
-	free(hardware->h_lport_previous);
+	/* Remote ports are usually already removed. When they are not, for
+	 * example when the port cannot be initialized again, they should not
+	 * stay in the expiry heap. */
+	TAILQ_FOREACH (port, &hardware->h_rports, p_entries)
+		expiry_remove(&cfg->g_expiry, port);
+	lldpd_remote_cleanup(hardware, NULL, 1);
 	free(hardware->h_lchassis_previous_id);
 	free(hardware->h_lport_previous_id);
+#ifdef ENABLE_DOT1
+	lldpd_lport_previous_vlans_cleanup(hardware);
+#endif
+	lldpd_tx_cache_cleanup(hardware);
 	lldpd_port_cleanup(&hardware->h_lport, 1);
 	if (hardware->h_ops && hardware->h_ops->cleanup)
 		hardware->h_ops->cleanup(cfg, hardware);
@@ -360,58 +464,74 @@ notify_clients_deletion(struct lldpd_hardware *hardware, struct lldpd_port *rpor
 {
 	TRACE(LLDPD_NEIGHBOR_DELETE(hardware->h_ifname, rport->p_chassis->c_name,
 	    rport->p_descr));
-	levent_ctl_notify(hardware->h_ifname, NEIGHBOR_CHANGE_DELETED, rport);
+	hardware->h_generation++;
+	levent_ctl_notify(hardware->h_ifname, NEIGHBOR_CHANGE_DELETED, rport,
+	    NEIGHBOR_UNCHANGED_ALL);
+	levent_schedule_snapshot(hardware->h_cfg);
 #ifdef USE_SNMP
 	agent_notify(hardware, NEIGHBOR_CHANGE_DELETED, rport);
 #endif
 }
 
+/* Called for each remote port about to be removed */
+static void
+lldpd_remote_removed(struct lldpd_hardware *hardware, struct lldpd_port *rport)
+{
+	expiry_remove(&hardware->h_cfg->g_expiry, rport);
+	notify_clients_deletion(hardware, rport);
+}
+
 static void
 lldpd_reset_timer(struct lldpd *cfg)
 {
 	/* Reset timer for ports that have been changed. */
 	struct lldpd_hardware *hardware;
+	struct lldpd_chassis *chassis = LOCAL_CHASSIS(cfg);
+	struct lldpd_port *port;
+	u_int32_t hash;
+
+#ifdef USE_SNMP
+	/* Local addresses, VLANs, PPVIDs and PIs have been freed and rebuilt
+	 * even when their content did not change. */
+	agent_index_invalidate();
+#endif
+
+	/* The local chassis is rebuilt on each update. Its generation is bumped
+	 * only if its content changed. */
+	hash = marshal_hash(lldpd_chassis, chassis, LLDPD_CHASSIS_START_MARKER);
+	if (hash != cfg->g_lchassis_hash) {
+		cfg->g_lchassis_hash = hash;
+		chassis->c_generation++;
+	}
+
 	TAILQ_FOREACH (hardware, &cfg->g_hardware, h_entries) {
-		/* We keep a flat copy of the local port to see if there is any
-		 * change. To do this, we zero out fields that are not
-		 * significant, marshal the port, then restore. */
-		struct lldpd_port *port = &hardware->h_lport;
-		/* Take the current flags into account to detect a change. */
-		port->_p_hardware_flags = hardware->h_flags;
-		u_int8_t *output = NULL;
-		ssize_t output_len;
-		char save[LLDPD_PORT_START_MARKER];
-		memcpy(save, port, sizeof(save));
-		/* coverity[sizeof_mismatch]
-		   We intentionally partially memset port */
-		memset(port, 0, sizeof(save));
-		output_len = lldpd_port_serialize(port, (void **)&output);
-		memcpy(port, save, sizeof(save));
-		if (output_len == -1) {
-			log_warnx("localchassis",
-			    "unable to serialize local port %s to check for differences",
-			    hardware->h_ifname);
-			continue;
+		port = &hardware->h_lport;
+		/* Interface helpers and clients bump the generation when they
+		 * modify the port. Only rebuilt VLANs and flags are checked
+		 * here. */
+		if (port->_p_hardware_flags != hardware->h_flags) {
+			port->_p_hardware_flags = hardware->h_flags;
+			port->p_generation++;
 		}
+#ifdef ENABLE_DOT1
+		if (!hardware->h_unchanged && lldpd_lport_vlans_changed(hardware))
+			port->p_generation++;
+#endif
 
-		/* Compare with the previous value */
-		if (!hardware->h_ifindex_changed && hardware->h_lport_previous &&
-		    output_len == hardware->h_lport_previous_len &&
-		    !memcmp(output, hardware->h_lport_previous, output_len)) {
+		if (!hardware->h_ifindex_changed &&
+		    port->p_generation == hardware->h_lport_generation &&
+		    chassis->c_generation == hardware->h_lchassis_generation) {
 			log_debug("localchassis", "no change detected for port %s",
 			    hardware->h_ifname);
-		} else {
-			log_debug("localchassis",
-			    "change detected for port %s, resetting its timer",
-			    hardware->h_ifname);
-			hardware->h_ifindex_changed = 0;
-			levent_schedule_pdu(hardware);
+			continue;
 		}
-
-		/* Update the value */
-		free(hardware->h_lport_previous);
-		hardware->h_lport_previous = output;
-		hardware->h_lport_previous_len = output_len;
+		log_debug("localchassis",
+		    "change detected for port %s, resetting its timer",
+		    hardware->h_ifname);
+		hardware->h_ifindex_changed = 0;
+		hardware->h_lport_generation = port->p_generation;
+		hardware->h_lchassis_generation = chassis->c_generation;
+		levent_schedule_pdu(hardware);
 	}
 }
 
@@ -425,11 +545,30 @@ lldpd_all_chassis_cleanup(struct lldpd *cfg)
 		chassis_next = TAILQ_NEXT(chassis, c_entries);
 		if (chassis->c_refcount == 0) {
 			TAILQ_REMOVE(&cfg->g_chassis, chassis, c_entries);
+			hash_remove(&cfg->g_chassis_index, &chassis->c_hentry);
 			lldpd_chassis_cleanup(chassis, 1);
 		}
 	}
 }
 
+/* Remove remote ports whose TTL is over. Return the number of removed ports. */
+static int
+lldpd_expire_ports(struct lldpd *cfg)
+{
+	struct lldpd_hardware *hardware;
+	struct lldpd_port *port;
+	time_t now = time(NULL);
+	int count = 0;
+
+	while (expiry_due(&cfg->g_expiry, now, &hardware, &port)) {
+		log_debug("localchassis", "remote port on %s has expired",
+		    hardware->h_ifname);
+		lldpd_remote_expire(hardware, port, lldpd_remote_removed);
+		count++;
+	}
+	return count;
+}
+
 void
 lldpd_cleanup(struct lldpd *cfg)
 {
@@ -442,8 +581,8 @@ lldpd_cleanup(struct lldpd *cfg)
 		hardware_next = TAILQ_NEXT(hardware, h_entries);
 		if (!hardware->h_flags) {
 			int m = cfg->g_config.c_perm_ifaces ?
-			    pattern_match(hardware->h_ifname,
-				cfg->g_config.c_perm_ifaces, 0) :
+			    pattern_set_match(cfg->g_perm_patterns,
+				hardware->h_ifname, 0) :
 			    0;
 			switch (m) {
 			case PATTERN_MATCH_DENIED:
@@ -452,29 +591,43 @@ lldpd_cleanup(struct lldpd *cfg)
 				    hardware->h_ifname);
 				TRACE(LLDPD_INTERFACES_DELETE(hardware->h_ifname));
 				TAILQ_REMOVE(&cfg->g_hardware, hardware, h_entries);
-				lldpd_remote_cleanup(hardware, notify_clients_deletion,
+				lldpd_remote_cleanup(hardware, lldpd_remote_removed,
 				    1);
 				lldpd_hardware_cleanup(cfg, hardware);
+#ifdef USE_SNMP
+				agent_index_invalidate();
+#endif
 				break;
 			case PATTERN_MATCH_ALLOWED:
 			case PATTERN_MATCH_ALLOWED_EXACT:
 				log_debug("localchassis", "do not delete %s, permanent",
 				    hardware->h_ifname);
-				lldpd_remote_cleanup(hardware, notify_clients_deletion,
+				lldpd_remote_cleanup(hardware, lldpd_remote_removed,
 				    1);
 				break;
 			}
-		} else {
-			lldpd_remote_cleanup(hardware, notify_clients_deletion,
-			    !(hardware->h_flags & IFF_RUNNING));
+		} else if (!(hardware->h_flags & IFF_RUNNING)) {
+			lldpd_remote_cleanup(hardware, lldpd_remote_removed, 1);
 		}
 	}
 
+	lldpd_expire_ports(cfg);
 	levent_schedule_cleanup(cfg);
 	lldpd_all_chassis_cleanup(cfg);
 	lldpd_count_neighbors(cfg);
 }
 
+/* Only remove remote ports whose TTL is over */
+void
+lldpd_expire(struct lldpd *cfg)
+{
+	if (lldpd_expire_ports(cfg) > 0) {
+		lldpd_all_chassis_cleanup(cfg);
+		lldpd_count_neighbors(cfg);
+	}
+	levent_schedule_cleanup(cfg);
+}
+
 /* Update chassis `ochassis' with values from `chassis'. The later one is not
    expected to be part of a list! It will also be wiped from memory. */
 static void
@@ -482,15 +635,19 @@ lldpd_move_chassis(struct lldpd_chassis *ochassis, struct lldpd_chassis *chassis
 {
 	struct lldpd_mgmt *mgmt, *mgmt_next;
 
-	/* We want to keep refcount, index and list stuff from the current
-	 * chassis */
+	/* We want to keep refcount, index, generation and list stuff from the
+	 * current chassis */
 	TAILQ_ENTRY(lldpd_chassis) entries;
+	struct hash_entry hentry;
 	int refcount = ochassis->c_refcount;
 	int index = ochassis->c_index;
+	u_int32_t generation = ochassis->c_generation;
 	memcpy(&entries, &ochassis->c_entries, sizeof(entries));
+	memcpy(&hentry, &ochassis->c_hentry, sizeof(hentry));
 	lldpd_chassis_cleanup(ochassis, 0);
 
-	/* Make the copy. */
+	/* Make the copy. The reference to the arena of the new chassis, if
+	 * any, is taken over with its content. */
 	/* WARNING: this is a kludgy hack, we need in-place copy and cannot use
 	 * marshaling. */
 	memcpy(ochassis, chassis, sizeof(struct lldpd_chassis));
@@ -506,12 +663,33 @@ lldpd_move_chassis(struct lldpd_chassis *ochassis, struct lldpd_chassis *chassis
 	/* Restore saved values */
 	ochassis->c_refcount = refcount;
 	ochassis->c_index = index;
+	ochassis->c_generation = generation;
 	memcpy(&ochassis->c_entries, &entries, sizeof(entries));
+	memcpy(&ochassis->c_hentry, &hentry, sizeof(hentry));
 
 	/* Get rid of the new chassis */
 	free(chassis);
 }
 
+/* Hash of the key used to find a remote chassis: protocol and chassis ID. */
+static u_int32_t
+lldpd_chassis_hash(u_int8_t protocol, struct lldpd_chassis *chassis)
+{
+	u_int8_t key[] = { protocol, chassis->c_id_subtype };
+	return hash_bytes(hash_bytes(HASH_INIT, key, sizeof(key)), chassis->c_id,
+	    chassis->c_id_len);
+}
+
+/* Hash of the MSAP of a remote port: protocol, chassis ID and port ID. */
+static u_int32_t
+lldpd_msap_hash(struct lldpd_port *port, struct lldpd_chassis *chassis)
+{
+	u_int8_t key[] = { port->p_id_subtype };
+	return hash_bytes(hash_bytes(lldpd_chassis_hash(port->p_protocol, chassis), key,
+			      sizeof(key)),
+	    port->p_id, port->p_id_len);
+}
+
 static int
 lldpd_guess_type(struct lldpd *cfg, char *frame, int s)
 {
@@ -543,13 +721,137 @@ lldpd_guess_type(struct lldpd *cfg, char *frame, int s)
 	return -1;
 }
 
+#define LLDPD_LIST_HASH(type, head) \
+  (TAILQ_EMPTY(head) ? 0 : marshal_hash(type, TAILQ_FIRST(head), 0))
+
+/* Tell which sections of a remote port did not change between `oport' and its
+ * update `port'. `same_chassis' tells if the chassis did not change either. A
+ * chassis shared with other ports is never considered unchanged as their own
+ * updates would not carry it. */
+static int
+lldpd_port_unchanged(struct lldpd_port *oport, struct lldpd_port *port,
+    int same_chassis)
+{
+	int unchanged = 0;
+
+	if (oport->p_chassis->c_refcount == 1 && same_chassis)
+		unchanged |= NEIGHBOR_UNCHANGED_CHASSIS;
+#ifdef ENABLE_DOT1
+	if (LLDPD_LIST_HASH(lldpd_vlan, &oport->p_vlans) ==
+		LLDPD_LIST_HASH(lldpd_vlan, &port->p_vlans) &&
+	    LLDPD_LIST_HASH(lldpd_ppvid, &oport->p_ppvids) ==
+		LLDPD_LIST_HASH(lldpd_ppvid, &port->p_ppvids) &&
+	    LLDPD_LIST_HASH(lldpd_pi, &oport->p_pids) ==
+		LLDPD_LIST_HASH(lldpd_pi, &port->p_pids))
+		unchanged |= NEIGHBOR_UNCHANGED_VLANS;
+#else
+	unchanged |= NEIGHBOR_UNCHANGED_VLANS;
+#endif
+#ifdef ENABLE_CUSTOM
+	if (LLDPD_LIST_HASH(lldpd_custom, &oport->p_custom_list) ==
+	    LLDPD_LIST_HASH(lldpd_custom, &port->p_custom_list))
+		unchanged |= NEIGHBOR_UNCHANGED_CUSTOM;
+#else
+	unchanged |= NEIGHBOR_UNCHANGED_CUSTOM;
+#endif
+	return unchanged;
+}
+
+/* Hash of the content of a remote port, except its custom TLVs. */
+static u_int32_t
+lldpd_port_hash(struct lldpd_port *port)
+{
+#ifdef ENABLE_CUSTOM
+	struct lldpd_custom *custom = TAILQ_FIRST(&port->p_custom_list);
+	u_int32_t hash;
+
+	port->p_custom_list.tqh_first = NULL;
+	hash = marshal_hash(lldpd_port, port, LLDPD_PORT_START_MARKER);
+	port->p_custom_list.tqh_first = custom;
+	return hash;
+#else
+	return marshal_hash(lldpd_port, port, LLDPD_PORT_START_MARKER);
+#endif
+}
+
+/* Tell if the update `port' of remote port `oport' is worth a notification.
+ * Custom TLVs are opaque and some neighbors put counters or timestamps in
+ * them: changes limited to them are not notified. */
+static int
+lldpd_port_changed(struct lldpd_port *oport, struct lldpd_port *port,
+    int same_chassis)
+{
+	if (!same_chassis) return 1;
+	return lldpd_port_hash(oport) != lldpd_port_hash(port);
+}
+
+/* Refresh remote port `oport' with the values of `port', decoded from a new
+ * frame. `oport' keeps its place in lists and indexes, its chassis and its
+ * generation. `port' is freed. */
+static void
+lldpd_move_port(struct lldpd_port *oport, struct lldpd_port *port)
+{
+	struct lldpd_chassis *chassis = oport->p_chassis;
+#ifdef ENABLE_DOT1
+	struct lldpd_vlan *vlan;
+	struct lldpd_ppvid *ppvid;
+	struct lldpd_pi *pi;
+#endif
+#ifdef ENABLE_CUSTOM
+	struct lldpd_custom *custom;
+#endif
+
+	/* Do not release the chassis, it is only updated by the caller */
+	oport->p_chassis = NULL;
+	lldpd_port_cleanup(oport, 1);
+	oport->p_chassis = chassis;
+
+	oport->p_arena = port->p_arena;
+	oport->p_lastframe = port->p_lastframe;
+	memcpy((char *)oport + LLDPD_PORT_START_MARKER,
+	    (char *)port + LLDPD_PORT_START_MARKER,
+	    sizeof(struct lldpd_port) - LLDPD_PORT_START_MARKER);
+
+	/* Lists have to be moved, their heads point to the new port */
+#ifdef ENABLE_DOT1
+	TAILQ_INIT(&oport->p_vlans);
+	while ((vlan = TAILQ_FIRST(&port->p_vlans)) != NULL) {
+		TAILQ_REMOVE(&port->p_vlans, vlan, v_entries);
+		TAILQ_INSERT_TAIL(&oport->p_vlans, vlan, v_entries);
+	}
+	TAILQ_INIT(&oport->p_ppvids);
+	while ((ppvid = TAILQ_FIRST(&port->p_ppvids)) != NULL) {
+		TAILQ_REMOVE(&port->p_ppvids, ppvid, p_entries);
+		TAILQ_INSERT_TAIL(&oport->p_ppvids, ppvid, p_entries);
+	}
+	TAILQ_INIT(&oport->p_pids);
+	while ((pi = TAILQ_FIRST(&port->p_pids)) != NULL) {
+		TAILQ_REMOVE(&port->p_pids, pi, p_entries);
+		TAILQ_INSERT_TAIL(&oport->p_pids, pi, p_entries);
+	}
+#endif
+#ifdef ENABLE_CUSTOM
+	TAILQ_INIT(&oport->p_custom_list);
+	while ((custom = TAILQ_FIRST(&port->p_custom_list)) != NULL) {
+		TAILQ_REMOVE(&port->p_custom_list, custom, next);
+		TAILQ_INSERT_TAIL(&oport->p_custom_list, custom, next);
+	}
+#endif
+
+	free(port);
+}
+
 static void
 lldpd_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardware)
 {
 	int i;
-	struct lldpd_chassis *chassis, *ochassis = NULL;
+	struct lldpd_chassis *chassis, *ochassis = NULL, *achassis;
 	struct lldpd_port *port, *oport = NULL, *aport;
-	int guess = LLDPD_MODE_LLDP;
+	struct hash_entry *entry;
+	u_int32_t frame_hash;
+	int guess = LLDPD_MODE_LLDP, unchanged = 0, modified = 1, notify = 1;
+	int same_chassis = 0;
+	time_t now;
 
 	log_debug("decode", "decode a received frame on %s", hardware->h_ifname);
 
@@ -570,12 +872,15 @@ lldpd_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardw
 		s -= 4;
 	}
 
-	TAILQ_FOREACH (oport, &hardware->h_rports, p_entries) {
-		if ((oport->p_lastframe != NULL) && (oport->p_lastframe->size == s) &&
-		    (memcmp(oport->p_lastframe->frame, frame, s) == 0)) {
+	frame_hash = hash_bytes(HASH_INIT, frame, s);
+	HASH_FOREACH (entry, &hardware->h_rports_frame, frame_hash) {
+		aport = HASH_ENTRY(entry, struct lldpd_port, p_frame_hentry);
+		if ((aport->p_lastframe->size == s) &&
+		    (memcmp(aport->p_lastframe->frame, frame, s) == 0)) {
 			/* Already received the same frame */
 			log_debug("decode", "duplicate frame, no need to decode");
-			oport->p_lastupdate = time(NULL);
+			aport->p_lastupdate = time(NULL);
+			expiry_update(&cfg->g_expiry, hardware, aport);
 			return;
 		}
 	}
@@ -608,26 +913,26 @@ lldpd_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardw
 	    chassis->c_name, port->p_descr));
 
 	/* Do we already have the same MSAP somewhere? */
-	int count = 0;
 	log_debug("decode", "search for the same MSAP");
-	TAILQ_FOREACH (oport, &hardware->h_rports, p_entries) {
-		if (port->p_protocol == oport->p_protocol) {
-			count++;
-			if ((port->p_id_subtype == oport->p_id_subtype) &&
-			    (port->p_id_len == oport->p_id_len) &&
-			    (memcmp(port->p_id, oport->p_id, port->p_id_len) == 0) &&
-			    (chassis->c_id_subtype == oport->p_chassis->c_id_subtype) &&
-			    (chassis->c_id_len == oport->p_chassis->c_id_len) &&
-			    (memcmp(chassis->c_id, oport->p_chassis->c_id,
-				 chassis->c_id_len) == 0)) {
-				ochassis = oport->p_chassis;
-				log_debug("decode", "MSAP is already known");
-				break;
-			}
+	HASH_FOREACH (entry, &hardware->h_rports_msap, lldpd_msap_hash(port, chassis)) {
+		aport = HASH_ENTRY(entry, struct lldpd_port, p_msap_hentry);
+		if ((port->p_protocol == aport->p_protocol) &&
+		    (port->p_id_subtype == aport->p_id_subtype) &&
+		    (port->p_id_len == aport->p_id_len) &&
+		    (memcmp(port->p_id, aport->p_id, port->p_id_len) == 0) &&
+		    (chassis->c_id_subtype == aport->p_chassis->c_id_subtype) &&
+		    (chassis->c_id_len == aport->p_chassis->c_id_len) &&
+		    (memcmp(chassis->c_id, aport->p_chassis->c_id, chassis->c_id_len) ==
+			0)) {
+			oport = aport;
+			ochassis = oport->p_chassis;
+			log_debug("decode", "MSAP is already known");
+			break;
 		}
 	}
 	/* Do we have room for a new MSAP? */
 	if (!oport && cfg->g_config.c_max_neighbors) {
+		int count = hardware->h_rports_count[port->p_protocol];
 		if (count == (cfg->g_config.c_max_neighbors - 1)) {
 			log_debug("decode",
 			    "max neighbors %d reached for port %s, "
@@ -643,30 +948,60 @@ lldpd_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardw
 			return;
 		}
 	}
+	/* Ensure we can track expiration of a new MSAP */
+	if (!oport && expiry_reserve(&cfg->g_expiry) == -1) {
+		lldpd_port_cleanup(port, 1);
+		lldpd_chassis_cleanup(chassis, 1);
+		free(port);
+		return;
+	}
 	/* No, but do we already know the system? */
 	if (!oport) {
 		log_debug("decode", "MSAP is unknown, search for the chassis");
-		TAILQ_FOREACH (ochassis, &cfg->g_chassis, c_entries) {
-			if ((chassis->c_protocol == ochassis->c_protocol) &&
-			    (chassis->c_id_subtype == ochassis->c_id_subtype) &&
-			    (chassis->c_id_len == ochassis->c_id_len) &&
-			    (memcmp(chassis->c_id, ochassis->c_id, chassis->c_id_len) ==
-				0))
+		HASH_FOREACH (entry, &cfg->g_chassis_index,
+		    lldpd_chassis_hash(chassis->c_protocol, chassis)) {
+			achassis = HASH_ENTRY(entry, struct lldpd_chassis, c_hentry);
+			if ((chassis->c_protocol == achassis->c_protocol) &&
+			    (chassis->c_id_subtype == achassis->c_id_subtype) &&
+			    (chassis->c_id_len == achassis->c_id_len) &&
+			    (memcmp(chassis->c_id, achassis->c_id, chassis->c_id_len) ==
+				0)) {
+				ochassis = achassis;
 				break;
+			}
 		}
 	}
 
+	/* A shutdown LLDPDU does not carry the chassis, keep the known one */
+	if (ochassis &&
+	    (port->p_ttl == 0 ||
+		marshal_hash(lldpd_chassis, ochassis, LLDPD_CHASSIS_START_MARKER) ==
+		    marshal_hash(lldpd_chassis, chassis, LLDPD_CHASSIS_START_MARKER)))
+		same_chassis = 1;
+
 	if (oport) {
-		/* The port is known, remove it before adding it back */
-		TAILQ_REMOVE(&hardware->h_rports, oport, p_entries);
-		lldpd_port_cleanup(oport, 1);
-		free(oport);
+		/* The port is known, refresh it in place */
+		unchanged = lldpd_port_unchanged(oport, port, same_chassis);
+		notify = lldpd_port_changed(oport, port, same_chassis);
+		modified = notify || !(unchanged & NEIGHBOR_UNCHANGED_CUSTOM);
+		hash_remove(&hardware->h_rports_frame, &oport->p_frame_hentry);
+		lldpd_move_port(oport, port);
+		port = oport;
+		if (notify) {
+			/* Delta subscribers still have the custom TLVs that were
+			 * current when they were last notified */
+			if (port->p_custom_changed)
+				unchanged &= ~NEIGHBOR_UNCHANGED_CUSTOM;
+			port->p_custom_changed = 0;
+			port->p_generation++;
+		} else if (modified)
+			port->p_custom_changed = 1;
 	}
 	if (ochassis) {
-		if (port->p_ttl == 0) {
-			/* Shutdown LLDPDU is special. We do not want to replace
-			 * the chassis. Free the new chassis (which is mostly empty) */
-			log_debug("decode", "received a shutdown LLDPDU");
+		if (same_chassis) {
+			/* Keep the known chassis. Free the new one. */
+			if (port->p_ttl == 0)
+				log_debug("decode", "received a shutdown LLDPDU");
 			lldpd_chassis_cleanup(chassis, 1);
 		} else {
 			lldpd_move_chassis(ochassis, chassis);
@@ -678,60 +1013,75 @@ lldpd_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardw
 		chassis->c_index = ++cfg->g_lastrid;
 		chassis->c_refcount = 0;
 		TAILQ_INSERT_TAIL(&cfg->g_chassis, chassis, c_entries);
-		i = 0;
-		TAILQ_FOREACH (ochassis, &cfg->g_chassis, c_entries)
-			i++;
-		log_debug("decode", "%d different systems are known", i);
-	}
-	/* Add port */
-	port->p_lastchange = port->p_lastupdate = time(NULL);
-	if ((port->p_lastframe = (struct lldpd_frame *)malloc(
+		hash_insert(&cfg->g_chassis_index, &chassis->c_hentry,
+		    lldpd_chassis_hash(chassis->c_protocol, chassis));
+		log_debug("decode", "%u different systems are known",
+		    cfg->g_chassis_index.ht_count + 1);
+	}
+	/* Add or update port */
+	now = time(NULL);
+	port->p_lastupdate = now;
+	if (modified) port->p_lastchange = now;
+	if ((port->p_lastframe = (struct lldpd_frame *)arena_alloc(port->p_arena,
 		 s + sizeof(struct lldpd_frame))) != NULL) {
 		port->p_lastframe->size = s;
 		memcpy(port->p_lastframe->frame, frame, s);
+		hash_insert(&hardware->h_rports_frame, &port->p_frame_hentry,
+		    frame_hash);
 	}
-	TAILQ_INSERT_TAIL(&hardware->h_rports, port, p_entries);
-	port->p_chassis = chassis;
-	port->p_chassis->c_refcount++;
-	/* Several cases are possible :
-	     1. chassis is new, its refcount was 0. It is now attached
-		to this port, its refcount is 1.
-	     2. chassis already exists and was attached to another
-		port, we increase its refcount accordingly.
-	     3. chassis already exists and was attached to the same
-		port, its refcount was decreased with
-		lldpd_port_cleanup() and is now increased again.
-
-	   In all cases, if the port already existed, it has been
-	   freed with lldpd_port_cleanup() and therefore, the refcount
-	   of the chassis that was attached to it is decreased.
-	*/
-	i = 0;
-	/* coverity[use_after_free]
-	   TAILQ_REMOVE does the right thing */
-	TAILQ_FOREACH (aport, &hardware->h_rports, p_entries)
-		i++;
+	expiry_update(&cfg->g_expiry, hardware, port);
+	if (!oport) {
+		TAILQ_INSERT_TAIL(&hardware->h_rports, port, p_entries);
+		hardware->h_rports_count[port->p_protocol]++;
+		hash_insert(&hardware->h_rports_msap, &port->p_msap_hentry,
+		    lldpd_msap_hash(port, chassis));
+		/* The chassis is either new (its refcount was 0) or already
+		 * attached to other ports. A refreshed port keeps its chassis
+		 * and its reference. */
+		port->p_chassis = chassis;
+		port->p_chassis->c_refcount++;
+		hardware->h_insert_cnt++;
+	}
+	i = hardware->h_rports_msap.ht_count;
 	log_debug("decode", "%d neighbors for %s", i, hardware->h_ifname);
 
-	if (!oport) hardware->h_insert_cnt++;
+	if (!notify) {
+		/* The content of the port has been replaced anyway */
+#ifdef USE_SNMP
+		agent_index_invalidate();
+#endif
+		if (!modified) {
+			log_debug("decode", "no change for neighbor on %s",
+			    hardware->h_ifname);
+			return;
+		}
+		log_debug("decode", "only custom TLVs changed for neighbor on %s",
+		    hardware->h_ifname);
+		hardware->h_generation++;
+		levent_schedule_snapshot(cfg);
+		return;
+	}
 
 	/* Notify */
 	log_debug("decode", "send notifications for changes on %s", hardware->h_ifname);
+	hardware->h_generation++;
 	if (oport) {
 		TRACE(LLDPD_NEIGHBOR_UPDATE(hardware->h_ifname, chassis->c_name,
 		    port->p_descr, i));
-		levent_ctl_notify(hardware->h_ifname, NEIGHBOR_CHANGE_UPDATED, port);
+		levent_ctl_notify(hardware->h_ifname, NEIGHBOR_CHANGE_UPDATED, port,
+		    unchanged);
 #ifdef USE_SNMP
 		agent_notify(hardware, NEIGHBOR_CHANGE_UPDATED, port);
 #endif
 	} else {
 		TRACE(LLDPD_NEIGHBOR_NEW(hardware->h_ifname, chassis->c_name,
 		    port->p_descr, i));
-		levent_ctl_notify(hardware->h_ifname, NEIGHBOR_CHANGE_ADDED, port);
+		levent_ctl_notify(hardware->h_ifname, NEIGHBOR_CHANGE_ADDED, port, 0);
 #ifdef USE_SNMP
 		agent_notify(hardware, NEIGHBOR_CHANGE_ADDED, port);
 #endif
 	}
+	levent_schedule_snapshot(cfg);
 
 #ifdef ENABLE_LLDPMED
 	if (!oport && port->p_chassis->c_med_type) {
@@ -1011,6 +1361,7 @@ lldpd_dot3_power_pd_pse(struct lldpd_hardware *hardware)
 		    selected_port->p_power.allocated_a;
 		hardware->h_lport.p_power.allocated_b =
 		    selected_port->p_power.allocated_b;
+		hardware->h_lport.p_generation++;
 		levent_schedule_pdu(hardware);
 	}
 
@@ -1020,49 +1371,75 @@ lldpd_dot3_power_pd_pse(struct lldpd_hardware *hardware)
 		hardware->h_lport.p_cdp_power.management_id) {
 		hardware->h_lport.p_cdp_power.management_id =
 		    selected_port->p_cdp_power.management_id;
+		hardware->h_lport.p_generation++;
 	}
 #  endif
 
 #endif
 }
 
-void
-lldpd_recv(struct lldpd *cfg, struct lldpd_hardware *hardware, int fd)
+/* Handle one received frame. Return -1 if the frame is ignored. */
+int
+lldpd_recv_frame(struct lldpd *cfg, struct lldpd_hardware *hardware, char *frame,
+    size_t size)
 {
-	char *buffer = NULL;
-	int n;
-	log_debug("receive", "receive a frame on %s", hardware->h_ifname);
-	if ((buffer = (char *)malloc(hardware->h_mtu)) == NULL) {
-		log_warn("receive", "failed to alloc reception buffer");
-		return;
-	}
-	if ((n = hardware->h_ops->recv(cfg, hardware, fd, buffer, hardware->h_mtu)) ==
-	    -1) {
-		log_debug("receive", "discard frame received on %s",
-		    hardware->h_ifname);
-		free(buffer);
-		return;
-	}
 	if (hardware->h_lport.p_disable_rx) {
 		log_debug("receive", "RX disabled, ignore the frame on %s",
 		    hardware->h_ifname);
-		free(buffer);
-		return;
+		return -1;
 	}
 	if (cfg->g_config.c_paused) {
 		log_debug("receive", "paused, ignore the frame on %s",
 		    hardware->h_ifname);
-		free(buffer);
-		return;
+		return -1;
 	}
 	hardware->h_rx_cnt++;
 	log_debug("receive", "decode received frame on %s", hardware->h_ifname);
-	TRACE(LLDPD_FRAME_RECEIVED(hardware->h_ifname, buffer, (size_t)n));
-	lldpd_decode(cfg, buffer, n, hardware);
+	TRACE(LLDPD_FRAME_RECEIVED(hardware->h_ifname, frame, size));
+	lldpd_decode(cfg, frame, size, hardware);
+	return 0;
+}
+
+void
+lldpd_recv(struct lldpd *cfg, struct lldpd_hardware *hardware, int fd)
+{
+	char *buffer = NULL;
+	int n;
+	log_debug("receive", "receive a frame on %s", hardware->h_ifname);
+	if (hardware->h_ops->recv_batch) {
+		if (hardware->h_ops->recv_batch(cfg, hardware, fd, lldpd_recv_frame) <= 0)
+			return;
+	} else {
+		if ((buffer = (char *)malloc(hardware->h_mtu)) == NULL) {
+			log_warn("receive", "failed to alloc reception buffer");
+			return;
+		}
+		if ((n = hardware->h_ops->recv(cfg, hardware, fd, buffer,
+			 hardware->h_mtu)) == -1) {
+			log_debug("receive", "discard frame received on %s",
+			    hardware->h_ifname);
+			free(buffer);
+			return;
+		}
+		n = lldpd_recv_frame(cfg, hardware, buffer, n);
+		free(buffer);
+		if (n == -1) return;
+	}
+	lldpd_recv_done(cfg, hardware);
+}
+
+/* To be called after frames have been received on `hardware` (or on several
+ * ports when NULL) */
+void
+lldpd_recv_done(struct lldpd *cfg, struct lldpd_hardware *hardware)
+{
 	lldpd_hide_all(cfg); /* Immediatly hide */
-	lldpd_dot3_power_pd_pse(hardware);
+	if (hardware)
+		lldpd_dot3_power_pd_pse(hardware);
+	else
+		TAILQ_FOREACH (hardware, &cfg->g_hardware, h_entries)
+			lldpd_dot3_power_pd_pse(hardware);
 	lldpd_count_neighbors(cfg);
-	free(buffer);
 }
 
 static void
@@ -1080,6 +1457,102 @@ lldpd_send_shutdown(struct lldpd_hardware *hardware)
 		    hardware->h_ifname);
 }
 
+/* Send again the frames cached for the given protocol. Return -1 if there is
+ * no valid cache. */
+int
+lldpd_send_cached(struct lldpd *cfg, struct lldpd_hardware *hardware, int mode)
+{
+	struct lldpd_tx_cache *cache;
+	struct lldpd_frame *frame;
+	char *buffer;
+	int i, rc;
+
+	if (cfg == NULL || hardware->h_tx_cache == NULL) return -1;
+	cache = &hardware->h_tx_cache[mode];
+	if (cache->tc_count == 0 ||
+	    cache->tc_port_generation != hardware->h_lport.p_generation ||
+	    cache->tc_chassis_generation != hardware->h_lport.p_chassis->c_generation ||
+	    cache->tc_config_generation != cfg->g_config_generation)
+		return -1;
+
+	log_debug("send", "send cached PDU to %s", hardware->h_ifname);
+	for (i = 0; i < cache->tc_count; i++) {
+		frame = cache->tc_frames[i];
+		if (!hardware->h_mangle)
+			rc = interfaces_send_helper(cfg, hardware,
+			    (char *)frame->frame, frame->size);
+		else {
+			/* The source address is mangled in place */
+			if ((buffer = malloc(frame->size)) == NULL) return -1;
+			memcpy(buffer, frame->frame, frame->size);
+			rc = interfaces_send_helper(cfg, hardware, buffer,
+			    frame->size);
+			free(buffer);
+		}
+		if (rc == -1) {
+			log_warn("send", "unable to send packet on real device for %s",
+			    hardware->h_ifname);
+			return ENETDOWN;
+		}
+	}
+	hardware->h_tx_cnt++;
+	return 0;
+}
+
+static void
+lldpd_tx_cache_flush(struct lldpd_tx_cache *cache)
+{
+	int i;
+	for (i = 0; i < cache->tc_count; i++)
+		free(cache->tc_frames[i]);
+	cache->tc_count = 0;
+}
+
+/* Record a frame about to be sent for the given protocol. The first frame of a
+ * transmission (`index` is 0) replaces the previous content of the cache. */
+void
+lldpd_cache_frame(struct lldpd *cfg, struct lldpd_hardware *hardware, int mode,
+    int index, void *packet, size_t len)
+{
+	struct lldpd_tx_cache *cache;
+	struct lldpd_frame *frame;
+
+	if (cfg == NULL || mode <= 0 || mode > LLDPD_MODE_MAX ||
+	    index >= LLDPD_TX_CACHE_FRAMES)
+		return;
+	if (hardware->h_tx_cache == NULL &&
+	    (hardware->h_tx_cache = calloc(LLDPD_MODE_MAX + 1,
+		 sizeof(struct lldpd_tx_cache))) == NULL)
+		return;
+	cache = &hardware->h_tx_cache[mode];
+	if (index == 0) {
+		lldpd_tx_cache_flush(cache);
+		cache->tc_port_generation = hardware->h_lport.p_generation;
+		cache->tc_chassis_generation = hardware->h_lport.p_chassis->c_generation;
+		cache->tc_config_generation = cfg->g_config_generation;
+	} else if (cache->tc_count != index)
+		return; /* Previous frame is missing */
+	if ((frame = malloc(sizeof(int) + len)) == NULL) {
+		lldpd_tx_cache_flush(cache);
+		return;
+	}
+	frame->size = len;
+	memcpy(frame->frame, packet, len);
+	cache->tc_frames[cache->tc_count++] = frame;
+}
+
+/* Drop all frames cached for a port. */
+void
+lldpd_tx_cache_cleanup(struct lldpd_hardware *hardware)
+{
+	int i;
+	if (hardware->h_tx_cache == NULL) return;
+	for (i = 0; i <= LLDPD_MODE_MAX; i++)
+		lldpd_tx_cache_flush(&hardware->h_tx_cache[i]);
+	free(hardware->h_tx_cache);
+	hardware->h_tx_cache = NULL;
+}
+
 void
 lldpd_send(struct lldpd_hardware *hardware)
 {
@@ -1176,6 +1649,21 @@ lldpd_routing_enabled(struct lldpd *cfg)
 	return routing;
 }
 
+/* Compile patterns from the configuration. To be called each time one of
+ * them is changed. */
+void
+lldpd_update_patterns(struct lldpd *cfg)
+{
+	pattern_set_free(cfg->g_iface_patterns);
+	pattern_set_free(cfg->g_perm_patterns);
+	pattern_set_free(cfg->g_mgmt_patterns);
+	pattern_set_free(cfg->g_cid_patterns);
+	cfg->g_iface_patterns = pattern_compile(cfg->g_config.c_iface_pattern);
+	cfg->g_perm_patterns = pattern_compile(cfg->g_config.c_perm_ifaces);
+	cfg->g_mgmt_patterns = pattern_compile(cfg->g_config.c_mgmt_pattern);
+	cfg->g_cid_patterns = pattern_compile(cfg->g_config.c_cid_pattern);
+}
+
 void
 lldpd_update_localchassis(struct lldpd *cfg)
 {
@@ -1268,8 +1756,10 @@ lldpd_update_localchassis(struct lldpd *cfg)
 	}
 }
 
-void
-lldpd_update_localports(struct lldpd *cfg)
+/* Refresh local ports without looking for changes. When `full` is false, only
+ * interfaces that changed since the last update are refreshed. */
+static void
+lldpd_refresh_localports(struct lldpd *cfg, int full)
 {
 	struct lldpd_hardware *hardware;
 
@@ -1278,12 +1768,21 @@ lldpd_update_localports(struct lldpd *cfg)
 	/* h_flags is set to 0 for each port. If the port is updated, h_flags
 	 * will be set to a non-zero value. This will allow us to clean up any
 	 * non up-to-date port */
-	TAILQ_FOREACH (hardware, &cfg->g_hardware, h_entries)
+	TAILQ_FOREACH (hardware, &cfg->g_hardware, h_entries) {
 		hardware->h_flags = 0;
+		hardware->h_unchanged = 0;
+	}
 
 	TRACE(LLDPD_INTERFACES_UPDATE());
-	interfaces_update(cfg);
+	interfaces_update(cfg, full);
 	lldpd_cleanup(cfg);
+}
+
+/* Update local ports and send new PDUs for the ones that changed. */
+void
+lldpd_update_localports(struct lldpd *cfg, int full)
+{
+	lldpd_refresh_localports(cfg, full);
 	lldpd_reset_timer(cfg);
 }
 
@@ -1300,16 +1799,20 @@ lldpd_loop(struct lldpd *cfg)
 	 * update them on some other event because we want to refresh them if we
 	 * missed something. */
 	log_debug("loop", "update information for local ports");
-	lldpd_update_localports(cfg);
+	lldpd_refresh_localports(cfg, 1);
 	log_debug("loop", "update information for local chassis");
 	lldpd_update_localchassis(cfg);
+	/* Look for changes once both the ports and the chassis are complete:
+	 * capabilities are computed in both steps. */
+	lldpd_reset_timer(cfg);
 	lldpd_count_neighbors(cfg);
+	levent_schedule_snapshot(cfg);
 }
 
 static void
 lldpd_exit(struct lldpd *cfg)
 {
-	char *lockname = NULL;
+	char *lockname = NULL, *snapshotname = NULL;
 	struct lldpd_hardware *hardware, *hardware_next;
 	log_debug("main", "exit lldpd");
 
@@ -1322,6 +1825,16 @@ lldpd_exit(struct lldpd *cfg)
 	}
 	close(cfg->g_ctl);
 	priv_ctl_cleanup(cfg->g_ctlname);
+	if (cfg->g_snapshot.s_fd != -1) {
+		/* Readers still mapping the file will see it is gone */
+		if (cfg->g_snapshot.s_map != NULL)
+			snapshot_update(&cfg->g_snapshot, NULL, 0);
+		snapshot_close(&cfg->g_snapshot);
+		if (asprintf(&snapshotname, "%s.snapshot", cfg->g_ctlname) != -1) {
+			priv_ctl_cleanup(snapshotname);
+			free(snapshotname);
+		}
+	}
 	log_debug("main", "cleanup hardware information");
 	for (hardware = TAILQ_FIRST(&cfg->g_hardware); hardware != NULL;
 	     hardware = hardware_next) {
@@ -1333,6 +1846,12 @@ lldpd_exit(struct lldpd *cfg)
 	interfaces_cleanup(cfg);
 	lldpd_port_cleanup(cfg->g_default_local_port, 1);
 	lldpd_all_chassis_cleanup(cfg);
+	hash_free(&cfg->g_chassis_index);
+	expiry_free(&cfg->g_expiry);
+	pattern_set_free(cfg->g_iface_patterns);
+	pattern_set_free(cfg->g_perm_patterns);
+	pattern_set_free(cfg->g_mgmt_patterns);
+	pattern_set_free(cfg->g_cid_patterns);
 	free(cfg->g_default_local_port);
 	free(cfg->g_config.c_platform);
 	levent_shutdown(cfg);
@@ -1837,6 +2356,29 @@ lldpd_main(int argc, char *argv[], char *envp[])
 #endif
 	free(lockname);
 
+	/* Create the file used to publish a snapshot of neighbors. A previous
+	 * one is unlinked: readers still mapping it are not disturbed. */
+	char *snapshotname = NULL;
+	int snapshot;
+	if (asprintf(&snapshotname, "%s.snapshot", ctlname) == -1)
+		fatal("main", "cannot build snapshot name");
+	if (unlink(snapshotname) == -1 && errno != ENOENT)
+		log_warn("main", "unable to remove previous snapshot");
+	if ((snapshot = open(snapshotname, O_CREAT | O_EXCL | O_RDWR, 0000)) == -1)
+		log_warn("main", "cannot create snapshot file");
+	else if (fcntl(snapshot, F_SETFD, FD_CLOEXEC) == -1) {
+		log_warn("main", "unable to set snapshot file as close-on-exec");
+		close(snapshot);
+		snapshot = -1;
+	}
+#ifdef ENABLE_PRIVSEP
+	if (snapshot != -1 && fchown(snapshot, uid, gid) == -1)
+		log_warn("main", "unable to chown snapshot file");
+#endif
+	if (snapshot != -1 && fchmod(snapshot, S_IRUSR | S_IWUSR | S_IRGRP) == -1)
+		log_warn("main", "unable to chmod snapshot file");
+	free(snapshotname);
+
 	/* Disable SIGPIPE */
 	signal(SIGPIPE, SIG_IGN);
 
@@ -1903,9 +2445,11 @@ lldpd_main(int argc, char *argv[], char *envp[])
 	lldpd_alloc_default_local_port(cfg);
 	cfg->g_ctlname = ctlname;
 	cfg->g_ctl = ctl;
+	cfg->g_snapshot.s_fd = snapshot;
 	cfg->g_config.c_mgmt_pattern = mgmtp;
 	cfg->g_config.c_cid_pattern = cidp;
 	cfg->g_config.c_iface_pattern = interfaces;
+	lldpd_update_patterns(cfg);
 	cfg->g_config.c_smart = smart;
 	if (lldpcli) cfg->g_config.c_paused = 1;
 	cfg->g_config.c_receiveonly = receiveonly;
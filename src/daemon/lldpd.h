@@ -54,6 +54,7 @@
 #include "../marshal.h"
 #include "../log.h"
 #include "../ctl.h"
+#include "../snapshot.h"
 #include "../lldpd-structs.h"
 
 /* We don't want to import event2/event.h. We only need those as
@@ -96,21 +97,42 @@ struct protocol {
 
 #define SMART_HIDDEN(port) (port->p_hidden_in)
 
+/* Frames sent for a protocol on a port. They are sent again as is as long as
+ * the local port, the local chassis and the configuration do not change. */
+#define LLDPD_TX_CACHE_FRAMES 2
+struct lldpd_tx_cache {
+	u_int32_t tc_port_generation;
+	u_int32_t tc_chassis_generation;
+	u_int32_t tc_config_generation;
+	int tc_count;
+	struct lldpd_frame *tc_frames[LLDPD_TX_CACHE_FRAMES];
+};
+
 struct lldpd;
 
 /* lldpd.c */
 struct lldpd_hardware *lldpd_get_hardware(struct lldpd *, char *, int);
 struct lldpd_hardware *lldpd_alloc_hardware(struct lldpd *, char *, int);
 void lldpd_hardware_cleanup(struct lldpd *, struct lldpd_hardware *);
-struct lldpd_mgmt *lldpd_alloc_mgmt(int family, void *addr, size_t addrsize,
-    u_int32_t iface);
+void lldpd_lport_refresh(struct lldpd_hardware *);
+u_int32_t lldpd_hardware_generation(struct lldpd_hardware *);
+struct lldpd_mgmt *lldpd_alloc_mgmt(struct arena *, int family, void *addr,
+    size_t addrsize, u_int32_t iface);
 void lldpd_recv(struct lldpd *, struct lldpd_hardware *, int);
+int lldpd_recv_frame(struct lldpd *, struct lldpd_hardware *, char *, size_t);
+void lldpd_recv_done(struct lldpd *, struct lldpd_hardware *);
 void lldpd_send(struct lldpd_hardware *);
+int lldpd_send_cached(struct lldpd *, struct lldpd_hardware *, int);
+void lldpd_cache_frame(struct lldpd *, struct lldpd_hardware *, int, int, void *,
+    size_t);
+void lldpd_tx_cache_cleanup(struct lldpd_hardware *);
 void lldpd_loop(struct lldpd *);
 int lldpd_main(int, char **, char **);
-void lldpd_update_localports(struct lldpd *);
+void lldpd_update_localports(struct lldpd *, int);
 void lldpd_update_localchassis(struct lldpd *);
+void lldpd_update_patterns(struct lldpd *);
 void lldpd_cleanup(struct lldpd *);
+void lldpd_expire(struct lldpd *);
 
 /* frame.c */
 u_int16_t frame_checksum(const u_int8_t *, int, int);
@@ -121,12 +143,15 @@ void levent_shutdown(struct lldpd *);
 void levent_hardware_init(struct lldpd_hardware *);
 void levent_hardware_add_fd(struct lldpd_hardware *, int);
 void levent_hardware_release(struct lldpd_hardware *);
-void levent_ctl_notify(char *, int, struct lldpd_port *);
+void levent_ctl_notify(char *, int, struct lldpd_port *, int);
 void levent_send_now(struct lldpd *);
 void levent_update_now(struct lldpd *);
 int levent_iface_subscribe(struct lldpd *, int);
+int levent_packet_subscribe(struct lldpd *, int, void (*)(struct lldpd *, int));
+void levent_packet_unsubscribe(struct lldpd *);
 void levent_schedule_pdu(struct lldpd_hardware *);
 void levent_schedule_cleanup(struct lldpd *);
+void levent_schedule_snapshot(struct lldpd *);
 int levent_make_socket_nonblocking(int);
 int levent_make_socket_blocking(int);
 #ifdef HOST_OS_LINUX
@@ -179,6 +204,7 @@ char *dmi_asset(void);
 void agent_shutdown(void);
 void agent_init(struct lldpd *, const char *);
 void agent_notify(struct lldpd_hardware *, int, struct lldpd_port *);
+void agent_index_invalidate(void);
 #endif
 
 #ifdef ENABLE_PRIVSEP
@@ -187,9 +213,12 @@ void agent_priv_register_domain(void);
 #endif
 
 /* client.c */
+#define CLIENT_SUBSCRIPTION_MAX_WINDOW 60000 /* Maximum coalescing window (ms) */
+#define CLIENT_SUBSCRIPTION_MAX_QUEUE 65536  /* Maximum of coalesced changes */
 int client_handle_client(struct lldpd *cfg,
     ssize_t (*send)(void *, int, void *, size_t), void *, enum hmsg_type type,
-    void *buffer, size_t n, int *);
+    void *buffer, size_t n, struct lldpd_subscription *);
+void client_publish_snapshot(struct lldpd *);
 
 /* priv.c */
 #ifdef ENABLE_PRIVSEP
@@ -207,6 +236,18 @@ void asroot_open(void);
 int priv_iface_init(int, char *);
 int asroot_iface_init_os(int, char *, int *);
 int priv_iface_multicast(const char *, const u_int8_t *, int);
+/* Interface initialized with priv_iface_init_batch() */
+struct priv_iface {
+	int index;
+	char name[IFNAMSIZ];
+	int fd; /* Socket for the interface or -1 */
+	int rc; /* Error when opening the socket */
+};
+#define PRIV_IFACE_BATCH 128  /* Maximum number of interfaces per request */
+#define PRIV_MULTICAST_MAX 32 /* Maximum number of multicast addresses */
+#define PRIV_FD_BATCH 64      /* Maximum number of descriptors per message */
+void priv_iface_init_batch(struct priv_iface *, size_t, int,
+    const u_int8_t (*)[ETHER_ADDR_LEN], size_t, int, int *);
 int priv_iface_description(const char *, const char *);
 int asroot_iface_description_os(const char *, const char *);
 int priv_iface_promisc(const char *);
@@ -219,6 +260,7 @@ enum priv_cmd {
 	PRIV_GET_HOSTNAME,
 	PRIV_OPEN,
 	PRIV_IFACE_INIT,
+	PRIV_IFACE_INIT_BATCH,
 	PRIV_IFACE_MULTICAST,
 	PRIV_IFACE_DESCRIPTION,
 	PRIV_IFACE_PROMISC,
@@ -240,6 +282,8 @@ void priv_unprivileged_fd(int);
 int priv_fd(enum priv_context);
 int receive_fd(enum priv_context);
 void send_fd(enum priv_context, int);
+void receive_fds(enum priv_context, int *, size_t);
+void send_fds(enum priv_context, const int *, size_t);
 
 /* interfaces-*.c */
 
@@ -285,8 +329,9 @@ void send_fd(enum priv_context, int);
 /* This function is responsible to refresh information about interfaces. It is
  * OS specific but should be present for each OS. It can use the functions in
  * `interfaces.c` as helper by providing a list of OS-independent interface
- * devices. */
-void interfaces_update(struct lldpd *);
+ * devices. When `full` is false, only interfaces which changed since the last
+ * update may be refreshed. */
+void interfaces_update(struct lldpd *, int);
 
 /* interfaces.c */
 /* An interface cannot be both physical and (bridge or bond or vlan) */
@@ -302,6 +347,7 @@ void interfaces_update(struct lldpd *);
 struct interfaces_device {
 	TAILQ_ENTRY(interfaces_device) next;
 	int ignore;			     /* Ignore this interface */
+	int unchanged;			     /* Not changed since last update */
 	int index;			     /* Index */
 	char *name;			     /* Name */
 	char *alias;			     /* Alias */
@@ -317,8 +363,9 @@ struct interfaces_device {
 
 	/* The following are OS specific. Should be static (no free function) */
 #ifdef HOST_OS_LINUX
-	int lower_idx; /* Index to lower interface */
-	int upper_idx; /* Index to upper interface */
+	int lower_idx;		  /* Index to lower interface */
+	int upper_idx;		  /* Index to upper interface */
+	struct hash_entry hentry; /* Index on interface index */
 #endif
 };
 struct interfaces_address {
@@ -328,7 +375,9 @@ struct interfaces_address {
 	struct sockaddr_storage address; /* Address */
 
 	/* The following are OS specific. */
-	/* Nothing yet. */
+#ifdef HOST_OS_LINUX
+	struct hash_entry hentry; /* Index on interface index */
+#endif
 };
 TAILQ_HEAD(interfaces_device_list, interfaces_device);
 TAILQ_HEAD(interfaces_address_list, interfaces_address);
@@ -347,8 +396,15 @@ void interfaces_helper_chassis(struct lldpd *, struct interfaces_device_list *);
 void interfaces_helper_add_hardware(struct lldpd *, struct lldpd_hardware *);
 void interfaces_helper_physical(struct lldpd *, struct interfaces_device_list *,
     struct lldpd_ops *, int (*init)(struct lldpd *, struct lldpd_hardware *));
+void interfaces_helper_prepare(struct lldpd *, struct interfaces_device_list *, int);
+int interfaces_helper_prepared(struct lldpd *, struct lldpd_hardware *, int *);
+void interfaces_helper_prepared_release(struct lldpd *);
 void interfaces_helper_port_name_desc(struct lldpd *, struct lldpd_hardware *,
     struct interfaces_device *);
+void interfaces_helper_port_physical(struct lldpd_hardware *,
+    struct interfaces_device *, int);
+void interfaces_helper_macphy(struct lldpd *, struct lldpd_hardware *,
+    void (*)(struct lldpd *, struct lldpd_hardware *));
 void interfaces_helper_mgmt(struct lldpd *, struct interfaces_address_list *,
     struct interfaces_device_list *);
 #ifdef ENABLE_DOT1
@@ -380,12 +436,35 @@ enum pattern_match_result {
 	PATTERN_MATCH_ALLOWED_EXACT
 };
 enum pattern_match_result pattern_match(char *, char *, int);
+struct pattern_set;
+struct pattern_set *pattern_compile(const char *);
+enum pattern_match_result pattern_set_match(struct pattern_set *, const char *, int);
+void pattern_set_free(struct pattern_set *);
 
 /* bitmap.c */
 void bitmap_set(uint32_t *bmap, uint16_t vlan_id);
 int bitmap_isempty(uint32_t *bmap);
 unsigned int bitmap_numbits(uint32_t *bmap);
 
+/* expiry.c */
+struct expiry_entry {
+	time_t e_when; /* Expiration time */
+	struct lldpd_hardware *e_hardware;
+	struct lldpd_port *e_port;
+};
+struct expiry_heap {
+	struct expiry_entry *eh_entries;
+	u_int32_t eh_count;
+	u_int32_t eh_size;
+};
+int expiry_reserve(struct expiry_heap *);
+int expiry_update(struct expiry_heap *, struct lldpd_hardware *, struct lldpd_port *);
+void expiry_remove(struct expiry_heap *, struct lldpd_port *);
+time_t expiry_next(struct expiry_heap *);
+int expiry_due(struct expiry_heap *, time_t, struct lldpd_hardware **,
+    struct lldpd_port **);
+void expiry_free(struct expiry_heap *);
+
 struct lldpd {
 	int g_sock;
 	struct event_base *g_base;
@@ -393,11 +472,20 @@ struct lldpd {
 #endif
 
 	struct lldpd_config g_config;
+	u_int32_t g_config_generation; /* Bumped on each configuration change */
 
 	struct protocol *g_protocols;
 	int g_lastrid;
 	struct event *g_main_loop;
 	struct event *g_cleanup_timer;
+	struct event *g_snapshot_timer;
+	struct snapshot g_snapshot; /* Neighbors published for local clients */
+	struct expiry_heap g_expiry; /* Remote ports, by expiration time */
+	/* Patterns from the configuration, compiled by lldpd_update_patterns() */
+	struct pattern_set *g_iface_patterns;
+	struct pattern_set *g_perm_patterns;
+	struct pattern_set *g_mgmt_patterns;
+	struct pattern_set *g_cid_patterns;
 #ifdef USE_SNMP
 	int g_snmp;
 	struct event *g_snmp_timeout;
@@ -413,16 +501,27 @@ struct lldpd {
 	    *g_iface_timer_event; /* Triggered one second after last interface change */
 	void (*g_iface_cb)(
 	    struct lldpd *); /* Called when there is an interface change */
+	struct event *g_packet_event; /* Triggered when a frame is received on the
+					 socket shared by all ports */
+	void (*g_packet_cb)(struct lldpd *,
+	    int); /* Called to receive frames from the shared socket */
 
 	char *g_lsb_release;
 
+	struct priv_iface *g_prepared; /* Interfaces initialized in advance */
+	size_t g_prepared_count, g_prepared_next;
+
 #ifdef HOST_OS_LINUX
 	struct lldpd_netlink *g_netlink;
+	struct lldpd_shared *g_shared; /* Socket shared by all ports */
+	struct lldpd_recv_batch *g_recv_batch; /* Reception buffers */
 #endif
 
 	struct lldpd_port *g_default_local_port;
 #define LOCAL_CHASSIS(cfg) ((struct lldpd_chassis *)(TAILQ_FIRST(&cfg->g_chassis)))
 	TAILQ_HEAD(, lldpd_chassis) g_chassis;
+	struct hash_table g_chassis_index; /* Remote chassis by protocol and ID */
+	u_int32_t g_lchassis_hash; /* Hash of the local chassis */
 	TAILQ_HEAD(, lldpd_hardware) g_hardware;
 };
 
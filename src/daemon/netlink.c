@@ -43,6 +43,8 @@ struct lldpd_netlink {
 	/* Cache */
 	struct interfaces_device_list *devices;
 	struct interfaces_address_list *addresses;
+	struct hash_table devices_index;   /* Devices, by index */
+	struct hash_table addresses_index; /* Addresses, by interface index */
 };
 
 /**
@@ -517,6 +519,84 @@ netlink_merge(struct interfaces_device *old, struct interfaces_device *new)
 	new->lower_idx = old->lower_idx;
 }
 
+static u_int32_t
+netlink_index_hash(int index)
+{
+	return hash_bytes(HASH_INIT, &index, sizeof(index));
+}
+
+/**
+ * Find an interface in the cache from its index.
+ */
+static struct interfaces_device *
+netlink_device_lookup(struct lldpd_netlink *nl, int index)
+{
+	struct hash_entry *entry;
+	struct interfaces_device *iface;
+	HASH_FOREACH (entry, &nl->devices_index, netlink_index_hash(index)) {
+		iface = HASH_ENTRY(entry, struct interfaces_device, hentry);
+		if (iface->index == index) return iface;
+	}
+	return NULL;
+}
+
+/**
+ * Find an address in the cache.
+ */
+static struct interfaces_address *
+netlink_address_lookup(struct lldpd_netlink *nl, struct interfaces_address *ifa)
+{
+	struct hash_entry *entry;
+	struct interfaces_address *ifaold;
+	HASH_FOREACH (entry, &nl->addresses_index, netlink_index_hash(ifa->index)) {
+		ifaold = HASH_ENTRY(entry, struct interfaces_address, hentry);
+		if (ifaold->index == ifa->index &&
+		    !memcmp(&ifaold->address, &ifa->address, sizeof(ifaold->address)))
+			return ifaold;
+	}
+	return NULL;
+}
+
+/**
+ * Mark the interface with the given index as changed.
+ */
+static void
+netlink_mark_changed(struct lldpd_netlink *nl, int index)
+{
+	struct interfaces_device *iface;
+	if (index == -1) return;
+	if ((iface = netlink_device_lookup(nl, index)) != NULL) iface->unchanged = 0;
+}
+
+/**
+ * Propagate changes to the interfaces below the changed ones.
+ *
+ * Local ports get information from the interfaces stacked on top of them
+ * (VLAN, bond, bridge). When one of them changes, ports below should be
+ * refreshed too.
+ */
+static void
+netlink_propagate_changes(struct interfaces_device_list *ifs)
+{
+	struct interfaces_device *iface;
+	int again;
+	do {
+		again = 0;
+		TAILQ_FOREACH (iface, ifs, next) {
+			if (iface->unchanged && iface->upper &&
+			    !iface->upper->unchanged) {
+				iface->unchanged = 0;
+				again = 1;
+			}
+			if (!iface->unchanged && iface->lower &&
+			    iface->lower->unchanged) {
+				iface->lower->unchanged = 0;
+				again = 1;
+			}
+		}
+	} while (again);
+}
+
 /**
  * Receive netlink answer from the kernel.
  *
@@ -531,7 +611,8 @@ netlink_recv(struct lldpd *cfg, struct interfaces_device_list *ifs,
 	int end = 0, ret = 0, flags, retry = 0;
 	struct iovec iov;
 	int link_update = 0;
-	int s = cfg->g_netlink->nl_socket;
+	struct lldpd_netlink *nl = cfg->g_netlink;
+	int s = nl->nl_socket;
 
 	struct interfaces_device *ifdold;
 	struct interfaces_device *ifdnew;
@@ -645,10 +726,8 @@ netlink_recv(struct lldpd *cfg, struct interfaces_device_list *ifs,
 				if (netlink_parse_link(msg, ifdnew) == 0) {
 					/* We need to find if we already have this
 					 * interface */
-					TAILQ_FOREACH (ifdold, ifs, next) {
-						if (ifdold->index == ifdnew->index)
-							break;
-					}
+					ifdold = netlink_device_lookup(nl,
+					    ifdnew->index);
 
 					if (msg->nlmsg_type == RTM_NEWLINK) {
 						if (ifdold == NULL) {
@@ -657,6 +736,10 @@ netlink_recv(struct lldpd *cfg, struct interfaces_device_list *ifs,
 							    ifdnew->name);
 							TAILQ_INSERT_TAIL(ifs, ifdnew,
 							    next);
+							hash_insert(&nl->devices_index,
+							    &ifdnew->hentry,
+							    netlink_index_hash(
+								ifdnew->index));
 						} else {
 							log_debug("netlink",
 							    "interface %s/%s is updated",
@@ -665,6 +748,12 @@ netlink_recv(struct lldpd *cfg, struct interfaces_device_list *ifs,
 							TAILQ_INSERT_AFTER(ifs, ifdold,
 							    ifdnew, next);
 							TAILQ_REMOVE(ifs, ifdold, next);
+							hash_remove(&nl->devices_index,
+							    &ifdold->hentry);
+							hash_insert(&nl->devices_index,
+							    &ifdnew->hentry,
+							    netlink_index_hash(
+								ifdnew->index));
 							interfaces_free_device(ifdold);
 						}
 					} else {
@@ -676,7 +765,11 @@ netlink_recv(struct lldpd *cfg, struct interfaces_device_list *ifs,
 							log_debug("netlink",
 							    "interface %s is to be removed",
 							    ifdold->name);
+							netlink_mark_changed(nl,
+							    ifdold->lower_idx);
 							TAILQ_REMOVE(ifs, ifdold, next);
+							hash_remove(&nl->devices_index,
+							    &ifdold->hentry);
 							interfaces_free_device(ifdold);
 						}
 						interfaces_free_device(ifdnew);
@@ -702,13 +795,7 @@ netlink_recv(struct lldpd *cfg, struct interfaces_device_list *ifs,
 						interfaces_free_address(ifanew);
 						break;
 					}
-					TAILQ_FOREACH (ifaold, ifas, next) {
-						if ((ifaold->index == ifanew->index) &&
-						    !memcmp(&ifaold->address,
-							&ifanew->address,
-							sizeof(ifaold->address)))
-							break;
-					}
+					ifaold = netlink_address_lookup(nl, ifanew);
 					if (getnameinfo(
 						(struct sockaddr *)&ifanew->address,
 						sizeof(ifanew->address), addr,
@@ -725,6 +812,10 @@ netlink_recv(struct lldpd *cfg, struct interfaces_device_list *ifs,
 							    ifanew->index);
 							TAILQ_INSERT_TAIL(ifas, ifanew,
 							    next);
+							hash_insert(&nl->addresses_index,
+							    &ifanew->hentry,
+							    netlink_index_hash(
+								ifanew->index));
 						} else {
 							log_debug("netlink",
 							    "updated address %s%%%d",
@@ -733,6 +824,12 @@ netlink_recv(struct lldpd *cfg, struct interfaces_device_list *ifs,
 							    ifanew, next);
 							TAILQ_REMOVE(ifas, ifaold,
 							    next);
+							hash_remove(&nl->addresses_index,
+							    &ifaold->hentry);
+							hash_insert(&nl->addresses_index,
+							    &ifanew->hentry,
+							    netlink_index_hash(
+								ifanew->index));
 							interfaces_free_address(ifaold);
 						}
 					} else {
@@ -746,6 +843,8 @@ netlink_recv(struct lldpd *cfg, struct interfaces_device_list *ifs,
 							    addr, ifaold->index);
 							TAILQ_REMOVE(ifas, ifaold,
 							    next);
+							hash_remove(&nl->addresses_index,
+							    &ifaold->hentry);
 							interfaces_free_address(ifaold);
 						}
 						interfaces_free_address(ifanew);
@@ -764,56 +863,44 @@ netlink_recv(struct lldpd *cfg, struct interfaces_device_list *ifs,
 end:
 	if (link_update) {
 		/* Fill out lower/upper */
-		struct interfaces_device *iface1, *iface2;
+		struct interfaces_device *iface1, *iface2, *upper, *lower;
 		TAILQ_FOREACH (iface1, ifs, next) {
+			upper = lower = NULL;
 			if (iface1->upper_idx != -1 &&
-			    iface1->upper_idx != iface1->index) {
-				TAILQ_FOREACH (iface2, ifs, next) {
-					if (iface1->upper_idx == iface2->index) {
-						log_debug("netlink",
-						    "upper interface for %s is %s",
-						    iface1->name, iface2->name);
-						iface1->upper = iface2;
-						break;
-					}
-				}
-				if (iface2 == NULL) iface1->upper = NULL;
-			} else {
-				iface1->upper = NULL;
+			    iface1->upper_idx != iface1->index &&
+			    (iface2 = netlink_device_lookup(nl, iface1->upper_idx)) !=
+				NULL) {
+				log_debug("netlink", "upper interface for %s is %s",
+				    iface1->name, iface2->name);
+				upper = iface2;
 			}
 			if (iface1->lower_idx != -1 &&
-			    iface1->lower_idx != iface1->index) {
-				TAILQ_FOREACH (iface2, ifs, next) {
-					if (iface1->lower_idx == iface2->index) {
-						/* Workaround a bug introduced
-						 * in Linux 4.1: a pair of veth
-						 * will be lower interface of
-						 * each other. Do not modify
-						 * index as if one of them is
-						 * updated, we will loose the
-						 * information about the
-						 * loop. */
-						if (iface2->lower_idx ==
-						    iface1->index) {
-							iface1->lower = NULL;
-							log_debug("netlink",
-							    "link loop detected between %s(%d) and %s(%d)",
-							    iface1->name, iface1->index,
-							    iface2->name,
-							    iface2->index);
-						} else {
-							log_debug("netlink",
-							    "lower interface for %s is %s",
-							    iface1->name, iface2->name);
-							iface1->lower = iface2;
-						}
-						break;
-					}
+			    iface1->lower_idx != iface1->index &&
+			    (iface2 = netlink_device_lookup(nl, iface1->lower_idx)) !=
+				NULL) {
+				/* Workaround a bug introduced in Linux 4.1: a
+				 * pair of veth will be lower interface of each
+				 * other. Do not modify index as if one of them
+				 * is updated, we will loose the information
+				 * about the loop. */
+				if (iface2->lower_idx == iface1->index) {
+					log_debug("netlink",
+					    "link loop detected between %s(%d) and %s(%d)",
+					    iface1->name, iface1->index, iface2->name,
+					    iface2->index);
+				} else {
+					log_debug("netlink",
+					    "lower interface for %s is %s",
+					    iface1->name, iface2->name);
+					lower = iface2;
 				}
-			} else {
-				iface1->lower = NULL;
 			}
+			if (iface1->upper != upper || iface1->lower != lower)
+				iface1->unchanged = 0;
+			iface1->upper = upper;
+			iface1->lower = lower;
 		}
+		netlink_propagate_changes(ifs);
 	}
 
 out:
@@ -940,6 +1027,8 @@ netlink_cleanup(struct lldpd *cfg)
 	if (cfg->g_netlink->nl_socket != -1) close(cfg->g_netlink->nl_socket);
 	interfaces_free_devices(cfg->g_netlink->devices);
 	interfaces_free_addresses(cfg->g_netlink->addresses);
+	hash_free(&cfg->g_netlink->devices_index);
+	hash_free(&cfg->g_netlink->addresses_index);
 
 	free(cfg->g_netlink);
 	cfg->g_netlink = NULL;
@@ -17,9 +17,208 @@
 
 #include "lldpd.h"
 
+#include <limits.h>
 #include <string.h>
 #include <fnmatch.h>
 
+/* Kind of pattern, from its prefix */
+#define PATTERN_ALLOW 0	     /* `eth0` */
+#define PATTERN_DENY 1	     /* `!eth0` */
+#define PATTERN_ALLOW_BACK 2 /* `!!eth0` */
+
+/* Pattern without any wildcard, looked up by name */
+struct pattern_literal {
+	struct hash_entry pl_entry;
+	int pl_kind;
+	unsigned int pl_index; /* Position in the list of patterns */
+	char pl_name[];
+};
+
+/* Pattern with wildcards, matched with `fnmatch()` after checking the part
+ * before the first wildcard. */
+struct pattern_glob {
+	struct pattern_glob *pg_next;
+	int pg_kind;
+	unsigned int pg_index; /* Position in the list of patterns */
+	size_t pg_prefix;      /* Length of the part without wildcards */
+	int pg_star;	       /* Pattern is this part followed by a single `*` */
+	char pg_pattern[];
+};
+
+struct pattern_set {
+	struct arena *ps_arena;		/* Holds literals and globs */
+	struct hash_table ps_literals;	/* Literals, by name */
+	struct pattern_glob *ps_globs;	/* Globs, in order */
+};
+
+/**
+ * Compile a list of patterns.
+ *
+ * @param patterns List of comma separated patterns, as for `pattern_match()`.
+ * @return The compiled patterns, to be freed with `pattern_set_free()`, or
+ *         NULL if `patterns` is NULL or on allocation failure.
+ *
+ * Patterns without wildcards are put in a hash table. The other ones are kept
+ * in order and only handed to `fnmatch()` when the string starts with the part
+ * of the pattern before the first wildcard.
+ */
+struct pattern_set *
+pattern_compile(const char *patterns)
+{
+	struct pattern_set *set;
+	struct pattern_literal *literal;
+	struct pattern_glob *glob, **last;
+	const char *token, *name;
+	size_t len, namelen, prefix;
+	unsigned int index = 0;
+	int kind;
+
+	if (patterns == NULL) return NULL;
+	if ((set = calloc(1, sizeof(*set))) == NULL ||
+	    (set->ps_arena = arena_new(2 * strlen(patterns))) == NULL) {
+		free(set);
+		log_warnx("interfaces", "unable to allocate memory");
+		return NULL;
+	}
+	last = &set->ps_globs;
+	for (token = patterns; *token != '\0';
+	     token += len + (token[len] == ',')) {
+		if ((len = strcspn(token, ",")) == 0) continue;
+		name = token;
+		kind = PATTERN_ALLOW;
+		if (len >= 2 && token[0] == '!' && token[1] == '!') {
+			name += 2;
+			kind = PATTERN_ALLOW_BACK;
+		} else if (token[0] == '!') {
+			name += 1;
+			kind = PATTERN_DENY;
+		}
+		namelen = len - (name - token);
+		prefix = strcspn(name, "*?[\\,");
+		if (prefix >= namelen) {
+			if ((literal = arena_alloc(set->ps_arena,
+				 sizeof(*literal) + namelen + 1)) == NULL)
+				goto fail;
+			literal->pl_kind = kind;
+			literal->pl_index = index++;
+			memcpy(literal->pl_name, name, namelen);
+			hash_insert(&set->ps_literals, &literal->pl_entry,
+			    hash_bytes(HASH_INIT, name, namelen));
+			continue;
+		}
+		if ((glob = arena_alloc(set->ps_arena, sizeof(*glob) + namelen + 1)) ==
+		    NULL)
+			goto fail;
+		glob->pg_kind = kind;
+		glob->pg_index = index++;
+		glob->pg_prefix = prefix;
+		glob->pg_star = (name[prefix] == '*' && prefix + 1 == namelen);
+		memcpy(glob->pg_pattern, name, namelen);
+		*last = glob;
+		last = &glob->pg_next;
+	}
+	return set;
+
+fail:
+	log_warnx("interfaces", "unable to allocate memory");
+	pattern_set_free(set);
+	return NULL;
+}
+
+/* Free compiled patterns. */
+void
+pattern_set_free(struct pattern_set *set)
+{
+	if (set == NULL) return;
+	hash_free(&set->ps_literals);
+	arena_release(set->ps_arena);
+	free(set);
+}
+
+static int
+pattern_glob_match(struct pattern_glob *glob, const char *string, size_t len)
+{
+	if (len < glob->pg_prefix || strncmp(glob->pg_pattern, string, glob->pg_prefix))
+		return 0;
+	if (glob->pg_star) return 1;
+	/* The prefix has no wildcard, so the remaining parts can be matched
+	 * alone. */
+	return (fnmatch(glob->pg_pattern + glob->pg_prefix, string + glob->pg_prefix,
+		    0) == 0);
+}
+
+/**
+ * Match compiled patterns.
+ *
+ * @param set    Patterns compiled with `pattern_compile()`.
+ * @param string String to match against the patterns.
+ * @param found  Value to return if the pattern isn't found.
+ *
+ * @return Same as `pattern_match()`. PATTERN_MATCH_DENIED if `set` is NULL.
+ */
+enum pattern_match_result
+pattern_set_match(struct pattern_set *set, const char *string, int found)
+{
+	struct hash_entry *entry;
+	struct pattern_literal *literal;
+	struct pattern_glob *glob;
+	size_t len;
+	unsigned int back = UINT_MAX; /* Position of the first `!!` matching */
+	int back_exact = 0, denied = 0;
+	enum pattern_match_result allowed = PATTERN_MATCH_DENIED;
+
+	if (set == NULL) return PATTERN_MATCH_DENIED;
+	len = strlen(string);
+
+	HASH_FOREACH(entry, &set->ps_literals, hash_bytes(HASH_INIT, string, len))
+	{
+		literal = HASH_ENTRY(entry, struct pattern_literal, pl_entry);
+		if (strcmp(literal->pl_name, string)) continue;
+		switch (literal->pl_kind) {
+		case PATTERN_ALLOW_BACK:
+			if (literal->pl_index < back) {
+				back = literal->pl_index;
+				back_exact = 1;
+			}
+			break;
+		case PATTERN_DENY:
+			denied = 1;
+			break;
+		default:
+			allowed = PATTERN_MATCH_ALLOWED_EXACT;
+		}
+	}
+
+	/* The first `!!` matching decides alone, nothing after it matters */
+	for (glob = set->ps_globs; glob != NULL && glob->pg_index < back;
+	     glob = glob->pg_next) {
+		if (glob->pg_kind != PATTERN_ALLOW_BACK && denied) continue;
+		if (glob->pg_kind == PATTERN_ALLOW &&
+		    allowed == PATTERN_MATCH_ALLOWED_EXACT)
+			continue;
+		if (!pattern_glob_match(glob, string, len)) continue;
+		switch (glob->pg_kind) {
+		case PATTERN_ALLOW_BACK:
+			back = glob->pg_index;
+			back_exact = !strcmp(glob->pg_pattern, string);
+			break;
+		case PATTERN_DENY:
+			denied = 1;
+			break;
+		default:
+			allowed = strcmp(glob->pg_pattern, string) ?
+			    PATTERN_MATCH_ALLOWED :
+			    PATTERN_MATCH_ALLOWED_EXACT;
+		}
+	}
+
+	if (back != UINT_MAX)
+		return back_exact ? PATTERN_MATCH_ALLOWED_EXACT : PATTERN_MATCH_ALLOWED;
+	if (denied) return PATTERN_MATCH_DENIED;
+	if (allowed != PATTERN_MATCH_DENIED) return allowed;
+	return found ? PATTERN_MATCH_ALLOWED : PATTERN_MATCH_DENIED;
+}
+
 /**
  * Match a list of patterns.
  *
@@ -40,41 +239,18 @@
  *         allowed or if the pattern wasn't found and `found` was set to
  *         PATTERN_MATCH_DENIED. Otherwise, return PATTERN_MATCH_ALLOWED unless the
  *         interface match is exact, in this case return PATTERN_MATCH_ALLOWED_EXACT.
+ *
+ * The patterns are compiled on each call. Use `pattern_compile()` and
+ * `pattern_set_match()` to match several strings against the same patterns.
  */
 enum pattern_match_result
 pattern_match(char *string, char *patterns, int found)
 {
-	char *pattern;
-	int denied = 0;
-	found = found ? PATTERN_MATCH_ALLOWED : PATTERN_MATCH_DENIED;
-
-	if ((patterns = strdup(patterns)) == NULL) {
-		log_warnx("interfaces", "unable to allocate memory");
-		return PATTERN_MATCH_DENIED;
-	}
-
-	for (pattern = strtok(patterns, ","); pattern != NULL;
-	     pattern = strtok(NULL, ",")) {
-		if ((pattern[0] == '!') && (pattern[1] == '!') &&
-		    (fnmatch(pattern + 2, string, 0) == 0)) {
-			/* Allowed. No need to search further. */
-			found = (strcmp(pattern + 2, string)) ?
-			    PATTERN_MATCH_ALLOWED :
-			    PATTERN_MATCH_ALLOWED_EXACT;
-			break;
-		}
-		if ((pattern[0] == '!') && (fnmatch(pattern + 1, string, 0) == 0)) {
-			denied = 1;
-			found = PATTERN_MATCH_DENIED;
-		} else if (!denied && fnmatch(pattern, string, 0) == 0) {
-			if (!strcmp(pattern, string)) {
-				found = PATTERN_MATCH_ALLOWED_EXACT;
-			} else if (found < 2) {
-				found = PATTERN_MATCH_ALLOWED;
-			}
-		}
-	}
+	struct pattern_set *set;
+	enum pattern_match_result result;
 
-	free(patterns);
-	return found;
+	if ((set = pattern_compile(patterns)) == NULL) return PATTERN_MATCH_DENIED;
+	result = pattern_set_match(set, string, found);
+	pattern_set_free(set);
+	return result;
 }
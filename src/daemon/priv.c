@@ -134,6 +134,56 @@ priv_iface_init(int index, char *iface)
 	return receive_fd(PRIV_UNPRIVILEGED);
 }
 
+/**
+ * Proxy to initialize several interfaces with one request.
+ *
+ * @param ifaces  Interfaces to initialize. On return, @c fd and @c rc are set.
+ * @param n       Number of interfaces, at most @c PRIV_IFACE_BATCH.
+ * @param sockets Whether a socket should be opened for each interface. Only
+ *                when adding multicast addresses.
+ * @param macs    Multicast addresses to add to or remove from each interface.
+ * @param nmacs   Number of multicast addresses, at most @c PRIV_MULTICAST_MAX.
+ * @param add     1 to add multicast addresses, 0 to remove them.
+ * @param mrc     Result for each multicast address of each interface (@c n
+ *                times @c nmacs). Meaningless when the socket cannot be
+ *                opened.
+ */
+void
+priv_iface_init_batch(struct priv_iface *ifaces, size_t n, int sockets,
+    const u_int8_t (*macs)[ETHER_ADDR_LEN], size_t nmacs, int add, int *mrc)
+{
+	int count = n, nmac = nmacs;
+	int fds[PRIV_FD_BATCH];
+	size_t i, j, k, nfds;
+	enum priv_cmd cmd = PRIV_IFACE_INIT_BATCH;
+	must_write(PRIV_UNPRIVILEGED, &cmd, sizeof(enum priv_cmd));
+	must_write(PRIV_UNPRIVILEGED, &count, sizeof(int));
+	must_write(PRIV_UNPRIVILEGED, &sockets, sizeof(int));
+	must_write(PRIV_UNPRIVILEGED, &nmac, sizeof(int));
+	if (nmacs > 0) must_write(PRIV_UNPRIVILEGED, macs, nmacs * ETHER_ADDR_LEN);
+	must_write(PRIV_UNPRIVILEGED, &add, sizeof(int));
+	for (i = 0; i < n; i++) {
+		must_write(PRIV_UNPRIVILEGED, &ifaces[i].index, sizeof(int));
+		must_write(PRIV_UNPRIVILEGED, ifaces[i].name, IFNAMSIZ);
+	}
+	priv_wait();
+	for (i = 0, nfds = 0; i < n; i++) {
+		must_read(PRIV_UNPRIVILEGED, &ifaces[i].rc, sizeof(int));
+		ifaces[i].fd = -1;
+		if (sockets && ifaces[i].rc == 0) nfds++;
+	}
+	if (nmacs > 0) must_read(PRIV_UNPRIVILEGED, mrc, n * nmacs * sizeof(int));
+
+	/* File descriptors come in order, by batches of PRIV_FD_BATCH */
+	for (i = 0; nfds > 0; nfds -= j) {
+		j = (nfds > PRIV_FD_BATCH) ? PRIV_FD_BATCH : nfds;
+		receive_fds(PRIV_UNPRIVILEGED, fds, j);
+		for (k = 0; k < j; i++) {
+			if (ifaces[i].rc == 0) ifaces[i].fd = fds[k++];
+		}
+	}
+}
+
 int
 priv_iface_multicast(const char *name, const u_int8_t *mac, int add)
 {
@@ -257,14 +307,14 @@ asroot_iface_init()
 	if (fd >= 0) close(fd);
 }
 
-static void
-asroot_iface_multicast()
+/* Add or remove a multicast address on an interface. Return 0 or errno. */
+static int
+asroot_iface_multicast_do(int sock, const char *name, const u_int8_t *mac, int add)
 {
-	int sock = -1, add, rc = 0;
 	struct ifreq ifr = { .ifr_name = {} };
-	must_read(PRIV_PRIVILEGED, ifr.ifr_name, IFNAMSIZ);
+	strlcpy(ifr.ifr_name, name, IFNAMSIZ);
 #if defined HOST_OS_LINUX
-	must_read(PRIV_PRIVILEGED, ifr.ifr_hwaddr.sa_data, ETHER_ADDR_LEN);
+	memcpy(ifr.ifr_hwaddr.sa_data, mac, ETHER_ADDR_LEN);
 #elif defined HOST_OS_FREEBSD || defined HOST_OS_OSX || defined HOST_OS_DRAGONFLY
 	/* Black magic from mtest.c */
 	struct sockaddr_dl *dlp = ALIGNED_CAST(struct sockaddr_dl *, &ifr.ifr_addr);
@@ -274,28 +324,110 @@ asroot_iface_multicast()
 	dlp->sdl_nlen = 0;
 	dlp->sdl_alen = ETHER_ADDR_LEN;
 	dlp->sdl_slen = 0;
-	must_read(PRIV_PRIVILEGED, LLADDR(dlp), ETHER_ADDR_LEN);
+	memcpy(LLADDR(dlp), mac, ETHER_ADDR_LEN);
 #elif defined HOST_OS_OPENBSD || defined HOST_OS_NETBSD || defined HOST_OS_SOLARIS
 	struct sockaddr *sap = (struct sockaddr *)&ifr.ifr_addr;
 #  if !defined HOST_OS_SOLARIS
 	sap->sa_len = sizeof(struct sockaddr);
 #  endif
 	sap->sa_family = AF_UNSPEC;
-	must_read(PRIV_PRIVILEGED, sap->sa_data, ETHER_ADDR_LEN);
+	memcpy(sap->sa_data, mac, ETHER_ADDR_LEN);
 #else
 #  error Unsupported OS
 #endif
 
+	if ((ioctl(sock, (add) ? SIOCADDMULTI : SIOCDELMULTI, &ifr) < 0) &&
+	    (errno != EADDRINUSE))
+		return errno;
+	return 0;
+}
+
+static void
+asroot_iface_multicast()
+{
+	int sock = -1, add, rc = 0;
+	char name[IFNAMSIZ];
+	u_int8_t mac[ETHER_ADDR_LEN];
+	must_read(PRIV_PRIVILEGED, name, IFNAMSIZ);
+	name[sizeof(name) - 1] = '\0';
+	must_read(PRIV_PRIVILEGED, mac, ETHER_ADDR_LEN);
 	must_read(PRIV_PRIVILEGED, &add, sizeof(int));
-	if (((sock = socket(AF_INET, SOCK_DGRAM, 0)) == -1) ||
-	    ((ioctl(sock, (add) ? SIOCADDMULTI : SIOCDELMULTI, &ifr) < 0) &&
-		(errno != EADDRINUSE)))
+	if ((sock = socket(AF_INET, SOCK_DGRAM, 0)) == -1)
 		rc = errno;
+	else
+		rc = asroot_iface_multicast_do(sock, name, mac, add);
 
 	if (sock != -1) close(sock);
 	must_write(PRIV_PRIVILEGED, &rc, sizeof(rc));
 }
 
+static void
+asroot_iface_init_batch()
+{
+	int n, sockets, nmacs, add, sock = -1;
+	u_int8_t macs[PRIV_MULTICAST_MAX][ETHER_ADDR_LEN];
+	int rc[PRIV_IFACE_BATCH], fds[PRIV_IFACE_BATCH];
+	int mrc[PRIV_IFACE_BATCH * PRIV_MULTICAST_MAX];
+	int ifindex, i, j, nfds = 0;
+	char name[IFNAMSIZ];
+
+	must_read(PRIV_PRIVILEGED, &n, sizeof(int));
+	must_read(PRIV_PRIVILEGED, &sockets, sizeof(int));
+	must_read(PRIV_PRIVILEGED, &nmacs, sizeof(int));
+	if (n < 1 || n > PRIV_IFACE_BATCH || nmacs < 0 || nmacs > PRIV_MULTICAST_MAX)
+		fatalx("privsep", "too large value requested");
+	if (nmacs > 0) must_read(PRIV_PRIVILEGED, macs, nmacs * ETHER_ADDR_LEN);
+	must_read(PRIV_PRIVILEGED, &add, sizeof(int));
+	if (sockets && !add) fatalx("privsep", "unexpected request");
+	if (nmacs > 0 && (sock = socket(AF_INET, SOCK_DGRAM, 0)) == -1)
+		log_warn("privsep", "unable to open socket to %s multicast addresses",
+		    add ? "add" : "remove");
+
+	for (i = 0; i < n; i++) {
+		must_read(PRIV_PRIVILEGED, &ifindex, sizeof(int));
+		must_read(PRIV_PRIVILEGED, name, IFNAMSIZ);
+		name[sizeof(name) - 1] = '\0';
+
+		rc[i] = 0;
+		fds[i] = -1;
+		if (sockets) {
+			TRACE(LLDPD_PRIV_INTERFACE_INIT(name));
+			rc[i] = asroot_iface_init_os(ifindex, name, &fds[i]);
+			if (rc[i] == 0 && fds[i] < 0) rc[i] = EBADF;
+			if (rc[i] != 0 && fds[i] >= 0) {
+				close(fds[i]);
+				fds[i] = -1;
+			}
+			if (rc[i] == 0) nfds++;
+		}
+		for (j = 0; j < nmacs; j++) {
+			if (rc[i] != 0)
+				mrc[i * nmacs + j] = 0;
+			else if (sock == -1)
+				mrc[i * nmacs + j] = EBADF;
+			else
+				mrc[i * nmacs + j] =
+				    asroot_iface_multicast_do(sock, name, macs[j], add);
+		}
+	}
+	if (sock != -1) close(sock);
+
+	must_write(PRIV_PRIVILEGED, rc, n * sizeof(int));
+	if (nmacs > 0) must_write(PRIV_PRIVILEGED, mrc, n * nmacs * sizeof(int));
+
+	/* Send file descriptors in order, by batches of PRIV_FD_BATCH */
+	for (i = 0, j = 0; i < n; i++) {
+		if (fds[i] < 0) continue;
+		fds[j++] = fds[i];
+		if (j == PRIV_FD_BATCH || j == nfds) {
+			send_fds(PRIV_PRIVILEGED, fds, j);
+			nfds -= j;
+			while (j > 0)
+				close(fds[--j]);
+		}
+	}
+}
+
 static void
 asroot_iface_description()
 {
@@ -390,6 +522,7 @@ static struct dispatch_actions actions[] = { { PRIV_PING, asroot_ping },
 	{ PRIV_OPEN, asroot_open },
 #endif
 	{ PRIV_IFACE_INIT, asroot_iface_init },
+	{ PRIV_IFACE_INIT_BATCH, asroot_iface_init_batch },
 	{ PRIV_IFACE_MULTICAST, asroot_iface_multicast },
 	{ PRIV_IFACE_DESCRIPTION, asroot_iface_description },
 	{ PRIV_IFACE_PROMISC, asroot_iface_promisc },
@@ -127,3 +127,78 @@ receive_fd(enum priv_context ctx)
 		return -1;
 	}
 }
+
+/* Send several file descriptors in one message. The receiver has to expect
+ * exactly the same number of descriptors. */
+void
+send_fds(enum priv_context ctx, const int *fds, size_t n)
+{
+	struct msghdr msg;
+	union {
+		struct cmsghdr hdr;
+		char buf[CMSG_SPACE(sizeof(int) * PRIV_FD_BATCH)];
+	} cmsgbuf;
+	struct cmsghdr *cmsg;
+	struct iovec vec;
+	int count = n;
+	ssize_t nw;
+
+	if (n == 0 || n > PRIV_FD_BATCH)
+		fatalx("privsep", "invalid number of descriptors to send");
+
+	memset(&msg, 0, sizeof(msg));
+	memset(&cmsgbuf.buf, 0, sizeof(cmsgbuf.buf));
+	msg.msg_control = (caddr_t)&cmsgbuf.buf;
+	msg.msg_controllen = CMSG_SPACE(sizeof(int) * n);
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int) * n);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * n);
+
+	vec.iov_base = &count;
+	vec.iov_len = sizeof(int);
+	msg.msg_iov = &vec;
+	msg.msg_iovlen = 1;
+
+	if ((nw = sendmsg(priv_fd(ctx), &msg, 0)) == -1)
+		fatal("privsep", "sendmsg");
+	if (nw != sizeof(int)) fatalx("privsep", "sendmsg: short write");
+}
+
+/* Receive several file descriptors sent with send_fds() */
+void
+receive_fds(enum priv_context ctx, int *fds, size_t n)
+{
+	struct msghdr msg;
+	union {
+		struct cmsghdr hdr;
+		char buf[CMSG_SPACE(sizeof(int) * PRIV_FD_BATCH)];
+	} cmsgbuf;
+	struct cmsghdr *cmsg;
+	struct iovec vec;
+	ssize_t nr;
+	int count;
+
+	if (n == 0 || n > PRIV_FD_BATCH)
+		fatalx("privsep", "invalid number of descriptors to receive");
+
+	memset(&msg, 0, sizeof(msg));
+	vec.iov_base = &count;
+	vec.iov_len = sizeof(int);
+	msg.msg_iov = &vec;
+	msg.msg_iovlen = 1;
+	msg.msg_control = &cmsgbuf.buf;
+	msg.msg_controllen = sizeof(cmsgbuf.buf);
+
+	if ((nr = recvmsg(priv_fd(ctx), &msg, 0)) == -1) fatal("privsep", "recvmsg");
+	if (nr != sizeof(int)) fatalx("privsep", "recvmsg: short read");
+	if (msg.msg_flags & MSG_CTRUNC)
+		fatalx("privsep", "recvmsg: file descriptors truncated");
+	cmsg = CMSG_FIRSTHDR(&msg);
+	if ((size_t)count != n || cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET ||
+	    cmsg->cmsg_type != SCM_RIGHTS ||
+	    cmsg->cmsg_len != CMSG_LEN(sizeof(int) * n))
+		fatalx("privsep", "unexpected number of file descriptors");
+	memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * n);
+}
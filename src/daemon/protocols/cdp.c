@@ -50,11 +50,16 @@ cdp_send(struct lldpd *global, struct lldpd_hardware *hardware, int version)
 	char *capstr;
 #  endif
 	u_int16_t checksum;
-	int length, i;
+	int length, i, mode, ret;
 	u_int32_t cap;
 	u_int8_t *packet;
 	u_int8_t *pos, *pos_len_eh, *pos_llc, *pos_cdp, *pos_checksum, *tlv, *end;
 
+	mode = (version == 0) ? LLDPD_MODE_FDP :
+	    (version == 1)    ? LLDPD_MODE_CDPV1 :
+				LLDPD_MODE_CDPV2;
+	if ((ret = lldpd_send_cached(global, hardware, mode)) != -1) return ret;
+
 	log_debug("cdp", "send CDP frame on %s", hardware->h_ifname);
 
 	port = &(hardware->h_lport);
@@ -250,6 +255,8 @@ cdp_send(struct lldpd *global, struct lldpd_hardware *hardware, int version)
 	POKE_RESTORE(pos_checksum);
 	if (!(POKE_UINT16(checksum))) goto toobig;
 
+	/* Cache the frame before its source address is mangled for bonds */
+	lldpd_cache_frame(global, hardware, mode, 0, packet, end - packet);
 	if (interfaces_send_helper(global, hardware, (char *)packet, end - packet) ==
 	    -1) {
 		log_warn("cdp", "unable to send packet on real device for %s",
@@ -282,6 +289,7 @@ cdp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwar
 {
 	struct lldpd_chassis *chassis;
 	struct lldpd_port *port;
+	struct arena *arena;
 	struct lldpd_mgmt *mgmt;
 	struct in_addr addr;
 #  if 0
@@ -312,6 +320,14 @@ cdp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwar
 		free(chassis);
 		return -1;
 	}
+	if ((arena = arena_new(2 * s)) == NULL) {
+		log_warn("cdp", "failed to allocate memory for remote port");
+		free(port);
+		free(chassis);
+		return -1;
+	}
+	chassis->c_arena = arena;
+	port->p_arena = arena_ref(arena);
 #  ifdef ENABLE_DOT1
 	TAILQ_INIT(&port->p_vlans);
 #  endif
@@ -412,17 +428,16 @@ cdp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwar
 		}
 		switch (tlv_type) {
 		case CDP_TLV_CHASSIS:
-			free(chassis->c_name);
-			if ((chassis->c_name = (char *)calloc(1, tlv_len + 1)) ==
-			    NULL) {
+			if ((chassis->c_name = (char *)arena_alloc(arena,
+				 tlv_len + 1)) == NULL) {
 				log_warn("cdp",
 				    "unable to allocate memory for chassis name");
 				goto malformed;
 			}
 			PEEK_BYTES(chassis->c_name, tlv_len);
 			chassis->c_id_subtype = LLDP_CHASSISID_SUBTYPE_LOCAL;
-			free(chassis->c_id);
-			if ((chassis->c_id = (char *)malloc(tlv_len)) == NULL) {
+			if ((chassis->c_id = (char *)arena_alloc(arena, tlv_len)) ==
+			    NULL) {
 				log_warn("cdp",
 				    "unable to allocate memory for chassis ID");
 				goto malformed;
@@ -475,8 +490,8 @@ cdp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwar
 				    (PEEK_UINT8 == CDP_ADDRESS_PROTO_IP) &&
 				    (PEEK_UINT16 == sizeof(struct in_addr))) {
 					PEEK_BYTES(&addr, sizeof(struct in_addr));
-					mgmt = lldpd_alloc_mgmt(LLDPD_AF_IPV4, &addr,
-					    sizeof(struct in_addr), 0);
+					mgmt = lldpd_alloc_mgmt(arena, LLDPD_AF_IPV4,
+					    &addr, sizeof(struct in_addr), 0);
 					if (mgmt == NULL) {
 						if (errno == ENOMEM)
 							log_warn("cdp",
@@ -499,16 +514,15 @@ cdp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwar
 				log_warn("cdp", "too short port description received");
 				goto malformed;
 			}
-			free(port->p_descr);
-			if ((port->p_descr = (char *)calloc(1, tlv_len + 1)) == NULL) {
+			if ((port->p_descr = (char *)arena_alloc(arena, tlv_len + 1)) ==
+			    NULL) {
 				log_warn("cdp",
 				    "unable to allocate memory for port description");
 				goto malformed;
 			}
 			PEEK_BYTES(port->p_descr, tlv_len);
 			port->p_id_subtype = LLDP_PORTID_SUBTYPE_IFNAME;
-			free(port->p_id);
-			if ((port->p_id = (char *)calloc(1, tlv_len)) == NULL) {
+			if ((port->p_id = (char *)arena_alloc(arena, tlv_len)) == NULL) {
 				log_warn("cdp",
 				    "unable to allocate memory for port ID");
 				goto malformed;
@@ -552,7 +566,7 @@ cdp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwar
 #  ifdef ENABLE_DOT1
 		case CDP_TLV_NATIVEVLAN:
 			CHECK_TLV_SIZE(2, "Native VLAN");
-			if ((vlan = (struct lldpd_vlan *)calloc(1,
+			if ((vlan = (struct lldpd_vlan *)arena_alloc(arena,
 				 sizeof(struct lldpd_vlan))) == NULL) {
 				log_warn("cdp",
 				    "unable to alloc vlan "
@@ -562,12 +576,12 @@ cdp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwar
 				goto malformed;
 			}
 			vlan->v_vid = port->p_pvid = PEEK_UINT16;
-			if (asprintf(&vlan->v_name, "VLAN #%d", vlan->v_vid) == -1) {
+			if (arena_asprintf(arena, &vlan->v_name, "VLAN #%d",
+				vlan->v_vid) == -1) {
 				log_warn("cdp",
 				    "unable to alloc VLAN name for "
 				    "TLV received on %s",
 				    hardware->h_ifname);
-				free(vlan);
 				goto malformed;
 			}
 			TAILQ_INSERT_TAIL(&port->p_vlans, vlan, v_entries);
@@ -610,14 +624,16 @@ cdp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwar
 		PEEK_DISCARD(tlv + tlv_len - pos);
 	}
 	if (!software && platform) {
-		if ((chassis->c_descr = (char *)calloc(1, platform_len + 1)) == NULL) {
+		if ((chassis->c_descr = (char *)arena_alloc(arena, platform_len + 1)) ==
+		    NULL) {
 			log_warn("cdp",
 			    "unable to allocate memory for chassis description");
 			goto malformed;
 		}
 		memcpy(chassis->c_descr, platform, platform_len);
 	} else if (software && !platform) {
-		if ((chassis->c_descr = (char *)calloc(1, software_len + 1)) == NULL) {
+		if ((chassis->c_descr = (char *)arena_alloc(arena, software_len + 1)) ==
+		    NULL) {
 			log_warn("cdp",
 			    "unable to allocate memory for chassis description");
 			goto malformed;
@@ -625,7 +641,7 @@ cdp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwar
 		memcpy(chassis->c_descr, software, software_len);
 	} else if (software && platform) {
 #  define CONCAT_PLATFORM " running on\n"
-		if ((chassis->c_descr = (char *)calloc(1,
+		if ((chassis->c_descr = (char *)arena_alloc(arena,
 			 software_len + platform_len + strlen(CONCAT_PLATFORM) + 1)) ==
 		    NULL) {
 			log_warn("cdp",
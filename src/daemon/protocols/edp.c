@@ -26,6 +26,7 @@
 #  include <arpa/inet.h>
 #  include <fnmatch.h>
 
+/* Each EDP frame carries a sequence number: they are not cached. */
 static int seq = 0;
 
 int
@@ -236,6 +237,9 @@ edp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwar
 
 	log_debug("edp", "decode EDP frame on port %s", hardware->h_ifname);
 
+	/* Unlike other protocols, no arena is used: VLANs and management
+	 * addresses received in separate frames are moved to an existing port
+	 * and chassis. */
 	if ((chassis = calloc(1, sizeof(struct lldpd_chassis))) == NULL) {
 		log_warn("edp", "failed to allocate remote chassis");
 		return -1;
@@ -416,7 +420,7 @@ edp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwar
 			PEEK_BYTES(&address, sizeof(address));
 
 			if (address.s_addr != INADDR_ANY) {
-				mgmt = lldpd_alloc_mgmt(LLDPD_AF_IPV4, &address,
+				mgmt = lldpd_alloc_mgmt(NULL, LLDPD_AF_IPV4, &address,
 				    sizeof(struct in_addr), 0);
 				if (mgmt == NULL) {
 					log_warn("edp", "Out of memory");
@@ -474,6 +474,10 @@ end:
 	/* END */
 	if (!(POKE_START_LLDP_TLV(LLDP_TLV_END) && POKE_END_LLDP_TLV)) goto toobig;
 
+	/* Cache the frame before its source address is mangled for bonds */
+	if (!shutdown)
+		lldpd_cache_frame(global, hardware, LLDPD_MODE_LLDP, 0, packet,
+		    pos - packet);
 	if (interfaces_send_helper(global, hardware, (char *)packet, pos - packet) ==
 	    -1) {
 		log_warn("lldp", "unable to send packet on real device for %s",
@@ -536,6 +540,10 @@ lldp_send(struct lldpd *global, struct lldpd_hardware *hardware)
 	struct lldpd_chassis *chassis = port->p_chassis;
 	int ret;
 
+	/* Nothing changed since the last PDU, the MSAP neither. */
+	if ((ret = lldpd_send_cached(global, hardware, LLDPD_MODE_LLDP)) != -1)
+		return ret;
+
 	/* Check if we have a change. */
 	if (hardware->h_lchassis_previous_id != NULL &&
 	    hardware->h_lport_previous_id != NULL &&
@@ -596,6 +604,7 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 {
 	struct lldpd_chassis *chassis;
 	struct lldpd_port *port;
+	struct arena *arena;
 	char lldpaddr[ETHER_ADDR_LEN];
 	const char dot1[] = LLDP_TLV_ORG_DOT1;
 	const char dot3[] = LLDP_TLV_ORG_DOT3;
@@ -607,10 +616,10 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 	u_int8_t *pos, *tlv;
 	char *b;
 #ifdef ENABLE_DOT1
-	struct lldpd_vlan *vlan = NULL;
+	struct lldpd_vlan *vlan;
 	int vlan_len;
 	struct lldpd_ppvid *ppvid;
-	struct lldpd_pi *pi = NULL;
+	struct lldpd_pi *pi;
 #endif
 	struct lldpd_mgmt *mgmt;
 	int af;
@@ -619,7 +628,7 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 	u_int32_t iface_number, iface;
 	int unrecognized;
 #ifdef ENABLE_CUSTOM
-	struct lldpd_custom *custom = NULL;
+	struct lldpd_custom *custom;
 #endif
 
 	log_debug("lldp", "receive LLDP PDU on %s", hardware->h_ifname);
@@ -634,6 +643,16 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 		free(chassis);
 		return -1;
 	}
+	/* Everything else is allocated from an arena shared by the chassis and
+	 * the port. Twice the size of the frame is usually enough. */
+	if ((arena = arena_new(2 * s)) == NULL) {
+		log_warn("lldp", "failed to allocate memory for remote port");
+		free(port);
+		free(chassis);
+		return -1;
+	}
+	chassis->c_arena = arena;
+	port->p_arena = arena_ref(arena);
 #ifdef ENABLE_DOT1
 	TAILQ_INIT(&port->p_vlans);
 	TAILQ_INIT(&port->p_ppvids);
@@ -735,7 +754,7 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 				    hardware->h_ifname);
 				goto malformed;
 			}
-			if ((b = (char *)calloc(1, tlv_size - 1)) == NULL) {
+			if ((b = (char *)arena_alloc(arena, tlv_size - 1)) == NULL) {
 				log_warn("lldp",
 				    "unable to allocate memory for id tlv "
 				    "received on %s",
@@ -748,7 +767,6 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 					log_warnx("lldp",
 					    "Port ID TLV received twice on %s",
 					    hardware->h_ifname);
-					free(b);
 					goto malformed;
 				}
 				port->p_id_subtype = tlv_subtype;
@@ -759,7 +777,6 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 					log_warnx("lldp",
 					    "Chassis ID TLV received twice on %s",
 					    hardware->h_ifname);
-					free(b);
 					goto malformed;
 				}
 				chassis->c_id_subtype = tlv_subtype;
@@ -785,7 +802,7 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 				    hardware->h_ifname);
 				break;
 			}
-			if ((b = (char *)calloc(1, tlv_size + 1)) == NULL) {
+			if ((b = (char *)arena_alloc(arena, tlv_size + 1)) == NULL) {
 				log_warn("lldp",
 				    "unable to allocate memory for string tlv "
 				    "received on %s",
@@ -795,21 +812,14 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 			PEEK_BYTES(b, tlv_size);
 			switch (tlv_type) {
 			case LLDP_TLV_PORT_DESCR:
-				free(port->p_descr);
 				port->p_descr = b;
 				break;
 			case LLDP_TLV_SYSTEM_NAME:
-				free(chassis->c_name);
 				chassis->c_name = b;
 				break;
 			case LLDP_TLV_SYSTEM_DESCR:
-				free(chassis->c_descr);
 				chassis->c_descr = b;
 				break;
-			default:
-				/* unreachable */
-				free(b);
-				break;
 			}
 			break;
 		case LLDP_TLV_SYSTEM_CAP:
@@ -840,7 +850,8 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 				iface = iface_number;
 			else
 				iface = 0;
-			mgmt = lldpd_alloc_mgmt(af, addr_ptr, addr_length, iface);
+			mgmt = lldpd_alloc_mgmt(arena, af, addr_ptr, addr_length,
+			    iface);
 			if (mgmt == NULL) {
 				if (errno == ENOMEM)
 					log_warn("lldp",
@@ -868,8 +879,9 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 				switch (tlv_subtype) {
 				case LLDP_TLV_DOT1_VLANNAME:
 					CHECK_TLV_SIZE(7, "VLAN");
-					if ((vlan = (struct lldpd_vlan *)calloc(1,
-						 sizeof(struct lldpd_vlan))) == NULL) {
+					if ((vlan = (struct lldpd_vlan *)arena_alloc(
+						 arena, sizeof(struct lldpd_vlan))) ==
+					    NULL) {
 						log_warn("lldp",
 						    "unable to alloc vlan "
 						    "structure for "
@@ -880,7 +892,7 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 					vlan->v_vid = PEEK_UINT16;
 					vlan_len = PEEK_UINT8;
 					CHECK_TLV_SIZE(7 + vlan_len, "VLAN");
-					if ((vlan->v_name = (char *)calloc(1,
+					if ((vlan->v_name = (char *)arena_alloc(arena,
 						 vlan_len + 1)) == NULL) {
 						log_warn("lldp",
 						    "unable to alloc vlan name for "
@@ -891,7 +903,6 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 					PEEK_BYTES(vlan->v_name, vlan_len);
 					TAILQ_INSERT_TAIL(&port->p_vlans, vlan,
 					    v_entries);
-					vlan = NULL;
 					break;
 				case LLDP_TLV_DOT1_PVID:
 					CHECK_TLV_SIZE(6, "PVID");
@@ -907,8 +918,9 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 					   enabled bit is set - PPVID TLV is
 					   considered error  and discarded */
 					/* if PPVID > 4096 - bad and discard */
-					if ((ppvid = (struct lldpd_ppvid *)calloc(1,
-						 sizeof(struct lldpd_ppvid))) == NULL) {
+					if ((ppvid = (struct lldpd_ppvid *)arena_alloc(
+						 arena, sizeof(struct lldpd_ppvid))) ==
+					    NULL) {
 						log_warn("lldp",
 						    "unable to alloc ppvid "
 						    "structure for "
@@ -927,7 +939,7 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 					   one PI TLVs are received  - discard
 					   if duplicate ?? */
 					CHECK_TLV_SIZE(5, "PI");
-					if ((pi = (struct lldpd_pi *)calloc(1,
+					if ((pi = (struct lldpd_pi *)arena_alloc(arena,
 						 sizeof(struct lldpd_pi))) == NULL) {
 						log_warn("lldp",
 						    "unable to alloc PI "
@@ -938,7 +950,7 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 					}
 					pi->p_pi_len = PEEK_UINT8;
 					CHECK_TLV_SIZE(5 + pi->p_pi_len, "PI");
-					if ((pi->p_pi = (char *)calloc(1,
+					if ((pi->p_pi = (char *)arena_alloc(arena,
 						 pi->p_pi_len)) == NULL) {
 						log_warn("lldp",
 						    "unable to alloc pid name for "
@@ -948,7 +960,6 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 					}
 					PEEK_BYTES(pi->p_pi, pi->p_pi_len);
 					TAILQ_INSERT_TAIL(&port->p_pids, pi, p_entries);
-					pi = NULL;
 					break;
 				default:
 					/* Unknown Dot1 TLV, ignore it */
@@ -1114,10 +1125,9 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 						    hardware->h_ifname);
 						break;
 					}
-					free(port->p_med_location[loctype - 1].data);
 					if ((port->p_med_location[loctype - 1].data =
-						    (char *)malloc(tlv_size - 5)) ==
-					    NULL) {
+						    (char *)arena_alloc(arena,
+							tlv_size - 5)) == NULL) {
 						log_warn("lldp",
 						    "unable to allocate memory "
 						    "for LLDP-MED location for "
@@ -1207,7 +1217,7 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 					if (tlv_size <= 4)
 						b = NULL;
 					else {
-						if ((b = (char *)malloc(
+						if ((b = (char *)arena_alloc(arena,
 							 tlv_size - 3)) == NULL) {
 							log_warn("lldp",
 							    "unable to allocate "
@@ -1222,37 +1232,26 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 					}
 					switch (tlv_subtype) {
 					case LLDP_TLV_MED_IV_HW:
-						free(chassis->c_med_hw);
 						chassis->c_med_hw = b;
 						break;
 					case LLDP_TLV_MED_IV_FW:
-						free(chassis->c_med_fw);
 						chassis->c_med_fw = b;
 						break;
 					case LLDP_TLV_MED_IV_SW:
-						free(chassis->c_med_sw);
 						chassis->c_med_sw = b;
 						break;
 					case LLDP_TLV_MED_IV_SN:
-						free(chassis->c_med_sn);
 						chassis->c_med_sn = b;
 						break;
 					case LLDP_TLV_MED_IV_MANUF:
-						free(chassis->c_med_manuf);
 						chassis->c_med_manuf = b;
 						break;
 					case LLDP_TLV_MED_IV_MODEL:
-						free(chassis->c_med_model);
 						chassis->c_med_model = b;
 						break;
 					case LLDP_TLV_MED_IV_ASSET:
-						free(chassis->c_med_asset);
 						chassis->c_med_asset = b;
 						break;
-					default:
-						/* unreachable */
-						free(b);
-						break;
 					}
 					port->p_med_cap_enabled |= LLDP_MED_CAP_IV;
 					break;
@@ -1275,7 +1274,7 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 			if (unrecognized) {
 				hardware->h_rx_unrecognized_cnt++;
 #ifdef ENABLE_CUSTOM
-				custom = (struct lldpd_custom *)calloc(1,
+				custom = (struct lldpd_custom *)arena_alloc(arena,
 				    sizeof(struct lldpd_custom));
 				if (!custom) {
 					log_warn("lldp",
@@ -1286,7 +1285,8 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 				memcpy(custom->oui, orgid, sizeof(custom->oui));
 				custom->subtype = tlv_subtype;
 				if (custom->oui_info_len > 0) {
-					custom->oui_info = malloc(custom->oui_info_len);
+					custom->oui_info = arena_alloc(arena,
+					    custom->oui_info_len);
 					if (!custom->oui_info) {
 						log_warn("lldp",
 						    "unable to allocate memory for custom TLV data");
@@ -1296,7 +1296,6 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 					    custom->oui_info_len);
 				}
 				TAILQ_INSERT_TAIL(&port->p_custom_list, custom, next);
-				custom = NULL;
 #endif
 			}
 			break;
@@ -1325,13 +1324,6 @@ lldp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardwa
 	*newport = port;
 	return 1;
 malformed:
-#ifdef ENABLE_CUSTOM
-	free(custom);
-#endif
-#ifdef ENABLE_DOT1
-	free(vlan);
-	free(pi);
-#endif
 	lldpd_chassis_cleanup(chassis, 1);
 	lldpd_port_cleanup(port, 1);
 	free(port);
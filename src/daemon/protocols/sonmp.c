@@ -188,9 +188,12 @@ sonmp_send(struct lldpd *global, struct lldpd_hardware *hardware)
 	struct lldpd_chassis *chassis;
 	struct lldpd_mgmt *mgmt;
 	u_int8_t *packet, *pos, *pos_pid, *end;
-	int length;
+	int length, ret;
 	struct in_addr address;
 
+	if ((ret = lldpd_send_cached(global, hardware, LLDPD_MODE_SONMP)) != -1)
+		return ret;
+
 	log_debug("sonmp", "send SONMP PDU to %s", hardware->h_ifname);
 
 	chassis = hardware->h_lport.p_chassis;
@@ -243,10 +246,13 @@ sonmp_send(struct lldpd *global, struct lldpd_hardware *hardware)
 		POKE_SAVE(end)))
 		goto toobig;
 
+	/* Cache the frame before its source address is mangled for bonds */
+	lldpd_cache_frame(global, hardware, LLDPD_MODE_SONMP, 0, packet, end - packet);
 	if (interfaces_send_helper(global, hardware, (char *)packet, end - packet) ==
 	    -1) {
 		log_warn("sonmp", "unable to send packet on real device for %s",
 		    hardware->h_ifname);
+		lldpd_tx_cache_cleanup(hardware);
 		free(packet);
 		return ENETDOWN;
 	}
@@ -256,12 +262,16 @@ sonmp_send(struct lldpd *global, struct lldpd_hardware *hardware)
 	POKE_RESTORE(packet);		  /* Go to the beginning */
 	PEEK_DISCARD(ETHER_ADDR_LEN - 1); /* Modify the last byte of the MAC address */
 	(void)POKE_UINT8(1);
+	/* Restore the source address, it may have been mangled */
+	(void)POKE_BYTES(&hardware->h_lladdr, ETHER_ADDR_LEN);
 
+	lldpd_cache_frame(global, hardware, LLDPD_MODE_SONMP, 1, packet, end - packet);
 	if (interfaces_send_helper(global, hardware, (char *)packet, end - packet) ==
 	    -1) {
 		log_warn("sonmp",
 		    "unable to send second SONMP packet on real device for %s",
 		    hardware->h_ifname);
+		lldpd_tx_cache_cleanup(hardware);
 		free(packet);
 		return ENETDOWN;
 	}
@@ -281,6 +291,7 @@ sonmp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardw
 	const u_int8_t mcastaddr[] = SONMP_MULTICAST_ADDR;
 	struct lldpd_chassis *chassis;
 	struct lldpd_port *port;
+	struct arena *arena;
 	struct lldpd_mgmt *mgmt;
 	int length, i;
 	u_int8_t *pos;
@@ -299,6 +310,14 @@ sonmp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardw
 		free(chassis);
 		return -1;
 	}
+	if ((arena = arena_new(2 * s)) == NULL) {
+		log_warn("sonmp", "failed to allocate memory for remote port");
+		free(port);
+		free(chassis);
+		return -1;
+	}
+	chassis->c_arena = arena;
+	port->p_arena = arena_ref(arena);
 #  ifdef ENABLE_DOT1
 	TAILQ_INIT(&port->p_vlans);
 #  endif
@@ -325,7 +344,7 @@ sonmp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardw
 	}
 
 	chassis->c_id_subtype = LLDP_CHASSISID_SUBTYPE_ADDR;
-	if ((chassis->c_id = calloc(1, sizeof(struct in_addr) + 1)) == NULL) {
+	if ((chassis->c_id = arena_alloc(arena, sizeof(struct in_addr) + 1)) == NULL) {
 		log_warn("sonmp", "unable to allocate memory for chassis id on %s",
 		    hardware->h_ifname);
 		goto malformed;
@@ -334,7 +353,8 @@ sonmp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardw
 	chassis->c_id[0] = 1;
 	PEEK_BYTES(&address, sizeof(struct in_addr));
 	memcpy(chassis->c_id + 1, &address, sizeof(struct in_addr));
-	if (asprintf(&chassis->c_name, "%s", inet_ntoa(address)) == -1) {
+	if (arena_asprintf(arena, &chassis->c_name, "%s", inet_ntoa(address)) ==
+	    -1) {
 		log_warnx("sonmp", "unable to write chassis name for %s",
 		    hardware->h_ifname);
 		goto malformed;
@@ -344,13 +364,14 @@ sonmp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardw
 	for (i = 0; sonmp_chassis_types[i].type != 0; i++) {
 		if (sonmp_chassis_types[i].type == rchassis) break;
 	}
-	if (asprintf(&chassis->c_descr, "%s", sonmp_chassis_types[i].description) ==
-	    -1) {
+	if (arena_asprintf(arena, &chassis->c_descr, "%s",
+		sonmp_chassis_types[i].description) == -1) {
 		log_warnx("sonmp", "unable to write chassis description for %s",
 		    hardware->h_ifname);
 		goto malformed;
 	}
-	mgmt = lldpd_alloc_mgmt(LLDPD_AF_IPV4, &address, sizeof(struct in_addr), 0);
+	mgmt = lldpd_alloc_mgmt(arena, LLDPD_AF_IPV4, &address,
+	    sizeof(struct in_addr), 0);
 	if (mgmt == NULL) {
 		if (errno == ENOMEM)
 			log_warn("sonmp",
@@ -367,8 +388,8 @@ sonmp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardw
 
 	port->p_id_subtype = LLDP_PORTID_SUBTYPE_LOCAL;
 
-	port->p_id_len =
-	    asprintf(&port->p_id, "%02x-%02x-%02x", seg[0], seg[1], seg[2]);
+	port->p_id_len = arena_asprintf(arena, &port->p_id, "%02x-%02x-%02x", seg[0],
+	    seg[1], seg[2]);
 	if (port->p_id_len == -1) {
 		log_warn("sonmp", "unable to allocate memory for port id on %s",
 		    hardware->h_ifname);
@@ -377,20 +398,21 @@ sonmp_decode(struct lldpd *cfg, char *frame, int s, struct lldpd_hardware *hardw
 
 	/* Port description depend on the number of segments */
 	if ((seg[0] == 0) && (seg[1] == 0)) {
-		if (asprintf(&port->p_descr, "port %d", seg[2]) == -1) {
+		if (arena_asprintf(arena, &port->p_descr, "port %d", seg[2]) == -1) {
 			log_warnx("sonmp", "unable to write port description for %s",
 			    hardware->h_ifname);
 			goto malformed;
 		}
 	} else if (seg[0] == 0) {
-		if (asprintf(&port->p_descr, "port %d/%d", seg[1], seg[2]) == -1) {
+		if (arena_asprintf(arena, &port->p_descr, "port %d/%d", seg[1],
+			seg[2]) == -1) {
 			log_warnx("sonmp", "unable to write port description for %s",
 			    hardware->h_ifname);
 			goto malformed;
 		}
 	} else {
-		if (asprintf(&port->p_descr, "port %x:%x:%x", seg[0], seg[1], seg[2]) ==
-		    -1) {
+		if (arena_asprintf(arena, &port->p_descr, "port %x:%x:%x", seg[0],
+			seg[1], seg[2]) == -1) {
 			log_warnx("sonmp", "unable to write port description for %s",
 			    hardware->h_ifname);
 			goto malformed;
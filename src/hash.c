@@ -0,0 +1,129 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2026 Vincent Bernat <bernat@luffy.cx>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "hash.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+
+#define HASH_MIN_SIZE 16
+
+/* FNV-1a. Chain calls by giving the previous result as the seed. */
+u_int32_t
+hash_bytes(u_int32_t hash, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+	while (len--) {
+		hash ^= *p++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static struct hash_entry **
+hash_bucket(struct hash_table *table, u_int32_t hash)
+{
+	if (table->ht_buckets == NULL) return &table->ht_inline;
+	return &table->ht_buckets[hash & (table->ht_size - 1)];
+}
+
+static void
+hash_grow(struct hash_table *table)
+{
+	struct hash_entry **old, **buckets, *entry, *entry_next;
+	u_int32_t oldsize, size, i;
+
+	old = table->ht_buckets ? table->ht_buckets : &table->ht_inline;
+	oldsize = table->ht_buckets ? table->ht_size : 1;
+	size = table->ht_buckets ? table->ht_size * 2 : HASH_MIN_SIZE;
+	if (size == 0 || (buckets = calloc(size, sizeof(*buckets))) == NULL) {
+		log_debug("hash", "unable to grow hash table to %u buckets", size);
+		return;
+	}
+
+	/* Move all entries to the new buckets. */
+	for (i = 0; i < oldsize; i++) {
+		for (entry = old[i]; entry != NULL; entry = entry_next) {
+			entry_next = entry->he_next;
+			entry->he_next = buckets[entry->he_hash & (size - 1)];
+			buckets[entry->he_hash & (size - 1)] = entry;
+		}
+	}
+	free(table->ht_buckets);
+	table->ht_buckets = buckets;
+	table->ht_inline = NULL;
+	table->ht_size = size;
+}
+
+void
+hash_insert(struct hash_table *table, struct hash_entry *entry, u_int32_t hash)
+{
+	struct hash_entry **bucket;
+
+	if (table->ht_count >= (table->ht_buckets ? table->ht_size : 1))
+		hash_grow(table);
+	bucket = hash_bucket(table, hash);
+	entry->he_hash = hash;
+	entry->he_next = *bucket;
+	*bucket = entry;
+	table->ht_count++;
+}
+
+/* Remove an entry. It is not an error to remove an entry not in the table. */
+void
+hash_remove(struct hash_table *table, struct hash_entry *entry)
+{
+	struct hash_entry **prev;
+
+	for (prev = hash_bucket(table, entry->he_hash); *prev != NULL;
+	     prev = &(*prev)->he_next) {
+		if (*prev == entry) {
+			*prev = entry->he_next;
+			entry->he_next = NULL;
+			table->ht_count--;
+			return;
+		}
+	}
+}
+
+struct hash_entry *
+hash_first(struct hash_table *table, u_int32_t hash)
+{
+	struct hash_entry *entry;
+	for (entry = *hash_bucket(table, hash); entry != NULL; entry = entry->he_next)
+		if (entry->he_hash == hash) return entry;
+	return NULL;
+}
+
+struct hash_entry *
+hash_next(struct hash_entry *current)
+{
+	struct hash_entry *entry;
+	for (entry = current->he_next; entry != NULL; entry = entry->he_next)
+		if (entry->he_hash == current->he_hash) return entry;
+	return NULL;
+}
+
+/* Release memory used by the table. Entries are not touched. */
+void
+hash_free(struct hash_table *table)
+{
+	free(table->ht_buckets);
+	memset(table, 0, sizeof(*table));
+}
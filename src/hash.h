@@ -0,0 +1,58 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2026 Vincent Bernat <bernat@luffy.cx>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _HASH_H
+#define _HASH_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Intrusive hash table. An object embeds a `struct hash_entry` and the caller
+ * provides the hash value when inserting or looking up. Entries sharing the
+ * same hash are walked with `hash_first()`/`hash_next()` and the caller
+ * compares the actual keys.
+ *
+ * A zeroed table is a valid empty table. Insertion never fails: when memory
+ * is short, the table just does not grow (and only gets slower). This keeps
+ * indexes consistent with the lists they are built on. */
+struct hash_entry {
+	struct hash_entry *he_next; /* Next entry in the same bucket */
+	u_int32_t he_hash;	    /* Cached hash value */
+};
+struct hash_table {
+	struct hash_entry **ht_buckets; /* NULL until the table grows */
+	struct hash_entry *ht_inline;	/* Single bucket used before that */
+	u_int32_t ht_size;		/* Number of buckets (power of two) */
+	u_int32_t ht_count;		/* Number of entries */
+};
+
+#define HASH_INIT 2166136261U
+
+/* Get the object containing the given entry */
+#define HASH_ENTRY(entry, type, field) \
+  ((type *)(void *)((char *)(entry)-offsetof(type, field)))
+#define HASH_FOREACH(var, table, hash) \
+  for ((var) = hash_first(table, hash); (var) != NULL; (var) = hash_next(var))
+
+u_int32_t hash_bytes(u_int32_t, const void *, size_t);
+void hash_insert(struct hash_table *, struct hash_entry *, u_int32_t);
+void hash_remove(struct hash_table *, struct hash_entry *);
+struct hash_entry *hash_first(struct hash_table *, u_int32_t);
+struct hash_entry *hash_next(struct hash_entry *);
+void hash_free(struct hash_table *);
+
+#endif
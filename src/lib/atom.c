@@ -15,6 +15,7 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <errno.h>
 #include <stdio.h>
 #include <string.h>
 #include <limits.h>
@@ -332,8 +333,8 @@ _lldpctl_do_something(lldpctl_conn_t *conn, int state_send, int state_recv,
 	    (state_data == NULL ||
 		!strncmp(conn->state_data, state_data, sizeof(conn->state_data) - 1))) {
 		/* We need to receive the answer */
-		while ((rc = ctl_msg_recv_unserialized(&conn->input_buffer,
-			    &conn->input_buffer_len, type, to_recv, mi_recv)) > 0) {
+		while ((rc = _lldpctl_recv_message(conn, type, to_recv, mi_recv)) >
+		    0) {
 			/* We need more bytes */
 			rc = _lldpctl_needs(conn, rc);
 			if (rc < 0) return SET_ERROR(conn, rc);
@@ -347,6 +348,44 @@ _lldpctl_do_something(lldpctl_conn_t *conn, int state_send, int state_recv,
 		return SET_ERROR(conn, LLDPCTL_ERR_INVALID_STATE);
 }
 
+/* Subscribe to changes, with the coalescing and delta parameters if any. */
+static int
+subscribe(lldpctl_conn_t *conn)
+{
+	struct lldpd_subscription subscription = { .window = conn->watch_window,
+		.queue = conn->watch_queue,
+		.delta = conn->watch_delta };
+
+	return _lldpctl_do_something(conn, CONN_STATE_SET_WATCH_SEND,
+	    CONN_STATE_SET_WATCH_RECV, NULL, SUBSCRIBE,
+	    (conn->watch_window || conn->watch_delta) ? &subscription : NULL,
+	    &MARSHAL_INFO(lldpd_subscription), NULL, NULL);
+}
+
+int
+lldpctl_watch_coalesce(lldpctl_conn_t *conn, int window, int queue)
+{
+	RESET_ERROR(conn);
+
+	if (conn->state != CONN_STATE_IDLE)
+		return SET_ERROR(conn, LLDPCTL_ERR_INVALID_STATE);
+	if (window < 0 || queue < 0) return SET_ERROR(conn, LLDPCTL_ERR_BAD_VALUE);
+	conn->watch_window = window;
+	conn->watch_queue = queue;
+	return 0;
+}
+
+int
+lldpctl_watch_delta(lldpctl_conn_t *conn, int enable)
+{
+	RESET_ERROR(conn);
+
+	if (conn->state != CONN_STATE_IDLE)
+		return SET_ERROR(conn, LLDPCTL_ERR_INVALID_STATE);
+	conn->watch_delta = !!enable;
+	return 0;
+}
+
 int
 lldpctl_watch_callback(lldpctl_conn_t *conn, lldpctl_change_callback cb, void *data)
 {
@@ -354,8 +393,7 @@ lldpctl_watch_callback(lldpctl_conn_t *conn, lldpctl_change_callback cb, void *d
 
 	RESET_ERROR(conn);
 
-	rc = _lldpctl_do_something(conn, CONN_STATE_SET_WATCH_SEND,
-	    CONN_STATE_SET_WATCH_RECV, NULL, SUBSCRIBE, NULL, NULL, NULL, NULL);
+	rc = subscribe(conn);
 	if (rc == 0) {
 		conn->watch_cb = cb;
 		conn->watch_data = data;
@@ -371,8 +409,7 @@ lldpctl_watch_callback2(lldpctl_conn_t *conn, lldpctl_change_callback2 cb, void
 
 	RESET_ERROR(conn);
 
-	rc = _lldpctl_do_something(conn, CONN_STATE_SET_WATCH_SEND,
-	    CONN_STATE_SET_WATCH_RECV, NULL, SUBSCRIBE, NULL, NULL, NULL, NULL);
+	rc = subscribe(conn);
 	if (rc == 0) {
 		conn->watch_cb2 = cb;
 		conn->watch_data = data;
@@ -485,6 +522,361 @@ lldpctl_get_port(lldpctl_atom_t *atom)
 	return NULL;
 }
 
+/* Get the port from an answer to GET_INTERFACE_IF_MODIFIED. The answer is
+ * freed. */
+static lldpctl_atom_t *
+port_if_modified(lldpctl_conn_t *conn, struct lldpd_interface_answer *answer,
+    uint32_t *generation)
+{
+	struct lldpd_hardware *hardware = answer->hardware;
+
+	*generation = answer->generation;
+	free(answer);
+	if (hardware == NULL) {
+		SET_ERROR(conn, LLDPCTL_ERR_NOT_MODIFIED);
+		return NULL;
+	}
+	return _lldpctl_new_atom(conn, atom_port, 1, hardware, &hardware->h_lport,
+	    NULL);
+}
+
+lldpctl_atom_t *
+lldpctl_get_port_if_modified(lldpctl_atom_t *atom, uint32_t *generation)
+{
+	int rc;
+	lldpctl_conn_t *conn = atom->conn;
+	struct _lldpctl_atom_interface_t *iface =
+	    (struct _lldpctl_atom_interface_t *)atom;
+	struct lldpd_interface_request request = { .ifname = iface->name,
+		.generation = *generation };
+	void *p;
+
+	RESET_ERROR(conn);
+
+	if (atom->type != atom_interface) {
+		SET_ERROR(conn, LLDPCTL_ERR_INCORRECT_ATOM_TYPE);
+		return NULL;
+	}
+	rc = _lldpctl_do_something(conn, CONN_STATE_GET_PORT_IF_MODIFIED_SEND,
+	    CONN_STATE_GET_PORT_IF_MODIFIED_RECV, iface->name,
+	    GET_INTERFACE_IF_MODIFIED, &request,
+	    &MARSHAL_INFO(lldpd_interface_request), &p,
+	    &MARSHAL_INFO(lldpd_interface_answer));
+	if (rc != 0) return NULL;
+	return port_if_modified(conn, p, generation);
+}
+
+/* Add the local port of a record to a list of local ports. The record is
+ * freed. */
+static int
+neighbors_add(lldpctl_conn_t *conn, lldpctl_atom_t *list,
+    struct lldpd_neighbors_record *record)
+{
+	struct _lldpctl_atom_local_ports_list_t *plist =
+	    (struct _lldpctl_atom_local_ports_list_t *)list;
+	lldpctl_atom_t *port, **ports;
+	size_t size;
+
+	port = _lldpctl_new_atom(conn, atom_port, 1, record->hardware,
+	    &record->hardware->h_lport, NULL);
+	free(record);
+	if (port == NULL) return conn->error ? conn->error : LLDPCTL_ERR_NOMEM;
+	if (plist->count == plist->size) {
+		size = plist->size ? plist->size * 2 : 16;
+		if ((ports = realloc(plist->ports, size * sizeof(*ports))) == NULL) {
+			lldpctl_atom_dec_ref(port);
+			return SET_ERROR(conn, LLDPCTL_ERR_NOMEM);
+		}
+		plist->ports = ports;
+		plist->size = size;
+	}
+	plist->ports[plist->count++] = port;
+	return 0;
+}
+
+lldpctl_atom_t *
+lldpctl_get_neighbors(lldpctl_conn_t *conn, const char *ifnames, int protocol)
+{
+	struct lldpd_neighbors_filter filter = { .ifnames = (char *)ifnames,
+		.protocol = protocol };
+	struct lldpd_neighbors_record *record;
+	lldpctl_atom_t *list;
+	void *p;
+	int rc;
+
+	RESET_ERROR(conn);
+
+	if (conn->state != CONN_STATE_GET_NEIGHBORS_SEND &&
+	    conn->state != CONN_STATE_GET_NEIGHBORS_RECV) {
+		lldpctl_atom_dec_ref(conn->state_atom);
+		conn->state_atom = _lldpctl_new_atom(conn, atom_local_ports_list);
+		if (conn->state_atom == NULL) return NULL;
+	}
+	list = conn->state_atom;
+
+	/* The answer is made of one message per interface. Each time one is
+	 * received, we get back to the receiving state until the last one. */
+	for (;;) {
+		rc = _lldpctl_do_something(conn, CONN_STATE_GET_NEIGHBORS_SEND,
+		    CONN_STATE_GET_NEIGHBORS_RECV, NULL, GET_NEIGHBORS, &filter,
+		    &MARSHAL_INFO(lldpd_neighbors_filter), &p,
+		    &MARSHAL_INFO(lldpd_neighbors_record));
+		if (rc == LLDPCTL_ERR_WOULDBLOCK) return NULL;
+		if (rc != 0) goto error;
+		record = p;
+		if (record->hardware == NULL) {
+			free(record);
+			break;
+		}
+		rc = neighbors_add(conn, list, record);
+		if (rc != 0) goto error;
+		conn->state = CONN_STATE_GET_NEIGHBORS_RECV;
+	}
+
+	conn->state_atom = NULL;
+	return list;
+
+error:
+	conn->state_atom = NULL;
+	lldpctl_atom_dec_ref(list);
+	return NULL;
+}
+
+/* Allocate a request for an asynchronous function. */
+static struct lldpctl_request *
+request_new(lldpctl_conn_t *conn, enum hmsg_type type, struct marshal_info *mi,
+    int (*answer)(lldpctl_conn_t *, struct lldpctl_request *, void *),
+    lldpctl_request_callback cb, void *data)
+{
+	struct lldpctl_request *request;
+
+	if ((request = calloc(1, sizeof(*request))) == NULL) {
+		SET_ERROR(conn, LLDPCTL_ERR_NOMEM);
+		return NULL;
+	}
+	request->type = type;
+	request->mi = mi;
+	request->answer = answer;
+	request->cb = cb;
+	request->data = data;
+	return request;
+}
+
+static int
+interfaces_answer(lldpctl_conn_t *conn, struct lldpctl_request *request, void *p)
+{
+	request->result = _lldpctl_new_atom(conn, atom_interfaces_list, p);
+	return request->result ? 0 : LLDPCTL_ERR_NOMEM;
+}
+
+int
+lldpctl_get_interfaces_async(lldpctl_conn_t *conn, lldpctl_request_callback cb,
+    void *data)
+{
+	struct lldpctl_request *request;
+
+	RESET_ERROR(conn);
+
+	request = request_new(conn, GET_INTERFACES, &MARSHAL_INFO(lldpd_interface_list),
+	    interfaces_answer, cb, data);
+	if (request == NULL) return conn->error;
+	return _lldpctl_request(conn, GET_INTERFACES, NULL, NULL, request);
+}
+
+static int
+port_answer(lldpctl_conn_t *conn, struct lldpctl_request *request, void *p)
+{
+	struct lldpd_hardware *hardware = p;
+
+	request->result = _lldpctl_new_atom(conn, atom_port, 1, hardware,
+	    &hardware->h_lport, NULL);
+	return request->result ? 0 : LLDPCTL_ERR_NOMEM;
+}
+
+int
+lldpctl_get_port_async(lldpctl_atom_t *atom, lldpctl_request_callback cb, void *data)
+{
+	lldpctl_conn_t *conn = atom->conn;
+	struct _lldpctl_atom_interface_t *iface =
+	    (struct _lldpctl_atom_interface_t *)atom;
+	struct lldpctl_request *request;
+
+	RESET_ERROR(conn);
+
+	if (atom->type != atom_interface)
+		return SET_ERROR(conn, LLDPCTL_ERR_INCORRECT_ATOM_TYPE);
+	request = request_new(conn, GET_INTERFACE, &MARSHAL_INFO(lldpd_hardware),
+	    port_answer, cb, data);
+	if (request == NULL) return conn->error;
+	return _lldpctl_request(conn, GET_INTERFACE, (void *)iface->name,
+	    &MARSHAL_INFO(string), request);
+}
+
+static int
+port_if_modified_answer(lldpctl_conn_t *conn, struct lldpctl_request *request,
+    void *p)
+{
+	RESET_ERROR(conn);
+	request->result = port_if_modified(conn, p, request->generation);
+	if (request->result == NULL)
+		return conn->error ? conn->error : LLDPCTL_ERR_NOMEM;
+	return 0;
+}
+
+int
+lldpctl_get_port_if_modified_async(lldpctl_atom_t *atom, uint32_t *generation,
+    lldpctl_request_callback cb, void *data)
+{
+	lldpctl_conn_t *conn = atom->conn;
+	struct _lldpctl_atom_interface_t *iface =
+	    (struct _lldpctl_atom_interface_t *)atom;
+	struct lldpd_interface_request content = { .ifname = iface->name,
+		.generation = *generation };
+	struct lldpctl_request *request;
+
+	RESET_ERROR(conn);
+
+	if (atom->type != atom_interface)
+		return SET_ERROR(conn, LLDPCTL_ERR_INCORRECT_ATOM_TYPE);
+	request = request_new(conn, GET_INTERFACE_IF_MODIFIED,
+	    &MARSHAL_INFO(lldpd_interface_answer), port_if_modified_answer, cb,
+	    data);
+	if (request == NULL) return conn->error;
+	request->generation = generation;
+	return _lldpctl_request(conn, GET_INTERFACE_IF_MODIFIED, &content,
+	    &MARSHAL_INFO(lldpd_interface_request), request);
+}
+
+/* The answer to GET_NEIGHBORS is made of one message per interface, then a
+ * last one without interface. */
+static int
+neighbors_answer(lldpctl_conn_t *conn, struct lldpctl_request *request, void *p)
+{
+	struct lldpd_neighbors_record *record = p;
+	int rc;
+
+	if (record->hardware == NULL) {
+		free(record);
+		return 0;
+	}
+	rc = neighbors_add(conn, request->result, record);
+	return rc ? rc : 1;
+}
+
+int
+lldpctl_get_neighbors_async(lldpctl_conn_t *conn, const char *ifnames, int protocol,
+    lldpctl_request_callback cb, void *data)
+{
+	struct lldpd_neighbors_filter filter = { .ifnames = (char *)ifnames,
+		.protocol = protocol };
+	struct lldpctl_request *request;
+
+	RESET_ERROR(conn);
+
+	request = request_new(conn, GET_NEIGHBORS,
+	    &MARSHAL_INFO(lldpd_neighbors_record), neighbors_answer, cb, data);
+	if (request == NULL) return conn->error;
+	if ((request->result = _lldpctl_new_atom(conn, atom_local_ports_list)) ==
+	    NULL) {
+		free(request);
+		return conn->error ? conn->error : SET_ERROR(conn, LLDPCTL_ERR_NOMEM);
+	}
+	return _lldpctl_request(conn, GET_NEIGHBORS, &filter,
+	    &MARSHAL_INFO(lldpd_neighbors_filter), request);
+}
+
+/* Translate a failure to read the snapshot. When it is not available anymore,
+ * it is closed: lldpd may have been restarted with a new one. */
+static int
+snapshot_error(lldpctl_conn_t *conn)
+{
+	if (errno == EAGAIN) return SET_ERROR(conn, LLDPCTL_ERR_WOULDBLOCK);
+	snapshot_close(&conn->snapshot);
+	return SET_ERROR(conn, LLDPCTL_ERR_NOT_EXIST);
+}
+
+int
+lldpctl_snapshot_generation(lldpctl_conn_t *conn, uint64_t *generation)
+{
+	u_int64_t current;
+
+	RESET_ERROR(conn);
+
+	if (_lldpctl_snapshot_open(conn) != 0) return conn->error;
+	if (snapshot_generation(&conn->snapshot, &current) == -1)
+		return snapshot_error(conn);
+	*generation = current;
+	return 0;
+}
+
+lldpctl_atom_t *
+lldpctl_snapshot_neighbors(lldpctl_conn_t *conn, uint64_t *generation)
+{
+	struct lldpd_neighbors_record *record;
+	lldpctl_atom_t *list;
+	u_int64_t current;
+	uint8_t *content, *message = NULL, *new;
+	size_t offset = 0, consumed, size = 0;
+	ssize_t len;
+	void *p;
+
+	RESET_ERROR(conn);
+
+	if (_lldpctl_snapshot_open(conn) != 0) return NULL;
+	if ((len = snapshot_read(&conn->snapshot, (void **)&content, &current)) ==
+	    -1) {
+		snapshot_error(conn);
+		return NULL;
+	}
+	if ((list = _lldpctl_new_atom(conn, atom_local_ports_list)) == NULL) {
+		free(content);
+		return NULL;
+	}
+
+	/* The snapshot contains the same messages as the answer to
+	 * GET_NEIGHBORS. Each of them is copied into an aligned buffer before
+	 * being unserialized. */
+	for (;;) {
+		if (ctl_msg_parse_unserialized(content + offset, len - offset,
+			GET_NEIGHBORS, NULL, NULL, &consumed) != 0) {
+			SET_ERROR(conn, LLDPCTL_ERR_SERIALIZATION);
+			goto error;
+		}
+		if (consumed > size) {
+			if ((new = realloc(message, consumed)) == NULL) {
+				SET_ERROR(conn, LLDPCTL_ERR_NOMEM);
+				goto error;
+			}
+			message = new;
+			size = consumed;
+		}
+		memcpy(message, content + offset, consumed);
+		if (ctl_msg_parse_unserialized(message, consumed, GET_NEIGHBORS, &p,
+			&MARSHAL_INFO(lldpd_neighbors_record), &consumed) != 0) {
+			SET_ERROR(conn, LLDPCTL_ERR_SERIALIZATION);
+			goto error;
+		}
+		offset += consumed;
+		record = p;
+		if (record->hardware == NULL) {
+			free(record);
+			break;
+		}
+		if (neighbors_add(conn, list, record) != 0) goto error;
+	}
+
+	free(message);
+	free(content);
+	if (generation) *generation = current;
+	return list;
+
+error:
+	free(message);
+	free(content);
+	lldpctl_atom_dec_ref(list);
+	return NULL;
+}
+
 lldpctl_atom_t *
 lldpctl_get_default_port(lldpctl_conn_t *conn)
 {
@@ -20,8 +20,25 @@
 #include "../compat/compat.h"
 #include "../marshal.h"
 #include "../ctl.h"
+#include "../snapshot.h"
 
 /* connection.c */
+
+/* Request sent by an asynchronous function, waiting for its answer. */
+struct lldpctl_request {
+	TAILQ_ENTRY(lldpctl_request) next;
+	enum hmsg_type type;	 /* Type of the expected answer */
+	struct marshal_info *mi; /* Content of the expected answer */
+	/* Build the result from an answer. Return 1 when more answers are
+	 * expected, 0 when the result is complete or a negative integer in
+	 * case of errors. */
+	int (*answer)(lldpctl_conn_t *, struct lldpctl_request *, void *);
+	lldpctl_atom_t *result; /* Result, possibly being built */
+	uint32_t *generation;	/* Generation to update, if any */
+	lldpctl_request_callback cb;
+	void *data;
+};
+
 struct lldpctl_conn_t {
 	/* the Unix-domain socket to connect to lldpd */
 	char *ctlname;
@@ -34,8 +51,12 @@ struct lldpctl_conn_t {
 	/* IO state handling. */
 	uint8_t *input_buffer;	/* Current input/output buffer */
 	uint8_t *output_buffer; /* Current input/output buffer */
-	size_t input_buffer_len;
+	size_t input_buffer_len; /* Unprocessed data in input buffer */
 	size_t output_buffer_len;
+	size_t input_buffer_start; /* Offset of unprocessed data */
+	size_t input_buffer_size;  /* Allocated size of input buffer */
+	uint8_t *message_buffer;   /* Aligned copy of the message to unserialize */
+	size_t message_buffer_size;
 
 #define CONN_STATE_IDLE 0
 #define CONN_STATE_GET_INTERFACES_SEND 1
@@ -57,12 +78,20 @@ struct lldpctl_conn_t {
 #define CONN_STATE_WATCHING 17
 #define CONN_STATE_SET_CHASSIS_SEND 18
 #define CONN_STATE_SET_CHASSIS_RECV 19
+#define CONN_STATE_GET_NEIGHBORS_SEND 20
+#define CONN_STATE_GET_NEIGHBORS_RECV 21
+#define CONN_STATE_GET_PORT_IF_MODIFIED_SEND 22
+#define CONN_STATE_GET_PORT_IF_MODIFIED_RECV 23
+#define CONN_STATE_ASYNC 24
 
 	int state; /* Current state */
 	/* Data attached to the state. It is used to check that we are using the
 	 * same data as a previous call until the state machine goes to
 	 * CONN_STATE_IDLE. */
 	char state_data[IFNAMSIZ + 64];
+	/* Answer being built when it spans several messages. It is released
+	 * when the state machine goes back to CONN_STATE_IDLE. */
+	lldpctl_atom_t *state_atom;
 	/* Error handling */
 	lldpctl_error_t error; /* Last error */
 
@@ -71,6 +100,15 @@ struct lldpctl_conn_t {
 	lldpctl_change_callback2 watch_cb2;
 	void *watch_data;
 	int watch_triggered;
+	int watch_window; /* Coalescing window requested to lldpd (ms) */
+	int watch_queue;  /* Maximum number of coalesced changes */
+	int watch_delta;  /* Omit unchanged sections of updated neighbors */
+
+	/* Snapshot of neighbors, opened on first use */
+	struct snapshot snapshot;
+
+	/* Asynchronous requests, in the order they were sent */
+	TAILQ_HEAD(, lldpctl_request) requests;
 };
 
 /* User data for synchronous callbacks. */
@@ -79,6 +117,11 @@ struct lldpctl_conn_sync_t {
 };
 
 ssize_t _lldpctl_needs(lldpctl_conn_t *lldpctl, size_t length);
+size_t _lldpctl_recv_message(lldpctl_conn_t *conn, enum hmsg_type type, void **t,
+    struct marshal_info *mi);
+int _lldpctl_snapshot_open(lldpctl_conn_t *conn);
+int _lldpctl_request(lldpctl_conn_t *conn, enum hmsg_type type, void *to_send,
+    struct marshal_info *mi_send, struct lldpctl_request *request);
 int _lldpctl_do_something(lldpctl_conn_t *conn, int state_send, int state_recv,
     const char *state_data, enum hmsg_type type, void *to_send,
     struct marshal_info *mi_send, void **to_recv, struct marshal_info *mi_recv);
@@ -92,6 +135,7 @@ typedef enum {
 	atom_config,
 	atom_interfaces_list,
 	atom_interface,
+	atom_local_ports_list,
 	atom_ports_list,
 	atom_port,
 	atom_mgmts_list,
@@ -176,6 +220,13 @@ struct _lldpctl_atom_interface_t {
 	char *name;
 };
 
+struct _lldpctl_atom_local_ports_list_t {
+	lldpctl_atom_t base;
+	size_t count;		/* Number of local ports */
+	size_t size;		/* Allocated size */
+	lldpctl_atom_t **ports; /* Local ports, with their neighbors */
+};
+
 struct _lldpctl_atom_chassis_t {
 	lldpctl_atom_t base;
 	struct lldpd_chassis *chassis;
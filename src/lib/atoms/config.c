@@ -224,6 +224,12 @@ _lldpctl_atom_get_int_config(lldpctl_atom_t *atom, lldpctl_key_t key)
 		return c->config->c_set_ifdescr;
 	case lldpctl_k_config_iface_promisc:
 		return c->config->c_promisc;
+	case lldpctl_k_config_iface_rx_ring:
+		return c->config->c_rx_ring;
+	case lldpctl_k_config_iface_shared_socket:
+		return c->config->c_shared_socket;
+	case lldpctl_k_config_snapshot:
+		return c->config->c_snapshot;
 	case lldpctl_k_config_chassis_cap_advertise:
 		return c->config->c_cap_advertise;
 	case lldpctl_k_config_chassis_cap_override:
@@ -274,6 +280,15 @@ _lldpctl_atom_set_int_config(lldpctl_atom_t *atom, lldpctl_key_t key, long int v
 	case lldpctl_k_config_iface_promisc:
 		config.c_promisc = c->config->c_promisc = value;
 		break;
+	case lldpctl_k_config_iface_rx_ring:
+		config.c_rx_ring = c->config->c_rx_ring = value;
+		break;
+	case lldpctl_k_config_iface_shared_socket:
+		config.c_shared_socket = c->config->c_shared_socket = value;
+		break;
+	case lldpctl_k_config_snapshot:
+		config.c_snapshot = c->config->c_snapshot = value;
+		break;
 	case lldpctl_k_config_chassis_cap_advertise:
 		config.c_cap_advertise = c->config->c_cap_advertise = value;
 		break;
@@ -101,6 +101,44 @@ _lldpctl_atom_get_str_interface(lldpctl_atom_t *atom, lldpctl_key_t key)
 	}
 }
 
+static void
+_lldpctl_atom_free_local_ports_list(lldpctl_atom_t *atom)
+{
+	struct _lldpctl_atom_local_ports_list_t *plist =
+	    (struct _lldpctl_atom_local_ports_list_t *)atom;
+	size_t i;
+	for (i = 0; i < plist->count; i++)
+		lldpctl_atom_dec_ref(plist->ports[i]);
+	free(plist->ports);
+}
+
+static lldpctl_atom_iter_t *
+_lldpctl_atom_iter_local_ports_list(lldpctl_atom_t *atom)
+{
+	struct _lldpctl_atom_local_ports_list_t *plist =
+	    (struct _lldpctl_atom_local_ports_list_t *)atom;
+	if (plist->count == 0) return NULL;
+	return (lldpctl_atom_iter_t *)&plist->ports[0];
+}
+
+static lldpctl_atom_iter_t *
+_lldpctl_atom_next_local_ports_list(lldpctl_atom_t *atom, lldpctl_atom_iter_t *iter)
+{
+	struct _lldpctl_atom_local_ports_list_t *plist =
+	    (struct _lldpctl_atom_local_ports_list_t *)atom;
+	lldpctl_atom_t **port = (lldpctl_atom_t **)iter;
+	if (++port == plist->ports + plist->count) return NULL;
+	return (lldpctl_atom_iter_t *)port;
+}
+
+static lldpctl_atom_t *
+_lldpctl_atom_value_local_ports_list(lldpctl_atom_t *atom, lldpctl_atom_iter_t *iter)
+{
+	lldpctl_atom_t *port = *(lldpctl_atom_t **)iter;
+	lldpctl_atom_inc_ref(port);
+	return port;
+}
+
 static struct atom_builder interfaces_list = { atom_interfaces_list,
 	sizeof(struct _lldpctl_atom_interfaces_list_t),
 	.init = _lldpctl_atom_new_interfaces_list,
@@ -114,5 +152,13 @@ static struct atom_builder interface = { atom_interface,
 	.free = _lldpctl_atom_free_interface,
 	.get_str = _lldpctl_atom_get_str_interface };
 
+static struct atom_builder local_ports_list = { atom_local_ports_list,
+	sizeof(struct _lldpctl_atom_local_ports_list_t),
+	.free = _lldpctl_atom_free_local_ports_list,
+	.iter = _lldpctl_atom_iter_local_ports_list,
+	.next = _lldpctl_atom_next_local_ports_list,
+	.value = _lldpctl_atom_value_local_ports_list };
+
 ATOM_BUILDER_REGISTER(interfaces_list, 2);
+ATOM_BUILDER_REGISTER(local_ports_list, 2);
 ATOM_BUILDER_REGISTER(interface, 3);
@@ -795,6 +795,10 @@ _lldpctl_atom_get_int_port(lldpctl_atom_t *atom, lldpctl_key_t key)
 		return port->p_lastchange;
 	case lldpctl_k_port_ttl:
 		return port->p_ttl;
+	case lldpctl_k_port_generation:
+		return port->p_generation;
+	case lldpctl_k_port_unchanged:
+		return port->p_unchanged;
 	case lldpctl_k_port_id_subtype:
 		return port->p_id_subtype;
 	case lldpctl_k_port_hidden:
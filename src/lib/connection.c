@@ -17,6 +17,7 @@
 
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -27,6 +28,8 @@
 #include "../ctl.h"
 #include "../log.h"
 
+#define INPUT_BUFFER_SIZE 4096 /* Initial size of the input buffer */
+
 const char *
 lldpctl_get_default_transport(void)
 {
@@ -52,36 +55,41 @@ sync_send(lldpctl_conn_t *lldpctl, const uint8_t *data, size_t length, void *use
 	}
 
 	while ((nb = write(conn->fd, data, length)) == -1) {
-		if (errno == EAGAIN || errno == EINTR) continue;
+		if (errno == EINTR) continue;
+		if (errno == EAGAIN) {
+			/* The socket is non-blocking in asynchronous mode */
+			if (lldpctl->state == CONN_STATE_ASYNC)
+				return LLDPCTL_ERR_WOULDBLOCK;
+			continue;
+		}
 		return LLDPCTL_ERR_CALLBACK_FAILURE;
 	}
 	return nb;
 }
 
-/* Statically receive data from remote end. */
+/* Statically receive data from remote end. Return as soon as some data is
+ * available: the caller asks again if this is not enough. */
 static ssize_t
 sync_recv(lldpctl_conn_t *lldpctl, const uint8_t *data, size_t length, void *user_data)
 {
 	struct lldpctl_conn_sync_t *conn = user_data;
 	ssize_t nb;
-	size_t remain, offset = 0;
 
 	if (conn->fd == -1 && ((conn->fd = sync_connect(lldpctl)) == -1)) {
 		lldpctl->error = LLDPCTL_ERR_CANNOT_CONNECT;
 		return LLDPCTL_ERR_CANNOT_CONNECT;
 	}
 
-	remain = length;
-	do {
-		if ((nb = read(conn->fd, (unsigned char *)data + offset, remain)) ==
-		    -1) {
-			if (errno == EAGAIN || errno == EINTR) continue;
-			return LLDPCTL_ERR_CALLBACK_FAILURE;
+	while ((nb = read(conn->fd, (unsigned char *)data, length)) == -1) {
+		if (errno == EINTR) continue;
+		if (errno == EAGAIN) {
+			if (lldpctl->state == CONN_STATE_ASYNC)
+				return LLDPCTL_ERR_WOULDBLOCK;
+			continue;
 		}
-		remain -= nb;
-		offset += nb;
-	} while (remain > 0 && nb != 0);
-	return offset;
+		return LLDPCTL_ERR_CALLBACK_FAILURE;
+	}
+	return nb;
 }
 
 lldpctl_conn_t *
@@ -123,6 +131,8 @@ lldpctl_new_name(const char *ctlname, lldpctl_send_callback send,
 		conn->recv = recv;
 		conn->user_data = user_data;
 	}
+	conn->snapshot.s_fd = -1;
+	TAILQ_INIT(&conn->requests);
 
 	return conn;
 }
@@ -130,62 +140,53 @@ lldpctl_new_name(const char *ctlname, lldpctl_send_callback send,
 int
 lldpctl_release(lldpctl_conn_t *conn)
 {
+	struct lldpctl_request *request;
+
 	if (conn == NULL) return 0;
+	/* Pending requests are dropped without invoking their callbacks */
+	while ((request = TAILQ_FIRST(&conn->requests)) != NULL) {
+		TAILQ_REMOVE(&conn->requests, request, next);
+		lldpctl_atom_dec_ref(request->result);
+		free(request);
+	}
 	free(conn->ctlname);
 	if (conn->send == sync_send) {
 		struct lldpctl_conn_sync_t *data = conn->user_data;
 		if (data->fd != -1) close(data->fd);
 		free(conn->user_data);
 	}
+	lldpctl_atom_dec_ref(conn->state_atom);
+	snapshot_close(&conn->snapshot);
 	free(conn->input_buffer);
 	free(conn->output_buffer);
+	free(conn->message_buffer);
 	free(conn);
 	return 0;
 }
 
-/**
- * Request some bytes if they are not already here.
- *
- * @param conn   The connection to lldpd.
- * @param length The number of requested bytes.
- * @return A negative integer if we can't have the bytes or the number of bytes we got.
- */
-ssize_t
-_lldpctl_needs(lldpctl_conn_t *conn, size_t length)
+/* Open the snapshot published by lldpd next to the Unix socket, if not already
+ * done. */
+int
+_lldpctl_snapshot_open(lldpctl_conn_t *conn)
 {
-	uint8_t *buffer;
-	ssize_t rc;
+	char *name;
+	int rc;
 
-	if ((buffer = calloc(1, length)) == NULL)
+	if (conn->snapshot.s_fd != -1) return 0;
+	if (asprintf(&name, "%s.snapshot", conn->ctlname) == -1)
 		return SET_ERROR(conn, LLDPCTL_ERR_NOMEM);
-	rc = conn->recv(conn, buffer, length, conn->user_data);
-	if (rc < 0) {
-		free(buffer);
-		return SET_ERROR(conn, rc);
-	}
-	if (rc == 0) {
-		free(buffer);
-		return SET_ERROR(conn, LLDPCTL_ERR_EOF);
-	}
-	rc = lldpctl_recv(conn, buffer, rc);
-	free(buffer);
-	if (rc < 0) return SET_ERROR(conn, rc);
-	RESET_ERROR(conn);
-	return rc;
+	rc = snapshot_open(&conn->snapshot, name);
+	free(name);
+	if (rc == -1) return SET_ERROR(conn, LLDPCTL_ERR_NOT_EXIST);
+	return 0;
 }
 
-static int
-check_for_notification(lldpctl_conn_t *conn)
+/* Call the callback for a change. The change is freed. */
+static void
+notify_change(lldpctl_conn_t *conn, struct lldpd_neighbor_change *change)
 {
-	struct lldpd_neighbor_change *change;
-	void *p;
-	int rc;
 	lldpctl_change_t type;
 	lldpctl_atom_t *interface = NULL, *neighbor = NULL;
-	rc = ctl_msg_recv_unserialized(&conn->input_buffer, &conn->input_buffer_len,
-	    NOTIFICATION, &p, &MARSHAL_INFO(lldpd_neighbor_change));
-	if (rc != 0) return rc;
-	change = p;
 
 	/* We have a notification, call the callback */
 	if (conn->watch_cb || conn->watch_cb2) {
@@ -229,11 +230,184 @@ end:
 	}
 	free(change->ifname);
 	free(change);
+}
+
+static int
+check_for_notification(lldpctl_conn_t *conn)
+{
+	struct lldpd_neighbor_changes *changes;
+	struct lldpd_neighbor_change *change, *change_next;
+	void *p;
+	int rc;
 
-	/* Indicate if more data remains in the buffer for processing */
+	if (conn->watch_window == 0) {
+		rc = _lldpctl_recv_message(conn, NOTIFICATION, &p,
+		    &MARSHAL_INFO(lldpd_neighbor_change));
+		if (rc != 0) return rc;
+		notify_change(conn, p);
+		/* Indicate if more data remains in the buffer for processing */
+		return (rc);
+	}
+
+	/* Coalesced changes */
+	rc = _lldpctl_recv_message(conn, NOTIFICATIONS, &p,
+	    &MARSHAL_INFO(lldpd_neighbor_changes));
+	if (rc != 0) return rc;
+	changes = p;
+	if (changes->overflow && (conn->watch_cb || conn->watch_cb2)) {
+		if (conn->watch_cb)
+			conn->watch_cb(conn, lldpctl_c_overflow, NULL, NULL,
+			    conn->watch_data);
+		else
+			conn->watch_cb2(lldpctl_c_overflow, NULL, NULL,
+			    conn->watch_data);
+		conn->watch_triggered = 1;
+	}
+	for (change = TAILQ_FIRST(&changes->changes); change; change = change_next) {
+		change_next = TAILQ_NEXT(change, c_entries);
+		notify_change(conn, change);
+	}
+	free(changes);
 	return (rc);
 }
 
+/**
+ * Make room for at least the given number of bytes at the end of the input
+ * buffer.
+ *
+ * Unprocessed data is moved at the beginning of the buffer only when there is
+ * not enough room after it. The buffer is grown when this is still not enough.
+ *
+ * @param conn   The connection to lldpd.
+ * @param length The number of bytes needed.
+ * @return 0 on success or a negative integer on error.
+ */
+static int
+input_reserve(lldpctl_conn_t *conn, size_t length)
+{
+	size_t size;
+	uint8_t *new;
+
+	if (conn->input_buffer_size - conn->input_buffer_start -
+		conn->input_buffer_len >=
+	    length)
+		return 0;
+	if (conn->input_buffer_start > 0) {
+		memmove(conn->input_buffer,
+		    conn->input_buffer + conn->input_buffer_start,
+		    conn->input_buffer_len);
+		conn->input_buffer_start = 0;
+		if (conn->input_buffer_size - conn->input_buffer_len >= length)
+			return 0;
+	}
+	size = conn->input_buffer_size ? conn->input_buffer_size : INPUT_BUFFER_SIZE;
+	while (size - conn->input_buffer_len < length) {
+		if (size * 2 < size) return LLDPCTL_ERR_NOMEM;
+		size *= 2;
+	}
+	if ((new = realloc(conn->input_buffer, size)) == NULL)
+		return LLDPCTL_ERR_NOMEM;
+	conn->input_buffer = new;
+	conn->input_buffer_size = size;
+	return 0;
+}
+
+/* Account for new data in the input buffer and process notifications. */
+static void
+input_received(lldpctl_conn_t *conn, size_t length)
+{
+	conn->input_buffer_len += length;
+
+	/* Read all notifications */
+	while (!check_for_notification(conn))
+		;
+}
+
+/**
+ * Get a message from the input buffer.
+ *
+ * @return Same as @c ctl_msg_recv_unserialized().
+ */
+size_t
+_lldpctl_recv_message(lldpctl_conn_t *conn, enum hmsg_type type, void **t,
+    struct marshal_info *mi)
+{
+	uint8_t *input = NULL, *new;
+	size_t len = conn->input_buffer_len, consumed, rc;
+
+	if (conn->input_buffer) input = conn->input_buffer + conn->input_buffer_start;
+	/* A message may be unserialized in place and needs the alignment of the
+	 * allocation. When it does not start the buffer, only this message is
+	 * copied into an aligned buffer. */
+	if (conn->input_buffer_start > 0) {
+		rc = ctl_msg_parse_unserialized(input, len, type, NULL, NULL,
+		    &consumed);
+		if (rc != 0) goto end;
+		if (consumed > conn->message_buffer_size) {
+			if ((new = realloc(conn->message_buffer, consumed)) == NULL) {
+				rc = -1;
+				goto end;
+			}
+			conn->message_buffer = new;
+			conn->message_buffer_size = consumed;
+		}
+		memcpy(conn->message_buffer, input, consumed);
+		input = conn->message_buffer;
+		len = consumed;
+	}
+	rc = ctl_msg_parse_unserialized(input, len, type, t, mi, &consumed);
+end:
+	conn->input_buffer_start += consumed;
+	conn->input_buffer_len -= consumed;
+	if (conn->input_buffer_len == 0) conn->input_buffer_start = 0;
+	return rc;
+}
+
+/* Drop the message at the beginning of the input buffer, whatever its type.
+ * Everything is dropped if we cannot find where it ends. */
+static void
+input_drop_message(lldpctl_conn_t *conn)
+{
+	struct hmsg_header hdr;
+
+	if (conn->input_buffer_len >= sizeof(struct hmsg_header)) {
+		memcpy(&hdr, conn->input_buffer + conn->input_buffer_start,
+		    sizeof(struct hmsg_header));
+		if (_lldpctl_recv_message(conn, hdr.type, NULL, NULL) == 0) return;
+	}
+	log_warnx("control", "drop %zu bytes of unexpected data",
+	    conn->input_buffer_len);
+	conn->input_buffer_start = conn->input_buffer_len = 0;
+}
+
+/**
+ * Request some bytes if they are not already here.
+ *
+ * Data is directly received in the input buffer. More bytes than requested
+ * may be received if they are available.
+ *
+ * @param conn   The connection to lldpd.
+ * @param length The number of requested bytes.
+ * @return A negative integer if we can't have the bytes or the number of bytes we got.
+ */
+ssize_t
+_lldpctl_needs(lldpctl_conn_t *conn, size_t length)
+{
+	ssize_t rc;
+
+	if ((rc = input_reserve(conn, length)) < 0) return SET_ERROR(conn, rc);
+	rc = conn->recv(conn,
+	    conn->input_buffer + conn->input_buffer_start + conn->input_buffer_len,
+	    conn->input_buffer_size - conn->input_buffer_start -
+		conn->input_buffer_len,
+	    conn->user_data);
+	if (rc < 0) return SET_ERROR(conn, rc);
+	if (rc == 0) return SET_ERROR(conn, LLDPCTL_ERR_EOF);
+	input_received(conn, rc);
+	RESET_ERROR(conn);
+	return rc;
+}
+
 ssize_t
 lldpctl_recv(lldpctl_conn_t *conn, const uint8_t *data, size_t length)
 {
@@ -243,22 +417,10 @@ lldpctl_recv(lldpctl_conn_t *conn, const uint8_t *data, size_t length)
 	if (length == 0) return 0;
 
 	/* Received data should be appended to the input buffer. */
-	if (conn->input_buffer == NULL) {
-		conn->input_buffer_len = 0;
-		if ((conn->input_buffer = malloc(length)) == NULL)
-			return SET_ERROR(conn, LLDPCTL_ERR_NOMEM);
-	} else {
-		uint8_t *new =
-		    realloc(conn->input_buffer, conn->input_buffer_len + length);
-		if (new == NULL) return SET_ERROR(conn, LLDPCTL_ERR_NOMEM);
-		conn->input_buffer = new;
-	}
-	memcpy(conn->input_buffer + conn->input_buffer_len, data, length);
-	conn->input_buffer_len += length;
-
-	/* Read all notifications */
-	while (!check_for_notification(conn))
-		;
+	if (input_reserve(conn, length) < 0) return SET_ERROR(conn, LLDPCTL_ERR_NOMEM);
+	memcpy(conn->input_buffer + conn->input_buffer_start + conn->input_buffer_len,
+	    data, length);
+	input_received(conn, length);
 
 	RESET_ERROR(conn);
 
@@ -304,3 +466,127 @@ lldpctl_send(lldpctl_conn_t *conn)
 	RESET_ERROR(conn);
 	return rc;
 }
+
+int
+lldpctl_get_fd(lldpctl_conn_t *conn)
+{
+	struct lldpctl_conn_sync_t *data = conn->user_data;
+	int flags;
+
+	RESET_ERROR(conn);
+
+	if (conn->send != sync_send ||
+	    (conn->state != CONN_STATE_IDLE && conn->state != CONN_STATE_ASYNC))
+		return SET_ERROR(conn, LLDPCTL_ERR_INVALID_STATE);
+	if (data->fd == -1 && (data->fd = sync_connect(conn)) == -1)
+		return SET_ERROR(conn, LLDPCTL_ERR_CANNOT_CONNECT);
+	if (conn->state == CONN_STATE_IDLE) {
+		if ((flags = fcntl(data->fd, F_GETFL)) == -1 ||
+		    fcntl(data->fd, F_SETFL, flags | O_NONBLOCK) == -1)
+			return SET_ERROR(conn, LLDPCTL_ERR_CALLBACK_FAILURE);
+		conn->state = CONN_STATE_ASYNC;
+	}
+	return data->fd;
+}
+
+/**
+ * Send an asynchronous request.
+ *
+ * @param conn     The connection to lldpd, in asynchronous mode.
+ * @param type     The type of the request.
+ * @param to_send  The content of the request or @c NULL.
+ * @param mi_send  The marshal structure for the content.
+ * @param request  The request waiting for an answer. It is released once its
+ *                 callback has been invoked, or now in case of error.
+ * @return 0 on success or a negative integer on error.
+ *
+ * The request is sent right away if possible. Otherwise, it is sent later by
+ * @c lldpctl_process().
+ */
+int
+_lldpctl_request(lldpctl_conn_t *conn, enum hmsg_type type, void *to_send,
+    struct marshal_info *mi_send, struct lldpctl_request *request)
+{
+	int rc = 0;
+
+	if (conn->state != CONN_STATE_ASYNC)
+		rc = LLDPCTL_ERR_INVALID_STATE;
+	else if (ctl_msg_send_unserialized(&conn->output_buffer,
+		     &conn->output_buffer_len, type, to_send, mi_send) != 0)
+		rc = LLDPCTL_ERR_SERIALIZATION;
+	if (rc != 0) {
+		lldpctl_atom_dec_ref(request->result);
+		free(request);
+		return SET_ERROR(conn, rc);
+	}
+	TAILQ_INSERT_TAIL(&conn->requests, request, next);
+
+	/* Errors are reported by lldpctl_process() */
+	lldpctl_send(conn);
+	RESET_ERROR(conn);
+	return 0;
+}
+
+/* Invoke the callback of the first pending request and release it. */
+static void
+request_complete(lldpctl_conn_t *conn, lldpctl_error_t error)
+{
+	struct lldpctl_request *request = TAILQ_FIRST(&conn->requests);
+
+	TAILQ_REMOVE(&conn->requests, request, next);
+	if (error != LLDPCTL_NO_ERROR) {
+		lldpctl_atom_dec_ref(request->result);
+		request->result = NULL;
+	}
+	request->cb(conn, request->result, error, request->data);
+	lldpctl_atom_dec_ref(request->result);
+	free(request);
+}
+
+int
+lldpctl_process(lldpctl_conn_t *conn)
+{
+	struct lldpctl_request *request;
+	size_t len;
+	ssize_t rc;
+	void *p;
+
+	RESET_ERROR(conn);
+
+	if (conn->state != CONN_STATE_ASYNC)
+		return SET_ERROR(conn, LLDPCTL_ERR_INVALID_STATE);
+
+	if (conn->output_buffer != NULL) {
+		rc = lldpctl_send(conn);
+		if (rc < 0 && rc != LLDPCTL_ERR_WOULDBLOCK) goto error;
+	}
+
+	/* Answers come in the same order as requests */
+	while ((request = TAILQ_FIRST(&conn->requests)) != NULL) {
+		len = conn->input_buffer_len;
+		rc = _lldpctl_recv_message(conn, request->type, &p, request->mi);
+		if (rc > 0) {
+			/* We need more bytes */
+			rc = _lldpctl_needs(conn, rc);
+			if (rc == LLDPCTL_ERR_WOULDBLOCK) break;
+			if (rc < 0) goto error;
+			continue;
+		}
+		if (rc < 0) {
+			/* The answers to the next requests come after this
+			 * message: do not let them stumble upon it. */
+			if (conn->input_buffer_len == len) input_drop_message(conn);
+			request_complete(conn, LLDPCTL_ERR_SERIALIZATION);
+		} else if ((rc = request->answer(conn, request, p)) != 1)
+			request_complete(conn, rc);
+	}
+
+	RESET_ERROR(conn);
+	return (conn->output_buffer != NULL ? LLDPCTL_WANT_WRITE : 0) |
+	    (TAILQ_EMPTY(&conn->requests) ? 0 : LLDPCTL_WANT_READ);
+
+error:
+	while (!TAILQ_EMPTY(&conn->requests))
+		request_complete(conn, rc);
+	return SET_ERROR(conn, rc);
+}
@@ -44,6 +44,8 @@ lldpctl_strerror(lldpctl_error_t error)
 		return "Cannot iterate on this atom";
 	case LLDPCTL_ERR_CANNOT_CREATE:
 		return "Cannot create a new element for this atom";
+	case LLDPCTL_ERR_NOT_MODIFIED:
+		return "Information did not change";
 	case LLDPCTL_ERR_BAD_VALUE:
 		return "Provided value is invalid";
 	case LLDPCTL_ERR_FATAL:
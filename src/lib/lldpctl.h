@@ -317,6 +317,11 @@ typedef enum {
 	 * No new element can be created for this element.
 	 */
 	LLDPCTL_ERR_CANNOT_CREATE = -510,
+	/**
+	 * The requested information did not change since the last time it
+	 * was retrieved.
+	 */
+	LLDPCTL_ERR_NOT_MODIFIED = -511,
 	/**
 	 * The library is under unexpected conditions and cannot process
 	 * any further data reliably.
@@ -450,9 +455,10 @@ void lldpctl_atom_dec_ref(lldpctl_atom_t *atom);
  * @see lldpctl_watch_callback2
  */
 typedef enum {
-	lldpctl_c_deleted, /**< The neighbor has been deleted */
-	lldpctl_c_updated, /**< The neighbor has been updated */
-	lldpctl_c_added,   /**< This is a new neighbor */
+	lldpctl_c_deleted,  /**< The neighbor has been deleted */
+	lldpctl_c_updated,  /**< The neighbor has been updated */
+	lldpctl_c_added,    /**< This is a new neighbor */
+	lldpctl_c_overflow, /**< Some changes were lost (only when coalescing) */
 } lldpctl_change_t;
 
 /**
@@ -535,6 +541,55 @@ int lldpctl_watch_callback(lldpctl_conn_t *conn, lldpctl_change_callback cb, voi
 int lldpctl_watch_callback2(lldpctl_conn_t *conn, lldpctl_change_callback2 cb,
     void *data);
 
+/**
+ * Ask lldpd to coalesce changes before sending them.
+ *
+ * @param conn   Connection with lldpd.
+ * @param window Coalescing window in milliseconds. 0 disables coalescing.
+ * @param queue  Maximum number of changes lldpd keeps for us during the
+ *               window. 0 means the maximum allowed by lldpd.
+ * @return 0 in case of success or a negative integer in case of errors.
+ *
+ * This function should be called before registering a callback with @c
+ * lldpctl_watch_callback2(). Successive changes of the same neighbor on the
+ * same interface during the window are merged and only the last state is
+ * reported. All changes are then received at once. When lldpd has to drop
+ * some changes, because the queue is full or because we are too slow to read
+ * them, the callback is invoked with @c lldpctl_c_overflow and @c NULL as
+ * interface and neighbor. Current neighbors should then be retrieved again.
+ */
+int lldpctl_watch_coalesce(lldpctl_conn_t *conn, int window, int queue);
+
+/**
+ * Sections of a neighbor omitted from a delta notification.
+ *
+ * @see lldpctl_watch_delta(), lldpctl_k_port_unchanged
+ */
+#define LLDPCTL_UNCHANGED_CHASSIS 0x1 /**< Only the chassis identity is present */
+#define LLDPCTL_UNCHANGED_VLANS 0x2   /**< VLAN, PPVID and PI lists are empty */
+#define LLDPCTL_UNCHANGED_CUSTOM 0x4  /**< Custom TLVs are absent */
+
+/**
+ * Ask lldpd to only send the sections of updated neighbors that changed.
+ *
+ * @param conn   Connection with lldpd.
+ * @param enable 1 to enable delta notifications, 0 to disable them.
+ * @return 0 in case of success or a negative integer in case of errors.
+ *
+ * This function should be called before registering a callback with @c
+ * lldpctl_watch_callback2(). It is intended for clients keeping their own copy
+ * of the neighbors. For @c lldpctl_c_updated and @c lldpctl_c_deleted, the
+ * neighbor atom may then lack some sections, as told by @c
+ * lldpctl_k_port_unchanged. Those sections are the same as in the previous
+ * version of the neighbor. Versions are given by @c lldpctl_k_port_generation:
+ * a delta applies to the copy whose generation is one less. Otherwise, or when
+ * no copy exists, the complete neighbor should be retrieved again with @c
+ * lldpctl_get_neighbors() on another connection. Port fields and strings are
+ * always present. Changes coalesced with @c lldpctl_watch_coalesce() are always
+ * complete.
+ */
+int lldpctl_watch_delta(lldpctl_conn_t *conn, int enable);
+
 /**
  * Wait for the next change.
  *
@@ -619,6 +674,26 @@ lldpctl_atom_t *lldpctl_get_local_chassis(lldpctl_conn_t *conn);
  */
 lldpctl_atom_t *lldpctl_get_port(lldpctl_atom_t *port);
 
+/**
+ * Retrieve the information related to a given interface if it changed.
+ *
+ * @param port       The port we want to retrieve information from. This port is
+ *                   an atom retrieved from an iteration on @c
+ *                   lldpctl_get_interfaces().
+ * @param generation Generation of the information retrieved the last time, 0
+ *                   if none. It is updated with the current generation.
+ * @return Atom related to this port or @c NULL if an error happened.
+ *
+ * This function works like @c lldpctl_get_port() but lldpd only sends the
+ * information when its generation is not the provided one. The generation
+ * changes with the local port, the neighbors and the counters of the
+ * interface. Otherwise, @c NULL is returned and the last error is @c
+ * LLDPCTL_ERR_NOT_MODIFIED: the information retrieved the last time is still
+ * current.
+ */
+lldpctl_atom_t *lldpctl_get_port_if_modified(lldpctl_atom_t *port,
+    uint32_t *generation);
+
 /**
  * Retrieve the default port information.
  *
@@ -635,6 +710,198 @@ lldpctl_atom_t *lldpctl_get_port(lldpctl_atom_t *port);
  */
 lldpctl_atom_t *lldpctl_get_default_port(lldpctl_conn_t *conn);
 
+/**
+ * Retrieve all local ports with their neighbors in a single request.
+ *
+ * @param conn     Previously allocated handler to a connection to lldpd.
+ * @param ifnames  Comma-separated list of patterns matching the interfaces to
+ *                 retrieve or @c NULL for all interfaces. Patterns are the
+ *                 same as the ones accepted by `lldpd -I`.
+ * @param protocol Only keep neighbors using this protocol (a value from the
+ *                 map of @c lldpctl_k_port_protocol) or 0 to keep all of them.
+ *                 Any other value (like -1) keeps no neighbor.
+ * @return The list of local ports or @c NULL if an error happened.
+ *
+ * The list can be iterated with @ref lldpctl_atom_foreach(). Each item is a
+ * local port, as returned by @c lldpctl_get_port(), and its neighbors are
+ * available with @c lldpctl_k_port_neighbors. Filtering is done by lldpd.
+ *
+ * This function may have to do IO to get the requested information. Depending
+ * on the IO mode, information may not be available right now and the function
+ * should be called again later with the same arguments. If @c NULL is
+ * returned, check what the last error is. If it is @c LLDPCTL_ERR_WOULDBLOCK,
+ * try again later (when more data is available).
+ */
+lldpctl_atom_t *lldpctl_get_neighbors(lldpctl_conn_t *conn, const char *ifnames,
+    int protocol);
+
+/**
+ * Get the generation of the snapshot of neighbors published by lldpd.
+ *
+ * @param conn            Previously allocated handler to a connection to lldpd.
+ * @param[out] generation Generation of the snapshot, bumped each time lldpd
+ *                        publishes it again.
+ * @return 0 in case of success or a negative integer in case of errors.
+ *
+ * lldpd publishes a snapshot of all local ports with their neighbors in a
+ * memory-mapped file when configured to (with @c lldpctl_k_config_snapshot).
+ * The file is next to the Unix socket used by the connection, with a @c
+ * .snapshot suffix. This function only reads the header of this file and never
+ * does IO with lldpd: it is cheap enough to be called very often to know
+ * when the snapshot should be read again with @c lldpctl_snapshot_neighbors().
+ *
+ * When there is no snapshot, @c LLDPCTL_ERR_NOT_EXIST is returned. When lldpd
+ * is updating the snapshot for too long, @c LLDPCTL_ERR_WOULDBLOCK is
+ * returned.
+ */
+int lldpctl_snapshot_generation(lldpctl_conn_t *conn, uint64_t *generation);
+
+/**
+ * Retrieve all local ports with their neighbors from the snapshot published by
+ * lldpd.
+ *
+ * @param conn            Previously allocated handler to a connection to lldpd.
+ * @param[out] generation Generation of the returned snapshot. Can be @c NULL.
+ * @return The list of local ports or @c NULL if an error happened.
+ *
+ * The list is the same as the one returned by @c lldpctl_get_neighbors() without
+ * filter, as it was when lldpd last published the snapshot. lldpd publishes it
+ * again shortly after neighbors or local ports change. Reading the snapshot
+ * does not involve lldpd. Errors are the same as for @c
+ * lldpctl_snapshot_generation().
+ */
+lldpctl_atom_t *lldpctl_snapshot_neighbors(lldpctl_conn_t *conn,
+    uint64_t *generation);
+
+/**@}*/
+
+/**
+ * @defgroup liblldpctl_async Asynchronous requests
+ *
+ * Requests integrated in an event loop.
+ *
+ * A connection allocated with the default callbacks can be switched to
+ * asynchronous mode with @ref lldpctl_get_fd(). The returned file descriptor
+ * is non-blocking and should be watched by the event loop. Requests are then
+ * sent with the @c _async variants of the functions retrieving atoms from
+ * lldpd. Each of them registers a callback invoked once the answer is
+ * complete. Several requests can be pending at the same time: they are
+ * answered in order by lldpd. When the file descriptor is ready, @ref
+ * lldpctl_process() should be called to do the IO and invoke the callbacks.
+ * Its return value tells for which events the file descriptor should be
+ * watched.
+ *
+ * Other functions doing IO cannot be used on such a connection. They would
+ * return @c LLDPCTL_ERR_INVALID_STATE. Use another connection for them.
+ *
+ * @{
+ */
+
+/**
+ * Callback function invoked when the answer to a request is complete.
+ *
+ * @param conn   Connection with lldpd.
+ * @param result Atom retrieved from lldpd or @c NULL in case of error.
+ * @param error  @c LLDPCTL_NO_ERROR or the error for this request.
+ * @param data   Data provided with the request.
+ *
+ * The result is released when the callback ends. If you want to keep a
+ * reference to it, increment its reference count in the callback. New
+ * requests can be sent from the callback but the connection should not be
+ * released.
+ */
+typedef void (*lldpctl_request_callback)(lldpctl_conn_t *conn,
+    lldpctl_atom_t *result, lldpctl_error_t error, void *data);
+
+/**
+ * Switch a connection to asynchronous mode and get its file descriptor.
+ *
+ * @param conn Connection with lldpd, allocated with the default callbacks.
+ * @return The non-blocking file descriptor of the connection to lldpd or a
+ *         negative integer in case of errors.
+ *
+ * The connection to lldpd is established if needed. It cannot be used
+ * anymore for synchronous requests or to watch for changes.
+ */
+int lldpctl_get_fd(lldpctl_conn_t *conn);
+
+#define LLDPCTL_WANT_READ 0x1  /**< Some requests are waiting for an answer */
+#define LLDPCTL_WANT_WRITE 0x2 /**< Some requests are waiting to be sent */
+
+/**
+ * Do the pending IO of an asynchronous connection.
+ *
+ * @param conn Connection switched to asynchronous mode with @c
+ *             lldpctl_get_fd().
+ * @return A combination of @c LLDPCTL_WANT_READ and @c LLDPCTL_WANT_WRITE or a
+ *         negative integer in case of errors.
+ *
+ * Pending requests are sent and available answers are read, without
+ * blocking. Callbacks of complete requests are invoked. The file descriptor
+ * should then be watched for the returned events. When nothing is returned,
+ * there is no pending request. When the connection fails, the callbacks of
+ * all pending requests are invoked with the error and the connection should
+ * be released.
+ */
+int lldpctl_process(lldpctl_conn_t *conn);
+
+/**
+ * Retrieve the list of available interfaces asynchronously.
+ *
+ * @param conn Connection switched to asynchronous mode.
+ * @param cb   Callback invoked with the result of @c lldpctl_get_interfaces().
+ * @param data Data that will be passed to the callback.
+ * @return 0 in case of success or a negative integer in case of errors.
+ */
+int lldpctl_get_interfaces_async(lldpctl_conn_t *conn, lldpctl_request_callback cb,
+    void *data);
+
+/**
+ * Retrieve the information related to a given interface asynchronously.
+ *
+ * @param port The port we want to retrieve information from, as for @c
+ *             lldpctl_get_port().
+ * @param cb   Callback invoked with the result of @c lldpctl_get_port().
+ * @param data Data that will be passed to the callback.
+ * @return 0 in case of success or a negative integer in case of errors.
+ */
+int lldpctl_get_port_async(lldpctl_atom_t *port, lldpctl_request_callback cb,
+    void *data);
+
+/**
+ * Retrieve the information related to a given interface asynchronously, if it
+ * changed.
+ *
+ * @param port       The port we want to retrieve information from, as for @c
+ *                   lldpctl_get_port_if_modified().
+ * @param generation Generation of the information retrieved the last time, 0
+ *                   if none. It is updated with the current generation before
+ *                   invoking the callback and should be valid until then.
+ * @param cb         Callback invoked with the result of @c
+ *                   lldpctl_get_port_if_modified(). The error is @c
+ *                   LLDPCTL_ERR_NOT_MODIFIED when the interface did not change.
+ * @param data       Data that will be passed to the callback.
+ * @return 0 in case of success or a negative integer in case of errors.
+ */
+int lldpctl_get_port_if_modified_async(lldpctl_atom_t *port, uint32_t *generation,
+    lldpctl_request_callback cb, void *data);
+
+/**
+ * Retrieve local ports with their neighbors asynchronously.
+ *
+ * @param conn     Connection switched to asynchronous mode.
+ * @param ifnames  Patterns of interfaces to retrieve, as for @c
+ *                 lldpctl_get_neighbors().
+ * @param protocol Protocol of the neighbors to keep, as for @c
+ *                 lldpctl_get_neighbors().
+ * @param cb       Callback invoked with the result of @c
+ *                 lldpctl_get_neighbors().
+ * @param data     Data that will be passed to the callback.
+ * @return 0 in case of success or a negative integer in case of errors.
+ */
+int lldpctl_get_neighbors_async(lldpctl_conn_t *conn, const char *ifnames,
+    int protocol, lldpctl_request_callback cb, void *data);
+
 /**@}*/
 
 /**
@@ -724,6 +991,12 @@ typedef enum {
 						  milliseconds. Set to -1 to transmit now. */
 	lldpctl_k_config_chassis_cap_override, /**< `(I,WO)` Override chassis
 						  capabilities */
+	lldpctl_k_config_iface_rx_ring, /**< `(I,WO)` Enable or disable reception
+					   through a memory-mapped ring */
+	lldpctl_k_config_iface_shared_socket, /**< `(I,WO)` Enable or disable the use
+						 of a single socket for all ports */
+	lldpctl_k_config_snapshot, /**< `(I,WO)` Enable or disable the snapshot of
+				      neighbors in a memory-mapped file */
 
 	lldpctl_k_interface_name = 1000, /**< `(S)` The interface name. */
 
@@ -749,6 +1022,10 @@ typedef enum {
 	lldpctl_k_port_ttl, /**< `(I)` TTL for port, 0 if info is attached to chassis */
 	lldpctl_k_port_vlan_tx, /**< `(I,W)` VLAN tag for TX on port, -1 VLAN disabled
 				 */
+	lldpctl_k_port_generation, /**< `(I)` Version of this port, bumped on each
+				      notified change */
+	lldpctl_k_port_unchanged,  /**< `(I)` Sections omitted from a delta
+				      notification (`LLDPCTL_UNCHANGED_*`) */
 
 	lldpctl_k_port_dot3_mfs = 1300,		/**< `(I)` MFS */
 	lldpctl_k_port_dot3_aggregid,		/**< `(I)` Port aggregation ID */
@@ -16,6 +16,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <time.h>
 #include "lldpd-structs.h"
@@ -29,9 +30,12 @@ lldpd_chassis_mgmt_cleanup(struct lldpd_chassis *chassis)
 	log_debug("alloc", "cleanup management addresses for chassis %s",
 	    chassis->c_name ? chassis->c_name : "(unknown)");
 
-	for (mgmt = TAILQ_FIRST(&chassis->c_mgmt); mgmt != NULL; mgmt = mgmt_next) {
-		mgmt_next = TAILQ_NEXT(mgmt, m_entries);
-		free(mgmt);
+	if (chassis->c_arena == NULL) {
+		for (mgmt = TAILQ_FIRST(&chassis->c_mgmt); mgmt != NULL;
+		     mgmt = mgmt_next) {
+			mgmt_next = TAILQ_NEXT(mgmt, m_entries);
+			free(mgmt);
+		}
 	}
 	TAILQ_INIT(&chassis->c_mgmt);
 }
@@ -42,18 +46,23 @@ lldpd_chassis_cleanup(struct lldpd_chassis *chassis, int all)
 	lldpd_chassis_mgmt_cleanup(chassis);
 	log_debug("alloc", "cleanup chassis %s",
 	    chassis->c_name ? chassis->c_name : "(unknown)");
+	if (chassis->c_arena == NULL) {
 #ifdef ENABLE_LLDPMED
-	free(chassis->c_med_hw);
-	free(chassis->c_med_sw);
-	free(chassis->c_med_fw);
-	free(chassis->c_med_sn);
-	free(chassis->c_med_manuf);
-	free(chassis->c_med_model);
-	free(chassis->c_med_asset);
+		free(chassis->c_med_hw);
+		free(chassis->c_med_sw);
+		free(chassis->c_med_fw);
+		free(chassis->c_med_sn);
+		free(chassis->c_med_manuf);
+		free(chassis->c_med_model);
+		free(chassis->c_med_asset);
 #endif
-	free(chassis->c_id);
-	free(chassis->c_name);
-	free(chassis->c_descr);
+		free(chassis->c_id);
+		free(chassis->c_name);
+		free(chassis->c_descr);
+	}
+	/* Everything else has been allocated from the arena */
+	arena_release(chassis->c_arena);
+	chassis->c_arena = NULL;
 	if (all) free(chassis);
 }
 
@@ -62,10 +71,13 @@ void
 lldpd_vlan_cleanup(struct lldpd_port *port)
 {
 	struct lldpd_vlan *vlan, *vlan_next;
-	for (vlan = TAILQ_FIRST(&port->p_vlans); vlan != NULL; vlan = vlan_next) {
-		free(vlan->v_name);
-		vlan_next = TAILQ_NEXT(vlan, v_entries);
-		free(vlan);
+	if (port->p_arena == NULL) {
+		for (vlan = TAILQ_FIRST(&port->p_vlans); vlan != NULL;
+		     vlan = vlan_next) {
+			free(vlan->v_name);
+			vlan_next = TAILQ_NEXT(vlan, v_entries);
+			free(vlan);
+		}
 	}
 	TAILQ_INIT(&port->p_vlans);
 	port->p_pvid = 0;
@@ -75,9 +87,12 @@ void
 lldpd_ppvid_cleanup(struct lldpd_port *port)
 {
 	struct lldpd_ppvid *ppvid, *ppvid_next;
-	for (ppvid = TAILQ_FIRST(&port->p_ppvids); ppvid != NULL; ppvid = ppvid_next) {
-		ppvid_next = TAILQ_NEXT(ppvid, p_entries);
-		free(ppvid);
+	if (port->p_arena == NULL) {
+		for (ppvid = TAILQ_FIRST(&port->p_ppvids); ppvid != NULL;
+		     ppvid = ppvid_next) {
+			ppvid_next = TAILQ_NEXT(ppvid, p_entries);
+			free(ppvid);
+		}
 	}
 	TAILQ_INIT(&port->p_ppvids);
 }
@@ -86,10 +101,12 @@ void
 lldpd_pi_cleanup(struct lldpd_port *port)
 {
 	struct lldpd_pi *pi, *pi_next;
-	for (pi = TAILQ_FIRST(&port->p_pids); pi != NULL; pi = pi_next) {
-		free(pi->p_pi);
-		pi_next = TAILQ_NEXT(pi, p_entries);
-		free(pi);
+	if (port->p_arena == NULL) {
+		for (pi = TAILQ_FIRST(&port->p_pids); pi != NULL; pi = pi_next) {
+			free(pi->p_pi);
+			pi_next = TAILQ_NEXT(pi, p_entries);
+			free(pi);
+		}
 	}
 	TAILQ_INIT(&port->p_pids);
 }
@@ -134,16 +151,38 @@ void
 lldpd_custom_list_cleanup(struct lldpd_port *port)
 {
 	struct lldpd_custom *custom, *custom_next;
-	for (custom = TAILQ_FIRST(&port->p_custom_list); custom != NULL;
-	     custom = custom_next) {
-		custom_next = TAILQ_NEXT(custom, next);
-		free(custom->oui_info);
-		free(custom);
+	if (port->p_arena == NULL) {
+		for (custom = TAILQ_FIRST(&port->p_custom_list); custom != NULL;
+		     custom = custom_next) {
+			custom_next = TAILQ_NEXT(custom, next);
+			free(custom->oui_info);
+			free(custom);
+		}
 	}
 	TAILQ_INIT(&port->p_custom_list);
 }
 #endif
 
+/* Remove a single remote port whose TTL is over. `expire` is called before the
+ * port is freed. */
+void
+lldpd_remote_expire(struct lldpd_hardware *hardware, struct lldpd_port *port,
+    void (*expire)(struct lldpd_hardware *, struct lldpd_port *))
+{
+	if (port->p_ttl > 0) hardware->h_ageout_cnt++;
+	if (expire) expire(hardware, port);
+	TAILQ_REMOVE(&hardware->h_rports, port, p_entries);
+	hardware->h_rports_count[port->p_protocol]--;
+	hash_remove(&hardware->h_rports_msap, &port->p_msap_hentry);
+	hash_remove(&hardware->h_rports_frame, &port->p_frame_hentry);
+	hardware->h_delete_cnt++;
+	/* Register last removal to be able to report
+	 * lldpStatsRemTablesLastChangeTime */
+	hardware->h_lport.p_lastremove = time(NULL);
+	lldpd_port_cleanup(port, 1);
+	free(port);
+}
+
 /* Cleanup a remote port. The before last argument, `expire` is a function that
  * should be called when a remote port is removed. If the last argument is 1,
  * all remote ports are removed.
@@ -153,34 +192,32 @@ lldpd_remote_cleanup(struct lldpd_hardware *hardware,
     void (*expire)(struct lldpd_hardware *, struct lldpd_port *), int all)
 {
 	struct lldpd_port *port, *port_next;
-	int del;
 	time_t now = time(NULL);
 
 	log_debug("alloc", "cleanup remote port on %s", hardware->h_ifname);
 	for (port = TAILQ_FIRST(&hardware->h_rports); port != NULL; port = port_next) {
 		port_next = TAILQ_NEXT(port, p_entries);
-		del = all;
-		if (!all && expire && (now >= port->p_lastupdate + port->p_ttl)) {
-			if (port->p_ttl > 0) hardware->h_ageout_cnt++;
-			del = 1;
-		}
-		if (del) {
-			if (expire) expire(hardware, port);
-			/* This TAILQ_REMOVE is dangerous. It should not be
-			 * called while in liblldpctl because we don't have a
-			 * real list. It is only needed to be called when we
-			 * don't delete the entire list. */
-			if (!all) TAILQ_REMOVE(&hardware->h_rports, port, p_entries);
-
-			hardware->h_delete_cnt++;
-			/* Register last removal to be able to report
-			 * lldpStatsRemTablesLastChangeTime */
-			hardware->h_lport.p_lastremove = time(NULL);
-			lldpd_port_cleanup(port, 1);
-			free(port);
+		if (!all) {
+			/* lldpd_remote_expire() uses TAILQ_REMOVE. This is
+			 * dangerous. It should not be called while in
+			 * liblldpctl because we don't have a real list. */
+			if (expire && (now >= port->p_lastupdate + port->p_ttl))
+				lldpd_remote_expire(hardware, port, expire);
+			continue;
 		}
+		if (expire) expire(hardware, port);
+		hardware->h_delete_cnt++;
+		hardware->h_lport.p_lastremove = time(NULL);
+		lldpd_port_cleanup(port, 1);
+		free(port);
+	}
+	if (all) {
+		TAILQ_INIT(&hardware->h_rports);
+		memset(hardware->h_rports_count, 0,
+		    sizeof(hardware->h_rports_count));
+		hash_free(&hardware->h_rports_msap);
+		hash_free(&hardware->h_rports_frame);
 	}
-	if (all) TAILQ_INIT(&hardware->h_rports);
 }
 
 /* If `all' is true, clear all information, including information that
@@ -190,7 +227,7 @@ lldpd_port_cleanup(struct lldpd_port *port, int all)
 {
 #ifdef ENABLE_LLDPMED
 	int i;
-	if (all)
+	if (all && port->p_arena == NULL)
 		for (i = 0; i < LLDP_MED_LOCFORMAT_LAST; i++)
 			free(port->p_med_location[i].data);
 #endif
@@ -202,11 +239,13 @@ lldpd_port_cleanup(struct lldpd_port *port, int all)
 	/* will set these to NULL so we don't free wrong memory */
 
 	if (all) {
-		free(port->p_id);
+		if (port->p_arena == NULL) {
+			free(port->p_id);
+			free(port->p_descr);
+			free(port->p_lastframe);
+		}
 		port->p_id = NULL;
-		free(port->p_descr);
 		port->p_descr = NULL;
-		free(port->p_lastframe);
 		if (port->p_chassis) { /* chassis may not have been attributed, yet */
 			port->p_chassis->c_refcount--;
 			port->p_chassis = NULL;
@@ -214,6 +253,9 @@ lldpd_port_cleanup(struct lldpd_port *port, int all)
 #ifdef ENABLE_CUSTOM
 		lldpd_custom_list_cleanup(port);
 #endif
+		/* Everything else has been allocated from the arena */
+		arena_release(port->p_arena);
+		port->p_arena = NULL;
 	}
 }
 
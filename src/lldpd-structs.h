@@ -40,6 +40,8 @@
 
 #include "compat/compat.h"
 #include "marshal.h"
+#include "hash.h"
+#include "arena.h"
 #include "lldp-const.h"
 
 #ifdef ENABLE_DOT1
@@ -173,8 +175,14 @@ MARSHAL_END(lldpd_mgmt);
 
 struct lldpd_chassis {
 	TAILQ_ENTRY(lldpd_chassis) c_entries;
+	struct hash_entry c_hentry; /* Index on protocol and chassis ID */
 	u_int16_t c_refcount; /* Reference count by ports */
 	u_int16_t c_index;    /* Monotonic index */
+	u_int32_t c_generation; /* Bumped on each change (local chassis only) */
+	struct arena *c_arena;	/* Content of a remote chassis or NULL */
+	/* Important: all fields that should be ignored to check if the chassis
+	 * has been changed should be before this mark. */
+#define LLDPD_CHASSIS_START_MARKER (offsetof(struct lldpd_chassis, c_protocol))
 	u_int8_t c_protocol;  /* Protocol used to get this chassis */
 	u_int8_t c_id_subtype;
 	char *c_id;
@@ -204,6 +212,9 @@ struct lldpd_chassis {
 MARSHAL_BEGIN(lldpd_chassis)
 MARSHAL_IGNORE(lldpd_chassis, c_entries.tqe_next)
 MARSHAL_IGNORE(lldpd_chassis, c_entries.tqe_prev)
+MARSHAL_IGNORE(lldpd_chassis, c_hentry.he_next)
+MARSHAL_IGNORE(lldpd_chassis, c_hentry.he_hash)
+MARSHAL_IGNORE(lldpd_chassis, c_arena)
 MARSHAL_FSTR(lldpd_chassis, c_id, c_id_len)
 MARSHAL_STR(lldpd_chassis, c_name)
 MARSHAL_STR(lldpd_chassis, c_descr)
@@ -246,6 +257,9 @@ MARSHAL_END(lldpd_custom);
 
 struct lldpd_port {
 	TAILQ_ENTRY(lldpd_port) p_entries;
+	struct hash_entry p_msap_hentry;  /* Index on MSAP (remote ports only) */
+	struct hash_entry p_frame_hentry; /* Index on last frame (remote ports only) */
+	u_int32_t p_expiry; /* Position in expiry heap (remote ports only) */
 	struct lldpd_chassis *p_chassis; /* Attached chassis */
 	time_t p_lastchange;		 /* Time of last change of values */
 	time_t p_lastupdate;		 /* Time of last update received */
@@ -253,11 +267,15 @@ struct lldpd_port {
 	    p_lastremove; /* Time of last removal of a remote port. Used for local ports
 			   * only Used for deciding lldpStatsRemTablesLastChangeTime */
 	struct lldpd_frame *p_lastframe; /* Frame received during last update */
+	struct arena *p_arena;		 /* Content of a remote port or NULL */
 	u_int8_t p_protocol;		 /* Protocol used to get this port */
 	u_int8_t p_hidden_in : 1;	 /* Considered as hidden for reception */
 	u_int8_t p_hidden_out : 1;	 /* Considered as hidden for emission */
 	u_int8_t p_disable_rx : 1;	 /* Should RX be disabled for this port? */
 	u_int8_t p_disable_tx : 1;	 /* Should TX be disabled for this port? */
+	u_int8_t p_custom_changed : 1;	 /* Custom TLVs changed, not notified */
+	u_int32_t p_generation; /* Bumped on each notified change */
+	u_int8_t p_unchanged;	/* Sections omitted from a delta notification */
 	/* Important: all fields that should be ignored to check if a port has
 	 * been changed should be before this mark. */
 #define LLDPD_PORT_START_MARKER (offsetof(struct lldpd_port, _p_hardware_flags))
@@ -302,8 +320,13 @@ struct lldpd_port {
 };
 MARSHAL_BEGIN(lldpd_port)
 MARSHAL_TQE(lldpd_port, p_entries)
+MARSHAL_IGNORE(lldpd_port, p_msap_hentry.he_next)
+MARSHAL_IGNORE(lldpd_port, p_msap_hentry.he_hash)
+MARSHAL_IGNORE(lldpd_port, p_frame_hentry.he_next)
+MARSHAL_IGNORE(lldpd_port, p_frame_hentry.he_hash)
 MARSHAL_POINTER(lldpd_port, lldpd_chassis, p_chassis)
 MARSHAL_IGNORE(lldpd_port, p_lastframe)
+MARSHAL_IGNORE(lldpd_port, p_arena)
 MARSHAL_FSTR(lldpd_port, p_id, p_id_len)
 MARSHAL_STR(lldpd_port, p_descr)
 #ifdef ENABLE_LLDPMED
@@ -419,6 +442,9 @@ struct lldpd_config {
 					  slaves */
 	int c_lldp_portid_type;	       /* The PortID type */
 	int c_lldp_agent_type;	       /* The agent type */
+	int c_rx_ring;		       /* Receive frames through a memory-mapped ring */
+	int c_shared_socket;	       /* Use a single socket for all ports */
+	int c_snapshot;		       /* Publish neighbors in a mapped file */
 };
 MARSHAL_BEGIN(lldpd_config)
 MARSHAL_STR(lldpd_config, c_mgmt_pattern)
@@ -437,12 +463,17 @@ struct lldpd_frame {
 };
 
 struct lldpd_hardware;
+struct lldpd_tx_cache;
 struct lldpd;
 struct lldpd_ops {
 	int (*send)(struct lldpd *, struct lldpd_hardware *, char *,
 	    size_t); /* Function to send a frame */
 	int (*recv)(struct lldpd *, struct lldpd_hardware *, int, char *,
 	    size_t); /* Function to receive a frame */
+	int (*recv_batch)(struct lldpd *, struct lldpd_hardware *, int,
+	    int (*)(struct lldpd *, struct lldpd_hardware *, char *,
+		size_t)); /* Optional function to handle all pending frames in
+			     place. Return the number of accepted frames. */
 	int (*cleanup)(struct lldpd *, struct lldpd_hardware *); /* Cleanup function. */
 };
 
@@ -459,6 +490,7 @@ struct lldpd_hardware {
 	int h_mangle;		 /* 1 if we have to mangle the MAC address */
 	struct lldpd_ops *h_ops; /* Hardware-dependent functions */
 	void *h_data;		 /* Hardware-dependent data */
+	struct lldpd_tx_cache *h_tx_cache; /* Cached frames, by protocol */
 	void *h_timer;		 /* Timer for this port */
 
 	int h_mtu;
@@ -468,6 +500,7 @@ struct lldpd_hardware {
 				    to 0. */
 	int h_ifindex;		 /* Interface index, used by SNMP */
 	int h_ifindex_changed;	 /* Interface index has changed */
+	int h_unchanged;	 /* Not refreshed during last update */
 	char h_ifname[IFNAMSIZ]; /* Should be unique */
 	u_int8_t h_lladdr[ETHER_ADDR_LEN];
 
@@ -480,12 +513,30 @@ struct lldpd_hardware {
 	u_int64_t h_delete_cnt;
 	u_int64_t h_drop_cnt;
 
+	/* Bumped on each change of the interface, its counters or its neighbors.
+	 * Only up-to-date in answers to GET_INTERFACE_IF_MODIFIED, see
+	 * lldpd_hardware_generation(). */
+	u_int32_t h_generation;
+	/* Generations of the local port and chassis and counters when
+	 * h_generation was last bumped. */
+	struct {
+		u_int32_t lport_generation;
+		u_int32_t lchassis_generation;
+		u_int64_t counters[8]; /* From h_tx_cnt to h_drop_cnt */
+	} h_state;
+
 	/* Previous values of different stuff. */
-	/* Backup of the previous local port. Used to check if there was a
-	 * change to send an immediate update. All those are not marshalled to
-	 * the client. */
-	void *h_lport_previous;
-	ssize_t h_lport_previous_len;
+	/* Generations of the local port and chassis when the transmit timer
+	 * was last reset. Used to check if there was a change to send an
+	 * immediate update. */
+	u_int32_t h_lport_generation;
+	u_int32_t h_lchassis_generation;
+#ifdef ENABLE_DOT1
+	/* VLANs of the local port before it was refreshed. They are rebuilt
+	 * from scratch and compared with these ones to detect a change. */
+	u_int16_t h_lport_previous_pvid;
+	TAILQ_HEAD(, lldpd_vlan) h_lport_previous_vlans;
+#endif
 	/* Backup of the previous chassis ID. Used to check if there was a
 	 * change and send an LLDP shutdown. */
 	u_int8_t h_lchassis_previous_id_subtype;
@@ -499,6 +550,9 @@ struct lldpd_hardware {
 
 	struct lldpd_port h_lport;	   /* Port attached to this hardware port */
 	TAILQ_HEAD(, lldpd_port) h_rports; /* Remote ports */
+	u_int32_t h_rports_count[LLDPD_MODE_MAX + 1]; /* Remote ports by protocol */
+	struct hash_table h_rports_msap;   /* Remote ports indexed by MSAP */
+	struct hash_table h_rports_frame;  /* Remote ports indexed by last frame */
 
 #ifdef ENABLE_LLDPMED
 	int h_tx_fast; /* current tx fast start count */
@@ -509,15 +563,22 @@ MARSHAL_IGNORE(lldpd_hardware, h_entries.tqe_next)
 MARSHAL_IGNORE(lldpd_hardware, h_entries.tqe_prev)
 MARSHAL_IGNORE(lldpd_hardware, h_ops)
 MARSHAL_IGNORE(lldpd_hardware, h_data)
+MARSHAL_IGNORE(lldpd_hardware, h_tx_cache)
 MARSHAL_IGNORE(lldpd_hardware, h_cfg)
-MARSHAL_IGNORE(lldpd_hardware, h_lport_previous)
-MARSHAL_IGNORE(lldpd_hardware, h_lport_previous_len)
 MARSHAL_IGNORE(lldpd_hardware, h_lchassis_previous_id_subtype)
 MARSHAL_IGNORE(lldpd_hardware, h_lchassis_previous_id)
 MARSHAL_IGNORE(lldpd_hardware, h_lchassis_previous_id_len)
 MARSHAL_IGNORE(lldpd_hardware, h_lport_previous_id_subtype)
 MARSHAL_IGNORE(lldpd_hardware, h_lport_previous_id)
 MARSHAL_IGNORE(lldpd_hardware, h_lport_previous_id_len)
+#ifdef ENABLE_DOT1
+MARSHAL_IGNORE(lldpd_hardware, h_lport_previous_vlans.tqh_first)
+MARSHAL_IGNORE(lldpd_hardware, h_lport_previous_vlans.tqh_last)
+#endif
+MARSHAL_IGNORE(lldpd_hardware, h_rports_msap.ht_buckets)
+MARSHAL_IGNORE(lldpd_hardware, h_rports_msap.ht_inline)
+MARSHAL_IGNORE(lldpd_hardware, h_rports_frame.ht_buckets)
+MARSHAL_IGNORE(lldpd_hardware, h_rports_frame.ht_inline)
 MARSHAL_SUBSTRUCT(lldpd_hardware, lldpd_port, h_lport)
 MARSHAL_SUBTQ(lldpd_hardware, lldpd_port, h_rports)
 MARSHAL_END(lldpd_hardware);
@@ -533,24 +594,95 @@ MARSHAL_END(lldpd_interface);
 TAILQ_HEAD(lldpd_interface_list, lldpd_interface);
 MARSHAL_TQ(lldpd_interface_list, lldpd_interface);
 
+/* Filter for a GET_NEIGHBORS request */
+struct lldpd_neighbors_filter {
+	char *ifnames; /* Patterns of interfaces to match (NULL for all) */
+	int protocol;  /* Protocol of neighbors to keep (0 for all) */
+};
+MARSHAL_BEGIN(lldpd_neighbors_filter)
+MARSHAL_STR(lldpd_neighbors_filter, ifnames)
+MARSHAL_END(lldpd_neighbors_filter);
+
+/* One message of a GET_NEIGHBORS answer. A record is sent for each matching
+ * interface, then a record without hardware ends the answer. */
+struct lldpd_neighbors_record {
+	struct lldpd_hardware *hardware;
+};
+MARSHAL_BEGIN(lldpd_neighbors_record)
+MARSHAL_POINTER(lldpd_neighbors_record, lldpd_hardware, hardware)
+MARSHAL_END(lldpd_neighbors_record);
+
+/* A GET_INTERFACE_IF_MODIFIED request */
+struct lldpd_interface_request {
+	char *ifname;
+	u_int32_t generation; /* Generation known by the client, 0 for none */
+};
+MARSHAL_BEGIN(lldpd_interface_request)
+MARSHAL_STR(lldpd_interface_request, ifname)
+MARSHAL_END(lldpd_interface_request);
+
+/* Answer to a GET_INTERFACE_IF_MODIFIED request. The interface is omitted
+ * when its generation is the one known by the client. */
+struct lldpd_interface_answer {
+	u_int32_t generation;
+	struct lldpd_hardware *hardware;
+};
+MARSHAL_BEGIN(lldpd_interface_answer)
+MARSHAL_POINTER(lldpd_interface_answer, lldpd_hardware, hardware)
+MARSHAL_END(lldpd_interface_answer);
+
 struct lldpd_neighbor_change {
 	char *ifname;
 #define NEIGHBOR_CHANGE_DELETED -1
 #define NEIGHBOR_CHANGE_ADDED 1
 #define NEIGHBOR_CHANGE_UPDATED 0
 	int state;
+/* Sections of a neighbor left unchanged by an update */
+#define NEIGHBOR_UNCHANGED_CHASSIS 0x1 /* Only the chassis identity is sent */
+#define NEIGHBOR_UNCHANGED_VLANS 0x2   /* VLAN, PPVID and PI lists */
+#define NEIGHBOR_UNCHANGED_CUSTOM 0x4  /* Custom TLVs */
+#define NEIGHBOR_UNCHANGED_ALL 0x7
 	struct lldpd_port *neighbor;
+	TAILQ_ENTRY(lldpd_neighbor_change) c_entries;
+	struct hash_entry c_hentry; /* Index of coalesced changes */
 };
 MARSHAL_BEGIN(lldpd_neighbor_change)
 MARSHAL_STR(lldpd_neighbor_change, ifname)
 MARSHAL_POINTER(lldpd_neighbor_change, lldpd_port, neighbor)
+MARSHAL_TQE(lldpd_neighbor_change, c_entries)
+MARSHAL_IGNORE(lldpd_neighbor_change, c_hentry.he_next)
+MARSHAL_IGNORE(lldpd_neighbor_change, c_hentry.he_hash)
 MARSHAL_END(lldpd_neighbor_change);
 
+/* Neighbor changes coalesced by lldpd and sent in a single message */
+struct lldpd_neighbor_changes {
+	TAILQ_HEAD(, lldpd_neighbor_change) changes;
+	int overflow; /* Some changes were dropped */
+};
+MARSHAL_BEGIN(lldpd_neighbor_changes)
+MARSHAL_SUBTQ(lldpd_neighbor_changes, lldpd_neighbor_change, changes)
+MARSHAL_END(lldpd_neighbor_changes);
+
+/* Subscription to neighbor changes. When the window is not 0, changes for the
+ * same neighbor are coalesced during this window and sent together with
+ * NOTIFICATIONS. Otherwise, when delta is set, sections of updated neighbors
+ * that did not change since the previous generation are omitted and listed in
+ * `p_unchanged`. */
+struct lldpd_subscription {
+	int subscribed; /* Is the client subscribed to changes? */
+	int window;	/* Coalescing window in milliseconds */
+	int queue;	/* Maximum number of pending changes */
+	int delta;	/* Omit unchanged sections of updated neighbors */
+};
+MARSHAL(lldpd_subscription);
+
 /* Cleanup functions */
 void lldpd_chassis_mgmt_cleanup(struct lldpd_chassis *);
 void lldpd_chassis_cleanup(struct lldpd_chassis *, int);
 void lldpd_remote_cleanup(struct lldpd_hardware *,
     void (*expire)(struct lldpd_hardware *, struct lldpd_port *), int);
+void lldpd_remote_expire(struct lldpd_hardware *, struct lldpd_port *,
+    void (*expire)(struct lldpd_hardware *, struct lldpd_port *));
 void lldpd_port_cleanup(struct lldpd_port *, int);
 void lldpd_config_cleanup(struct lldpd_config *);
 #ifdef ENABLE_DOT1
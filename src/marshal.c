@@ -23,8 +23,10 @@
 #include <sys/types.h>
 #include <sys/queue.h>
 #include <string.h>
+#include <stdint.h>
 
 #include "compat/compat.h"
+#include "hash.h"
 #include "log.h"
 
 #include "lldpd-structs.h"
@@ -67,155 +69,276 @@ struct marshal_info marshal_info_ignore = {
 	.pointers = { MARSHAL_SUBINFO_NULL },
 };
 
-/* List of already seen pointers */
+/* Pointers already seen while serializing, with the dummy value replacing
+ * them. This is an open-addressing hash table. Dummy values are allocated in
+ * the order pointers are first seen, starting at 1. */
 struct ref {
-	TAILQ_ENTRY(ref) next;
 	void *pointer;
-	uintptr_t dummy; /* To renumerate pointers */
+	uintptr_t dummy;
+};
+struct refs {
+	struct ref *refs;
+	size_t size;	/* Number of slots (power of two) */
+	uintptr_t last; /* Last allocated dummy value */
+	uintptr_t next; /* Next dummy value to write */
+	marshal_filter filter; /* See marshal_serialize_filtered_() */
+	void *arg;
 };
-TAILQ_HEAD(ref_l, ref);
 
-/* Serialize the given object. */
-ssize_t
-marshal_serialize_(struct marshal_info *mi, void *unserialized, void **input, int skip,
-    void *_refs, int osize)
+#define REFS_MIN_SIZE 64
+
+static struct ref *
+marshal_ref_slot(struct ref *refs, size_t size, void *pointer)
 {
-	struct ref_l *refs = _refs;
-	struct ref *cref;
-	int size;
-	size_t len;
-	struct marshal_subinfo *current;
-	struct marshal_serialized *new = NULL, *serialized = NULL;
-	uintptr_t dummy = 1;
+	size_t i = (((uintptr_t)pointer >> 3) * (uintptr_t)0x9e3779b97f4a7c15ULL) &
+	    (size - 1);
+	while (refs[i].pointer != NULL && refs[i].pointer != pointer)
+		i = (i + 1) & (size - 1);
+	return &refs[i];
+}
 
-	log_debug("marshal", "start serialization of %s", mi->name);
+/* Return the dummy value for the given pointer or 0 if not seen yet. */
+static uintptr_t
+marshal_ref_get(struct refs *refs, void *pointer)
+{
+	if (refs->size == 0) return 0;
+	return marshal_ref_slot(refs->refs, refs->size, pointer)->dummy;
+}
+
+static int
+marshal_ref_add(struct refs *refs, void *pointer)
+{
+	struct ref *new, *old;
+	size_t i, size;
 
-	/* Check if we have already serialized this one. */
-	if (!refs) {
-		refs = calloc(1, sizeof(struct ref_l));
-		if (!refs) {
+	if (refs->last * 2 >= refs->size) {
+		size = refs->size ? refs->size * 2 : REFS_MIN_SIZE;
+		if ((new = calloc(size, sizeof(struct ref))) == NULL) {
 			log_warnx("marshal",
 			    "unable to allocate memory for list of references");
 			return -1;
 		}
-		TAILQ_INIT(refs);
-	}
-	TAILQ_FOREACH (cref, refs, next) {
-		if (unserialized == cref->pointer) return 0;
-		/* dummy should be higher than any existing dummy */
-		if (cref->dummy >= dummy) dummy = cref->dummy + 1;
+		for (i = 0; i < refs->size; i++) {
+			old = &refs->refs[i];
+			if (old->pointer == NULL) continue;
+			*marshal_ref_slot(new, size, old->pointer) = *old;
+		}
+		free(refs->refs);
+		refs->refs = new;
+		refs->size = size;
 	}
+	new = marshal_ref_slot(refs->refs, refs->size, pointer);
+	new->pointer = pointer;
+	new->dummy = ++refs->last;
+	return 0;
+}
 
-	/* Handle special cases. */
-	size = mi->size;
-	if (!strcmp(mi->name, "null string")) /* We know we can't be called with NULL */
-		size = strlen((char *)unserialized) + 1;
-	else if (!strcmp(mi->name, "fixed string"))
-		size = osize;
-
-	/* Allocate serialized structure */
-	len = sizeof(struct marshal_serialized) + (skip ? 0 : size);
-	serialized = calloc(1, len);
-	if (!serialized) {
-		log_warnx("marshal",
-		    "unable to allocate memory to serialize structure %s", mi->name);
-		len = -1;
-		goto marshal_error;
-	}
-	/* We don't use the original pointer but a dummy one. */
-	serialized->orig = (unsigned char *)dummy;
+static size_t
+marshal_object_size(struct marshal_info *mi, void *unserialized, int osize)
+{
+	if (mi == &marshal_info_string) /* We know we can't be called with NULL */
+		return strlen((char *)unserialized) + 1;
+	if (mi == &marshal_info_fstring) return osize;
+	return mi->size;
+}
 
-	/* Append the new reference */
-	if (!(cref = calloc(1, sizeof(struct ref)))) {
-		log_warnx("marshal",
-		    "unable to allocate memory for list of references");
-		free(serialized);
-		len = -1;
-		goto marshal_error;
+/* Padding to put before a substructure to be able to unserialize it */
+static size_t
+marshal_padding(size_t len)
+{
+	size_t padlen = ALIGNOF(struct marshal_serialized);
+	return (padlen - (len % padlen)) % padlen;
+}
+
+/* Get the source of a substructure. Return NULL if there is nothing to
+ * serialize. */
+static void *
+marshal_source(struct refs *refs, struct marshal_subinfo *current,
+    void *unserialized, int *osize)
+{
+	void *source;
+	if (current->kind == ignore) return NULL;
+	if (current->kind == pointer) {
+		memcpy(&source, (unsigned char *)unserialized + current->offset,
+		    sizeof(void *));
+		if (source != NULL && refs->filter != NULL)
+			source = refs->filter(current->mi, source, refs->arg);
+	} else
+		source = (void *)((unsigned char *)unserialized + current->offset);
+	if (source != NULL && current->offset2)
+		memcpy(osize, (unsigned char *)unserialized + current->offset2,
+		    sizeof(int));
+	return source;
+}
+
+/* First pass: record all pointers and compute the size of the serialized
+ * object. Return 0 if the object was already seen. */
+static ssize_t
+marshal_serialize_size(struct refs *refs, struct marshal_info *mi, void *unserialized,
+    int skip, int osize)
+{
+	struct marshal_subinfo *current;
+	ssize_t len, sublen;
+	void *source;
+
+	if (marshal_ref_get(refs, unserialized)) return 0;
+	if (marshal_ref_add(refs, unserialized) == -1) return -1;
+
+	len = sizeof(struct marshal_serialized) +
+	    (skip ? 0 : marshal_object_size(mi, unserialized, osize));
+	for (current = mi->pointers; current->mi; current++) {
+		if ((source = marshal_source(refs, current, unserialized, &osize)) ==
+		    NULL)
+			continue;
+		sublen = marshal_serialize_size(refs, current->mi, source,
+		    current->kind == substruct, osize);
+		if (sublen == -1) return -1;
+		if (sublen == 0) continue; /* This was already serialized */
+		len += marshal_padding(len) + sublen;
 	}
-	cref->pointer = unserialized;
-	cref->dummy = dummy;
-	TAILQ_INSERT_TAIL(refs, cref, next);
+	return len;
+}
+
+/* Second pass: write the serialized object. Objects are seen in the same order
+ * as during the first pass. */
+static size_t
+marshal_serialize_write(struct refs *refs, struct marshal_info *mi, void *unserialized,
+    int skip, int osize, unsigned char *output)
+{
+	struct marshal_serialized *serialized = (struct marshal_serialized *)output;
+	struct marshal_subinfo *current;
+	uintptr_t dummy = marshal_ref_get(refs, unserialized);
+	size_t len, sublen, padlen, size;
+	void *source, *fakepointer;
+
+	if (dummy != refs->next) return 0; /* Already serialized */
+	refs->next++;
 
-	/* First, serialize the main structure */
-	if (!skip) memcpy(serialized->object, unserialized, size);
+	/* We don't use the original pointer but a dummy one. */
+	size = skip ? 0 : marshal_object_size(mi, unserialized, osize);
+	serialized->orig = (unsigned char *)dummy;
+	memcpy(serialized->object, unserialized, size);
+	len = sizeof(struct marshal_serialized) + size;
 
-	/* Then, serialize inner structures */
 	for (current = mi->pointers; current->mi; current++) {
-		size_t sublen;
-		size_t padlen;
-		void *source;
-		void *target = NULL;
-		if (current->kind == ignore) continue;
-		if (current->kind == pointer) {
-			memcpy(&source, (unsigned char *)unserialized + current->offset,
-			    sizeof(void *));
-			if (source == NULL) continue;
-		} else
-			source =
-			    (void *)((unsigned char *)unserialized + current->offset);
-		if (current->offset2)
-			memcpy(&osize, (unsigned char *)unserialized + current->offset2,
-			    sizeof(int));
-		target = NULL;
-		sublen = marshal_serialize_(current->mi, source, &target,
-		    current->kind == substruct, refs, osize);
-		if (sublen == -1) {
-			log_warnx("marshal",
-			    "unable to serialize substructure %s for %s",
-			    current->mi->name, mi->name);
-			free(serialized);
-			return -1;
+		if ((source = marshal_source(refs, current, unserialized, &osize)) ==
+		    NULL) {
+			/* The pointer may have been filtered out */
+			if (current->kind == pointer && !skip)
+				memset(serialized->object + current->offset, 0,
+				    sizeof(void *));
+			continue;
 		}
+		padlen = marshal_padding(len);
+		sublen = marshal_serialize_write(refs, current->mi, source,
+		    current->kind == substruct, osize, output + len + padlen);
 		/* We want to put the renumerated pointer instead of the real one. */
 		if (current->kind == pointer && !skip) {
-			TAILQ_FOREACH (cref, refs, next) {
-				if (source == cref->pointer) {
-					void *fakepointer =
-					    (unsigned char *)cref->dummy;
-					memcpy((unsigned char *)serialized->object +
-						current->offset,
-					    &fakepointer, sizeof(void *));
-					break;
-				}
-			}
+			fakepointer = (unsigned char *)marshal_ref_get(refs, source);
+			memcpy(serialized->object + current->offset, &fakepointer,
+			    sizeof(void *));
 		}
 		if (sublen == 0) continue; /* This was already serialized */
-		/* Append the result, force alignment to be able to unserialize it */
-		padlen = ALIGNOF(struct marshal_serialized);
-		padlen = (padlen - (len % padlen)) % padlen;
-		new = realloc(serialized, len + padlen + sublen);
-		if (!new) {
-			log_warnx("marshal",
-			    "unable to allocate more memory to serialize structure %s",
-			    mi->name);
-			free(serialized);
-			free(target);
-			len = -1;
-			goto marshal_error;
-		}
-		memset((unsigned char *)new + len, 0, padlen);
-		memcpy((unsigned char *)new + len + padlen, target, sublen);
-		free(target);
-		len += sublen + padlen;
-		serialized = (struct marshal_serialized *)new;
+		memset(output + len, 0, padlen);
+		len += padlen + sublen;
 	}
-
 	serialized->size = len;
-	*input = serialized;
-marshal_error:
-	if (refs && !_refs) {
-		struct ref *cref, *cref_next;
-		for (cref = TAILQ_FIRST(refs); cref != NULL; cref = cref_next) {
-			cref_next = TAILQ_NEXT(cref, next);
-			TAILQ_REMOVE(refs, cref, next);
-			free(cref);
-		}
-		free(refs);
+	return len;
+}
+
+/* Serialize the given object. The size of the result is computed first to
+ * allocate it at once. Each pointer to another structure is passed to `filter`
+ * which returns the structure to serialize instead, or NULL to serialize a
+ * NULL pointer. */
+ssize_t
+marshal_serialize_filtered_(struct marshal_info *mi, void *unserialized,
+    void **input, marshal_filter filter, void *arg)
+{
+	struct refs refs = { .filter = filter, .arg = arg };
+	unsigned char *output = NULL;
+	ssize_t len;
+
+	log_debug("marshal", "start serialization of %s", mi->name);
+
+	if ((len = marshal_serialize_size(&refs, mi, unserialized, 0, 0)) == -1)
+		goto end;
+	if ((output = malloc(len)) == NULL) {
+		log_warnx("marshal",
+		    "unable to allocate memory to serialize structure %s", mi->name);
+		len = -1;
+		goto end;
 	}
+	refs.next = 1;
+	marshal_serialize_write(&refs, mi, unserialized, 0, 0, output);
+	*input = output;
+end:
+	free(refs.refs);
 	return len;
 }
 
+ssize_t
+marshal_serialize_(struct marshal_info *mi, void *unserialized, void **input)
+{
+	return marshal_serialize_filtered_(mi, unserialized, input, NULL, NULL);
+}
+
+static u_int32_t
+marshal_hash_object(struct marshal_info *mi, void *object, size_t start, int osize,
+    u_int32_t hash)
+{
+	static const unsigned char present[] = { 0, 1 };
+	struct marshal_subinfo *current, *next;
+	unsigned char *base = object;
+	size_t offset = start, end;
+	void *source;
+
+	if (mi == &marshal_info_string || mi == &marshal_info_fstring)
+		return hash_bytes(hash, object, marshal_object_size(mi, object, osize));
+
+	for (;;) {
+		/* Hash everything up to the next pointer or substructure */
+		next = NULL;
+		for (current = mi->pointers; current->mi; current++)
+			if (current->offset >= offset &&
+			    (next == NULL || current->offset < next->offset))
+				next = current;
+		end = next ? next->offset : mi->size;
+		hash = hash_bytes(hash, base + offset, end - offset);
+		if (next == NULL) return hash;
+
+		switch (next->kind) {
+		case ignore:
+			/* Like when unserializing, assume a pointer-sized field */
+			offset = end + sizeof(void *);
+			break;
+		case substruct:
+			hash = marshal_hash_object(next->mi, base + end, 0, 0, hash);
+			offset = end + next->mi->size;
+			break;
+		case pointer:
+			memcpy(&source, base + end, sizeof(void *));
+			offset = end + sizeof(void *);
+			hash = hash_bytes(hash, &present[source != NULL], 1);
+			if (source == NULL) break;
+			if (next->offset2)
+				memcpy(&osize, base + next->offset2, sizeof(int));
+			hash = marshal_hash_object(next->mi, source, 0, osize, hash);
+			break;
+		}
+	}
+}
+
+/* Hash the content of the given object, following pointers. The value of
+ * pointers and ignored fields does not contribute to the result, nor do the
+ * fields located before `start` in the top-level object. Unlike
+ * serialization, this does not allocate memory but the object should not
+ * contain loops. */
+u_int32_t
+marshal_hash_(struct marshal_info *mi, void *unserialized, size_t start)
+{
+	return marshal_hash_object(mi, unserialized, start, 0, HASH_INIT);
+}
+
 /* This structure is used to track memory allocation when serializing */
 struct gc {
 	TAILQ_ENTRY(gc) next;
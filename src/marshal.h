@@ -130,10 +130,20 @@ extern struct marshal_info marshal_info_ignore;
   MARSHAL_END(type)
 
 /* Serialization */
-ssize_t marshal_serialize_(struct marshal_info *, void *, void **, int, void *, int)
+ssize_t marshal_serialize_(struct marshal_info *, void *, void **)
     __attribute__((nonnull(1, 2, 3)));
 #define marshal_serialize(type, o, output) \
-  marshal_serialize_(&MARSHAL_INFO(type), o, output, 0, NULL, 0)
+  marshal_serialize_(&MARSHAL_INFO(type), o, output)
+typedef void *(*marshal_filter)(struct marshal_info *, void *, void *);
+ssize_t marshal_serialize_filtered_(struct marshal_info *, void *, void **,
+    marshal_filter, void *) __attribute__((nonnull(1, 2, 3)));
+#define marshal_serialize_filtered(type, o, output, filter, arg) \
+  marshal_serialize_filtered_(&MARSHAL_INFO(type), o, output, filter, arg)
+
+/* Hashing */
+u_int32_t marshal_hash_(struct marshal_info *, void *, size_t)
+    __attribute__((nonnull(1, 2)));
+#define marshal_hash(type, o, start) marshal_hash_(&MARSHAL_INFO(type), o, start)
 
 /* Unserialization */
 size_t marshal_unserialize_(struct marshal_info *, void *, size_t, void **, void *, int,
@@ -0,0 +1,241 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2026 Vincent Bernat <bernat@luffy.cx>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "snapshot.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "log.h"
+
+#define SNAPSHOT_MIN_SIZE (64 * 1024)
+#define SNAPSHOT_RETRIES 1000 /* Attempts to get a consistent copy */
+
+static int
+snapshot_map(struct snapshot *snapshot, size_t size, int prot)
+{
+	void *map;
+
+	if (snapshot->s_map != NULL) munmap(snapshot->s_map, snapshot->s_size);
+	snapshot->s_map = NULL;
+	snapshot->s_size = 0;
+	if ((map = mmap(NULL, size, prot, MAP_SHARED, snapshot->s_fd, 0)) ==
+	    MAP_FAILED)
+		return -1;
+	snapshot->s_map = map;
+	snapshot->s_size = size;
+	return 0;
+}
+
+/**
+ * Publish a new content in a snapshot file.
+ *
+ * @param snapshot Snapshot with a file descriptor opened for writing.
+ * @param content  New content.
+ * @param len      Length of the content. 0 withdraws the snapshot.
+ * @return 0 on success, -1 otherwise.
+ *
+ * The file is grown and mapped again when the content does not fit anymore.
+ */
+int
+snapshot_update(struct snapshot *snapshot, const void *content, size_t len)
+{
+	struct snapshot_header *header;
+	struct stat st;
+	size_t size;
+
+	if (snapshot->s_fd == -1) return -1;
+	if (snapshot->s_size < sizeof(*header) + len) {
+		if (fstat(snapshot->s_fd, &st) == -1) {
+			log_warn("snapshot", "unable to stat snapshot file");
+			return -1;
+		}
+		size = snapshot->s_size ? snapshot->s_size : SNAPSHOT_MIN_SIZE;
+		while (size < sizeof(*header) + len)
+			size *= 2;
+		if ((size_t)st.st_size < size &&
+		    ftruncate(snapshot->s_fd, size) == -1) {
+			log_warn("snapshot",
+			    "unable to grow snapshot file to %zu bytes", size);
+			return -1;
+		}
+		if ((size_t)st.st_size > size) size = st.st_size;
+		if (snapshot_map(snapshot, size, PROT_READ | PROT_WRITE) == -1) {
+			log_warn("snapshot", "unable to map snapshot file");
+			return -1;
+		}
+	}
+
+	header = snapshot->s_map;
+	header->sh_magic = SNAPSHOT_MAGIC;
+	header->sh_version = SNAPSHOT_VERSION;
+	header->sh_seq++;
+	__sync_synchronize();
+	if (len > 0) memcpy(header + 1, content, len);
+	header->sh_len = len;
+	header->sh_generation++;
+	__sync_synchronize();
+	header->sh_seq++;
+	return 0;
+}
+
+/**
+ * Open a snapshot file for reading.
+ *
+ * @param snapshot Snapshot to initialize.
+ * @param name     Name of the snapshot file.
+ * @return 0 on success, -1 otherwise.
+ *
+ * The file is only mapped when reading it.
+ */
+int
+snapshot_open(struct snapshot *snapshot, const char *name)
+{
+	snapshot->s_map = NULL;
+	snapshot->s_size = 0;
+	if ((snapshot->s_fd = open(name, O_RDONLY)) == -1) return -1;
+	if (fcntl(snapshot->s_fd, F_SETFD, FD_CLOEXEC) == -1) {
+		snapshot_close(snapshot);
+		return -1;
+	}
+	return 0;
+}
+
+/* Map the whole file if it grew since the last time. */
+static int
+snapshot_remap(struct snapshot *snapshot)
+{
+	struct stat st;
+
+	if (fstat(snapshot->s_fd, &st) == -1) return -1;
+	if ((size_t)st.st_size < sizeof(struct snapshot_header)) {
+		errno = ENOENT;
+		return -1;
+	}
+	if ((size_t)st.st_size <= snapshot->s_size) return 0;
+	return snapshot_map(snapshot, st.st_size, PROT_READ);
+}
+
+/* Wait for the writer to leave the header in a stable state. Return the
+ * sequence counter or -1 when no snapshot is published. */
+static int64_t
+snapshot_begin(struct snapshot *snapshot)
+{
+	volatile struct snapshot_header *header;
+	u_int32_t seq;
+	int retries;
+
+	if (snapshot->s_map == NULL && snapshot_remap(snapshot) == -1) return -1;
+	header = snapshot->s_map;
+	for (retries = 0; retries < SNAPSHOT_RETRIES; retries++) {
+		seq = header->sh_seq;
+		__sync_synchronize();
+		if (seq & 1) continue;
+		if (header->sh_magic != SNAPSHOT_MAGIC ||
+		    header->sh_version != SNAPSHOT_VERSION || header->sh_len == 0) {
+			errno = ENOENT;
+			return -1;
+		}
+		return seq;
+	}
+	errno = EAGAIN;
+	return -1;
+}
+
+/**
+ * Get the generation of the content of a snapshot.
+ *
+ * @param snapshot        Snapshot opened with @c snapshot_open().
+ * @param[out] generation Generation of the current content.
+ * @return 0 on success, -1 if no snapshot is published.
+ */
+int
+snapshot_generation(struct snapshot *snapshot, u_int64_t *generation)
+{
+	volatile struct snapshot_header *header;
+	int64_t seq;
+	int retries;
+
+	for (retries = 0; retries < SNAPSHOT_RETRIES; retries++) {
+		if ((seq = snapshot_begin(snapshot)) == -1) return -1;
+		header = snapshot->s_map;
+		*generation = header->sh_generation;
+		__sync_synchronize();
+		if (header->sh_seq == seq) return 0;
+	}
+	errno = EAGAIN;
+	return -1;
+}
+
+/**
+ * Get a consistent copy of the content of a snapshot.
+ *
+ * @param snapshot        Snapshot opened with @c snapshot_open().
+ * @param[out] content    Copy of the content, to be freed by the caller.
+ * @param[out] generation Generation of the content.
+ * @return The length of the content or -1 if no snapshot is published.
+ */
+ssize_t
+snapshot_read(struct snapshot *snapshot, void **content, u_int64_t *generation)
+{
+	volatile struct snapshot_header *header;
+	void *buffer = NULL, *nbuffer;
+	size_t len, size = 0;
+	int64_t seq;
+	int retries;
+
+	for (retries = 0; retries < SNAPSHOT_RETRIES; retries++) {
+		if ((seq = snapshot_begin(snapshot)) == -1) break;
+		header = snapshot->s_map;
+		len = header->sh_len;
+		if (sizeof(*header) + len > snapshot->s_size) {
+			/* The file grew, or the length is not stable yet */
+			if (snapshot_remap(snapshot) == -1) break;
+			continue;
+		}
+		if (len > size) {
+			if ((nbuffer = realloc(buffer, len)) == NULL) break;
+			buffer = nbuffer;
+			size = len;
+		}
+		memcpy(buffer, (char *)snapshot->s_map + sizeof(*header), len);
+		*generation = header->sh_generation;
+		__sync_synchronize();
+		if (header->sh_seq != seq) continue;
+		*content = buffer;
+		return len;
+	}
+	if (retries == SNAPSHOT_RETRIES) errno = EAGAIN;
+	free(buffer);
+	return -1;
+}
+
+/* Unmap and close a snapshot file. */
+void
+snapshot_close(struct snapshot *snapshot)
+{
+	if (snapshot->s_map != NULL) munmap(snapshot->s_map, snapshot->s_size);
+	if (snapshot->s_fd != -1) close(snapshot->s_fd);
+	snapshot->s_map = NULL;
+	snapshot->s_size = 0;
+	snapshot->s_fd = -1;
+}
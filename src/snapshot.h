@@ -0,0 +1,64 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2026 Vincent Bernat <bernat@luffy.cx>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _SNAPSHOT_H
+#define _SNAPSHOT_H
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* Memory-mapped snapshot of neighbors, written by lldpd and read by local
+ * clients without going through the control socket.
+ *
+ * The file starts with a header, followed by the content: the same messages
+ * lldpd sends in answer to GET_NEIGHBORS, one for each interface and a last
+ * one without interface. Updates are protected by a sequence counter: it is
+ * odd while the content is modified and readers retry when it changed while
+ * they were copying the content. The file never shrinks, so a reader only has
+ * to map it again when the content becomes larger than its mapping. An empty
+ * content means no snapshot is published. */
+struct snapshot_header {
+	u_int32_t sh_magic;	 /* SNAPSHOT_MAGIC */
+	u_int32_t sh_version;	 /* SNAPSHOT_VERSION */
+	u_int32_t sh_seq;	 /* Sequence counter, odd during updates */
+	u_int32_t sh_reserved;	 /* Unused, 0 */
+	u_int64_t sh_generation; /* Bumped on each update */
+	u_int64_t sh_len;	 /* Length of the content */
+};
+#define SNAPSHOT_MAGIC 0x4c4c4450 /* LLDP */
+#define SNAPSHOT_VERSION 1
+
+/* Either side of a snapshot file */
+struct snapshot {
+	int s_fd;      /* File descriptor, -1 if none */
+	void *s_map;   /* Mapping of the file or NULL */
+	size_t s_size; /* Size of the mapping */
+};
+
+/* snapshot.c */
+int snapshot_update(struct snapshot *, const void *, size_t);
+int snapshot_open(struct snapshot *, const char *);
+int snapshot_generation(struct snapshot *, u_int64_t *);
+ssize_t snapshot_read(struct snapshot *, void **, u_int64_t *);
+void snapshot_close(struct snapshot *);
+
+#endif
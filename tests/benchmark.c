@@ -0,0 +1,663 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2026 Vincent Bernat <bernat@luffy.cx>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Benchmarks for encoding and decoding frames, for the reception pipeline of
+ * lldpd and for the serialization of neighbors. Run them with `make bench`.
+ *
+ * Frames for synthetic neighbors are built with the encoders of each
+ * protocol. Each benchmark is repeated until it ran long enough and its
+ * result is written on standard output as a JSON object on a line of its own:
+ * number of operations (frames or round-trips), rate and, when they can be
+ * counted, allocations for each operation.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <event2/event.h>
+
+#include "pcap-hdr.h"
+#include "../src/daemon/lldpd.h"
+
+#define BENCH_DURATION 200	/* Minimum duration of a benchmark, in ms */
+#define BENCH_NEIGHBORS "1,10,100,1000,10000,100000"
+#define BENCH_BATCH 16		/* Frames received before lldpd_recv_done() */
+#define BENCH_FRAME_SIZE 1600	/* Largest frame we can build */
+
+/* Count allocations by interposing the allocator of the C library. Only
+ * possible with the GNU C library and without sanitizers. */
+static unsigned long allocations = 0;
+#if defined(__has_feature)
+#  if __has_feature(address_sanitizer) || __has_feature(memory_sanitizer)
+#    define BENCH_SANITIZED
+#  endif
+#endif
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(BENCH_SANITIZED)
+#  define BENCH_COUNT_ALLOCATIONS
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+
+void *
+malloc(size_t size)
+{
+	allocations++;
+	return __libc_malloc(size);
+}
+
+void *
+calloc(size_t nmemb, size_t size)
+{
+	allocations++;
+	return __libc_calloc(nmemb, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+	allocations++;
+	return __libc_realloc(ptr, size);
+}
+#endif
+
+struct bench_protocol {
+	const char *name;
+	int (*send)(PROTO_SEND_SIG);
+	int (*decode)(PROTO_DECODE_SIG);
+};
+static struct bench_protocol protocols[] = {
+	{ "lldp", lldp_send, lldp_decode },
+#ifdef ENABLE_CDP
+	{ "cdp", cdpv2_send, cdp_decode },
+#endif
+#ifdef ENABLE_EDP
+	{ "edp", edp_send, edp_decode },
+#endif
+#ifdef ENABLE_SONMP
+	{ "sonmp", sonmp_send, sonmp_decode },
+#endif
+	{ NULL, NULL, NULL }
+};
+
+/* The reception pipeline only handles LLDP */
+static struct protocol pipeline_protocols[] = {
+	{ LLDPD_MODE_LLDP, 1, "LLDP", 'l', lldp_send, lldp_decode, NULL,
+	    { LLDP_ADDR_NEAREST_BRIDGE, LLDP_ADDR_NEAREST_NONTPMR_BRIDGE,
+		LLDP_ADDR_NEAREST_CUSTOMER_BRIDGE } },
+	{ 0, 0, "any", ' ', NULL, NULL, NULL, { { 0, 0, 0, 0, 0, 0 } } }
+};
+
+struct bench_frames {
+	struct bench_protocol *protocol;
+	int count;
+	size_t *lengths;
+	char **frames;
+};
+
+/* Input of a benchmark */
+struct bench_input {
+	struct bench_protocol *protocol;
+	struct bench_frames *frames;
+	struct lldpd_port **ports;
+};
+
+static double duration = BENCH_DURATION / 1000.;
+static struct pattern_set *selection = NULL;
+static int selected = 0; /* Number of selected benchmarks */
+static const char *prefix = NULL;
+
+static struct lldpd cfg;
+static struct lldpd_hardware *lhardware; /* Port sending frames */
+static struct lldpd_hardware *rhardware; /* Port receiving frames */
+static struct lldpd_chassis lchassis;
+static struct lldpd_mgmt *lmgmt;
+static char capture[BENCH_FRAME_SIZE];
+static size_t capture_len;
+
+static void
+bench_fatal(const char *message)
+{
+	fprintf(stderr, "benchmark: %s\n", message);
+	exit(1);
+}
+
+static double
+bench_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* A benchmark is selected by its name or by its group, the part of its name
+ * before the first underscore (like "pipeline"). */
+static int
+bench_selected(const char *name)
+{
+	char group[64];
+
+	if (selection == NULL) return 1;
+	strlcpy(group, name, sizeof(group));
+	group[strcspn(group, "_")] = '\0';
+	if (pattern_set_match(selection, name, PATTERN_MATCH_ALLOWED) ==
+		PATTERN_MATCH_DENIED ||
+	    pattern_set_match(selection, group, PATTERN_MATCH_ALLOWED) ==
+		PATTERN_MATCH_DENIED)
+		return 0;
+	if (pattern_set_match(selection, name, PATTERN_MATCH_DENIED) ==
+		PATTERN_MATCH_DENIED &&
+	    pattern_set_match(selection, group, PATTERN_MATCH_DENIED) ==
+		PATTERN_MATCH_DENIED)
+		return 0;
+	selected++;
+	return 1;
+}
+
+static void
+bench_report(const char *name, int neighbors, unsigned long operations,
+    double seconds, unsigned long allocated)
+{
+	printf("{\"benchmark\": \"%s\", \"neighbors\": %d, \"operations\": %lu, "
+	       "\"seconds\": %.6f, \"per_second\": %.0f, ",
+	    name, neighbors, operations, seconds, operations / seconds);
+#ifdef BENCH_COUNT_ALLOCATIONS
+	printf("\"allocations\": %.2f}\n", (double)allocated / operations);
+#else
+	printf("\"allocations\": null}\n");
+#endif
+	fflush(stdout);
+}
+
+/* Run `pass` until the minimum duration is reached. It returns the number of
+ * operations it did. */
+static void
+bench_run(const char *name, int neighbors,
+    unsigned long (*pass)(struct bench_input *), struct bench_input *input)
+{
+	unsigned long operations = 0, allocated;
+	double start, elapsed;
+
+	if (!bench_selected(name)) return;
+	fprintf(stderr, "benchmark: %s with %d neighbors\n", name, neighbors);
+	allocated = allocations;
+	start = bench_now();
+	do {
+		operations += pass(input);
+	} while ((elapsed = bench_now() - start) < duration);
+	bench_report(name, neighbors, operations, elapsed, allocations - allocated);
+}
+
+/* Only keep the first frame of a transmission */
+static int
+bench_send(struct lldpd *cfg, struct lldpd_hardware *hardware, char *buffer,
+    size_t size)
+{
+	if (capture_len > 0) return 0;
+	if (size > sizeof(capture)) bench_fatal("frame too large");
+	memcpy(capture, buffer, size);
+	capture_len = size;
+	return 0;
+}
+
+static struct lldpd_ops bench_ops = {
+	.send = bench_send,
+	.recv = NULL,
+	.cleanup = NULL,
+};
+
+static struct lldpd_hardware *
+bench_hardware(const char *name, int index)
+{
+	struct lldpd_hardware *hardware;
+
+	if ((hardware = calloc(1, sizeof(struct lldpd_hardware))) == NULL)
+		bench_fatal("unable to allocate port");
+	TAILQ_INIT(&hardware->h_rports);
+#ifdef ENABLE_DOT1
+	TAILQ_INIT(&hardware->h_lport.p_vlans);
+	TAILQ_INIT(&hardware->h_lport.p_ppvids);
+	TAILQ_INIT(&hardware->h_lport.p_pids);
+#endif
+#ifdef ENABLE_CUSTOM
+	TAILQ_INIT(&hardware->h_lport.p_custom_list);
+#endif
+	hardware->h_cfg = &cfg;
+	hardware->h_ops = &bench_ops;
+	hardware->h_flags = IFF_UP | IFF_RUNNING;
+	hardware->h_mtu = 1500;
+	hardware->h_ifindex = index;
+	strlcpy(hardware->h_ifname, name, sizeof(hardware->h_ifname));
+	return hardware;
+}
+
+static void
+bench_setup(void)
+{
+	in_addr_t addr = 0;
+
+	cfg.g_config.c_tx_interval = LLDPD_TX_INTERVAL * 1000;
+	cfg.g_config.c_tx_hold = LLDPD_TX_HOLD;
+	cfg.g_config.c_ttl = LLDPD_TX_INTERVAL * LLDPD_TX_HOLD;
+	cfg.g_config.c_platform = "Linux";
+	cfg.g_config.c_cap_advertise = 1;
+	cfg.g_config.c_mgmt_advertise = 1;
+	cfg.g_protocols = pipeline_protocols;
+	if ((cfg.g_base = event_base_new()) == NULL)
+		bench_fatal("unable to create event base");
+	TAILQ_INIT(&cfg.g_chassis);
+	TAILQ_INIT(&cfg.g_hardware);
+
+	/* The local chassis is the first one, used by both ports */
+	lchassis.c_refcount = 2;
+	TAILQ_INIT(&lchassis.c_mgmt);
+	if ((lmgmt = lldpd_alloc_mgmt(NULL, LLDPD_AF_IPV4, &addr, sizeof(addr), 0)) ==
+	    NULL)
+		bench_fatal("unable to allocate management address");
+	TAILQ_INSERT_TAIL(&lchassis.c_mgmt, lmgmt, m_entries);
+	TAILQ_INSERT_TAIL(&cfg.g_chassis, &lchassis, c_entries);
+
+	lhardware = bench_hardware("bench0", 1);
+	lhardware->h_lport.p_chassis = &lchassis;
+	rhardware = bench_hardware("bench1", 2);
+	rhardware->h_lport.p_chassis = &lchassis;
+	TAILQ_INSERT_TAIL(&cfg.g_hardware, rhardware, h_entries);
+}
+
+static void
+bench_teardown(void)
+{
+	lldpd_remote_cleanup(rhardware, NULL, 1);
+	lldpd_tx_cache_cleanup(lhardware);
+	free(lhardware->h_lchassis_previous_id);
+	free(lhardware->h_lport_previous_id);
+	free(lhardware->h_lport.p_lastframe);
+	free(lhardware);
+	free(rhardware);
+	free(lmgmt);
+	if (cfg.g_cleanup_timer) event_free(cfg.g_cleanup_timer);
+	event_base_free(cfg.g_base);
+	expiry_free(&cfg.g_expiry);
+	hash_free(&cfg.g_chassis_index);
+}
+
+/* Make the local system look like the `n`th synthetic neighbor. With
+ * `variant`, the port description is different. */
+static void
+bench_neighbor(int n, int variant)
+{
+	static char id[ETHER_ADDR_LEN], name[32], ifname[IFNAMSIZ], descr[64];
+	struct lldpd_port *port = &lhardware->h_lport;
+	in_addr_t addr = htonl(0x0a000000 | (n & 0xffffff));
+
+	id[0] = 0x02;
+	id[1] = 0;
+	id[2] = n >> 24;
+	id[3] = n >> 16;
+	id[4] = n >> 8;
+	id[5] = n;
+	snprintf(name, sizeof(name), "neighbor%d", n);
+	snprintf(ifname, sizeof(ifname), "Ethernet%d", n % 48 + 1);
+	snprintf(descr, sizeof(descr), "%s to %s", variant ? "Uplink" : "Link",
+	    name);
+
+	lchassis.c_id_subtype = LLDP_CHASSISID_SUBTYPE_LLADDR;
+	lchassis.c_id = id;
+	lchassis.c_id_len = ETHER_ADDR_LEN;
+	lchassis.c_name = name;
+	lchassis.c_descr = "Synthetic neighbor";
+	lchassis.c_cap_available = LLDP_CAP_BRIDGE | LLDP_CAP_ROUTER;
+	lchassis.c_cap_enabled = LLDP_CAP_BRIDGE;
+	memcpy(&lmgmt->m_addr, &addr, sizeof(addr));
+	lmgmt->m_iface = n % 48 + 1;
+
+	port->p_id_subtype = LLDP_PORTID_SUBTYPE_IFNAME;
+	port->p_id = ifname;
+	port->p_id_len = strlen(ifname);
+	port->p_descr = descr;
+	memcpy(lhardware->h_lladdr, id, ETHER_ADDR_LEN);
+	lhardware->h_ifindex = n % 48 + 1;
+
+	/* This is a new system, not a change of the previous one, and the last
+	 * frame cannot be reused. */
+	free(lhardware->h_lchassis_previous_id);
+	free(lhardware->h_lport_previous_id);
+	lhardware->h_lchassis_previous_id = NULL;
+	lhardware->h_lport_previous_id = NULL;
+	port->p_generation++;
+}
+
+static void
+bench_encode(struct bench_protocol *protocol)
+{
+	capture_len = 0;
+	if (protocol->send(&cfg, lhardware) != 0 || capture_len == 0)
+		bench_fatal("unable to build a frame");
+}
+
+static void
+bench_write_pcap(struct bench_frames *frames)
+{
+	struct pcap_hdr hdr = { .magic_number = 0xa1b2c3d4,
+		.version_major = 2,
+		.version_minor = 4,
+		.snaplen = 65535,
+		.network = 1 };
+	struct pcaprec_hdr rechdr = { 0 };
+	char *name;
+	FILE *output;
+	int i;
+
+	if (asprintf(&name, "%s%s-%d.pcap", prefix, frames->protocol->name,
+		frames->count) == -1)
+		bench_fatal("unable to compute file name");
+	if ((output = fopen(name, "w")) == NULL) bench_fatal("unable to open pcap");
+	fwrite(&hdr, sizeof(hdr), 1, output);
+	for (i = 0; i < frames->count; i++) {
+		rechdr.incl_len = rechdr.orig_len = frames->lengths[i];
+		fwrite(&rechdr, sizeof(rechdr), 1, output);
+		fwrite(frames->frames[i], frames->lengths[i], 1, output);
+	}
+	if (fclose(output) != 0) bench_fatal("unable to write pcap");
+	free(name);
+}
+
+/* Build frames for `count` neighbors */
+static struct bench_frames *
+bench_frames_new(struct bench_protocol *protocol, int count, int variant)
+{
+	struct bench_frames *frames;
+	int i;
+
+	if ((frames = calloc(1, sizeof(struct bench_frames))) == NULL ||
+	    (frames->lengths = calloc(count, sizeof(size_t))) == NULL ||
+	    (frames->frames = calloc(count, sizeof(char *))) == NULL)
+		bench_fatal("unable to allocate frames");
+	frames->protocol = protocol;
+	frames->count = count;
+	for (i = 0; i < count; i++) {
+		bench_neighbor(i, variant);
+		bench_encode(protocol);
+		if ((frames->frames[i] = malloc(capture_len)) == NULL)
+			bench_fatal("unable to allocate frame");
+		memcpy(frames->frames[i], capture, capture_len);
+		frames->lengths[i] = capture_len;
+	}
+	if (prefix != NULL && !variant) bench_write_pcap(frames);
+	return frames;
+}
+
+static void
+bench_frames_free(struct bench_frames *frames)
+{
+	int i;
+	for (i = 0; i < frames->count; i++)
+		free(frames->frames[i]);
+	free(frames->frames);
+	free(frames->lengths);
+	free(frames);
+}
+
+static void
+bench_free_neighbor(struct lldpd_port *port)
+{
+	struct lldpd_chassis *chassis = port->p_chassis;
+	lldpd_port_cleanup(port, 1);
+	free(port);
+	if (chassis) lldpd_chassis_cleanup(chassis, 1);
+}
+
+/* Encode the same port again, as when its content changed */
+static unsigned long
+bench_pass_encode(struct bench_input *input)
+{
+	int i;
+	for (i = 0; i < 100; i++) {
+		lhardware->h_lport.p_generation++;
+		bench_encode(input->protocol);
+	}
+	return i;
+}
+
+static unsigned long
+bench_pass_decode(struct bench_input *input)
+{
+	struct bench_frames *frames = input->frames;
+	struct lldpd_chassis *chassis;
+	struct lldpd_port *port;
+	int i;
+
+	for (i = 0; i < frames->count; i++) {
+		if (input->protocol->decode(&cfg, frames->frames[i], frames->lengths[i],
+			rhardware, &chassis, &port) == -1)
+			bench_fatal("unable to decode a frame");
+		lldpd_port_cleanup(port, 1);
+		free(port);
+		lldpd_chassis_cleanup(chassis, 1);
+	}
+	return i;
+}
+
+static unsigned long
+bench_pass_marshal(struct bench_input *input)
+{
+	struct lldpd_port *port;
+	void *buffer;
+	ssize_t len;
+	int i;
+
+	for (i = 0; i < input->frames->count; i++) {
+		buffer = NULL;
+		if ((len = lldpd_port_serialize(input->ports[i], &buffer)) <= 0 ||
+		    lldpd_port_unserialize(buffer, len, &port) <= 0)
+			bench_fatal("unable to serialize a neighbor");
+		bench_free_neighbor(port);
+		free(buffer);
+	}
+	return i;
+}
+
+static void
+bench_receive(struct bench_frames *frames)
+{
+	int i;
+	for (i = 0; i < frames->count; i++) {
+		lldpd_recv_frame(&cfg, rhardware, frames->frames[i],
+		    frames->lengths[i]);
+		if ((i + 1) % BENCH_BATCH == 0 || i + 1 == frames->count)
+			lldpd_recv_done(&cfg, rhardware);
+	}
+}
+
+/* Receive new neighbors, the same frames again, updates and remove all
+ * neighbors, as when the port goes down. Each step is measured apart. */
+static void
+bench_pipeline(struct bench_frames *frames, struct bench_frames *updates)
+{
+	static const char *names[] = { "pipeline_insert", "pipeline_duplicate",
+		"pipeline_update", "pipeline_cleanup" };
+	unsigned long allocated[4] = { 0 }, before, cycles = 0;
+	double seconds[4] = { 0 }, start, total;
+	int step;
+
+	for (step = 0; step < 4 && !bench_selected(names[step]); step++)
+		;
+	if (step == 4) return;
+	fprintf(stderr, "benchmark: pipeline with %d neighbors\n", frames->count);
+
+	do {
+		for (step = 0, total = 0; step < 4; step++) {
+			before = allocations;
+			start = bench_now();
+			switch (step) {
+			case 0:
+			case 1:
+				bench_receive(frames);
+				break;
+			case 2:
+				bench_receive(updates);
+				break;
+			case 3:
+				rhardware->h_flags = IFF_UP;
+				lldpd_cleanup(&cfg);
+				rhardware->h_flags = IFF_UP | IFF_RUNNING;
+				break;
+			}
+			seconds[step] += bench_now() - start;
+			allocated[step] += allocations - before;
+			total += seconds[step];
+			if (step == 0 &&
+			    rhardware->h_rports_msap.ht_count != frames->count)
+				bench_fatal("some neighbors were not inserted");
+		}
+		cycles++;
+	} while (total < duration);
+
+	for (step = 0; step < 4; step++)
+		if (bench_selected(names[step]))
+			bench_report(names[step], frames->count,
+			    cycles * frames->count, seconds[step], allocated[step]);
+}
+
+static void
+bench_neighbors(int count)
+{
+	struct bench_protocol *protocol;
+	struct bench_frames *frames, *updates;
+	struct bench_input input = { NULL, NULL, NULL };
+	struct lldpd_chassis *chassis;
+	char name[64];
+	int i;
+
+	for (protocol = protocols; protocol->name != NULL; protocol++) {
+		frames = bench_frames_new(protocol, count, 0);
+		input.protocol = protocol;
+		input.frames = frames;
+		snprintf(name, sizeof(name), "%s_decode", protocol->name);
+		bench_run(name, count, bench_pass_decode, &input);
+
+		if (protocol == protocols) {
+			snprintf(name, sizeof(name), "marshal_roundtrip");
+			input.ports = calloc(count, sizeof(struct lldpd_port *));
+			if (input.ports == NULL)
+				bench_fatal("unable to allocate neighbors");
+			for (i = 0; i < count; i++) {
+				if (protocol->decode(&cfg, frames->frames[i],
+					frames->lengths[i], rhardware, &chassis,
+					&input.ports[i]) == -1)
+					bench_fatal("unable to decode a frame");
+				input.ports[i]->p_chassis = chassis;
+				chassis->c_refcount++;
+			}
+			bench_run(name, count, bench_pass_marshal, &input);
+			for (i = 0; i < count; i++)
+				bench_free_neighbor(input.ports[i]);
+			free(input.ports);
+			input.ports = NULL;
+
+			updates = bench_frames_new(protocol, count, 1);
+			bench_pipeline(frames, updates);
+			bench_frames_free(updates);
+		}
+		bench_frames_free(frames);
+	}
+}
+
+static void
+usage(void)
+{
+	fprintf(stderr, "Usage:   %s [OPTIONS ...]\n", "benchmark");
+	fprintf(stderr, "Version: %s\n", PACKAGE_STRING);
+
+	fprintf(stderr, "\n");
+
+	fprintf(stderr, "-n NUMBERS  Numbers of neighbors (default: %s)\n",
+	    BENCH_NEIGHBORS);
+	fprintf(stderr, "-t MS       Minimum duration of a benchmark (default: %d)\n",
+	    BENCH_DURATION);
+	fprintf(stderr, "-b PATTERNS Only run matching benchmarks or groups\n");
+	fprintf(stderr, "-w PREFIX   Write frames to PREFIX<proto>-<n>.pcap\n");
+
+	fprintf(stderr, "\n");
+
+	fprintf(stderr, "Measure encoding, decoding and reception of frames\n");
+	fprintf(stderr, "from synthetic neighbors. Results are written on\n");
+	fprintf(stderr, "standard output as one JSON object per line.\n");
+	exit(1);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct bench_protocol *protocol;
+	struct bench_input input = { NULL, NULL, NULL };
+	char *neighbors = BENCH_NEIGHBORS, *number, *end;
+	long count;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "hn:t:b:w:")) != -1) {
+		switch (ch) {
+		case 'n':
+			neighbors = optarg;
+			break;
+		case 't':
+			duration = atoi(optarg) / 1000.;
+			break;
+		case 'b':
+			pattern_set_free(selection);
+			if ((selection = pattern_compile(optarg)) == NULL)
+				bench_fatal("no memory");
+			break;
+		case 'w':
+			prefix = optarg;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (optind != argc) usage();
+
+	bench_setup();
+
+	/* Encoding does not depend on the number of neighbors */
+	bench_neighbor(0, 0);
+	for (protocol = protocols; protocol->name != NULL; protocol++) {
+		char name[64];
+		input.protocol = protocol;
+		snprintf(name, sizeof(name), "%s_encode", protocol->name);
+		bench_run(name, 1, bench_pass_encode, &input);
+	}
+
+	if ((neighbors = strdup(neighbors)) == NULL) bench_fatal("no memory");
+	for (number = strtok(neighbors, ","); number != NULL;
+	     number = strtok(NULL, ",")) {
+		count = strtol(number, &end, 10);
+		if (*end != '\0' || count < 1 || count > 0xffffff) usage();
+		bench_neighbors(count);
+	}
+	free(neighbors);
+
+	bench_teardown();
+	if (selection != NULL && selected == 0) bench_fatal("unknown benchmark");
+	pattern_set_free(selection);
+	return 0;
+}
@@ -0,0 +1,124 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2026 Vincent Bernat <bernat@luffy.cx>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <check.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/arena.h"
+
+START_TEST(test_alloc)
+{
+	struct arena *arena = arena_new(0);
+	char *p1, *p2;
+
+	ck_assert_ptr_ne(arena, NULL);
+	p1 = arena_alloc(arena, 5);
+	p2 = arena_alloc(arena, 16);
+	ck_assert_ptr_ne(p1, NULL);
+	ck_assert_ptr_ne(p2, NULL);
+	ck_assert(p2 >= p1 + 5);
+	ck_assert_int_eq((uintptr_t)p2 % sizeof(void *), 0);
+	ck_assert_int_eq(p2[0] | p2[15], 0);
+	memset(p1, 'x', 5);
+	memset(p2, 'y', 16);
+	arena_release(arena);
+}
+END_TEST
+
+START_TEST(test_grow)
+{
+	struct arena *arena = arena_new(100);
+	char *p[100];
+	size_t i, j;
+
+	ck_assert_ptr_ne(arena, NULL);
+	/* Allocations larger than the chunks and many small ones */
+	ck_assert_ptr_ne(arena_alloc(arena, 10000), NULL);
+	for (i = 0; i < 100; i++) {
+		p[i] = arena_alloc(arena, 100);
+		ck_assert_ptr_ne(p[i], NULL);
+		for (j = 0; j < 100; j++) ck_assert_int_eq(p[i][j], 0);
+		memset(p[i], i, 100);
+	}
+	for (i = 0; i < 100; i++)
+		for (j = 0; j < 100; j++) ck_assert_int_eq(p[i][j], (char)i);
+	arena_release(arena);
+}
+END_TEST
+
+START_TEST(test_ref)
+{
+	struct arena *arena = arena_new(0);
+	char *p;
+
+	ck_assert_ptr_ne(arena, NULL);
+	ck_assert_ptr_eq(arena_ref(arena), arena);
+	p = arena_alloc(arena, 10);
+	arena_release(arena);
+	/* Still usable with the remaining reference */
+	memset(p, 'x', 10);
+	ck_assert_ptr_ne(arena_alloc(arena, 10), NULL);
+	arena_release(arena);
+	arena_release(NULL);
+	ck_assert_ptr_eq(arena_ref(NULL), NULL);
+}
+END_TEST
+
+START_TEST(test_asprintf)
+{
+	struct arena *arena = arena_new(0);
+	char *s;
+
+	ck_assert_ptr_ne(arena, NULL);
+	ck_assert_int_eq(arena_asprintf(arena, &s, "port %d/%d", 1, 12), 9);
+	ck_assert_str_eq(s, "port 1/12");
+	arena_release(arena);
+
+	/* Without arena, the result is freed as usual */
+	ck_assert_int_eq(arena_asprintf(NULL, &s, "VLAN #%d", 100), 9);
+	ck_assert_str_eq(s, "VLAN #100");
+	free(s);
+}
+END_TEST
+
+Suite *
+arena_suite(void)
+{
+	Suite *s = suite_create("Arena allocator");
+
+	TCase *tc_arena = tcase_create("Arena");
+	tcase_add_test(tc_arena, test_alloc);
+	tcase_add_test(tc_arena, test_grow);
+	tcase_add_test(tc_arena, test_ref);
+	tcase_add_test(tc_arena, test_asprintf);
+	suite_add_tcase(s, tc_arena);
+
+	return s;
+}
+
+int
+main()
+{
+	int number_failed;
+	Suite *s = arena_suite();
+	SRunner *sr = srunner_create(s);
+	srunner_run_all(sr, CK_ENV);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
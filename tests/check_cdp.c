@@ -117,7 +117,7 @@ Cisco Discovery Protocol
 	chassis.c_cap_available = chassis.c_cap_enabled = LLDP_CAP_ROUTER;
 	TAILQ_INIT(&chassis.c_mgmt);
 	addr = inet_addr("172.17.142.37");
-	mgmt = lldpd_alloc_mgmt(LLDPD_AF_IPV4, &addr, sizeof(in_addr_t), 0);
+	mgmt = lldpd_alloc_mgmt(NULL, LLDPD_AF_IPV4, &addr, sizeof(in_addr_t), 0);
 	if (mgmt == NULL) ck_abort();
 	TAILQ_INSERT_TAIL(&chassis.c_mgmt, mgmt, m_entries);
 
@@ -241,8 +241,8 @@ Cisco Discovery Protocol
 	TAILQ_INIT(&chassis.c_mgmt);
 	addr1 = inet_addr("172.17.142.36");
 	addr2 = inet_addr("172.17.142.38");
-	mgmt1 = lldpd_alloc_mgmt(LLDPD_AF_IPV4, &addr1, sizeof(in_addr_t), 0);
-	mgmt2 = lldpd_alloc_mgmt(LLDPD_AF_IPV4, &addr2, sizeof(in_addr_t), 0);
+	mgmt1 = lldpd_alloc_mgmt(NULL, LLDPD_AF_IPV4, &addr1, sizeof(in_addr_t), 0);
+	mgmt2 = lldpd_alloc_mgmt(NULL, LLDPD_AF_IPV4, &addr2, sizeof(in_addr_t), 0);
 	if (mgmt1 == NULL || mgmt2 == NULL) ck_abort();
 	TAILQ_INSERT_TAIL(&chassis.c_mgmt, mgmt1, m_entries);
 	TAILQ_INSERT_TAIL(&chassis.c_mgmt, mgmt2, m_entries);
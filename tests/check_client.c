@@ -0,0 +1,216 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2026 Vincent Bernat <bernat@luffy.cx>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <check.h>
+
+#include "../src/daemon/lldpd.h"
+
+/* Protocols of the neighbors of the test interface, in order */
+static const int protocols[] = { LLDPD_MODE_CDPV2, LLDPD_MODE_LLDP,
+	LLDPD_MODE_LLDP, LLDPD_MODE_CDPV2, LLDPD_MODE_LLDP, LLDPD_MODE_CDPV2 };
+#define NPORTS (sizeof(protocols) / sizeof(protocols[0]))
+
+static struct lldpd cfg;
+static struct lldpd_hardware hardware;
+static struct lldpd_chassis chassis;
+static struct lldpd_port ports[NPORTS];
+
+/* Answer received for a GET_NEIGHBORS request */
+struct answer {
+	int records; /* Records with an interface */
+	int ended;   /* Final record received */
+	int nports;
+	char *descr[NPORTS]; /* Descriptions of received neighbors */
+};
+
+static void
+setup(void)
+{
+	static char descr[NPORTS][8];
+	unsigned i;
+
+	memset(&cfg, 0, sizeof(cfg));
+	memset(&hardware, 0, sizeof(hardware));
+	memset(&chassis, 0, sizeof(chassis));
+	memset(ports, 0, sizeof(ports));
+	TAILQ_INIT(&cfg.g_hardware);
+	TAILQ_INIT(&hardware.h_rports);
+	strlcpy(hardware.h_ifname, "eth0", sizeof(hardware.h_ifname));
+	TAILQ_INSERT_TAIL(&cfg.g_hardware, &hardware, h_entries);
+	for (i = 0; i < NPORTS; i++) {
+		snprintf(descr[i], sizeof(descr[i]), "port%u", i);
+		ports[i].p_protocol = protocols[i];
+		ports[i].p_descr = descr[i];
+		ports[i].p_chassis = &chassis;
+		TAILQ_INSERT_TAIL(&hardware.h_rports, &ports[i], p_entries);
+	}
+}
+
+static ssize_t
+collect(void *out, int type, void *buffer, size_t len)
+{
+	struct answer *answer = out;
+	struct lldpd_neighbors_record *record;
+	struct lldpd_chassis *rchassis = NULL;
+	struct lldpd_port *port;
+
+	ck_assert_int_eq(type, GET_NEIGHBORS);
+	ck_assert_int_eq(answer->ended, 0);
+	ck_assert_int_gt(lldpd_neighbors_record_unserialize(buffer, len, &record), 0);
+	if (record->hardware == NULL) {
+		answer->ended = 1;
+		free(record);
+		return len;
+	}
+	answer->records++;
+	ck_assert_str_eq(record->hardware->h_ifname, "eth0");
+	TAILQ_FOREACH (port, &record->hardware->h_rports, p_entries) {
+		ck_assert_int_lt(answer->nports, NPORTS);
+		answer->descr[answer->nports++] = strdup(port->p_descr);
+		/* The chassis shared by all neighbors is received once */
+		if (rchassis != NULL) ck_assert_ptr_eq(port->p_chassis, rchassis);
+		rchassis = port->p_chassis;
+	}
+	lldpd_remote_cleanup(record->hardware, NULL, 1);
+	lldpd_port_cleanup(&record->hardware->h_lport, 1);
+	if (rchassis != NULL) lldpd_chassis_cleanup(rchassis, 1);
+	free(record->hardware);
+	free(record);
+	return len;
+}
+
+/* Request neighbors with the given protocol and check the expected ones are
+ * received, in order. The daemon list should be left untouched. */
+static void
+check_neighbors(int protocol)
+{
+	struct lldpd_neighbors_filter filter = { .protocol = protocol };
+	struct answer answer = {};
+	struct lldpd_port *port;
+	void *input = NULL;
+	ssize_t len;
+	unsigned i;
+	int n = 0;
+
+	len = lldpd_neighbors_filter_serialize(&filter, &input);
+	ck_assert_int_gt(len, 0);
+	ck_assert_int_gt(
+	    client_handle_client(&cfg, collect, &answer, GET_NEIGHBORS, input, len,
+		NULL),
+	    0);
+	free(input);
+	ck_assert_int_eq(answer.ended, 1);
+	ck_assert_int_eq(answer.records, 1);
+	for (i = 0; i < NPORTS; i++) {
+		if (protocol != 0 && protocols[i] != protocol) continue;
+		ck_assert_int_lt(n, answer.nports);
+		ck_assert_str_eq(answer.descr[n], ports[i].p_descr);
+		free(answer.descr[n++]);
+	}
+	ck_assert_int_eq(n, answer.nports);
+
+	i = 0;
+	TAILQ_FOREACH (port, &hardware.h_rports, p_entries)
+		ck_assert_ptr_eq(port, &ports[i++]);
+	ck_assert_int_eq(i, NPORTS);
+	ck_assert_ptr_eq(hardware.h_rports.tqh_last,
+	    &ports[NPORTS - 1].p_entries.tqe_next);
+}
+
+START_TEST(test_all_neighbors)
+{
+	check_neighbors(0);
+}
+END_TEST
+
+START_TEST(test_protocol_neighbors)
+{
+	check_neighbors(LLDPD_MODE_LLDP);
+	check_neighbors(LLDPD_MODE_CDPV2);
+}
+END_TEST
+
+START_TEST(test_no_neighbors)
+{
+	check_neighbors(LLDPD_MODE_EDP);
+}
+END_TEST
+
+START_TEST(test_generation)
+{
+	u_int64_t *counters[] = { &hardware.h_tx_cnt, &hardware.h_rx_cnt,
+		&hardware.h_rx_discarded_cnt, &hardware.h_rx_unrecognized_cnt,
+		&hardware.h_ageout_cnt, &hardware.h_insert_cnt,
+		&hardware.h_delete_cnt, &hardware.h_drop_cnt };
+	u_int32_t generation;
+	unsigned i;
+
+	hardware.h_lport.p_chassis = &chassis;
+	generation = lldpd_hardware_generation(&hardware);
+	ck_assert_uint_eq(lldpd_hardware_generation(&hardware), generation);
+
+	/* Each counter, local port and chassis changes are detected once */
+	for (i = 0; i < sizeof(counters) / sizeof(counters[0]); i++) {
+		(*counters[i])++;
+		ck_assert_uint_eq(lldpd_hardware_generation(&hardware), ++generation);
+		ck_assert_uint_eq(lldpd_hardware_generation(&hardware), generation);
+	}
+	hardware.h_lport.p_generation++;
+	ck_assert_uint_eq(lldpd_hardware_generation(&hardware), ++generation);
+	ck_assert_uint_eq(lldpd_hardware_generation(&hardware), generation);
+	chassis.c_generation++;
+	ck_assert_uint_eq(lldpd_hardware_generation(&hardware), ++generation);
+	ck_assert_uint_eq(lldpd_hardware_generation(&hardware), generation);
+
+	/* Changes cancelling each other are detected too */
+	hardware.h_tx_cnt++;
+	hardware.h_rx_cnt--;
+	ck_assert_uint_eq(lldpd_hardware_generation(&hardware), ++generation);
+}
+END_TEST
+
+Suite *
+client_suite(void)
+{
+	Suite *s = suite_create("Client requests");
+
+	TCase *tc_neighbors = tcase_create("Neighbors filter");
+	tcase_add_checked_fixture(tc_neighbors, setup, NULL);
+	tcase_add_test(tc_neighbors, test_all_neighbors);
+	tcase_add_test(tc_neighbors, test_protocol_neighbors);
+	tcase_add_test(tc_neighbors, test_no_neighbors);
+	suite_add_tcase(s, tc_neighbors);
+
+	TCase *tc_generation = tcase_create("Interface generation");
+	tcase_add_checked_fixture(tc_generation, setup, NULL);
+	tcase_add_test(tc_generation, test_generation);
+	suite_add_tcase(s, tc_generation);
+
+	return s;
+}
+
+int
+main()
+{
+	int number_failed;
+	Suite *s = client_suite();
+	SRunner *sr = srunner_create(s);
+	srunner_run_all(sr, CK_ENV);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
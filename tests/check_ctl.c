@@ -0,0 +1,179 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2026 Vincent Bernat <bernat@luffy.cx>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <check.h>
+
+#include "../src/daemon/lldpd.h"
+
+/* Build a filter whose serialization spans several chunks. */
+static struct lldpd_neighbors_filter *
+large_filter(size_t len)
+{
+	struct lldpd_neighbors_filter *filter = calloc(1, sizeof(*filter));
+	ck_assert_ptr_ne(filter, NULL);
+	filter->ifnames = malloc(len + 1);
+	ck_assert_ptr_ne(filter->ifnames, NULL);
+	memset(filter->ifnames, 'e', len);
+	filter->ifnames[len] = '\0';
+	filter->protocol = 42;
+	return filter;
+}
+
+static void
+free_filter(struct lldpd_neighbors_filter *filter)
+{
+	free(filter->ifnames);
+	free(filter);
+}
+
+START_TEST(test_single_chunk)
+{
+	struct lldpd_neighbors_filter source = { .ifnames = "eth0", .protocol = 1 };
+	struct lldpd_neighbors_filter *destination = NULL;
+	uint8_t *buffer = NULL;
+	size_t len = 0;
+
+	ck_assert_int_eq(ctl_msg_send_unserialized(&buffer, &len, GET_NEIGHBORS,
+			     &source, &MARSHAL_INFO(lldpd_neighbors_filter)),
+	    0);
+	ck_assert_int_eq(((struct hmsg_header *)buffer)->flags, 0);
+	ck_assert_int_eq(ctl_msg_recv_unserialized(&buffer, &len, GET_NEIGHBORS,
+			     (void **)&destination,
+			     &MARSHAL_INFO(lldpd_neighbors_filter)),
+	    0);
+	ck_assert_ptr_eq(buffer, NULL);
+	ck_assert_int_eq(len, 0);
+	ck_assert_str_eq(destination->ifnames, "eth0");
+	ck_assert_int_eq(destination->protocol, 1);
+	free(destination->ifnames);
+	free(destination);
+}
+END_TEST
+
+START_TEST(test_several_chunks)
+{
+	struct lldpd_neighbors_filter *source = large_filter(3 * HMSG_MAX_SIZE);
+	struct lldpd_neighbors_filter *destination = NULL;
+	struct hmsg_header hdr;
+	uint8_t *buffer = NULL, *input = NULL;
+	size_t len = 0, input_len = 0, offset = 0, needed;
+	int chunks = 0;
+
+	ck_assert_int_eq(ctl_msg_send_unserialized(&buffer, &len, GET_NEIGHBORS,
+			     source, &MARSHAL_INFO(lldpd_neighbors_filter)),
+	    0);
+	/* Check the framing */
+	do {
+		memcpy(&hdr, buffer + offset, sizeof(hdr));
+		ck_assert_int_eq(hdr.type, GET_NEIGHBORS);
+		ck_assert(hdr.len <= HMSG_MAX_SIZE);
+		offset += sizeof(hdr) + hdr.len;
+		chunks++;
+	} while (hdr.flags & HMSG_MORE);
+	ck_assert_uint_eq(offset, len);
+	ck_assert_int_eq(chunks, 4);
+
+	/* Feed the receiver with what it asks, like liblldpctl does */
+	offset = 0;
+	while ((needed = ctl_msg_recv_unserialized(&input, &input_len,
+		    GET_NEIGHBORS, (void **)&destination,
+		    &MARSHAL_INFO(lldpd_neighbors_filter))) > 0 &&
+	    needed != (size_t)-1) {
+		ck_assert(offset + needed <= len);
+		input = realloc(input, input_len + needed);
+		ck_assert_ptr_ne(input, NULL);
+		memcpy(input + input_len, buffer + offset, needed);
+		input_len += needed;
+		offset += needed;
+	}
+	ck_assert_int_eq(needed, 0);
+	ck_assert_uint_eq(offset, len);
+	ck_assert_ptr_eq(input, NULL);
+	ck_assert_str_eq(destination->ifnames, source->ifnames);
+	ck_assert_int_eq(destination->protocol, 42);
+	free(destination->ifnames);
+	free(destination);
+	free_filter(source);
+	free(buffer);
+}
+END_TEST
+
+START_TEST(test_trailing_message)
+{
+	struct lldpd_neighbors_filter *source = large_filter(HMSG_MAX_SIZE);
+	uint8_t *buffer = NULL;
+	size_t len = 0;
+
+	ck_assert_int_eq(ctl_msg_send_unserialized(&buffer, &len, GET_NEIGHBORS,
+			     source, &MARSHAL_INFO(lldpd_neighbors_filter)),
+	    0);
+	ck_assert_int_eq(ctl_msg_send_unserialized(&buffer, &len, NONE, NULL, NULL),
+	    0);
+	/* Not the expected message: it is discarded */
+	ck_assert_int_eq(ctl_msg_recv_unserialized(&buffer, &len, GET_INTERFACES,
+			     NULL, NULL),
+	    -1);
+	ck_assert_uint_eq(len, sizeof(struct hmsg_header));
+	ck_assert_int_eq(ctl_msg_recv_unserialized(&buffer, &len, NONE, NULL, NULL),
+	    0);
+	ck_assert_ptr_eq(buffer, NULL);
+	free_filter(source);
+}
+END_TEST
+
+START_TEST(test_too_large_chunk)
+{
+	struct hmsg_header hdr = { .type = GET_NEIGHBORS,
+		.len = HMSG_MAX_SIZE + 1 };
+	uint8_t *buffer = malloc(sizeof(hdr));
+	size_t len = sizeof(hdr);
+
+	ck_assert_ptr_ne(buffer, NULL);
+	memcpy(buffer, &hdr, sizeof(hdr));
+	ck_assert_int_eq(ctl_msg_recv_unserialized(&buffer, &len, GET_NEIGHBORS,
+			     NULL, NULL),
+	    -1);
+	ck_assert_ptr_eq(buffer, NULL);
+	ck_assert_int_eq(len, 0);
+}
+END_TEST
+
+Suite *
+ctl_suite(void)
+{
+	Suite *s = suite_create("Control protocol");
+
+	TCase *tc_ctl = tcase_create("Framing");
+	tcase_add_test(tc_ctl, test_single_chunk);
+	tcase_add_test(tc_ctl, test_several_chunks);
+	tcase_add_test(tc_ctl, test_trailing_message);
+	tcase_add_test(tc_ctl, test_too_large_chunk);
+	suite_add_tcase(s, tc_ctl);
+
+	return s;
+}
+
+int
+main()
+{
+	int number_failed;
+	Suite *s = ctl_suite();
+	SRunner *sr = srunner_create(s);
+	srunner_run_all(sr, CK_ENV);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
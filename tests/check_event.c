@@ -0,0 +1,506 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2026 Vincent Bernat <bernat@luffy.cx>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <check.h>
+#include <sys/socket.h>
+
+/* Notification of changes is internal to the event loop */
+#include "../src/daemon/event.c"
+#include "../src/lib/lldpctl.h"
+
+#define NNEIGHBORS 3
+
+static struct lldpd cfg;
+static struct lldpd_one_client *client, *full_client;
+static int peer = -1, full_peer = -1; /* Client side of the connections */
+static struct lldpd_chassis chassis[NNEIGHBORS];
+static struct lldpd_port ports[NNEIGHBORS];
+
+/* Connect a new client subscribed to changes. */
+static struct lldpd_one_client *
+add_client(int *peer_fd)
+{
+	struct lldpd_one_client *new;
+	int fds[2];
+
+	ck_assert_int_eq(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+	*peer_fd = fds[1];
+	ck_assert_int_eq(levent_make_socket_nonblocking(fds[1]), 0);
+	ck_assert_int_eq(levent_make_socket_nonblocking(fds[0]), 0);
+	new = calloc(1, sizeof(struct lldpd_one_client));
+	ck_assert_ptr_ne(new, NULL);
+	new->cfg = &cfg;
+	TAILQ_INIT(&new->batch.changes);
+	new->subscription.subscribed = 1;
+	TAILQ_INSERT_TAIL(&lldpd_clients, new, next);
+	new->bev = bufferevent_socket_new(cfg.g_base, fds[0], BEV_OPT_CLOSE_ON_FREE);
+	ck_assert_ptr_ne(new->bev, NULL);
+	bufferevent_enable(new->bev, EV_READ | EV_WRITE);
+	return new;
+}
+
+static void
+setup(void)
+{
+	static char cids[NNEIGHBORS][8], pids[NNEIGHBORS][8];
+	int i;
+
+	memset(&cfg, 0, sizeof(cfg));
+	memset(chassis, 0, sizeof(chassis));
+	memset(ports, 0, sizeof(ports));
+	for (i = 0; i < NNEIGHBORS; i++) {
+		snprintf(cids[i], sizeof(cids[i]), "chassis%d", i);
+		snprintf(pids[i], sizeof(pids[i]), "port%d", i);
+		chassis[i].c_id_subtype = LLDP_CHASSISID_SUBTYPE_LOCAL;
+		chassis[i].c_id = cids[i];
+		chassis[i].c_id_len = strlen(cids[i]);
+		ports[i].p_protocol = LLDPD_MODE_LLDP;
+		ports[i].p_id_subtype = LLDP_PORTID_SUBTYPE_LOCAL;
+		ports[i].p_id = pids[i];
+		ports[i].p_id_len = strlen(pids[i]);
+		ports[i].p_descr = "initial";
+		ports[i].p_chassis = &chassis[i];
+	}
+
+	ck_assert_ptr_ne(cfg.g_base = event_base_new(), NULL);
+	TAILQ_INIT(&lldpd_clients);
+	client = add_client(&peer);
+	client->subscription.window = 10;
+	client->subscription.queue = 10;
+}
+
+static void
+teardown(void)
+{
+	levent_ctl_close_clients();
+	close(peer);
+	if (full_peer != -1) close(full_peer);
+	full_peer = -1;
+	event_base_free(cfg.g_base);
+}
+
+/* Run the event loop until the client receives coalesced changes. */
+static struct lldpd_neighbor_changes *
+receive_changes(void)
+{
+	struct lldpd_neighbor_changes *changes;
+	uint8_t buffer[4096];
+	size_t len = 0, consumed;
+	ssize_t nb;
+	void *p;
+
+	for (;;) {
+		ck_assert_int_ne(event_base_loop(cfg.g_base, EVLOOP_ONCE), -1);
+		while ((nb = read(peer, buffer + len, sizeof(buffer) - len)) > 0)
+			len += nb;
+		if (len == 0) continue;
+		if (ctl_msg_parse_unserialized(buffer, len, NOTIFICATIONS, &p,
+			&MARSHAL_INFO(lldpd_neighbor_changes), &consumed) == 0)
+			break;
+	}
+	ck_assert_int_eq(consumed, len);
+	changes = p;
+	return changes;
+}
+
+static void
+free_changes(struct lldpd_neighbor_changes *changes)
+{
+	struct lldpd_neighbor_change *change, *change_next, *other;
+
+	for (change = TAILQ_FIRST(&changes->changes); change; change = change_next) {
+		change_next = TAILQ_NEXT(change, c_entries);
+		/* A chassis is received once for all its changes */
+		for (other = change_next; other; other = TAILQ_NEXT(other, c_entries))
+			if (other->neighbor->p_chassis == change->neighbor->p_chassis)
+				break;
+		if (other == NULL) lldpd_chassis_cleanup(change->neighbor->p_chassis, 1);
+		lldpd_port_cleanup(change->neighbor, 1);
+		free(change->neighbor);
+		free(change->ifname);
+		free(change);
+	}
+	free(changes);
+}
+
+START_TEST(test_merge_changes)
+{
+	struct lldpd_neighbor_changes *changes;
+	struct lldpd_neighbor_change *change;
+
+	/* Added, then updated twice: still a new neighbor for the client */
+	levent_ctl_notify("eth0", NEIGHBOR_CHANGE_ADDED, &ports[0], 0);
+	ports[0].p_descr = "first";
+	levent_ctl_notify("eth0", NEIGHBOR_CHANGE_UPDATED, &ports[0], 0);
+	ports[0].p_descr = "second";
+	levent_ctl_notify("eth0", NEIGHBOR_CHANGE_UPDATED, &ports[0], 0);
+	ck_assert_int_eq(client->batch_count, 1);
+
+	/* Same neighbor on another interface */
+	levent_ctl_notify("eth1", NEIGHBOR_CHANGE_UPDATED, &ports[0], 0);
+	ck_assert_int_eq(client->batch_count, 2);
+
+	/* Deleted, then added again: updated */
+	levent_ctl_notify("eth0", NEIGHBOR_CHANGE_DELETED, &ports[1], 0);
+	levent_ctl_notify("eth0", NEIGHBOR_CHANGE_ADDED, &ports[1], 0);
+	ck_assert_int_eq(client->batch_count, 3);
+
+	/* Added, then deleted: never heard of */
+	levent_ctl_notify("eth0", NEIGHBOR_CHANGE_ADDED, &ports[2], 0);
+	levent_ctl_notify("eth0", NEIGHBOR_CHANGE_DELETED, &ports[2], 0);
+	ck_assert_int_eq(client->batch_count, 3);
+
+	ck_assert_int_eq(evtimer_pending(client->batch_timer, NULL), 1);
+	changes = receive_changes();
+	ck_assert_int_eq(changes->overflow, 0);
+	change = TAILQ_FIRST(&changes->changes);
+	ck_assert_ptr_ne(change, NULL);
+	ck_assert_str_eq(change->ifname, "eth0");
+	ck_assert_int_eq(change->state, NEIGHBOR_CHANGE_ADDED);
+	ck_assert_str_eq(change->neighbor->p_descr, "second");
+	change = TAILQ_NEXT(change, c_entries);
+	ck_assert_ptr_ne(change, NULL);
+	ck_assert_str_eq(change->ifname, "eth1");
+	ck_assert_int_eq(change->state, NEIGHBOR_CHANGE_UPDATED);
+	change = TAILQ_NEXT(change, c_entries);
+	ck_assert_ptr_ne(change, NULL);
+	ck_assert_str_eq(change->ifname, "eth0");
+	ck_assert_int_eq(change->neighbor->p_id_len, 5);
+	ck_assert_int_eq(memcmp(change->neighbor->p_id, "port1", 5), 0);
+	ck_assert_int_eq(change->state, NEIGHBOR_CHANGE_UPDATED);
+	ck_assert_ptr_eq(TAILQ_NEXT(change, c_entries), NULL);
+	free_changes(changes);
+
+	/* Nothing is left for the next window */
+	ck_assert_int_eq(client->batch_count, 0);
+	ck_assert_ptr_eq(TAILQ_FIRST(&client->batch.changes), NULL);
+	ck_assert_int_eq(evtimer_pending(client->batch_timer, NULL), 0);
+}
+END_TEST
+
+START_TEST(test_overflow)
+{
+	struct lldpd_neighbor_changes *changes;
+	struct lldpd_neighbor_change *change;
+	int i = 0;
+
+	client->subscription.queue = 2;
+	levent_ctl_notify("eth0", NEIGHBOR_CHANGE_ADDED, &ports[0], 0);
+	levent_ctl_notify("eth0", NEIGHBOR_CHANGE_ADDED, &ports[1], 0);
+	levent_ctl_notify("eth0", NEIGHBOR_CHANGE_ADDED, &ports[2], 0);
+	ck_assert_int_eq(client->batch_count, 2);
+	ck_assert_int_eq(client->batch.overflow, 1);
+	/* Changes of queued neighbors are still merged */
+	levent_ctl_notify("eth0", NEIGHBOR_CHANGE_UPDATED, &ports[1], 0);
+	ck_assert_int_eq(client->batch_count, 2);
+
+	changes = receive_changes();
+	ck_assert_int_eq(changes->overflow, 1);
+	TAILQ_FOREACH (change, &changes->changes, c_entries) {
+		ck_assert_int_eq(change->neighbor->p_id_len, ports[i].p_id_len);
+		ck_assert_int_eq(memcmp(change->neighbor->p_id, ports[i].p_id,
+				     ports[i].p_id_len),
+		    0);
+		i++;
+	}
+	ck_assert_int_eq(i, 2);
+	free_changes(changes);
+
+	/* The client has been told, the next window starts afresh */
+	ck_assert_int_eq(client->batch.overflow, 0);
+	levent_ctl_notify("eth0", NEIGHBOR_CHANGE_DELETED, &ports[2], 0);
+	changes = receive_changes();
+	ck_assert_int_eq(changes->overflow, 0);
+	free_changes(changes);
+}
+END_TEST
+
+START_TEST(test_slow_client)
+{
+	struct evbuffer *output = bufferevent_get_output(client->bev);
+	struct lldpd_neighbor_changes *changes;
+	struct lldpd_neighbor_change *change;
+	uint8_t buffer[4096];
+	void *backlog;
+	size_t len, size = LEVENT_CTL_BACKLOG + 1;
+	ssize_t nb;
+
+	levent_ctl_notify("eth0", NEIGHBOR_CHANGE_ADDED, &ports[0], 0);
+
+	/* The client did not read what was sent before */
+	backlog = calloc(1, size);
+	ck_assert_ptr_ne(backlog, NULL);
+	ck_assert_int_eq(evbuffer_add(output, backlog, size), 0);
+	free(backlog);
+	len = evbuffer_get_length(output);
+	evtimer_del(client->batch_timer);
+	levent_ctl_flush(-1, 0, client);
+	ck_assert_int_eq(evbuffer_get_length(output), len);
+	ck_assert_int_eq(client->batch_count, 1);
+	ck_assert_int_eq(evtimer_pending(client->batch_timer, NULL), 1);
+
+	/* Changes keep being coalesced meanwhile */
+	levent_ctl_notify("eth0", NEIGHBOR_CHANGE_DELETED, &ports[1], 0);
+	ck_assert_int_eq(client->batch_count, 2);
+
+	/* Once the client caught up, they are sent on a next timer */
+	while (size > 0) {
+		ck_assert_int_ne(event_base_loop(cfg.g_base, EVLOOP_NONBLOCK), -1);
+		while (size > 0 &&
+		    (nb = read(peer, buffer,
+			 size < sizeof(buffer) ? size : sizeof(buffer))) > 0)
+			size -= nb;
+	}
+	changes = receive_changes();
+	ck_assert_int_eq(changes->overflow, 0);
+	change = TAILQ_FIRST(&changes->changes);
+	ck_assert_ptr_ne(change, NULL);
+	ck_assert_int_eq(change->state, NEIGHBOR_CHANGE_ADDED);
+	change = TAILQ_NEXT(change, c_entries);
+	ck_assert_ptr_ne(change, NULL);
+	ck_assert_int_eq(change->state, NEIGHBOR_CHANGE_DELETED);
+	ck_assert_ptr_eq(TAILQ_NEXT(change, c_entries), NULL);
+	free_changes(changes);
+	ck_assert_int_eq(client->batch_count, 0);
+}
+END_TEST
+
+/* Data received by liblldpctl through the custom callbacks */
+static uint8_t *pending;
+static size_t pending_len;
+
+static ssize_t
+lib_send(lldpctl_conn_t *conn, const uint8_t *data, size_t length, void *user_data)
+{
+	return length;
+}
+
+static ssize_t
+lib_recv(lldpctl_conn_t *conn, const uint8_t *data, size_t length, void *user_data)
+{
+	if (pending_len == 0) return LLDPCTL_ERR_WOULDBLOCK;
+	if (length > pending_len) length = pending_len;
+	memcpy((uint8_t *)data, pending, length);
+	memmove(pending, pending + length, pending_len - length);
+	pending_len -= length;
+	return length;
+}
+
+/* Keep the last notified neighbor */
+static void
+lib_watch(lldpctl_change_t type, lldpctl_atom_t *interface,
+    lldpctl_atom_t *neighbor, void *data)
+{
+	lldpctl_atom_t **last = data;
+
+	lldpctl_atom_dec_ref(*last);
+	lldpctl_atom_inc_ref(neighbor);
+	*last = neighbor;
+}
+
+/* Subscribe to changes with liblldpctl. */
+static lldpctl_conn_t *
+lib_subscribe(int delta, lldpctl_atom_t **last)
+{
+	lldpctl_conn_t *conn;
+
+	ck_assert_int_eq(ctl_msg_send_unserialized(&pending, &pending_len,
+			     SUBSCRIBE, NULL, NULL),
+	    0);
+	conn = lldpctl_new(lib_send, lib_recv, NULL);
+	ck_assert_ptr_ne(conn, NULL);
+	ck_assert_int_eq(lldpctl_watch_delta(conn, delta), 0);
+	ck_assert_int_eq(lldpctl_watch_callback2(conn, lib_watch, last), 0);
+	ck_assert_int_eq(pending_len, 0);
+	free(pending);
+	pending = NULL;
+	return conn;
+}
+
+/* Give the notification sent to a client to liblldpctl. */
+static void
+lib_notify(lldpctl_conn_t *conn, int fd)
+{
+	uint8_t buffer[4096];
+	size_t len = 0, consumed;
+	ssize_t nb;
+
+	for (;;) {
+		ck_assert_int_ne(event_base_loop(cfg.g_base, EVLOOP_NONBLOCK), -1);
+		while ((nb = read(fd, buffer + len, sizeof(buffer) - len)) > 0)
+			len += nb;
+		if (len > 0 &&
+		    ctl_msg_parse_unserialized(buffer, len, NOTIFICATION, NULL, NULL,
+			&consumed) == 0)
+			break;
+	}
+	ck_assert_int_eq(consumed, len);
+	ck_assert_int_ge(lldpctl_recv(conn, buffer, len), 0);
+}
+
+/* Describe a neighbor. When a previous version is provided, sections omitted
+ * from the neighbor are taken from it. */
+static void
+describe(lldpctl_atom_t *neighbor, lldpctl_atom_t *previous, char *out, size_t len)
+{
+	long unchanged = lldpctl_atom_get_int(neighbor, lldpctl_k_port_unchanged);
+	lldpctl_atom_t *chassis, *list, *item;
+	const char *name, *descr;
+
+	ck_assert(previous != NULL || unchanged == 0);
+	chassis = (unchanged & LLDPCTL_UNCHANGED_CHASSIS) ? previous : neighbor;
+	name = lldpctl_atom_get_str(chassis, lldpctl_k_chassis_name);
+	descr = lldpctl_atom_get_str(chassis, lldpctl_k_chassis_descr);
+	snprintf(out, len, "port %s, chassis %s (%s)",
+	    lldpctl_atom_get_str(neighbor, lldpctl_k_port_descr), name ? name : "",
+	    descr ? descr : "");
+
+	list = lldpctl_atom_get(
+	    (unchanged & LLDPCTL_UNCHANGED_VLANS) ? previous : neighbor,
+	    lldpctl_k_port_vlans);
+	lldpctl_atom_foreach(list, item)
+	{
+		snprintf(out + strlen(out), len - strlen(out), ", vlan %ld (%s)",
+		    lldpctl_atom_get_int(item, lldpctl_k_vlan_id),
+		    lldpctl_atom_get_str(item, lldpctl_k_vlan_name));
+	}
+	lldpctl_atom_dec_ref(list);
+
+	list = lldpctl_atom_get(
+	    (unchanged & LLDPCTL_UNCHANGED_CUSTOM) ? previous : neighbor,
+	    lldpctl_k_custom_tlvs);
+	lldpctl_atom_foreach(list, item)
+	{
+		snprintf(out + strlen(out), len - strlen(out), ", custom %ld (%s)",
+		    lldpctl_atom_get_int(item, lldpctl_k_custom_tlv_oui_subtype),
+		    lldpctl_atom_get_str(item, lldpctl_k_custom_tlv_oui_info_string));
+	}
+	lldpctl_atom_dec_ref(list);
+}
+
+static void
+delta_setup(void)
+{
+	setup();
+	client->subscription.window = 0;
+	client->subscription.delta = 1;
+	full_client = add_client(&full_peer);
+}
+
+START_TEST(test_delta)
+{
+	lldpctl_atom_t *previous = NULL, *delta = NULL, *full = NULL;
+	lldpctl_conn_t *delta_conn = lib_subscribe(1, &delta),
+		       *full_conn = lib_subscribe(0, &full);
+	struct lldpd_port *port = &ports[0];
+	char expected[256], applied[256];
+#ifdef ENABLE_DOT1
+	struct lldpd_vlan vlan = { .v_name = "ten", .v_vid = 10 };
+#endif
+#ifdef ENABLE_CUSTOM
+	struct lldpd_custom custom = { .oui = { 0x00, 0x12, 0x34 }, .subtype = 5,
+		.oui_info = (u_int8_t *)"info", .oui_info_len = 4 };
+#endif
+
+	chassis[0].c_name = "switch";
+	chassis[0].c_descr = "a switch";
+#ifdef ENABLE_DOT1
+	TAILQ_INIT(&port->p_vlans);
+	TAILQ_INSERT_TAIL(&port->p_vlans, &vlan, v_entries);
+#endif
+#ifdef ENABLE_CUSTOM
+	TAILQ_INIT(&port->p_custom_list);
+	TAILQ_INSERT_TAIL(&port->p_custom_list, &custom, next);
+#endif
+
+	/* New neighbors are always complete */
+	port->p_generation = 1;
+	levent_ctl_notify("eth0", NEIGHBOR_CHANGE_ADDED, port, 0);
+	lib_notify(delta_conn, peer);
+	lib_notify(full_conn, full_peer);
+	ck_assert_ptr_ne(delta, NULL);
+	ck_assert_int_eq(lldpctl_atom_get_int(delta, lldpctl_k_port_unchanged), 0);
+	previous = delta;
+	lldpctl_atom_inc_ref(previous);
+
+	/* Only the port changes */
+	port->p_descr = "updated";
+	port->p_generation = 2;
+	levent_ctl_notify("eth0", NEIGHBOR_CHANGE_UPDATED, port,
+	    NEIGHBOR_UNCHANGED_ALL);
+	lib_notify(delta_conn, peer);
+	lib_notify(full_conn, full_peer);
+	ck_assert_ptr_ne(delta, previous);
+	ck_assert_int_eq(lldpctl_atom_get_int(delta, lldpctl_k_port_unchanged),
+	    LLDPCTL_UNCHANGED_CHASSIS | LLDPCTL_UNCHANGED_VLANS |
+		LLDPCTL_UNCHANGED_CUSTOM);
+	ck_assert_int_eq(lldpctl_atom_get_int(delta, lldpctl_k_port_generation),
+	    lldpctl_atom_get_int(previous, lldpctl_k_port_generation) + 1);
+	ck_assert_ptr_eq(lldpctl_atom_get_str(delta, lldpctl_k_chassis_name), NULL);
+	ck_assert_int_eq(lldpctl_atom_get_int(full, lldpctl_k_port_unchanged), 0);
+
+	describe(full, NULL, expected, sizeof(expected));
+	describe(delta, previous, applied, sizeof(applied));
+	ck_assert_str_eq(applied, expected);
+	ck_assert_ptr_ne(strstr(expected, "updated"), NULL);
+	ck_assert_ptr_ne(strstr(expected, "a switch"), NULL);
+#ifdef ENABLE_DOT1
+	ck_assert_ptr_ne(strstr(expected, "vlan 10 (ten)"), NULL);
+#endif
+#ifdef ENABLE_CUSTOM
+	ck_assert_ptr_ne(strstr(expected, "custom 5"), NULL);
+#endif
+
+	lldpctl_atom_dec_ref(previous);
+	lldpctl_atom_dec_ref(delta);
+	lldpctl_atom_dec_ref(full);
+	lldpctl_release(delta_conn);
+	lldpctl_release(full_conn);
+}
+END_TEST
+
+Suite *
+event_suite(void)
+{
+	Suite *s = suite_create("Event loop");
+
+	TCase *tc_coalesce = tcase_create("Coalesced changes");
+	tcase_add_checked_fixture(tc_coalesce, setup, teardown);
+	tcase_add_test(tc_coalesce, test_merge_changes);
+	tcase_add_test(tc_coalesce, test_overflow);
+	tcase_add_test(tc_coalesce, test_slow_client);
+	suite_add_tcase(s, tc_coalesce);
+
+	TCase *tc_delta = tcase_create("Delta notifications");
+	tcase_add_checked_fixture(tc_delta, delta_setup, teardown);
+	tcase_add_test(tc_delta, test_delta);
+	suite_add_tcase(s, tc_delta);
+
+	return s;
+}
+
+int
+main()
+{
+	int number_failed;
+	Suite *s = event_suite();
+	SRunner *sr = srunner_create(s);
+	srunner_run_all(sr, CK_ENV);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
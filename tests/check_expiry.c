@@ -0,0 +1,180 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2026 Vincent Bernat <bernat@luffy.cx>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <check.h>
+
+#include "../src/daemon/lldpd.h"
+
+#define NPORTS 500
+
+static struct lldpd_hardware hardware;
+static struct lldpd_port ports[NPORTS];
+
+static void
+setup(void)
+{
+	int i;
+	memset(ports, 0, sizeof(ports));
+	for (i = 0; i < NPORTS; i++) {
+		/* Spread expiration times without keeping insertion order */
+		ports[i].p_lastupdate = 1000 + (i * 7919) % NPORTS;
+		ports[i].p_ttl = 120;
+	}
+}
+
+/* Pop everything and check ports come out in order. Return the number of
+ * popped ports. */
+static int
+drain(struct expiry_heap *heap)
+{
+	struct lldpd_hardware *h;
+	struct lldpd_port *port;
+	time_t last = 0;
+	int n = 0;
+	while (expiry_due(heap, 1000000, &h, &port)) {
+		ck_assert_ptr_eq(h, &hardware);
+		ck_assert_int_ge(port->p_lastupdate + port->p_ttl, last);
+		last = port->p_lastupdate + port->p_ttl;
+		expiry_remove(heap, port);
+		ck_assert_int_eq(port->p_expiry, 0);
+		n++;
+	}
+	return n;
+}
+
+START_TEST(test_empty)
+{
+	struct expiry_heap heap = {};
+	struct lldpd_hardware *h;
+	struct lldpd_port *port;
+	ck_assert_int_eq(expiry_next(&heap), -1);
+	ck_assert_int_eq(expiry_due(&heap, 1000000, &h, &port), 0);
+	/* Removing an unknown port is harmless */
+	expiry_remove(&heap, &ports[0]);
+	ck_assert_int_eq(heap.eh_count, 0);
+	expiry_free(&heap);
+}
+END_TEST
+
+START_TEST(test_order)
+{
+	struct expiry_heap heap = {};
+	struct lldpd_hardware *h;
+	struct lldpd_port *port;
+	int i;
+	for (i = 0; i < NPORTS; i++)
+		ck_assert_int_eq(expiry_update(&heap, &hardware, &ports[i]), 0);
+	ck_assert_int_eq(heap.eh_count, NPORTS);
+	ck_assert_int_eq(expiry_next(&heap), 1120);
+	ck_assert_int_eq(expiry_due(&heap, 1119, &h, &port), 0);
+	ck_assert_int_eq(expiry_due(&heap, 1120, &h, &port), 1);
+	ck_assert_int_eq(port->p_lastupdate, 1000);
+	ck_assert_int_eq(drain(&heap), NPORTS);
+	expiry_free(&heap);
+}
+END_TEST
+
+START_TEST(test_update_remove)
+{
+	struct expiry_heap heap = {};
+	struct lldpd_hardware *h;
+	struct lldpd_port *port;
+	int i;
+	for (i = 0; i < NPORTS; i++)
+		expiry_update(&heap, &hardware, &ports[i]);
+	/* Refresh the first port to expire: it should not be first anymore */
+	expiry_due(&heap, 1120, &h, &port);
+	port->p_lastupdate = 5000;
+	expiry_update(&heap, &hardware, port);
+	ck_assert_int_eq(heap.eh_count, NPORTS);
+	ck_assert_int_eq(expiry_next(&heap), 1121);
+	/* Shutdown LLDPDU for another one: it should expire first */
+	ports[42].p_ttl = 0;
+	expiry_update(&heap, &hardware, &ports[42]);
+	ck_assert_int_eq(expiry_due(&heap, ports[42].p_lastupdate, &h, &port), 1);
+	ck_assert_ptr_eq(port, &ports[42]);
+	/* Remove some ports in the middle */
+	for (i = 0; i < NPORTS; i += 3)
+		expiry_remove(&heap, &ports[i]);
+	for (i = 0; i < NPORTS; i++) {
+		if (i % 3 == 0)
+			ck_assert_int_eq(ports[i].p_expiry, 0);
+		else
+			ck_assert_ptr_eq(heap.eh_entries[ports[i].p_expiry - 1].e_port,
+			    &ports[i]);
+	}
+	ck_assert_int_eq(drain(&heap), NPORTS - (NPORTS + 2) / 3);
+	expiry_free(&heap);
+}
+END_TEST
+
+START_TEST(test_hardware_cleanup)
+{
+	struct lldpd cfg = {};
+	struct lldpd_hardware *h;
+	struct lldpd_port *port;
+	int i;
+
+	/* A port of another interface */
+	expiry_update(&cfg.g_expiry, &hardware, &ports[0]);
+
+	/* Remote ports of a port removed without removing them first */
+	ck_assert_ptr_ne(h = calloc(1, sizeof(struct lldpd_hardware)), NULL);
+	TAILQ_INIT(&h->h_rports);
+	h->h_cfg = &cfg;
+	for (i = 1; i < 4; i++) {
+		ck_assert_ptr_ne(port = calloc(1, sizeof(struct lldpd_port)), NULL);
+		port->p_lastupdate = ports[i].p_lastupdate;
+		port->p_ttl = ports[i].p_ttl;
+		TAILQ_INSERT_TAIL(&h->h_rports, port, p_entries);
+		expiry_update(&cfg.g_expiry, h, port);
+	}
+	ck_assert_int_eq(cfg.g_expiry.eh_count, 4);
+	lldpd_hardware_cleanup(&cfg, h);
+	ck_assert_int_eq(cfg.g_expiry.eh_count, 1);
+	ck_assert_ptr_eq(cfg.g_expiry.eh_entries[0].e_port, &ports[0]);
+	expiry_free(&cfg.g_expiry);
+}
+END_TEST
+
+Suite *
+expiry_suite(void)
+{
+	Suite *s = suite_create("Expiry heap");
+
+	TCase *tc_expiry = tcase_create("Expiry heap");
+	tcase_add_checked_fixture(tc_expiry, setup, NULL);
+	tcase_add_test(tc_expiry, test_empty);
+	tcase_add_test(tc_expiry, test_order);
+	tcase_add_test(tc_expiry, test_update_remove);
+	tcase_add_test(tc_expiry, test_hardware_cleanup);
+	suite_add_tcase(s, tc_expiry);
+
+	return s;
+}
+
+int
+main()
+{
+	int number_failed;
+	Suite *s = expiry_suite();
+	SRunner *sr = srunner_create(s);
+	srunner_run_all(sr, CK_ENV);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
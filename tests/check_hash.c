@@ -0,0 +1,127 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2026 Vincent Bernat <bernat@luffy.cx>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <check.h>
+
+#include "../src/daemon/lldpd.h"
+
+struct item {
+	int key;
+	struct hash_entry entry;
+};
+
+static struct item *
+lookup(struct hash_table *table, int key, u_int32_t hash)
+{
+	struct hash_entry *entry;
+	HASH_FOREACH (entry, table, hash) {
+		struct item *item = HASH_ENTRY(entry, struct item, entry);
+		if (item->key == key) return item;
+	}
+	return NULL;
+}
+
+START_TEST(test_empty)
+{
+	struct hash_table table = {};
+	struct item item = { .key = 1 };
+	ck_assert_ptr_eq(hash_first(&table, 0), NULL);
+	ck_assert_ptr_eq(hash_first(&table, 42), NULL);
+	/* Removing an unknown entry is harmless */
+	hash_remove(&table, &item.entry);
+	ck_assert_int_eq(table.ht_count, 0);
+	hash_free(&table);
+}
+END_TEST
+
+START_TEST(test_insert_lookup_remove)
+{
+	struct hash_table table = {};
+	struct item items[1000];
+	int i;
+	for (i = 0; i < 1000; i++) {
+		items[i].key = i;
+		hash_insert(&table, &items[i].entry,
+		    hash_bytes(HASH_INIT, &items[i].key, sizeof(int)));
+	}
+	ck_assert_int_eq(table.ht_count, 1000);
+	ck_assert_int_ge(table.ht_size, 1000);
+	for (i = 0; i < 1000; i++)
+		ck_assert_ptr_eq(lookup(&table, i, hash_bytes(HASH_INIT, &i, sizeof(int))),
+		    &items[i]);
+	for (i = 0; i < 1000; i += 2)
+		hash_remove(&table, &items[i].entry);
+	ck_assert_int_eq(table.ht_count, 500);
+	for (i = 0; i < 1000; i++)
+		ck_assert_ptr_eq(lookup(&table, i, hash_bytes(HASH_INIT, &i, sizeof(int))),
+		    (i % 2) ? &items[i] : NULL);
+	hash_free(&table);
+	ck_assert_int_eq(table.ht_count, 0);
+}
+END_TEST
+
+START_TEST(test_collisions)
+{
+	struct hash_table table = {};
+	struct item items[10];
+	struct hash_entry *entry;
+	int i, n = 0;
+	/* All items share the same hash */
+	for (i = 0; i < 10; i++) {
+		items[i].key = i;
+		hash_insert(&table, &items[i].entry, 17);
+	}
+	hash_insert(&table, &(struct item) { .key = 99 }.entry, 18);
+	HASH_FOREACH (entry, &table, 17)
+		n++;
+	ck_assert_int_eq(n, 10);
+	for (i = 0; i < 10; i++)
+		ck_assert_ptr_eq(lookup(&table, i, 17), &items[i]);
+	ck_assert_ptr_eq(lookup(&table, 99, 17), NULL);
+	ck_assert_int_eq(lookup(&table, 99, 18)->key, 99);
+	hash_remove(&table, &items[5].entry);
+	ck_assert_ptr_eq(lookup(&table, 5, 17), NULL);
+	ck_assert_ptr_eq(lookup(&table, 6, 17), &items[6]);
+	hash_free(&table);
+}
+END_TEST
+
+Suite *
+hash_suite(void)
+{
+	Suite *s = suite_create("Hash table");
+
+	TCase *tc_hash = tcase_create("Hash table");
+	tcase_add_test(tc_hash, test_empty);
+	tcase_add_test(tc_hash, test_insert_lookup_remove);
+	tcase_add_test(tc_hash, test_collisions);
+	suite_add_tcase(s, tc_hash);
+
+	return s;
+}
+
+int
+main()
+{
+	int number_failed;
+	Suite *s = hash_suite();
+	SRunner *sr = srunner_create(s);
+	srunner_run_all(sr, CK_ENV);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
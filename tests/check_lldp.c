@@ -165,6 +165,180 @@ START_TEST(test_send_rcv_basic)
 }
 END_TEST
 
+START_TEST(test_send_cached)
+{
+	struct packet *pkt1, *pkt2, *pkt3;
+
+	hardware.h_lport.p_id_subtype = LLDP_PORTID_SUBTYPE_IFNAME;
+	hardware.h_lport.p_id = "FastEthernet 1/5";
+	hardware.h_lport.p_id_len = strlen(hardware.h_lport.p_id);
+	hardware.h_lport.p_descr = "Fake port description";
+	chassis.c_id_subtype = LLDP_CHASSISID_SUBTYPE_LLADDR;
+	chassis.c_id = macaddress;
+	chassis.c_id_len = ETHER_ADDR_LEN;
+	chassis.c_name = "First chassis";
+
+	/* The second PDU is the cached copy of the first one */
+	ck_assert_int_eq(lldp_send(&test_lldpd, &hardware), 0);
+	ck_assert_int_eq(lldp_send(&test_lldpd, &hardware), 0);
+	ck_assert_int_eq(hardware.h_tx_cnt, 2);
+	pkt1 = TAILQ_FIRST(&pkts);
+	fail_unless(pkt1 != NULL, "no packets sent");
+	pkt2 = TAILQ_NEXT(pkt1, next);
+	fail_unless(pkt2 != NULL, "only one packet sent");
+	ck_assert_int_eq(pkt1->size, pkt2->size);
+	fail_unless(memcmp(pkt1->data, pkt2->data, pkt1->size) == 0,
+	    "cached packet is different");
+
+	/* A change to the port invalidates the cache */
+	hardware.h_lport.p_descr = "Another port description";
+	hardware.h_lport.p_generation++;
+	ck_assert_int_eq(lldp_send(&test_lldpd, &hardware), 0);
+	pkt3 = TAILQ_NEXT(pkt2, next);
+	fail_unless(pkt3 != NULL, "no packet sent after change");
+	fail_unless(pkt3->size != pkt1->size ||
+		memcmp(pkt1->data, pkt3->data, pkt1->size) != 0,
+	    "packet was not rebuilt");
+}
+END_TEST
+
+START_TEST(test_send_cached_bond)
+{
+	struct packet *pkt1, *pkt2;
+	char mangled[ETHER_ADDR_LEN] = { 0x00, 0x60, 0x08, 0x69, 0x97, 0xef };
+
+	hardware.h_lport.p_id_subtype = LLDP_PORTID_SUBTYPE_IFNAME;
+	hardware.h_lport.p_id = "FastEthernet 1/5";
+	hardware.h_lport.p_id_len = strlen(hardware.h_lport.p_id);
+	hardware.h_lport.p_descr = "Fake port description";
+	chassis.c_id_subtype = LLDP_CHASSISID_SUBTYPE_LLADDR;
+	chassis.c_id = macaddress;
+	chassis.c_id_len = ETHER_ADDR_LEN;
+	chassis.c_name = "First chassis";
+	hardware.h_mangle = 1;
+	test_lldpd.g_config.c_bond_slave_src_mac_type =
+	    LLDP_BOND_SLAVE_SRC_MAC_TYPE_LOCALLY_ADMINISTERED;
+
+	/* The cached copy gets the same source address */
+	ck_assert_int_eq(lldp_send(&test_lldpd, &hardware), 0);
+	ck_assert_int_eq(lldp_send(&test_lldpd, &hardware), 0);
+	test_lldpd.g_config.c_bond_slave_src_mac_type = 0;
+	pkt1 = TAILQ_FIRST(&pkts);
+	fail_unless(pkt1 != NULL, "no packets sent");
+	pkt2 = TAILQ_NEXT(pkt1, next);
+	fail_unless(pkt2 != NULL, "only one packet sent");
+	/* Our address is already locally administered, a fixed one is used */
+	fail_unless(memcmp(pkt1->data + ETHER_ADDR_LEN, mangled, ETHER_ADDR_LEN) == 0,
+	    "source address is not the fixed one");
+	ck_assert_int_eq(pkt1->size, pkt2->size);
+	fail_unless(memcmp(pkt1->data, pkt2->data, pkt1->size) == 0,
+	    "cached packet is different");
+}
+END_TEST
+
+#ifdef ENABLE_CUSTOM
+/* The frames sent by the test port are received by another lldpd */
+static struct protocol refresh_protocols[] = {
+	{ LLDPD_MODE_LLDP, 1, "LLDP", 'l', lldp_send, lldp_decode, NULL,
+	    { LLDP_ADDR_NEAREST_BRIDGE, LLDP_ADDR_NEAREST_NONTPMR_BRIDGE,
+		LLDP_ADDR_NEAREST_CUSTOMER_BRIDGE } },
+	{ 0, 0, "any", ' ', NULL, NULL, NULL, { { 0, 0, 0, 0, 0, 0 } } }
+};
+static struct lldpd refresh_lldpd = { .g_protocols = refresh_protocols };
+static struct lldpd_hardware refresh_hardware;
+
+/* Send a frame from the test port and receive it on the other lldpd */
+static void
+refresh_exchange(void)
+{
+	struct packet *pkt;
+
+	hardware.h_lport.p_generation++;
+	ck_assert_int_eq(lldp_send(&test_lldpd, &hardware), 0);
+	pkt = TAILQ_LAST(&pkts, pkts_t);
+	ck_assert_int_eq(lldpd_recv_frame(&refresh_lldpd, &refresh_hardware,
+			     pkt->data, pkt->size),
+	    0);
+}
+
+START_TEST(test_recv_refresh)
+{
+	struct lldpd_custom custom = { .oui = { 0x33, 0x44, 0x55 }, .subtype = 1 };
+	struct lldpd_port *rport;
+	struct lldpd_chassis *rchassis;
+	char *rname;
+	u_int32_t generation, hgeneration;
+
+	TAILQ_INIT(&refresh_lldpd.g_chassis);
+	memset(&refresh_hardware, 0, sizeof(struct lldpd_hardware));
+	TAILQ_INIT(&refresh_hardware.h_rports);
+	refresh_hardware.h_cfg = &refresh_lldpd;
+	strlcpy(refresh_hardware.h_ifname, "refresh",
+	    sizeof(refresh_hardware.h_ifname));
+
+	hardware.h_lport.p_id_subtype = LLDP_PORTID_SUBTYPE_IFNAME;
+	hardware.h_lport.p_id = "FastEthernet 1/5";
+	hardware.h_lport.p_id_len = strlen(hardware.h_lport.p_id);
+	hardware.h_lport.p_descr = "Fake port description";
+	TAILQ_INIT(&hardware.h_lport.p_custom_list);
+	TAILQ_INSERT_TAIL(&hardware.h_lport.p_custom_list, &custom, next);
+	custom.oui_info = (u_int8_t *)"counter 1";
+	custom.oui_info_len = strlen((char *)custom.oui_info);
+	chassis.c_id_subtype = LLDP_CHASSISID_SUBTYPE_LLADDR;
+	chassis.c_id = macaddress;
+	chassis.c_id_len = ETHER_ADDR_LEN;
+	chassis.c_name = "First chassis";
+	test_lldpd.g_config.c_ttl = 120;
+
+	refresh_exchange();
+	rport = TAILQ_FIRST(&refresh_hardware.h_rports);
+	fail_unless(rport != NULL, "neighbor was not added");
+	rchassis = rport->p_chassis;
+	rname = rchassis->c_name;
+	generation = rport->p_generation;
+	hgeneration = refresh_hardware.h_generation;
+
+	/* Only a custom TLV changes: the neighbor is updated in place but its
+	 * generation is kept as the change is not notified */
+	custom.oui_info = (u_int8_t *)"counter 2";
+	refresh_exchange();
+	ck_assert_ptr_eq(TAILQ_FIRST(&refresh_hardware.h_rports), rport);
+	fail_unless(TAILQ_NEXT(rport, p_entries) == NULL, "neighbor was duplicated");
+	ck_assert_int_eq(rport->p_generation, generation);
+	ck_assert_int_eq(refresh_hardware.h_generation, hgeneration + 1);
+	ck_assert_str_eq_n((char *)TAILQ_FIRST(&rport->p_custom_list)->oui_info,
+	    "counter 2", strlen("counter 2"));
+	ck_assert_int_eq(rport->p_custom_changed, 1);
+	/* The chassis did not change, it was not replaced */
+	ck_assert_ptr_eq(rport->p_chassis, rchassis);
+	ck_assert_ptr_eq(rchassis->c_name, rname);
+
+	/* The port description changes: this is notified */
+	hardware.h_lport.p_descr = "Another port description";
+	refresh_exchange();
+	ck_assert_ptr_eq(TAILQ_FIRST(&refresh_hardware.h_rports), rport);
+	ck_assert_int_eq(rport->p_generation, generation + 1);
+	ck_assert_str_eq(rport->p_descr, "Another port description");
+	ck_assert_int_eq(rport->p_custom_changed, 0);
+	ck_assert_ptr_eq(rchassis->c_name, rname);
+
+	/* The chassis changes: it is updated in place */
+	chassis.c_name = "Second chassis";
+	refresh_exchange();
+	ck_assert_int_eq(rport->p_generation, generation + 2);
+	ck_assert_ptr_eq(rport->p_chassis, rchassis);
+	ck_assert_str_eq(rchassis->c_name, "Second chassis");
+	test_lldpd.g_config.c_ttl = 0;
+
+	lldpd_remote_cleanup(&refresh_hardware, NULL, 1);
+	TAILQ_REMOVE(&refresh_lldpd.g_chassis, rchassis, c_entries);
+	lldpd_chassis_cleanup(rchassis, 1);
+	hash_free(&refresh_lldpd.g_chassis_index);
+	expiry_free(&refresh_lldpd.g_expiry);
+}
+END_TEST
+#endif
+
 #define ETHERTYPE_OFFSET 2 * ETHER_ADDR_LEN
 #define VLAN_TAG_SIZE 2
 START_TEST(test_send_rcv_vlan_tx)
@@ -788,6 +962,9 @@ lldp_suite(void)
 	Suite *s = suite_create("LLDP");
 	TCase *tc_send = tcase_create("Send LLDP packets");
 	TCase *tc_receive = tcase_create("Receive LLDP packets");
+#ifdef ENABLE_CUSTOM
+	TCase *tc_refresh = tcase_create("Refresh LLDP neighbors");
+#endif
 
 	/* Send tests are first run without knowing the result. The
 	   result is then checked with:
@@ -801,6 +978,8 @@ lldp_suite(void)
 	tcase_add_checked_fixture(tc_send, pcap_setup, pcap_teardown);
 	tcase_add_test(tc_send, test_send_rcv_basic);
 	tcase_add_test(tc_send, test_send_rcv_vlan_tx);
+	tcase_add_test(tc_send, test_send_cached);
+	tcase_add_test(tc_send, test_send_cached_bond);
 #ifdef ENABLE_DOT1
 	tcase_add_test(tc_send, test_send_rcv_dot1_tlvs);
 #endif
@@ -816,6 +995,12 @@ lldp_suite(void)
 	tcase_add_test(tc_receive, test_recv_lldpd);
 	suite_add_tcase(s, tc_receive);
 
+#ifdef ENABLE_CUSTOM
+	tcase_add_checked_fixture(tc_refresh, pcap_setup, pcap_teardown);
+	tcase_add_test(tc_refresh, test_recv_refresh);
+	suite_add_tcase(s, tc_refresh);
+#endif
+
 	return s;
 }
 
@@ -0,0 +1,500 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2026 Vincent Bernat <bernat@luffy.cx>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <check.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "../src/daemon/lldpd.h"
+#include "../src/lib/lldpctl.h"
+
+#define NCHANGES 16
+
+/* Data received by the library through the custom callbacks */
+static uint8_t *pending;
+static size_t pending_len;
+
+/* Changes received by the watch callback */
+static int nchanges;
+static char *ifnames[NCHANGES];
+static char *descrs[NCHANGES];
+
+static ssize_t
+script_send(lldpctl_conn_t *conn, const uint8_t *data, size_t length,
+    void *user_data)
+{
+	return length;
+}
+
+static ssize_t
+script_recv(lldpctl_conn_t *conn, const uint8_t *data, size_t length,
+    void *user_data)
+{
+	if (pending_len == 0) return LLDPCTL_ERR_WOULDBLOCK;
+	if (length > pending_len) length = pending_len;
+	memcpy((uint8_t *)data, pending, length);
+	memmove(pending, pending + length, pending_len - length);
+	pending_len -= length;
+	return length;
+}
+
+static void
+watch(lldpctl_change_t type, lldpctl_atom_t *interface, lldpctl_atom_t *neighbor,
+    void *data)
+{
+	ck_assert_int_eq(type, lldpctl_c_added);
+	ck_assert_int_lt(nchanges, NCHANGES);
+	ifnames[nchanges] =
+	    strdup(lldpctl_atom_get_str(interface, lldpctl_k_interface_name));
+	descrs[nchanges] = strdup(lldpctl_atom_get_str(neighbor, lldpctl_k_port_descr));
+	ck_assert_str_eq(lldpctl_atom_get_str(neighbor, lldpctl_k_chassis_name),
+	    "switch");
+	nchanges++;
+}
+
+/* Subscribe to changes through the custom callbacks. */
+static lldpctl_conn_t *
+subscribe(void)
+{
+	lldpctl_conn_t *conn;
+
+	nchanges = 0;
+	pending = NULL;
+	pending_len = 0;
+	ck_assert_int_eq(ctl_msg_send_unserialized(&pending, &pending_len,
+			     SUBSCRIBE, NULL, NULL),
+	    0);
+	conn = lldpctl_new(script_send, script_recv, NULL);
+	ck_assert_ptr_ne(conn, NULL);
+	ck_assert_int_eq(lldpctl_watch_callback2(conn, watch, NULL), 0);
+	ck_assert_int_eq(pending_len, 0);
+	free(pending);
+	pending = NULL;
+	return conn;
+}
+
+/* Serialize back-to-back notifications. Messages are padded to a multiple of
+ * the alignment: some bytes are appended to their payload for the next ones
+ * to start at odd offsets. */
+static void
+notifications(uint8_t **buffer, size_t *len)
+{
+	struct lldpd_chassis chassis = { .c_name = "switch" };
+	struct lldpd_port port = { .p_chassis = &chassis };
+	struct lldpd_neighbor_change change = { .state = NEIGHBOR_CHANGE_ADDED,
+		.neighbor = &port };
+	struct hmsg_header hdr;
+	char ifname[IFNAMSIZ], descr[16];
+	size_t previous, extra;
+	int i;
+
+	*buffer = NULL;
+	*len = 0;
+	for (i = 0; i < NCHANGES; i++) {
+		snprintf(ifname, sizeof(ifname), "eth%d", i);
+		snprintf(descr, sizeof(descr), "port%d", i);
+		change.ifname = ifname;
+		port.p_descr = descr;
+		previous = *len;
+		ck_assert_int_eq(ctl_msg_send_unserialized(buffer, len, NOTIFICATION,
+				     &change, &MARSHAL_INFO(lldpd_neighbor_change)),
+		    0);
+		extra = 2 * i + 1;
+		*buffer = realloc(*buffer, *len + extra);
+		ck_assert_ptr_ne(*buffer, NULL);
+		memset(*buffer + *len, 0, extra);
+		memcpy(&hdr, *buffer + previous, sizeof(hdr));
+		hdr.len += extra;
+		memcpy(*buffer + previous, &hdr, sizeof(hdr));
+		*len += extra;
+	}
+}
+
+/* Feed notifications by pieces of the given size and check all of them are
+ * received in order. */
+static void
+check_notifications(size_t piece)
+{
+	lldpctl_conn_t *conn = subscribe();
+	char ifname[IFNAMSIZ], descr[16];
+	uint8_t *buffer;
+	size_t len, offset;
+	int i;
+
+	notifications(&buffer, &len);
+	for (offset = 0; offset < len; offset += piece)
+		ck_assert_int_ge(lldpctl_recv(conn, buffer + offset,
+				     (len - offset < piece) ? len - offset : piece),
+		    0);
+	free(buffer);
+
+	ck_assert_int_eq(nchanges, NCHANGES);
+	for (i = 0; i < NCHANGES; i++) {
+		snprintf(ifname, sizeof(ifname), "eth%d", i);
+		snprintf(descr, sizeof(descr), "port%d", i);
+		ck_assert_str_eq(ifnames[i], ifname);
+		ck_assert_str_eq(descrs[i], descr);
+		free(ifnames[i]);
+		free(descrs[i]);
+	}
+	lldpctl_release(conn);
+}
+
+START_TEST(test_notifications_at_once)
+{
+	check_notifications(SIZE_MAX);
+}
+END_TEST
+
+START_TEST(test_notifications_by_pieces)
+{
+	check_notifications(7);
+}
+END_TEST
+
+/* Asynchronous connection to a fake lldpd */
+#define SOCKDIR "/tmp/check_lldpctl.XXXXXX"
+static char sockdir[sizeof(SOCKDIR)];
+static char sockname[sizeof(SOCKDIR) + 4];
+static int listener = -1, server = -1;
+static lldpctl_conn_t *aconn;
+static int completed;
+
+/* Completion of a request */
+struct answer {
+	int order; /* Rank of completion */
+	lldpctl_error_t error;
+	int count; /* Number of atoms in the result */
+	char *first; /* Name of the first interface */
+};
+
+static void
+async_setup(void)
+{
+	struct sockaddr_un su = { .sun_family = AF_UNIX };
+
+	completed = 0;
+	strlcpy(sockdir, SOCKDIR, sizeof(sockdir));
+	ck_assert_ptr_ne(mkdtemp(sockdir), NULL);
+	snprintf(sockname, sizeof(sockname), "%s/ctl", sockdir);
+	strlcpy(su.sun_path, sockname, sizeof(su.sun_path));
+	listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	ck_assert_int_ge(listener, 0);
+	ck_assert_int_eq(bind(listener, (struct sockaddr *)&su, sizeof(su)), 0);
+	ck_assert_int_eq(listen(listener, 1), 0);
+	aconn = lldpctl_new_name(sockname, NULL, NULL, NULL);
+	ck_assert_ptr_ne(aconn, NULL);
+	ck_assert_int_ge(lldpctl_get_fd(aconn), 0);
+	server = accept(listener, NULL, NULL);
+	ck_assert_int_ge(server, 0);
+	ck_assert_int_eq(fcntl(server, F_SETFL, O_NONBLOCK), 0);
+}
+
+static void
+async_teardown(void)
+{
+	lldpctl_release(aconn);
+	if (server != -1) close(server);
+	close(listener);
+	unlink(sockname);
+	rmdir(sockdir);
+}
+
+static void
+answered(lldpctl_conn_t *conn, lldpctl_atom_t *result, lldpctl_error_t error,
+    void *data)
+{
+	struct answer *answer = data;
+	lldpctl_atom_t *atom;
+
+	ck_assert_int_eq(answer->order, 0);
+	answer->order = ++completed;
+	answer->error = error;
+	if (result == NULL) return;
+	lldpctl_atom_foreach(result, atom)
+	{
+		if (answer->count++ == 0)
+			answer->first = strdup(
+			    lldpctl_atom_get_str(atom, lldpctl_k_interface_name));
+	}
+}
+
+/* Read the available requests and check their types. */
+static void
+server_requests(const enum hmsg_type *types, int n)
+{
+	uint8_t *buffer = NULL;
+	size_t len = 0, offset = 0, consumed;
+	ssize_t nb;
+	int i;
+
+	for (;;) {
+		buffer = realloc(buffer, len + 4096);
+		ck_assert_ptr_ne(buffer, NULL);
+		if ((nb = read(server, buffer + len, 4096)) == -1) break;
+		ck_assert_int_gt(nb, 0);
+		len += nb;
+	}
+	ck_assert_int_eq(errno, EAGAIN);
+	for (i = 0; i < n; i++) {
+		ck_assert_int_eq(ctl_msg_parse_unserialized(buffer + offset,
+				     len - offset, types[i], NULL, NULL, &consumed),
+		    0);
+		offset += consumed;
+	}
+	ck_assert_int_eq(offset, len);
+	free(buffer);
+}
+
+/* Serialize an answer at the end of the provided buffer. */
+static void
+server_interfaces(uint8_t **buffer, size_t *len)
+{
+	struct lldpd_interface eth0 = { .name = "eth0" }, eth1 = { .name = "eth1" };
+	struct lldpd_interface_list list;
+
+	TAILQ_INIT(&list);
+	TAILQ_INSERT_TAIL(&list, &eth0, next);
+	TAILQ_INSERT_TAIL(&list, &eth1, next);
+	ck_assert_int_eq(ctl_msg_send_unserialized(buffer, len, GET_INTERFACES,
+			     &list, &MARSHAL_INFO(lldpd_interface_list)),
+	    0);
+}
+
+static void
+server_neighbors(uint8_t **buffer, size_t *len, enum hmsg_type type)
+{
+	struct lldpd_neighbors_record record = {};
+
+	ck_assert_int_eq(ctl_msg_send_unserialized(buffer, len, type, &record,
+			     &MARSHAL_INFO(lldpd_neighbors_record)),
+	    0);
+}
+
+static void
+server_send(const uint8_t *buffer, size_t len)
+{
+	ck_assert_int_eq(write(server, buffer, len), len);
+}
+
+START_TEST(test_async_in_order)
+{
+	enum hmsg_type types[] = { GET_INTERFACES, GET_NEIGHBORS, GET_INTERFACES };
+	struct answer answers[3] = {};
+	uint8_t *buffer = NULL;
+	size_t len = 0;
+
+	ck_assert_int_eq(lldpctl_get_interfaces_async(aconn, answered, &answers[0]),
+	    0);
+	ck_assert_int_eq(lldpctl_get_neighbors_async(aconn, "eth*", 0, answered,
+			     &answers[1]),
+	    0);
+	ck_assert_int_eq(lldpctl_get_interfaces_async(aconn, answered, &answers[2]),
+	    0);
+	ck_assert_int_eq(lldpctl_process(aconn), LLDPCTL_WANT_READ);
+	server_requests(types, 3);
+
+	server_interfaces(&buffer, &len);
+	server_neighbors(&buffer, &len, GET_NEIGHBORS);
+	server_interfaces(&buffer, &len);
+	server_send(buffer, len);
+	free(buffer);
+	ck_assert_int_eq(lldpctl_process(aconn), 0);
+
+	ck_assert_int_eq(completed, 3);
+	ck_assert_int_eq(answers[0].order, 1);
+	ck_assert_int_eq(answers[1].order, 2);
+	ck_assert_int_eq(answers[2].order, 3);
+	ck_assert_int_eq(answers[0].error, LLDPCTL_NO_ERROR);
+	ck_assert_int_eq(answers[1].error, LLDPCTL_NO_ERROR);
+	ck_assert_int_eq(answers[2].error, LLDPCTL_NO_ERROR);
+	ck_assert_int_eq(answers[0].count, 2);
+	ck_assert_int_eq(answers[1].count, 0);
+	ck_assert_int_eq(answers[2].count, 2);
+	ck_assert_str_eq(answers[0].first, "eth0");
+	ck_assert_str_eq(answers[2].first, "eth0");
+	free(answers[0].first);
+	free(answers[2].first);
+}
+END_TEST
+
+START_TEST(test_async_partial_read)
+{
+	enum hmsg_type types[] = { GET_INTERFACES };
+	struct answer answer = {};
+	uint8_t *buffer = NULL;
+	size_t len = 0;
+
+	ck_assert_int_eq(lldpctl_get_interfaces_async(aconn, answered, &answer), 0);
+	server_requests(types, 1);
+	server_interfaces(&buffer, &len);
+
+	/* Half of the answer */
+	server_send(buffer, len / 2);
+	ck_assert_int_eq(lldpctl_process(aconn), LLDPCTL_WANT_READ);
+	ck_assert_int_eq(completed, 0);
+
+	server_send(buffer + len / 2, len - len / 2);
+	free(buffer);
+	ck_assert_int_eq(lldpctl_process(aconn), 0);
+	ck_assert_int_eq(completed, 1);
+	ck_assert_int_eq(answer.error, LLDPCTL_NO_ERROR);
+	ck_assert_int_eq(answer.count, 2);
+	ck_assert_str_eq(answer.first, "eth0");
+	free(answer.first);
+}
+END_TEST
+
+START_TEST(test_async_partial_write)
+{
+	enum hmsg_type types[] = { GET_NEIGHBORS };
+	struct answer answer = {};
+	uint8_t *buffer = NULL, chunk[4096];
+	size_t len = 0, request = 0, consumed;
+	char *ifnames;
+	ssize_t nb;
+	int rc;
+
+	/* A request larger than what the socket can hold */
+	ifnames = malloc(1 << 21);
+	ck_assert_ptr_ne(ifnames, NULL);
+	memset(ifnames, 'e', (1 << 21) - 1);
+	ifnames[(1 << 21) - 1] = '\0';
+	ck_assert_int_eq(lldpctl_get_neighbors_async(aconn, ifnames, 0, answered,
+			     &answer),
+	    0);
+	free(ifnames);
+	ck_assert_int_eq(lldpctl_process(aconn),
+	    LLDPCTL_WANT_READ | LLDPCTL_WANT_WRITE);
+
+	/* Read the request while it is sent */
+	do {
+		while ((nb = read(server, chunk, sizeof(chunk))) > 0) {
+			buffer = realloc(buffer, request + nb);
+			ck_assert_ptr_ne(buffer, NULL);
+			memcpy(buffer + request, chunk, nb);
+			request += nb;
+		}
+		rc = lldpctl_process(aconn);
+		ck_assert_int_ge(rc, 0);
+	} while (rc & LLDPCTL_WANT_WRITE);
+	ck_assert_int_eq(rc, LLDPCTL_WANT_READ);
+	while ((nb = read(server, chunk, sizeof(chunk))) > 0) {
+		buffer = realloc(buffer, request + nb);
+		ck_assert_ptr_ne(buffer, NULL);
+		memcpy(buffer + request, chunk, nb);
+		request += nb;
+	}
+	ck_assert_int_eq(ctl_msg_parse_unserialized(buffer, request, types[0], NULL,
+			     NULL, &consumed),
+	    0);
+	ck_assert_int_eq(consumed, request);
+	free(buffer);
+	buffer = NULL;
+
+	server_neighbors(&buffer, &len, GET_NEIGHBORS);
+	server_send(buffer, len);
+	free(buffer);
+	ck_assert_int_eq(lldpctl_process(aconn), 0);
+	ck_assert_int_eq(completed, 1);
+	ck_assert_int_eq(answer.error, LLDPCTL_NO_ERROR);
+}
+END_TEST
+
+START_TEST(test_async_unexpected_answer)
+{
+	enum hmsg_type types[] = { GET_INTERFACES, GET_INTERFACES };
+	struct answer answers[2] = {};
+	uint8_t *buffer = NULL;
+	size_t len = 0;
+
+	ck_assert_int_eq(lldpctl_get_interfaces_async(aconn, answered, &answers[0]),
+	    0);
+	ck_assert_int_eq(lldpctl_get_interfaces_async(aconn, answered, &answers[1]),
+	    0);
+	server_requests(types, 2);
+
+	/* The first answer has not the expected type */
+	server_neighbors(&buffer, &len, GET_NEIGHBORS);
+	server_interfaces(&buffer, &len);
+	server_send(buffer, len);
+	free(buffer);
+	ck_assert_int_eq(lldpctl_process(aconn), 0);
+	ck_assert_int_eq(completed, 2);
+	ck_assert_int_eq(answers[0].error, LLDPCTL_ERR_SERIALIZATION);
+	ck_assert_int_eq(answers[0].count, 0);
+	ck_assert_int_eq(answers[1].error, LLDPCTL_NO_ERROR);
+	ck_assert_int_eq(answers[1].count, 2);
+	free(answers[1].first);
+}
+END_TEST
+
+START_TEST(test_async_eof)
+{
+	enum hmsg_type types[] = { GET_INTERFACES, GET_NEIGHBORS };
+	struct answer answers[2] = {};
+
+	ck_assert_int_eq(lldpctl_get_interfaces_async(aconn, answered, &answers[0]),
+	    0);
+	ck_assert_int_eq(lldpctl_get_neighbors_async(aconn, NULL, 0, answered,
+			     &answers[1]),
+	    0);
+	server_requests(types, 2);
+	close(server);
+	server = -1;
+	ck_assert_int_eq(lldpctl_process(aconn), LLDPCTL_ERR_EOF);
+	ck_assert_int_eq(completed, 2);
+	ck_assert_int_eq(answers[0].error, LLDPCTL_ERR_EOF);
+	ck_assert_int_eq(answers[1].error, LLDPCTL_ERR_EOF);
+}
+END_TEST
+
+Suite *
+lldpctl_suite(void)
+{
+	Suite *s = suite_create("liblldpctl");
+
+	TCase *tc_notifications = tcase_create("Notifications");
+	tcase_add_test(tc_notifications, test_notifications_at_once);
+	tcase_add_test(tc_notifications, test_notifications_by_pieces);
+	suite_add_tcase(s, tc_notifications);
+
+	TCase *tc_async = tcase_create("Asynchronous requests");
+	tcase_add_checked_fixture(tc_async, async_setup, async_teardown);
+	tcase_add_test(tc_async, test_async_in_order);
+	tcase_add_test(tc_async, test_async_partial_read);
+	tcase_add_test(tc_async, test_async_partial_write);
+	tcase_add_test(tc_async, test_async_unexpected_answer);
+	tcase_add_test(tc_async, test_async_eof);
+	suite_add_tcase(s, tc_async);
+
+	return s;
+}
+
+int
+main()
+{
+	int number_failed;
+	Suite *s = lldpctl_suite();
+	SRunner *sr = srunner_create(s);
+	srunner_run_all(sr, CK_ENV);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
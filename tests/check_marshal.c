@@ -319,6 +319,46 @@ START_TEST(test_null_pointers)
 }
 END_TEST
 
+START_TEST(test_hash)
+{
+	struct struct_simple simple1, simple2;
+	struct struct_nestedpointers nested1, nested2;
+	u_int32_t hash;
+
+	/* Padding should be zeroed to get the same hash */
+	memset(&simple1, 0, sizeof(simple1));
+	simple1.a1 = 78452;
+	simple1.a2 = 48751424;
+	simple1.a3 = 'h';
+	memcpy(&simple2, &simple1, sizeof(simple2));
+	memset(&nested1, 0, sizeof(nested1));
+	nested1.c1 = 4542;
+	nested1.c2 = 5665454;
+	nested1.c3 = &simple1;
+	nested1.c5 = -544;
+	memcpy(&nested2, &nested1, sizeof(nested2));
+	nested2.c3 = &simple2;
+
+	/* Only the pointed content matters, not the pointer itself */
+	hash = marshal_hash(struct_nestedpointers, &nested1, 0);
+	ck_assert_int_eq(hash, marshal_hash(struct_nestedpointers, &nested2, 0));
+	simple2.a3 = 'i';
+	ck_assert_int_ne(hash, marshal_hash(struct_nestedpointers, &nested2, 0));
+	simple2.a3 = 'h';
+	nested2.c3 = NULL;
+	ck_assert_int_ne(hash, marshal_hash(struct_nestedpointers, &nested2, 0));
+	nested2.c3 = &simple2;
+
+	/* Fields before the start offset are not significant */
+	nested2.c1 = 4543;
+	ck_assert_int_ne(hash, marshal_hash(struct_nestedpointers, &nested2, 0));
+	ck_assert_int_eq(marshal_hash(struct_nestedpointers, &nested1,
+			     offsetof(struct struct_nestedpointers, c2)),
+	    marshal_hash(struct_nestedpointers, &nested2,
+		offsetof(struct struct_nestedpointers, c2)));
+}
+END_TEST
+
 struct struct_multipleref {
 	int f1;
 	struct struct_simple *f2;
@@ -379,6 +419,44 @@ START_TEST(test_multiple_references)
 }
 END_TEST
 
+START_TEST(test_serialized_layout)
+{
+	struct struct_simple source_simple = {
+		.a1 = 451,
+	};
+	struct struct_nestedpointers source_nested = {
+		.c3 = &source_simple,
+		.c4 = NULL,
+	};
+	struct struct_multipleref source = {
+		.f1 = 15,
+		.f2 = &source_simple,
+		.f3 = &source_simple,
+		.f4 = &source_nested,
+	};
+	struct {
+		void *orig;
+		size_t size;
+	} *header;
+	struct struct_multipleref *object;
+	void *buffer = NULL;
+	ssize_t len;
+
+	len = struct_multipleref_serialize(&source, &buffer);
+	fail_unless(len > 0, "Unable to serialize");
+	header = buffer;
+	object = (struct struct_multipleref *)(header + 1);
+	ck_assert_int_eq(header->size, len);
+	/* Pointers are replaced by their order of appearance */
+	ck_assert_ptr_eq(header->orig, (void *)1);
+	ck_assert_ptr_eq(object->f2, (void *)2);
+	ck_assert_ptr_eq(object->f3, (void *)2);
+	ck_assert_ptr_eq(object->f4, (void *)3);
+	ck_assert_int_eq(object->f1, 15);
+	free(buffer);
+}
+END_TEST
+
 struct struct_circularref {
 	int g1;
 	struct struct_circularref *g2;
@@ -541,6 +619,56 @@ START_TEST(test_simple_list)
 }
 END_TEST
 
+START_TEST(test_long_list)
+{
+	struct struct_simple source_simple = {
+		.a1 = 451,
+	};
+	struct list_simple source;
+	struct struct_simpleentry *entries, *e, *e_next;
+	struct struct_simple *shared;
+	struct list_simple *destination;
+	void *buffer;
+	size_t len, len2;
+	int i, n = 1000;
+
+	entries = calloc(n, sizeof(struct struct_simpleentry));
+	fail_unless(entries != NULL, "Unable to allocate entries");
+	TAILQ_INIT(&source);
+	for (i = 0; i < n; i++) {
+		entries[i].g1 = i;
+		entries[i].g2 = (i % 2) ? &source_simple : NULL;
+		TAILQ_INSERT_TAIL(&source, &entries[i], s_entries);
+	}
+
+	len = list_simple_serialize(&source, &buffer);
+	fail_unless(len > 0, "Unable to serialize");
+	free(entries);
+	len2 = list_simple_unserialize(buffer, len, &destination);
+	fail_unless(len2 > 0, "Unable to deserialize");
+	ck_assert_int_eq(len, len2);
+	free(buffer);
+
+	i = 0;
+	shared = NULL;
+	for (e = TAILQ_FIRST(destination); e != NULL; e = e_next, i++) {
+		e_next = TAILQ_NEXT(e, s_entries);
+		ck_assert_int_eq(e->g1, i);
+		if (i % 2) {
+			/* All entries point to the same object */
+			ck_assert_int_eq(e->g2->a1, 451);
+			if (shared == NULL) shared = e->g2;
+			ck_assert_ptr_eq(e->g2, shared);
+		} else
+			ck_assert_ptr_eq(e->g2, NULL);
+		free(e);
+	}
+	ck_assert_int_eq(i, n);
+	free(shared);
+	free(destination);
+}
+END_TEST
+
 START_TEST(test_simple_repaired_list)
 {
 	struct struct_simple source_simple = {
@@ -896,10 +1024,13 @@ marshal_suite(void)
 	tcase_add_test(tc_marshal, test_pointer_structure);
 	tcase_add_test(tc_marshal, test_several_pointers_structure);
 	tcase_add_test(tc_marshal, test_null_pointers);
+	tcase_add_test(tc_marshal, test_hash);
 	tcase_add_test(tc_marshal, test_multiple_references);
+	tcase_add_test(tc_marshal, test_serialized_layout);
 	tcase_add_test(tc_marshal, test_circular_references);
 	tcase_add_test(tc_marshal, test_too_small_unmarshal);
 	tcase_add_test(tc_marshal, test_simple_list);
+	tcase_add_test(tc_marshal, test_long_list);
 	tcase_add_test(tc_marshal, test_simple_repaired_list);
 	tcase_add_test(tc_marshal, test_empty_repaired_list);
 	tcase_add_test(tc_marshal, test_embedded_list);
@@ -115,6 +115,41 @@ START_TEST(test_allowlist)
 }
 END_TEST
 
+START_TEST(test_wildcard_kinds)
+{
+	ck_assert_int_eq(pattern_match("eth0", "eth?", 0), 1);
+	ck_assert_int_eq(pattern_match("eth10", "eth?", 0), 0);
+	ck_assert_int_eq(pattern_match("eth1", "eth[01]", 0), 1);
+	ck_assert_int_eq(pattern_match("eth2", "eth[01]", 0), 0);
+	ck_assert_int_eq(pattern_match("eth0.100", "eth*.100", 0), 1);
+	ck_assert_int_eq(pattern_match("eth0.200", "eth*.100", 0), 0);
+	ck_assert_int_eq(pattern_match("eth", "eth*", 0), 1);
+	ck_assert_int_eq(pattern_match("et", "eth*", 0), 0);
+	ck_assert_int_eq(pattern_match("eth0", ",,eth0,,", 0), 2);
+	/* The first `!!` matching decides */
+	ck_assert_int_eq(pattern_match("eth0", "!!eth*,!!eth0", 0), 1);
+	ck_assert_int_eq(pattern_match("eth0", "!!eth0,!!eth*", 0), 2);
+}
+END_TEST
+
+START_TEST(test_compiled)
+{
+	struct pattern_set *set = pattern_compile("*,!eth*,!!eth0,vlan1,!!bond?");
+
+	ck_assert_ptr_ne(set, NULL);
+	ck_assert_int_eq(pattern_set_match(set, "eth0", 0), 2);
+	ck_assert_int_eq(pattern_set_match(set, "eth1", 1), 0);
+	ck_assert_int_eq(pattern_set_match(set, "vlan0", 0), 1);
+	ck_assert_int_eq(pattern_set_match(set, "vlan1", 0), 2);
+	ck_assert_int_eq(pattern_set_match(set, "bond0", 0), 1);
+	ck_assert_int_eq(pattern_set_match(set, "eth0", 0), 2);
+	pattern_set_free(set);
+
+	ck_assert_ptr_eq(pattern_compile(NULL), NULL);
+	ck_assert_int_eq(pattern_set_match(NULL, "eth0", 1), 0);
+}
+END_TEST
+
 Suite *
 pattern_suite(void)
 {
@@ -130,6 +165,8 @@ pattern_suite(void)
 	tcase_add_test(tc_pattern, test_match_and_denylist);
 	tcase_add_test(tc_pattern, test_denylist_wildcard);
 	tcase_add_test(tc_pattern, test_allowlist);
+	tcase_add_test(tc_pattern, test_wildcard_kinds);
+	tcase_add_test(tc_pattern, test_compiled);
 	suite_add_tcase(s, tc_pattern);
 
 	return s;
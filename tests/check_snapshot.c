@@ -0,0 +1,142 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2026 Vincent Bernat <bernat@luffy.cx>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/snapshot.h"
+
+static char name[] = "/tmp/check_snapshot.XXXXXX";
+static struct snapshot writer, reader;
+
+static void
+setup(void)
+{
+	writer.s_map = NULL;
+	writer.s_size = 0;
+	writer.s_fd = mkstemp(name);
+	ck_assert_int_ne(writer.s_fd, -1);
+	ck_assert_int_eq(snapshot_open(&reader, name), 0);
+}
+
+static void
+teardown(void)
+{
+	snapshot_close(&reader);
+	snapshot_close(&writer);
+	unlink(name);
+	strcpy(name + strlen(name) - 6, "XXXXXX");
+}
+
+START_TEST(test_empty)
+{
+	u_int64_t generation;
+	void *content = NULL;
+
+	ck_assert_int_eq(snapshot_generation(&reader, &generation), -1);
+	ck_assert_int_eq(snapshot_read(&reader, &content, &generation), -1);
+	ck_assert_ptr_eq(content, NULL);
+}
+END_TEST
+
+START_TEST(test_read)
+{
+	u_int64_t generation = 0;
+	void *content = NULL;
+
+	ck_assert_int_eq(snapshot_update(&writer, "hello", 5), 0);
+	ck_assert_int_eq(snapshot_generation(&reader, &generation), 0);
+	ck_assert_int_eq(generation, 1);
+	ck_assert_int_eq(snapshot_read(&reader, &content, &generation), 5);
+	ck_assert_int_eq(generation, 1);
+	ck_assert_int_eq(memcmp(content, "hello", 5), 0);
+	free(content);
+
+	ck_assert_int_eq(snapshot_update(&writer, "bye", 3), 0);
+	ck_assert_int_eq(snapshot_read(&reader, &content, &generation), 3);
+	ck_assert_int_eq(generation, 2);
+	ck_assert_int_eq(memcmp(content, "bye", 3), 0);
+	free(content);
+}
+END_TEST
+
+START_TEST(test_grow)
+{
+	u_int64_t generation = 0;
+	size_t len = 1024 * 1024;
+	char *large = malloc(len);
+	void *content = NULL;
+
+	ck_assert_ptr_ne(large, NULL);
+	memset(large, 'x', len);
+
+	/* The reader maps the file while it is still small */
+	ck_assert_int_eq(snapshot_update(&writer, "small", 5), 0);
+	ck_assert_int_eq(snapshot_read(&reader, &content, &generation), 5);
+	free(content);
+	ck_assert_int_eq(snapshot_update(&writer, large, len), 0);
+	ck_assert_int_eq(snapshot_read(&reader, &content, &generation), len);
+	ck_assert_int_eq(generation, 2);
+	ck_assert_int_eq(memcmp(content, large, len), 0);
+	ck_assert(reader.s_size >= len);
+	free(content);
+	free(large);
+}
+END_TEST
+
+START_TEST(test_withdraw)
+{
+	u_int64_t generation = 0;
+	void *content = NULL;
+
+	ck_assert_int_eq(snapshot_update(&writer, "hello", 5), 0);
+	ck_assert_int_eq(snapshot_generation(&reader, &generation), 0);
+	ck_assert_int_eq(snapshot_update(&writer, NULL, 0), 0);
+	ck_assert_int_eq(snapshot_generation(&reader, &generation), -1);
+	ck_assert_int_eq(snapshot_read(&reader, &content, &generation), -1);
+}
+END_TEST
+
+Suite *
+snapshot_suite(void)
+{
+	Suite *s = suite_create("Snapshot of neighbors");
+
+	TCase *tc_snapshot = tcase_create("Snapshot file");
+	tcase_add_checked_fixture(tc_snapshot, setup, teardown);
+	tcase_add_test(tc_snapshot, test_empty);
+	tcase_add_test(tc_snapshot, test_read);
+	tcase_add_test(tc_snapshot, test_grow);
+	tcase_add_test(tc_snapshot, test_withdraw);
+	suite_add_tcase(s, tc_snapshot);
+
+	return s;
+}
+
+int
+main()
+{
+	int number_failed;
+	Suite *s = snapshot_suite();
+	SRunner *sr = srunner_create(s);
+	srunner_run_all(sr, CK_ENV);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -314,6 +314,7 @@ void
 snmp_config()
 {
 	starttime = test_starttime;
+	agent_index_invalidate();
 	agent_scfg = &test_cfg;
 	TAILQ_INIT(&test_cfg.g_chassis);
 	TAILQ_INIT(&chassis1.c_mgmt);
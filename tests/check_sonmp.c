@@ -93,7 +93,7 @@ Nortel Networks / SynOptics Network Management Protocol
 	chassis.c_id_len = ETHER_ADDR_LEN;
 	TAILQ_INIT(&chassis.c_mgmt);
 	addr = inet_addr("172.17.142.37");
-	mgmt = lldpd_alloc_mgmt(LLDPD_AF_IPV4, &addr, sizeof(in_addr_t), 0);
+	mgmt = lldpd_alloc_mgmt(NULL, LLDPD_AF_IPV4, &addr, sizeof(in_addr_t), 0);
 	if (mgmt == NULL) ck_abort();
 	TAILQ_INSERT_TAIL(&chassis.c_mgmt, mgmt, m_entries);
 
@@ -129,6 +129,7 @@ void
 pcap_teardown()
 {
 	struct packet *npkt, *pkt;
+	lldpd_tx_cache_cleanup(&hardware);
 	for (pkt = TAILQ_FIRST(&pkts); pkt != NULL; pkt = npkt) {
 		npkt = TAILQ_NEXT(pkt, next);
 		TAILQ_REMOVE(&pkts, pkt, next);
@@ -484,6 +484,26 @@ def test_configure_one_port(lldpd1, lldpd, lldpcli, namespaces, links):
         assert out["lldp.eth2.port.power.device-type"] == "PSE"
 
 
+def test_show_neighbors_filters(lldpd1, lldpd, lldpcli, namespaces, links):
+    links(namespaces(1), namespaces(2))
+    with namespaces(2):
+        lldpd()
+    with namespaces(1):
+        time.sleep(2)
+        out = lldpcli("-f", "keyvalue", "show", "neighbors", "ports", "eth2")
+        assert "lldp.eth0.port.descr" not in out
+        assert out["lldp.eth2.port.descr"] == "eth3"
+        out = lldpcli("-f", "keyvalue", "show", "neighbors", "ports", "eth*")
+        assert out["lldp.eth0.port.descr"] == "eth1"
+        assert out["lldp.eth2.port.descr"] == "eth3"
+        out = lldpcli("-f", "keyvalue", "show", "neighbors", "protocol", "lldp")
+        assert out["lldp.eth0.port.descr"] == "eth1"
+        assert out["lldp.eth2.port.descr"] == "eth3"
+        out = lldpcli("-f", "keyvalue", "show", "neighbors", "protocol", "cdpv2")
+        assert "lldp.eth0.port.descr" not in out
+        assert "lldp.eth2.port.descr" not in out
+
+
 @pytest.mark.skipif("'Dot3' not in config.lldpd.features", reason="Dot3 not supported")
 def test_new_port_take_default(lldpd1, lldpd, lldpcli, namespaces, links):
     with namespaces(2):
@@ -619,6 +639,19 @@ def test_watch(lldpd1, lldpd, lldpcli, namespaces, links):
         assert got == expected
 
 
+def test_watch_coalesce(lldpd1, lldpd, lldpcli, namespaces, links):
+    with namespaces(2):
+        lldpd()
+    with namespaces(1):
+        out = lldpcli("-f", "keyvalue", "show", "neighbors")
+        assert out["lldp.eth0.chassis.name"] == "ns-2.example.com"
+
+        # Changes are received once the window has elapsed
+        links.down("eth0")
+        out = lldpcli("-f", "keyvalue", "watch", "coalesce", "500", "limit", "1")
+        assert out["lldp-deleted.eth0.chassis.name"] == "ns-2.example.com"
+
+
 @pytest.mark.skipif("'XML' not in config.lldpcli.outputs", reason="XML not supported")
 def test_watch_xml(lldpd1, lldpd, lldpcli, namespaces, links):
     with namespaces(2):
@@ -683,6 +716,7 @@ def test_return_code(lldpd1, lldpcli, namespaces):
     "command, name, expected",
     [
         ("configure system max-neighbors 10", "max-neighbors", 10),
+        ("configure system snapshot", "snapshot", "yes"),
         # get integral tx-delay from non-integral value (rounded up value)
         ("configure lldp tx-interval 1500ms", "tx-delay", 2),
         # get non-integral tx-delay-ms from non-integral value (exact value)
@@ -717,6 +751,8 @@ def test_return_code(lldpd1, lldpcli, namespaces):
         ("configure system hostname squid", "hostname", "squid"),
         ("configure system interface description", "ifdescr-update", "yes"),
         ("configure system interface promiscuous", "iface-promisc", "yes"),
+        ("configure system interface rx-ring", "iface-rx-ring", "yes"),
+        ("configure system interface shared-socket", "iface-shared-socket", "yes"),
         (
             "configure system bond-slave-src-mac-type fixed",
             "bond-slave-src-mac-type",